@@ -42,6 +42,7 @@ HEADERS += \
     ./src/editor/dialog_boxes.h \
     ./src/engine/script/script_write.h \
     ./src/engine/script/script_read.h \
+    ./src/engine/script/script_cache.h \
     ./src/engine/script/script.h \
     ./src/engine/video/color.h \
     ./src/editor/tileset_editor.h \
@@ -55,6 +56,8 @@ HEADERS += \
     ./src/engine/system.h \
     ./src/engine/mode_manager.h \
     ./src/engine/video/shake.h \
+    ./src/engine/video/sprite_batcher.h \
+    ./src/engine/video/image_loader.h \
     ./src/engine/video/text.h \
     ./src/modes/mode_help_window.h \
     ./src/engine/video/particle_system.h \
@@ -69,6 +72,7 @@ HEADERS += \
     ./src/common/gui/option.h \
     ./src/common/gui/menu_window.h \
     ./src/common/gui/gui.h \
+    ./src/common/map_binary.h \
     ./src/engine/effect_supervisor.h \
     ./src/engine/input.h \
     ./src/engine/audio/audio_descriptor.h \
@@ -84,6 +88,7 @@ SOURCES += \
     ./src/editor/dialog_boxes.cpp \
     ./src/engine/script/script_write.cpp \
     ./src/engine/script/script_read.cpp \
+    ./src/engine/script/script_cache.cpp \
     ./src/engine/script/script.cpp \
     ./src/luabind/src/wrapper_base.cpp \
     ./src/luabind/src/weak_ref.cpp \
@@ -114,6 +119,8 @@ SOURCES += \
     ./src/engine/system.cpp \
     ./src/engine/mode_manager.cpp \
     ./src/engine/video/shake.cpp \
+    ./src/engine/video/sprite_batcher.cpp \
+    ./src/engine/video/image_loader.cpp \
     ./src/engine/video/text.cpp \
     ./src/modes/mode_help_window.cpp \
     ./src/engine/video/particle_system.cpp \
@@ -125,6 +132,7 @@ SOURCES += \
     ./src/common/gui/option.cpp \
     ./src/common/gui/menu_window.cpp \
     ./src/common/gui/gui.cpp \
+    ./src/common/map_binary.cpp \
     ./src/engine/effect_supervisor.cpp \
     ./src/engine/input.cpp \
     ./src/engine/audio/audio_descriptor.cpp \
@@ -0,0 +1,28 @@
+-- Battle simulation setup example
+--
+-- Run it with: valyriatear --simulate-battle dat/battles/simulations/simulation_example.lua
+-- The battle is played without any player, the characters choosing random skills like
+-- the enemies do, and the statistics of the results are printed once all the runs are done.
+
+local ns = {}
+setmetatable(ns, {__index = _G})
+simulation_example = ns;
+setfenv(1, ns);
+
+-- The characters in the party
+characters = { BRONANN, KALYA };
+
+-- The experience points given to each character before the battles (optional)
+experience_points = 0;
+
+-- The enemies ids, see dat/actors/enemies.lua
+enemies = { 1, 1, 2 };
+
+-- The battle type: 0 = wait, 1 = semi-active, 2 = active (optional, wait by default)
+battle_type = 0;
+
+-- The battle scripts, as given to the battle encounters (optional)
+battle_scripts = {};
+
+-- The longest battle time allowed, in seconds (optional, 600 by default)
+time_limit = 600;
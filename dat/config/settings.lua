@@ -57,10 +57,14 @@ settings.video_defaults = {}
 settings.video_defaults.full_screen = false
 settings.video_defaults.screen_resx = 800
 settings.video_defaults.screen_resy = 600
+settings.video_defaults.vsync = true
+settings.video_defaults.frame_rate = 60
 settings.video_settings = {}
 settings.video_settings.full_screen = false
 settings.video_settings.screen_resx = 800
 settings.video_settings.screen_resy = 600
+settings.video_settings.vsync = true
+settings.video_settings.frame_rate = 60
 settings.audio_settings = {}
 settings.audio_settings.music_vol = 1
 settings.audio_settings.sound_vol = 1
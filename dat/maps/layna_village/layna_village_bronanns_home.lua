@@ -242,6 +242,7 @@ layers[4][23] = { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
 local bronann = {};
 local bronanns_dad = {};
 local bronanns_mother = {};
+local dad_dialogue = {};
 local quest2_start_scene = {};
 
 -- the main map loading code
@@ -258,11 +259,22 @@ function Load(m)
 	_CreateNPCs();
 	_CreateObjects();
 
+	_CreateEvents();
+	_CreateZones();
+end
+
+-- Sets the map up for Bronann coming in, each time the map is entered.
+-- The map may have been kept loaded since Bronann last left it.
+function Enter(m)
+	_PlaceCharacters();
+
 	-- Set the camera focus on bronann
 	Map:SetCamera(bronann);
 
-	_CreateEvents();
-	_CreateZones();
+	_UpdateParentsState();
+	_UpdateDishesAndFood();
+
+	quest2_start_scene = false;
 end
 
 function Update()
@@ -273,19 +285,29 @@ end
 
 -- Character creation
 function _CreateCharacters()
-	-- default position and direction
 	bronann = CreateSprite(Map, "Bronann", 46.5, 11.5);
-	bronann:SetDirection(hoa_map.MapMode.SOUTH);
 	bronann:SetMovementSpeed(hoa_map.MapMode.NORMAL_SPEED);
 
+	Map:AddGroundObject(bronann);
+end
+
+-- Character placement
+function _PlaceCharacters()
+	-- Bronann may have been hidden by the quest 2 start scene
+	bronann:SetVisible(true);
+	bronann:SetCollisionMask(hoa_map.MapMode.ALL_COLLISION);
+	bronann:SetMoving(false);
+
+	-- default position and direction
+	bronann:SetPosition(46.5, 11.5);
+	bronann:SetDirection(hoa_map.MapMode.SOUTH);
+
 	-- set up the position according to the previous map
 	if (GlobalManager:GetPreviousLocation() == "from_village_center") then
 		bronann:SetPosition(39.5, 22.5);
 		bronann:SetDirection(hoa_map.MapMode.NORTH);
 		AudioManager:PlaySound("snd/door_close.wav");
 	end
-
-	Map:AddGroundObject(bronann);
 end
 
 function _CreateNPCs()
@@ -300,29 +322,18 @@ function _CreateNPCs()
 	event:AddEventLinkAtEnd("Dad random move", 3000); -- Loop on itself
 	EventManager:RegisterEvent(event);
 
-	if (GlobalManager:DoesEventExist("story", "Quest2_forest_event_done") == true) then
-	    -- Carson isn't here anymore
-	    bronanns_dad:SetVisible(false);
-	    bronanns_dad:SetCollisionMask(hoa_map.MapMode.NO_COLLISION);
-        bronanns_dad:SetPosition(0, 0);
-	else
-	    EventManager:StartEvent("Dad random move");
-	end
-
-	dialogue = hoa_map.SpriteDialogue();
+	-- The dialogue the dad gets back when the parents state is updated
+	dad_dialogue = hoa_map.SpriteDialogue();
 	text = hoa_system.Translate("Hey son! Slept well? Err, where did I leave that oil lamp?");
-	dialogue:AddLine(text, bronanns_dad);
+	dad_dialogue:AddLine(text, bronanns_dad);
 	text = hoa_system.Translate("Hi Dad! Er, I don't know. Sorry.");
-	dialogue:AddLineEmote(text, bronann, "thinking dots");
+	dad_dialogue:AddLineEmote(text, bronann, "thinking dots");
 	text = hoa_system.Translate("Nah, no problem, I'll find it.");
-	dialogue:AddLine(text, bronanns_dad);
-	DialogueManager:AddDialogue(dialogue);
-	bronanns_dad:AddDialogueReference(dialogue);
+	dad_dialogue:AddLine(text, bronanns_dad);
+	DialogueManager:AddDialogue(dad_dialogue);
 
 	bronanns_mother = CreateSprite(Map, "Malta", 33.1, 17.5);
-	bronanns_mother:SetDirection(hoa_map.MapMode.SOUTH);
 	Map:AddGroundObject(bronanns_mother);
-	_UpdateMotherDialogue();
 
 	-- Make her walk in front of the table to prepare the lunch.
 	event = hoa_map.PathMoveSpriteEvent("Kitchen: Mother goes middle", bronanns_mother, 33.1, 19.9, false);
@@ -346,8 +357,6 @@ function _CreateNPCs()
 	event = hoa_map.ChangeDirectionSpriteEvent("Kitchen: Mother looks left 2", bronanns_mother, hoa_map.MapMode.WEST);
 	event:AddEventLinkAtEnd("Kitchen: Mother goes middle", 2000);
 	EventManager:RegisterEvent(event);
-	-- The mother routine event
-	EventManager:StartEvent("Kitchen: Mother goes middle");
 
 
 	-- The Hero's first noble quest briefing...
@@ -469,7 +478,6 @@ function _CreateObjects()
 	if (sauce_pot ~= nil) then Map:AddGroundObject(sauce_pot) end;
 	knife = CreateObject(Map, "Knife1", 35, 22);
 	if (knife ~= nil) then Map:AddGroundObject(knife) end;
-	_UpdateDishesAndFood();
 end
 
 -- Creates all events and sets up the entire event sequence chain
@@ -619,13 +627,19 @@ function _CreateZones()
 	home_exit_zone = hoa_map.CameraZone(38, 41, 24, 25, hoa_map.MapMode.CONTEXT_01);
 	Map:AddZone(home_exit_zone);
 
+	-- Starts loading the village images when Bronann walks to the door
+	home_exit_approach_zone = hoa_map.CameraZone(35, 44, 19, 25, hoa_map.MapMode.CONTEXT_01);
+	Map:AddZone(home_exit_approach_zone);
+
 	to_bronnans_room_zone = hoa_map.CameraZone(44, 47, 8, 9, hoa_map.MapMode.CONTEXT_01);
 	Map:AddZone(to_bronnans_room_zone);
-
-	quest2_start_scene = false;
 end
 
 function _CheckZones()
+	if (home_exit_approach_zone:IsCameraEntering() == true) then
+		Map:PrefetchMap("dat/maps/layna_village/layna_village_center.lua");
+	end
+
 	-- Don't check that zone when dealing with the quest 2 start scene.
 	if (quest2_start_scene == false and home_exit_zone:IsCameraEntering() == true) then
 		-- Prevent Bronann from exiting until his mother talked to him
@@ -644,6 +658,33 @@ end
 
 
 -- Internal Custom functions
+
+-- Puts the parents back to their daily routine, which the quest scenes may have stopped.
+function _UpdateParentsState()
+	EventManager:TerminateAllEvents(bronanns_dad);
+	bronanns_dad:SetMoving(false);
+	bronanns_dad:ClearDialogueReferences();
+
+	if (GlobalManager:DoesEventExist("story", "Quest2_forest_event_done") == true) then
+	    -- Carson isn't here anymore
+	    bronanns_dad:SetVisible(false);
+	    bronanns_dad:SetCollisionMask(hoa_map.MapMode.NO_COLLISION);
+        bronanns_dad:SetPosition(0, 0);
+	else
+	    bronanns_dad:SetPosition(33.5, 11.5);
+	    bronanns_dad:AddDialogueReference(dad_dialogue);
+	    EventManager:StartEvent("Dad random move");
+	end
+
+	EventManager:TerminateAllEvents(bronanns_mother);
+	bronanns_mother:SetMoving(false);
+	bronanns_mother:SetPosition(33.1, 17.5);
+	bronanns_mother:SetDirection(hoa_map.MapMode.SOUTH);
+	_UpdateMotherDialogue();
+	-- The mother routine event
+	EventManager:StartEvent("Kitchen: Mother goes middle");
+end
+
 function _UpdateDishesAndFood()
         if (GlobalManager:DoesEventExist("story", "Quest2_started") == true) then
 		-- Show the plate pile, hide the rest
@@ -272,6 +272,10 @@ local georges = {};
 local carson = {};
 local herth = {};
 local olivia = {}; -- Olivia npc, guarding the forest entrance
+local sophia = {};
+
+-- The dialogue event started when Olivia stops Bronann at the forest entrance
+local olivia_dialogue_event = "";
 
 -- the main map loading code
 function Load(m)
@@ -284,23 +288,35 @@ function Load(m)
 	Map.unlimited_stamina = true;
 
 	_CreateCharacters();
-	-- Set the camera focus on Bronann
-	Map:SetCamera(bronann);
-
 	_CreateNPCs();
 	_CreateObjects();
 
 	_CreateEvents();
 	_CreateZones();
 
-	_TriggerPotentialDialogueAfterFadeIn();
-
 	-- Add clouds overlay
 	Map:GetEffectSupervisor():EnableAmbientOverlay("img/ambient/clouds.png", 5.0, 5.0, true);
 
 	_HandleCredits();
 end
 
+-- Sets the map up for Bronann coming in, each time the map is entered.
+-- The map may have been kept loaded since Bronann last left it.
+function Enter(m)
+	_PlaceCharacters();
+	-- Set the camera focus on Bronann
+	Map:SetCamera(bronann);
+
+	-- Update the NPCs according to what Bronann did elsewhere meanwhile
+	_ResetNPCs();
+	_UpdateOrlinnAndKalyaState();
+	_UpdateGeorgesDialogue();
+	_UpdateOliviaDialogue();
+	_UpdateSophiaDialogue();
+
+	_TriggerPotentialDialogueAfterFadeIn();
+end
+
 -- Handle the display of the new game credits
 function _HandleCredits()
     -- Handle small credits triggering
@@ -322,9 +338,19 @@ end
 -- Character creation
 function _CreateCharacters()
 	bronann = CreateSprite(Map, "Bronann", 12, 63);
-	bronann:SetDirection(hoa_map.MapMode.SOUTH);
 	bronann:SetMovementSpeed(hoa_map.MapMode.NORMAL_SPEED);
 
+	Map:AddGroundObject(bronann);
+end
+
+-- Character placement
+function _PlaceCharacters()
+	bronann:SetMoving(false);
+
+	-- default position and direction
+	bronann:SetPosition(12, 63);
+	bronann:SetDirection(hoa_map.MapMode.SOUTH);
+
 	-- set up the position according to the previous map
 	if (GlobalManager:GetPreviousLocation() == "from_riverbank") then
 		bronann:SetPosition(30, 77);
@@ -352,8 +378,6 @@ function _CreateCharacters()
 	elseif (GlobalManager:GetPreviousLocation() == "from_bronanns_home") then
 		AudioManager:PlaySound("snd/door_close.wav");
 	end
-
-	Map:AddGroundObject(bronann);
 end
 
 function _CreateNPCs()
@@ -367,7 +391,6 @@ function _CreateNPCs()
 	event = hoa_map.RandomMoveSpriteEvent("Kalya random move", kalya, 1000, 2000);
 	event:AddEventLinkAtEnd("Kalya random move", 2000); -- Loop on itself
 	EventManager:RegisterEvent(event);
-	EventManager:StartEvent("Kalya random move");
 	dialogue = hoa_map.SpriteDialogue();
 	text = hoa_system.Translate("Please, leave me alone, Bronann...");
 	dialogue:AddLineEmote(text, kalya, "exclamation");
@@ -376,8 +399,6 @@ function _CreateNPCs()
 
 	orlinn = CreateSprite(Map, "Orlinn", 40, 18);
 	Map:AddGroundObject(orlinn);
-	-- Setup Orlinn's state and dialogue depending on the story current context
-	_UpdateOrlinnAndKalyaState();
 
 	carson = CreateSprite(Map, "Carson", 0, 0);
 	-- Default behaviour - not present on map.
@@ -409,19 +430,9 @@ function _CreateNPCs()
 	DialogueManager:AddDialogue(dialogue);
 	npc:AddDialogueReference(dialogue);
 
-	npc = CreateNPCSprite(Map, "Woman2", "Sophia", 22, 38);
-	Map:AddGroundObject(npc);
-	npc:SetDirection(hoa_map.MapMode.SOUTH);
-	dialogue = hoa_map.SpriteDialogue();
-	text = hoa_system.Translate("You're too young to trade stuff with me!");
-	if (GlobalManager:DoesEventExist("layna_south_entrance", "quest1_orlinn_hide_n_seek1_done") == true) then
-		if (GlobalManager:DoesEventExist("layna_riverbank", "quest1_orlinn_hide_n_seek2_done") == false) then
-			text = hoa_system.Translate("If you're running after Orlinn, I just saw him disappear near your house.");
-		end
-	end
-	dialogue:AddLine(text, npc);
-	DialogueManager:AddDialogue(dialogue);
-	npc:AddDialogueReference(dialogue);
+	sophia = CreateNPCSprite(Map, "Woman2", "Sophia", 22, 38);
+	Map:AddGroundObject(sophia);
+	sophia:SetDirection(hoa_map.MapMode.SOUTH);
 	-- Add her cat, Nekko
 	object = CreateObject(Map, "Cat1", 24, 37.6);
 	if (object ~= nil) then Map:AddGroundObject(object) end;
@@ -429,13 +440,11 @@ function _CreateNPCs()
 	georges = CreateNPCSprite(Map, "Man1", "Georges", 32, 76);
 	Map:AddGroundObject(georges);
 	georges:SetDirection(hoa_map.MapMode.WEST);
-	_UpdateGeorgesDialogue(georges);
 
     -- Olivia, guardian of the forest access
     olivia = CreateNPCSprite(Map, "Girl1", "Olivia", 115, 34);
     olivia:SetDirection(hoa_map.MapMode.SOUTH);
 	Map:AddGroundObject(olivia);
-    _UpdateOliviaDialogue();
 
     -- Needed look at events
     event = hoa_map.LookAtSpriteEvent("Bronann looks at Olivia", bronann, olivia);
@@ -961,6 +970,10 @@ function _CreateZones()
 	bronanns_home_entrance_zone = hoa_map.CameraZone(10, 14, 60, 61, hoa_map.MapMode.CONTEXT_01);
 	Map:AddZone(bronanns_home_entrance_zone);
 
+	-- Starts loading the houses images when Bronann walks to their doors
+	bronanns_home_approach_zone = hoa_map.CameraZone(7, 17, 60, 66, hoa_map.MapMode.CONTEXT_01);
+	Map:AddZone(bronanns_home_approach_zone);
+
 	to_riverbank_zone = hoa_map.CameraZone(19, 35, 78, 79, hoa_map.MapMode.CONTEXT_01);
 	Map:AddZone(to_riverbank_zone);
 
@@ -973,6 +986,9 @@ function _CreateZones()
 	shop_entrance_zone = hoa_map.CameraZone(92, 96, 70, 71, hoa_map.MapMode.CONTEXT_01);
 	Map:AddZone(shop_entrance_zone);
 
+	shop_approach_zone = hoa_map.CameraZone(89, 99, 70, 76, hoa_map.MapMode.CONTEXT_01);
+	Map:AddZone(shop_approach_zone);
+
 	secret_path_zone = hoa_map.CameraZone(0, 1, 55, 61, hoa_map.MapMode.CONTEXT_01);
 	Map:AddZone(secret_path_zone);
 
@@ -984,6 +1000,12 @@ function _CreateZones()
 end
 
 function _CheckZones()
+	if (bronanns_home_approach_zone:IsCameraEntering() == true) then
+		Map:PrefetchMap("dat/maps/layna_village/layna_village_bronanns_home.lua");
+	elseif (shop_approach_zone:IsCameraEntering() == true) then
+		Map:PrefetchMap("dat/maps/layna_village/layna_village_center_shop.lua");
+	end
+
 	if (bronanns_home_entrance_zone:IsCameraEntering() == true) then
 		-- If Bronann has started the quest 2, he doesn't want to go back and see his parents.
 		if (GlobalManager:DoesEventExist("story", "Quest2_started") == true
@@ -1009,7 +1031,7 @@ function _CheckZones()
 	elseif (to_layna_forest_zone:IsCameraEntering() == true) then
 		bronann:SetMoving(false);
 		if (GlobalManager:DoesEventExist("story", "Quest2_forest_event_done") == false) then
-			EventManager:StartEvent("Bronann can't enter the forest so easily");
+			EventManager:StartEvent(olivia_dialogue_event);
 		elseif (GlobalManager:DoesEventExist("story", "Quest2_kalya_equip_n_dungeons_speech_done") == false) then
 			EventManager:StartEvent("Quest2: Kalya's equipment and dungeons speech start");
 		else
@@ -1057,6 +1079,7 @@ function _UpdateOliviaDialogue()
     if (GlobalManager:DoesEventExist("story", "Quest2_forest_event_done") == false) then
         if (GlobalManager:DoesEventExist("story", "Quest2_wants_to_buy_sword_dialogue") == false
             and GlobalManager:DoesEventExist("story", "Quest2_started") == true) then
+            olivia_dialogue_event = "Bronann can't enter the forest without a sword";
             dialogue = hoa_map.SpriteDialogue();
             text = hoa_system.Translate("Bronann! Sorry, you can't access the forest without permission. You don't even have a sword...");
             dialogue:AddLineEmote(text, olivia, "exclamation");
@@ -1067,6 +1090,7 @@ function _UpdateOliviaDialogue()
             DialogueManager:AddDialogue(dialogue);
             olivia:AddDialogueReference(dialogue);
         else
+            olivia_dialogue_event = "Bronann can't enter the forest so easily";
             dialogue = hoa_map.SpriteDialogue();
             text = hoa_system.Translate("Bronann! Sorry, you know you can't access the forest without permission.");
             dialogue:AddLineEmote(text, olivia, "exclamation");
@@ -1076,6 +1100,7 @@ function _UpdateOliviaDialogue()
             olivia:AddDialogueReference(dialogue);
         end
     else
+        olivia_dialogue_event = "Olivia wishes Bronann good luck";
         dialogue = hoa_map.SpriteDialogue();
         text = hoa_system.Translate("Good luck Bronann.");
         dialogue:AddLine(text, olivia);
@@ -1085,9 +1110,59 @@ function _UpdateOliviaDialogue()
 
     -- Special event triggered when Bronann hasn't go the right to enter the forest yet.
     -- Shouldn't trigger once access is granted.
-    event = hoa_map.DialogueEvent("Bronann can't enter the forest so easily", dialogue);
-	event:SetStopCameraMovement(true);
-	EventManager:RegisterEvent(event);
+    -- An event keeps the dialogue it was first registered with, hence one event per dialogue.
+    if (EventManager:GetEvent(olivia_dialogue_event) == nil) then
+        event = hoa_map.DialogueEvent(olivia_dialogue_event, dialogue);
+        event:SetStopCameraMovement(true);
+        EventManager:RegisterEvent(event);
+    end
+end
+
+-- Updates Sophia's dialogue depending on where Orlinn is hiding.
+function _UpdateSophiaDialogue()
+	local text = {}
+	local dialogue = {}
+
+	sophia:ClearDialogueReferences();
+
+	dialogue = hoa_map.SpriteDialogue();
+	text = hoa_system.Translate("You're too young to trade stuff with me!");
+	if (GlobalManager:DoesEventExist("layna_south_entrance", "quest1_orlinn_hide_n_seek1_done") == true) then
+		if (GlobalManager:DoesEventExist("layna_riverbank", "quest1_orlinn_hide_n_seek2_done") == false) then
+			text = hoa_system.Translate("If you're running after Orlinn, I just saw him disappear near your house.");
+		end
+	end
+	dialogue:AddLine(text, sophia);
+	DialogueManager:AddDialogue(dialogue);
+	sophia:AddDialogueReference(dialogue);
+end
+
+-- Puts the NPCs moved or hidden by the scenes of an earlier visit back in their default state.
+function _ResetNPCs()
+	EventManager:TerminateAllEvents(orlinn);
+	orlinn:SetMoving(false);
+	orlinn:SetPosition(40, 18);
+	orlinn:SetMovementSpeed(hoa_map.MapMode.NORMAL_SPEED);
+	orlinn:SetVisible(true);
+	orlinn:SetCollisionMask(hoa_map.MapMode.ALL_COLLISION);
+
+	EventManager:TerminateAllEvents(kalya);
+	kalya:SetMoving(false);
+	kalya:SetPosition(42, 18);
+	kalya:SetVisible(true);
+	kalya:SetCollisionMask(hoa_map.MapMode.ALL_COLLISION);
+	EventManager:StartEvent("Kalya random move");
+
+	-- Carson and Herth only show up during the forest event
+	EventManager:TerminateAllEvents(carson);
+	carson:SetVisible(false);
+	carson:SetCollisionMask(hoa_map.MapMode.NO_COLLISION);
+	EventManager:TerminateAllEvents(herth);
+	herth:SetVisible(false);
+	herth:SetCollisionMask(hoa_map.MapMode.NO_COLLISION);
+
+	wooden_sword:SetVisible(false);
+	wooden_sword:SetCollisionMask(hoa_map.MapMode.NO_COLLISION);
 end
 
 -- Updates Georges dialogue depending on how far is the story going.
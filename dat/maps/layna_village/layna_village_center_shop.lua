@@ -229,11 +229,23 @@ function Load(m)
 	_CreateNPCs();
 	_CreateObjects();
 
+	_CreateEvents();
+	_CreateZones();
+end
+
+-- Sets the map up for Bronann coming in, each time the map is entered.
+-- The map may have been kept loaded since Bronann last left it.
+function Enter(m)
+	-- default position and direction
+	bronann:SetMoving(false);
+	bronann:SetPosition(32.0, 27.0);
+	bronann:SetDirection(hoa_map.MapMode.NORTH);
+
 	-- Set the camera focus on bronann
 	Map:SetCamera(bronann);
 
-	_CreateEvents();
-	_CreateZones();
+	-- Flora's dialogue depends on what Bronann did in the village meanwhile
+	_UpdateFloraDialogue();
 
 	-- The only entrance close door sound
 	AudioManager:PlaySound("snd/door_close.wav");
@@ -246,9 +258,7 @@ end
 
 -- Character creation
 function _CreateCharacters()
-	-- default position and direction
 	bronann = CreateSprite(Map, "Bronann", 32.0, 27.0);
-	bronann:SetDirection(hoa_map.MapMode.NORTH);
 	bronann:SetMovementSpeed(hoa_map.MapMode.NORMAL_SPEED);
 
 	Map:AddGroundObject(bronann);
@@ -264,7 +274,6 @@ function _CreateNPCs()
 	Map:AddGroundObject(flora);
 	flora:SetVisible(false);
 	flora:SetCollisionMask(hoa_map.MapMode.NO_COLLISION);
-    _UpdateFloraDialogue();
 end
 
 function _CreateObjects()
@@ -22,6 +22,7 @@
 --                  executing the skill before their stamina begins regenrating (zero is valid).
 -- {action_name}: The sprite action played before executing the battle scripted function.
 -- {target_type}: The type of target the skill affects, which may be an attack point, actor, or party.
+-- {particle_effects}: (optional) The particle effect files triggered by the skill, loaded when the battle starts.
 --
 -- Each skill entry requires a function called {BattleExecute} to be defined. This function implements the
 -- execution of the skill in battle, dealing damage, causing status changes, playing sounds, and animating
@@ -237,6 +238,7 @@ skills[7] = {
 	warmup_action_name = "magic_prepare",
 	action_name = "magic_cast",
 	target_type = hoa_global.GameGlobal.GLOBAL_TARGET_FOE,
+	particle_effects = { "dat/effects/particles/fire_spell.lua" },
 
 	BattleExecute = function(user, target)
 		target_actor = target:GetActor();
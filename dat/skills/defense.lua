@@ -21,6 +21,7 @@
 -- {cooldown_time}: The number of milliseconds that the actor using the skill must wait after
 --                  executing the skill before their stamina begins regenrating (zero is valid).
 -- {target_type}: The type of target the skill affects, which may be an attack point, actor, or party.
+-- {particle_effects}: (optional) The particle effect files triggered by the skill, loaded when the battle starts.
 --
 -- Each skill entry requires a function called {BattleExecute} to be defined. This function implements the
 -- execution of the skill in battle, buffing defense, causing status changes, playing sounds, and animating
@@ -46,6 +47,7 @@ skills[10001] = {
 	warmup_action_name = "magic_prepare",
 	action_name = "magic_cast",
 	target_type = hoa_global.GameGlobal.GLOBAL_TARGET_ALLY,
+	particle_effects = { "dat/effects/particles/defensive_stance.lua" },
 
 	BattleExecute = function(user, target)
 		target_actor = target:GetActor();
@@ -69,6 +71,7 @@ skills[10002] = {
 	warmup_action_name = "magic_prepare",
 	action_name = "magic_cast",
 	target_type = hoa_global.GameGlobal.GLOBAL_TARGET_ALLY,
+	particle_effects = { "dat/effects/particles/heal_particle.lua" },
 
 	BattleExecute = function(user, target)
 		target_actor = target:GetActor();
@@ -23,6 +23,7 @@
 -- {cooldown_time}: The number of milliseconds that the actor using the skill must wait after
 --                  executing the skill before their stamina begins regenrating (zero is valid).
 -- {target_type}: The type of target the skill affects, which may be an attack point, actor, or party.
+-- {particle_effects}: (optional) The particle effect files triggered by the skill, loaded when the battle starts.
 --
 -- Each skill entry requires a function called {BattleExecute} to be defined. This function implements the
 -- execution of the skill in battle, buffing defense, causing status changes, playing sounds, and animating
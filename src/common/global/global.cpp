@@ -258,6 +258,9 @@ void GameGlobal::ClearAllData()
 
     // Clear out the time played, in case of a new game
     SystemManager->SetPlayTime(0, 0, 0);
+
+    // The cached maps were set up with the previous game data
+    hoa_map::MapMode::FlushMapCache();
 } // void GameGlobal::ClearAllData()
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -92,6 +92,9 @@ GlobalSkill::GlobalSkill(uint32 id) :
         skill_script->CloseTable(); // animation_scripts table
     }
 
+    if(skill_script->DoesTableExist("particle_effects"))
+        skill_script->ReadStringVector("particle_effects", _particle_effects);
+
     skill_script->CloseTable(); // id.
 
     if(skill_script->IsErrorDetected()) {
@@ -117,6 +120,7 @@ GlobalSkill::GlobalSkill(const GlobalSkill &copy)
     _battle_execute_function = copy._battle_execute_function;
     _field_execute_function = copy._field_execute_function;
     _animation_scripts = copy._animation_scripts;
+    _particle_effects = copy._particle_effects;
 }
 
 
@@ -140,6 +144,7 @@ GlobalSkill &GlobalSkill::operator=(const GlobalSkill &copy)
     _battle_execute_function = copy._battle_execute_function;
     _field_execute_function = copy._field_execute_function;
     _animation_scripts = copy._animation_scripts;
+    _particle_effects = copy._particle_effects;
 
     return *this;
 }
@@ -143,6 +143,11 @@ public:
     *** Or an empty value otherwise;
     **/
     std::string GetAnimationScript(uint32 character_id);
+
+    //! \brief Returns the particle effect files the skill triggers, so that they can be loaded in advance.
+    const std::vector<std::string> &GetParticleEffects() const {
+        return _particle_effects;
+    }
     //@}
 
 private:
@@ -204,6 +209,9 @@ private:
 
     //! \brief map containing the animation scripts names linked to each characters id for the given skill.
     std::map <uint32, std::string> _animation_scripts;
+
+    //! \brief The particle effect files triggered by the skill battle execution function, if any.
+    std::vector<std::string> _particle_effects;
 }; // class GlobalSkill
 
 } // namespace hoa_global
@@ -64,6 +64,7 @@ void TextBox::ClearText()
 {
     _finished = true;
     _text.clear();
+    _char_offsets.clear();
     _num_chars = 0;
     _text_save.clear();
 }
@@ -308,6 +309,7 @@ void TextBox::_ReformatText()
     ustring temp_str = _text_save;
     const size_t temp_length = temp_str.length();
     _text.clear();
+    _char_offsets.clear();
     _num_chars = 0;
 
 
@@ -332,6 +334,9 @@ void TextBox::_ReformatText()
 
         }
     }
+
+    _CalculateCharOffsets();
+
     // (2): Calculate the height of the text and check it against the height of the textbox.
     int32 text_height = CalculateTextHeight();
 
@@ -343,6 +348,22 @@ void TextBox::_ReformatText()
 
 
 
+void TextBox::_CalculateCharOffsets()
+{
+    _char_offsets.resize(_text.size());
+
+    for(uint32 line = 0; line < _text.size(); ++line) {
+        const ustring &text = _text[line];
+        std::vector<int32> &offsets = _char_offsets[line];
+
+        offsets.assign(text.size() + 1, 0);
+        for(size_t i = 1; i <= text.size(); ++i)
+            offsets[i] = TextManager->CalculateTextWidth(_text_style.font, text.substr(0, i));
+    }
+}
+
+
+
 bool TextBox::IsInitialized(std::string &errors)
 {
     errors.clear();
@@ -383,7 +404,7 @@ void TextBox::_AddLine(const ustring &line)
     ustring temp_line = line;
 
     while(temp_line.empty() == false) {
-        int32 text_width = TextManager->CalculateTextWidth(_text_style.font, line);
+        int32 text_width = TextManager->CalculateTextWidth(_text_style.font, temp_line);
 
         // If the text can fit in the text box, add the whole line and return
         if(text_width < _width) {
@@ -471,7 +492,8 @@ void TextBox::_DrawTextLines(float text_x, float text_y, ScreenRect scissor_rect
     // Iterate through the loop for every line of text and draw it
     for(int32 line = 0; line < static_cast<int32>(_text.size()); ++line) {
         // (1): Calculate the x draw offset for this line and move to that position
-        float line_width = static_cast<float>(TextManager->CalculateTextWidth(_text_style.font, _text[line]));
+        const std::vector<int32> &char_offsets = _char_offsets[line];
+        float line_width = static_cast<float>(char_offsets.back());
         int32 x_align = VideoManager->_ConvertXAlign(_text_xalign);
         float x_offset = text_x + ((x_align + 1) * line_width) * 0.5f * VideoManager->_current_context.coordinate_system.GetHorizontalDirection();
 
@@ -495,10 +517,8 @@ void TextBox::_DrawTextLines(float text_x, float text_y, ScreenRect scissor_rect
             // The current character to draw is on this line: figure out which characters on this line should be drawn
             else {
                 int32 num_completed_chars = cur_char - num_chars_drawn;
-                if(num_completed_chars > 0) {
-                    ustring substring = _text[line].substr(0, num_completed_chars);
-                    TextManager->Draw(substring);
-                }
+                if(num_completed_chars > 0)
+                    TextManager->Draw(_text[line], _text_style, 0, num_completed_chars);
             }
         } // else if (_mode == VIDEO_TEXT_CHAR)
 
@@ -518,20 +538,16 @@ void TextBox::_DrawTextLines(float text_x, float text_y, ScreenRect scissor_rect
 
                 // Continue only if this line has at least one character that should be drawn
                 if(num_completed_chars >= 0) {
-                    ustring substring;
-
                     // Draw any fully completed characters at full opacity
-                    if(num_completed_chars > 0) {
-                        substring = _text[line].substr(0, num_completed_chars);
-                        TextManager->Draw(substring, _text_style);
-                    }
+                    if(num_completed_chars > 0)
+                        TextManager->Draw(_text[line], _text_style, 0, num_completed_chars);
 
                     // Draw the current character that is being faded in at the appropriate alpha level
                     Color old_color = _text_style.color;
                     _text_style.color[3] *= cur_percent;
 
-                    VideoManager->MoveRelative(static_cast<float>(TextManager->CalculateTextWidth(_text_style.font, substring)), 0.0f);
-                    TextManager->Draw(_text[line].substr(num_completed_chars, 1), _text_style);
+                    VideoManager->MoveRelative(static_cast<float>(char_offsets[num_completed_chars]), 0.0f);
+                    TextManager->Draw(_text[line], _text_style, num_completed_chars, 1);
                     _text_style.color = old_color;
                 }
             }
@@ -570,21 +586,17 @@ void TextBox::_DrawTextLines(float text_x, float text_y, ScreenRect scissor_rect
             }
             // If the line contains the current character, draw all previous characters as well as the current one
             else if(num_completed_chars >= 0) {
-                ustring substring;
-
                 // If there are already completed characters on this line, draw them in full
-                if(num_completed_chars > 0) {
-                    substring = _text[line].substr(0, num_completed_chars);
-                    TextManager->Draw(substring, _text_style);
-                }
+                if(num_completed_chars > 0)
+                    TextManager->Draw(_text[line], _text_style, 0, num_completed_chars);
 
                 // Now draw the current character from the line, partially scissored according to the amount that is complete
-                ustring cur_char_string = _text[line].substr(num_completed_chars, 1);
+                int32 completed_width = char_offsets[num_completed_chars];
 
                 // Create a rectangle for the current character, in window coordinates
                 int32 char_x, char_y, char_w, char_h;
                 char_x = static_cast<int32>(x_offset + VideoManager->_current_context.coordinate_system.GetHorizontalDirection()
-                                            * TextManager->CalculateTextWidth(_text_style.font, substring));
+                                            * completed_width);
                 char_y = static_cast<int32>(text_y - VideoManager->_current_context.coordinate_system.GetVerticalDirection()
                                             * (_font_properties->height + _font_properties->descent));
 
@@ -594,13 +606,13 @@ void TextBox::_DrawTextLines(float text_x, float text_y, ScreenRect scissor_rect
                 if(VideoManager->_current_context.coordinate_system.GetVerticalDirection() < 0.0f)
                     char_x = static_cast<int32>(VideoManager->_current_context.coordinate_system.GetLeft()) - char_x;
 
-                char_w = TextManager->CalculateTextWidth(_text_style.font, cur_char_string);
+                char_w = char_offsets[num_completed_chars + 1] - completed_width;
                 char_h = _font_properties->height;
 
                 // Multiply the width by percentage done to determine the scissoring dimensions
                 char_w = static_cast<int32>(cur_percent * char_w);
                 VideoManager->MoveRelative(VideoManager->_current_context.coordinate_system.GetHorizontalDirection()
-                                           * TextManager->CalculateTextWidth(_text_style.font, substring), 0.0f);
+                                           * completed_width, 0.0f);
 
                 // Construct the scissor rectangle using the character dimensions and draw the revealing character
                 VideoManager->PushState();
@@ -608,7 +620,7 @@ void TextBox::_DrawTextLines(float text_x, float text_y, ScreenRect scissor_rect
                 scissor_rect.Intersect(char_scissor_rect);
                 VideoManager->EnableScissoring();
                 VideoManager->SetScissorRect(scissor_rect);
-                TextManager->Draw(cur_char_string, _text_style);
+                TextManager->Draw(_text[line], _text_style, num_completed_chars, 1);
                 VideoManager->PopState();
             }
             // In the else case, the current character is before the line, so we don't draw anything for this line at all
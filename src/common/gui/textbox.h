@@ -247,6 +247,12 @@ private:
     //! \brief The unedited text for reformatting
     hoa_utils::ustring _text_save;
 
+    /** \brief The horizontal position of each character of each line of text, in pixels.
+    *** Each line holds one more offset than it has characters, the last one being the width of the line.
+    *** These are computed once when the text is formatted, so that drawing never has to measure text.
+    **/
+    std::vector<std::vector<int32> > _char_offsets;
+
     /** \brief Returns true if the given unicode character can be interrupted for a word wrap.
     *** \param character The character you wish to check.
     *** \return True if character can be wrapped, false if it can not.
@@ -273,6 +279,9 @@ private:
     **/
     void _ReformatText();
 
+    //! \brief Computes the character offsets of every line of text, once the lines are formatted.
+    void _CalculateCharOffsets();
+
     /** \brief Draws an outline of the element boundaries
     *** \note This function also draws an outline for each line of text in addition to the textbox
     *** as a whole.
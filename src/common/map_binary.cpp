@@ -0,0 +1,474 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012 by Bertram
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    map_binary.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fre
+*** \brief   Source file for the binary map data files
+*** ***************************************************************************/
+
+#include "map_binary.h"
+
+#include "engine/script/script_read.h"
+
+#include <cstring>
+#include <fstream>
+#include <sys/stat.h>
+
+using namespace hoa_utils;
+using namespace hoa_script;
+
+namespace hoa_common
+{
+
+//! \brief The first value of a binary map file: "VTMB" read as a 32 bits value.
+const uint32 MAP_BINARY_MAGIC = 0x424D5456;
+
+//! \brief The version of the binary map file format, to increase each time it changes.
+const uint32 MAP_BINARY_VERSION = 3;
+
+//! \brief A sanity limit for the number of elements of any table found in a binary map file.
+const uint32 MAP_BINARY_MAX_ELEMENTS = 1 << 24;
+
+namespace
+{
+
+//! \brief Returns the directory where the binary files of the maps without an up to date one are saved.
+std::string _GetUserCacheDirectory()
+{
+    return GetUserDataPath() + "map_cache/";
+}
+
+//! \brief A map Lua file, whose checksum is only computed when needed
+struct _LuaFile {
+    std::string filename;
+    uint32 size;
+    uint32 modification_time;
+    bool checksum_computed;
+    uint64_t checksum;
+};
+
+//! \brief Gets the size and modification time of a map Lua file, returns false if it doesn't exist.
+bool _StatLuaFile(const std::string &filename, _LuaFile &lua_file)
+{
+    struct stat buf;
+    if(stat(filename.c_str(), &buf) != 0)
+        return false;
+
+    lua_file.filename = filename;
+    lua_file.size = static_cast<uint32>(buf.st_size);
+    lua_file.modification_time = static_cast<uint32>(buf.st_mtime);
+    lua_file.checksum_computed = false;
+    lua_file.checksum = 0;
+    return true;
+}
+
+//! \brief Computes the checksum of a map Lua file if not already done, returns false if it can't be read.
+bool _ComputeLuaChecksum(_LuaFile &lua_file)
+{
+    if(lua_file.checksum_computed)
+        return true;
+
+    std::ifstream file(lua_file.filename.c_str(), std::ios::in | std::ios::binary);
+    if(!file)
+        return false;
+
+    std::vector<char> text(lua_file.size);
+    if(lua_file.size > 0 && !file.read(&text[0], lua_file.size))
+        return false;
+
+    lua_file.checksum = ComputeChecksum(text);
+    lua_file.checksum_computed = true;
+    return true;
+}
+
+//! \brief Reads consecutive values from a binary map file loaded in memory
+class _BinaryReader
+{
+public:
+    _BinaryReader(const std::vector<char> &buffer) :
+        _buffer(buffer),
+        _position(0),
+        _valid(true)
+    {}
+
+    uint32 ReadUInt() {
+        uint32 value = 0;
+        _Read(&value, sizeof(value));
+        return value;
+    }
+
+    uint64_t ReadChecksum() {
+        uint64_t value = 0;
+        _Read(&value, sizeof(value));
+        return value;
+    }
+
+    //! \brief Reads a number of elements, which is also checked against the size remaining in the file.
+    uint32 ReadCount(uint32 element_size) {
+        uint32 count = ReadUInt();
+        if(count > MAP_BINARY_MAX_ELEMENTS || static_cast<uint64_t>(count) * element_size > _buffer.size() - _position)
+            _valid = false;
+        return _valid ? count : 0;
+    }
+
+    template <class T> void ReadVector(std::vector<T> &values, uint32 count) {
+        values.resize(count);
+        if(count > 0)
+            _Read(&values[0], count * sizeof(T));
+    }
+
+    bool IsValid() const {
+        return _valid;
+    }
+
+    bool IsAtEnd() const {
+        return _position == _buffer.size();
+    }
+
+private:
+    const std::vector<char> &_buffer;
+    size_t _position;
+    bool _valid;
+
+    void _Read(void *data, size_t size) {
+        if(!_valid || size > _buffer.size() - _position) {
+            _valid = false;
+            return;
+        }
+        memcpy(data, &_buffer[_position], size);
+        _position += size;
+    }
+}; // class _BinaryReader
+
+template <class T> void _WriteValue(std::ofstream &file, T value)
+{
+    file.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <class T> void _WriteVector(std::ofstream &file, const std::vector<T> &values)
+{
+    _WriteValue<uint32>(file, values.size());
+    if(!values.empty())
+        file.write(reinterpret_cast<const char *>(&values[0]), values.size() * sizeof(T));
+}
+
+//! \brief Loads a binary map file, returns false if it doesn't exist, is invalid or doesn't match the Lua file.
+bool _LoadBinaryFile(MapBinaryData &data, const std::string &binary_filename, _LuaFile &lua_file)
+{
+    // The whole file is read at once and then parsed from memory
+    std::ifstream file(binary_filename.c_str(), std::ios::in | std::ios::binary);
+    if(!file)
+        return false;
+    std::vector<char> buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+
+    _BinaryReader reader(buffer);
+
+    // Ignore the files made by another version or from another Lua file
+    if(reader.ReadUInt() != MAP_BINARY_MAGIC || reader.ReadUInt() != MAP_BINARY_VERSION)
+        return false;
+    if(reader.ReadUInt() != lua_file.size)
+        return false;
+    uint32 modification_time = reader.ReadUInt();
+    uint64_t checksum = reader.ReadChecksum();
+    if(!reader.IsValid())
+        return false;
+
+    // The checksum is only computed when the modification times differ
+    if(modification_time != lua_file.modification_time) {
+        if(!_ComputeLuaChecksum(lua_file) || lua_file.checksum != checksum)
+            return false;
+    }
+
+    data.num_tile_rows = reader.ReadUInt();
+    data.num_tile_cols = reader.ReadUInt();
+    if(static_cast<uint64_t>(data.num_tile_rows) * data.num_tile_cols > MAP_BINARY_MAX_ELEMENTS) {
+        data.Clear();
+        return false;
+    }
+
+    uint32 num_tiles = data.num_tile_rows * data.num_tile_cols;
+
+    reader.ReadVector(data.context_inherits, reader.ReadCount(sizeof(int32)));
+
+    uint32 num_layers = reader.ReadCount(sizeof(uint32) + num_tiles * sizeof(int32));
+    data.layer_types.resize(num_layers);
+    data.layer_tiles.resize(num_layers);
+    for(uint32 i = 0; i < num_layers && reader.IsValid(); ++i) {
+        std::vector<char> type;
+        reader.ReadVector(type, reader.ReadCount(sizeof(char)));
+        data.layer_types[i].assign(type.begin(), type.end());
+        reader.ReadVector(data.layer_tiles[i], num_tiles);
+    }
+
+    data.context_data.resize(data.context_inherits.size());
+    for(uint32 i = 1; i < data.context_data.size() && reader.IsValid(); ++i)
+        reader.ReadVector(data.context_data[i], reader.ReadCount(sizeof(int32)));
+
+    data.num_grid_rows = reader.ReadUInt();
+    data.num_grid_cols = reader.ReadUInt();
+    if(static_cast<uint64_t>(data.num_grid_rows) * data.num_grid_cols > MAP_BINARY_MAX_ELEMENTS) {
+        data.Clear();
+        return false;
+    }
+    reader.ReadVector(data.collision_grid, data.num_grid_rows * data.num_grid_cols);
+
+    if(!reader.IsValid() || !reader.IsAtEnd()) {
+        data.Clear();
+        return false;
+    }
+    return true;
+} // bool _LoadBinaryFile(MapBinaryData &data, const std::string &binary_filename, _LuaFile &lua_file)
+
+//! \brief Saves a binary map file, returns false if it couldn't be written.
+bool _SaveBinaryFile(const MapBinaryData &data, const std::string &binary_filename, _LuaFile &lua_file)
+{
+    if(!_ComputeLuaChecksum(lua_file))
+        return false;
+
+    std::ofstream file(binary_filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if(!file)
+        return false;
+
+    _WriteValue<uint32>(file, MAP_BINARY_MAGIC);
+    _WriteValue<uint32>(file, MAP_BINARY_VERSION);
+    _WriteValue<uint32>(file, lua_file.size);
+    _WriteValue<uint32>(file, lua_file.modification_time);
+    _WriteValue<uint64_t>(file, lua_file.checksum);
+
+    _WriteValue<uint32>(file, data.num_tile_rows);
+    _WriteValue<uint32>(file, data.num_tile_cols);
+
+    _WriteVector(file, data.context_inherits);
+
+    _WriteValue<uint32>(file, data.layer_tiles.size());
+    for(uint32 i = 0; i < data.layer_tiles.size(); ++i) {
+        std::vector<char> type(data.layer_types[i].begin(), data.layer_types[i].end());
+        _WriteVector(file, type);
+        // The tiles count is known from the map dimensions
+        if(!data.layer_tiles[i].empty())
+            file.write(reinterpret_cast<const char *>(&data.layer_tiles[i][0]), data.layer_tiles[i].size() * sizeof(int32));
+    }
+
+    for(uint32 i = 1; i < data.context_inherits.size(); ++i) {
+        if(i < data.context_data.size())
+            _WriteVector(file, data.context_data[i]);
+        else
+            _WriteValue<uint32>(file, 0);
+    }
+
+    _WriteValue<uint32>(file, data.num_grid_rows);
+    _WriteValue<uint32>(file, data.num_grid_cols);
+    if(!data.collision_grid.empty())
+        file.write(reinterpret_cast<const char *>(&data.collision_grid[0]), data.collision_grid.size() * sizeof(uint32));
+
+    file.close();
+
+    // A partly written file would be rejected anyway, but is better removed
+    if(file.fail()) {
+        DeleteFile(binary_filename);
+        return false;
+    }
+    return true;
+} // bool _SaveBinaryFile(const MapBinaryData &data, const std::string &binary_filename, _LuaFile &lua_file)
+
+} // anonymous namespace
+
+
+
+MapBinaryData::MapBinaryData() :
+    num_tile_rows(0),
+    num_tile_cols(0),
+    num_grid_rows(0),
+    num_grid_cols(0)
+{}
+
+
+
+std::string MapBinaryData::GetBinaryFilename(const std::string &lua_filename)
+{
+    std::string filename = lua_filename;
+    size_t extension = filename.rfind(".lua");
+    if(extension != std::string::npos && extension == filename.size() - 4)
+        filename.erase(extension);
+    return filename + ".bin";
+}
+
+
+
+std::string MapBinaryData::GetUserCacheFilename(const std::string &lua_filename)
+{
+    std::string name = GetBinaryFilename(lua_filename);
+    for(uint32 i = 0; i < name.size(); ++i) {
+        if(name[i] == '/' || name[i] == '\\')
+            name[i] = '_';
+    }
+    return _GetUserCacheDirectory() + name;
+}
+
+
+
+bool MapBinaryData::Load(const std::string &lua_filename)
+{
+    Clear();
+
+    _LuaFile lua_file;
+    if(!_StatLuaFile(lua_filename, lua_file))
+        return false;
+
+    // The file shipped with the map comes first, then the one saved on a previous run
+    return _LoadBinaryFile(*this, GetBinaryFilename(lua_filename), lua_file)
+           || _LoadBinaryFile(*this, GetUserCacheFilename(lua_filename), lua_file);
+}
+
+
+
+bool MapBinaryData::Read(ReadScriptDescriptor &map_file)
+{
+    Clear();
+
+    num_tile_rows = map_file.ReadUInt("num_tile_rows");
+    num_tile_cols = map_file.ReadUInt("num_tile_cols");
+    if(static_cast<uint64_t>(num_tile_rows) * num_tile_cols > MAP_BINARY_MAX_ELEMENTS) {
+        PRINT_ERROR << "Invalid map dimensions in map file: " << map_file.GetFilename() << std::endl;
+        Clear();
+        return false;
+    }
+    uint32 num_tiles = num_tile_rows * num_tile_cols;
+
+    map_file.OpenTable("contexts");
+    uint32 num_contexts = map_file.GetTableSize();
+    for(uint32 context_id = 0; context_id < num_contexts; ++context_id) {
+        map_file.OpenTable(context_id);
+        context_inherits.push_back(map_file.ReadInt("inherit_from"));
+        map_file.CloseTable();
+    }
+    map_file.CloseTable(); // contexts
+
+    if(!map_file.DoesTableExist("layers")) {
+        PRINT_ERROR << "No 'layers' table in the map file: " << map_file.GetFilename() << std::endl;
+        Clear();
+        return false;
+    }
+
+    map_file.OpenTable("layers");
+    uint32 num_layers = map_file.GetTableSize();
+    layer_types.resize(num_layers);
+    layer_tiles.resize(num_layers);
+    for(uint32 layer_id = 0; layer_id < num_layers; ++layer_id) {
+        // A missing layer is kept empty, and ignored because of its invalid type
+        if(!map_file.DoesTableExist(layer_id)) {
+            layer_tiles[layer_id].assign(num_tiles, -1);
+            continue;
+        }
+
+        map_file.OpenTable(layer_id);
+        layer_types[layer_id] = map_file.ReadString("type");
+
+        uint32 rows = 0;
+        uint32 columns = 0;
+        if(!map_file.ReadIntGrid(layer_tiles[layer_id], rows, columns)) {
+            PRINT_ERROR << "the layers[" << layer_id << "] table rows weren't all arrays of tile indeces of the same size" << std::endl;
+            map_file.CloseTable(); // layers[layer_id]
+            map_file.CloseTable(); // layers
+            Clear();
+            return false;
+        }
+
+        // Check to make sure tables are of the proper size
+        if(rows < num_tile_rows) {
+            PRINT_ERROR << "the layers[" << layer_id << "] table size was not equal to the number of tile rows specified by the map, "
+                        " first missing row: " << rows << std::endl;
+            map_file.CloseTable(); // layers[layer_id]
+            map_file.CloseTable(); // layers
+            Clear();
+            return false;
+        }
+
+        if(columns != num_tile_cols) {
+            PRINT_ERROR << "the layers[" << layer_id << "] rows size was not equal to the number of tile columns specified by the map, "
+                        "should have " << num_tile_cols << " values." << std::endl;
+            map_file.CloseTable(); // layers[layer_id]
+            map_file.CloseTable(); // layers
+            Clear();
+            return false;
+        }
+
+        // The rows in excess are ignored
+        layer_tiles[layer_id].resize(num_tiles);
+        map_file.CloseTable(); // layers[layer_id]
+    }
+    map_file.CloseTable(); // layers
+
+    context_data.resize(num_contexts);
+    for(uint32 context_id = 1; context_id < num_contexts; ++context_id) {
+        std::string context_name = "context_";
+        if(context_id < 10)  // precede single digit context names with a zero
+            context_name += "0";
+        context_name += NumberToString(context_id);
+        map_file.ReadIntArray(context_name, context_data[context_id]);
+    }
+
+    if(!map_file.DoesTableExist("map_grid")) {
+        PRINT_ERROR << "No map grid found in map file: " << map_file.GetFilename() << std::endl;
+        Clear();
+        return false;
+    }
+
+    if(!map_file.ReadUIntGrid("map_grid", collision_grid, num_grid_rows, num_grid_cols)
+            || static_cast<uint64_t>(num_grid_rows) * num_grid_cols > MAP_BINARY_MAX_ELEMENTS) {
+        PRINT_ERROR << "Invalid map grid found in map file: " << map_file.GetFilename() << std::endl;
+        Clear();
+        return false;
+    }
+    return true;
+} // bool MapBinaryData::Read(ReadScriptDescriptor &map_file)
+
+
+
+bool MapBinaryData::Save(const std::string &lua_filename) const
+{
+    _LuaFile lua_file;
+    if(!_StatLuaFile(lua_filename, lua_file))
+        return false;
+
+    return _SaveBinaryFile(*this, GetBinaryFilename(lua_filename), lua_file);
+}
+
+
+
+bool MapBinaryData::SaveInUserCache(const std::string &lua_filename) const
+{
+    _LuaFile lua_file;
+    if(!_StatLuaFile(lua_filename, lua_file))
+        return false;
+
+    if(!MakeDirectory(_GetUserCacheDirectory()))
+        return false;
+
+    return _SaveBinaryFile(*this, GetUserCacheFilename(lua_filename), lua_file);
+}
+
+
+
+void MapBinaryData::Clear()
+{
+    num_tile_rows = 0;
+    num_tile_cols = 0;
+    context_inherits.clear();
+    layer_types.clear();
+    layer_tiles.clear();
+    context_data.clear();
+    num_grid_rows = 0;
+    num_grid_cols = 0;
+    collision_grid.clear();
+}
+
+} // namespace hoa_common
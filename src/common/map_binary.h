@@ -0,0 +1,124 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012 by Bertram
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    map_binary.h
+*** \author  Yohann Ferreira, yohann ferreira orange fre
+*** \brief   Header file for the binary map data files
+***
+*** The tile layers, contexts and collision grid of a map are by far the biggest
+*** part of its Lua file and are slow to read through the script engine, one
+*** element at a time. The map editor thus also saves them in a binary file,
+*** next to the map Lua file, which the map mode reads in a single pass when it
+*** is present and matches the Lua file it was made from. When it isn't, the
+*** map mode reads the data from the Lua file and saves it in the user map cache
+*** directory, so that it is read from there the next times.
+***
+*** A binary file matches its Lua file when they have the same size, and the
+*** same modification time or checksum. The checksum lets the files made before
+*** installing the game be used even though the installation changed the Lua
+*** files modification times.
+***
+*** The file is made of 32 bits values in the byte order of the machine which
+*** wrote it, the magic number permitting to reject files from other machines:
+*** - The header: magic number, format version, size, modification time and 64 bits checksum of the Lua file.
+*** - The number of tile rows and columns.
+*** - The number of contexts, followed by the inheritance of each context.
+*** - The number of layers, followed for each layer by the length and characters of its type name,
+***   and its tiles (row by row) for the base context.
+*** - For each context but the base one, the number of values and the values of its context data,
+***   in the same (layer, y, x, tile) groups as the Lua context_XX tables.
+*** - The number of rows and columns of the collision grid, followed by the grid values row by row.
+*** ***************************************************************************/
+
+#ifndef __MAP_BINARY_HEADER__
+#define __MAP_BINARY_HEADER__
+
+#include "utils.h"
+
+namespace hoa_script
+{
+class ReadScriptDescriptor;
+}
+
+namespace hoa_common
+{
+
+/** ****************************************************************************
+*** \brief The map data stored in a binary map file
+***
+*** The data is kept in the same form as in the map Lua file, so that the map
+*** mode can handle it the same way whatever the file it comes from.
+*** ***************************************************************************/
+class MapBinaryData
+{
+public:
+    MapBinaryData();
+
+    //! \brief Returns the binary file name corresponding to the given map Lua file name.
+    static std::string GetBinaryFilename(const std::string &lua_filename);
+
+    //! \brief Returns the binary file name of the given map Lua file in the user map cache directory.
+    static std::string GetUserCacheFilename(const std::string &lua_filename);
+
+    /** \brief Loads the binary file of the given map Lua file
+    *** \param lua_filename The name of the map Lua file
+    *** \return False if neither the binary file next to the Lua file nor the one in the
+    *** user map cache exists, is valid and matches the Lua file. The data is left empty in that case.
+    **/
+    bool Load(const std::string &lua_filename);
+
+    /** \brief Reads the data from the tables of a map Lua file
+    *** \param map_file The map Lua file, with its tablespace open
+    *** \return False if the tables are missing or invalid. The data is left empty in that case.
+    **/
+    bool Read(hoa_script::ReadScriptDescriptor &map_file);
+
+    /** \brief Saves the data in the binary file of the given map Lua file
+    *** \param lua_filename The name of the map Lua file, which must be already saved.
+    *** \return False if the file couldn't be written.
+    **/
+    bool Save(const std::string &lua_filename) const;
+
+    /** \brief Saves the data in the binary file of the given map Lua file in the user map cache
+    *** \param lua_filename The name of the map Lua file.
+    *** \return False if the file couldn't be written.
+    **/
+    bool SaveInUserCache(const std::string &lua_filename) const;
+
+    //! \brief Empties the data.
+    void Clear();
+
+    //! \brief The map dimensions, in tiles.
+    uint32 num_tile_rows;
+    uint32 num_tile_cols;
+
+    //! \brief The context each context inherits from, or -1 for none.
+    std::vector<int32> context_inherits;
+
+    //! \brief The type name of each layer, as written in the map Lua file ("ground", "sky").
+    std::vector<std::string> layer_types;
+
+    //! \brief The tiles of each layer in the base context, row by row.
+    std::vector<std::vector<int32> > layer_tiles;
+
+    //! \brief The context data of each context, the one of the base context being always empty.
+    std::vector<std::vector<int32> > context_data;
+
+    //! \brief The collision grid dimensions.
+    uint32 num_grid_rows;
+    uint32 num_grid_cols;
+
+    //! \brief The collision grid values, row by row.
+    std::vector<uint32> collision_grid;
+}; // class MapBinaryData
+
+} // namespace hoa_common
+
+#endif // __MAP_BINARY_HEADER__
@@ -102,7 +102,7 @@ class TexSheet;
 class FixedTexSheet;
 class VariableTexSheet;
 class FixedTexNode;
-class VariableTexNode;
+class VariableTexRect;
 
 class ImageMemory;
 
@@ -115,6 +115,9 @@ class ImageElement;
 
 class ScreenFader;
 class ShakeForce;
+
+class Transform2D;
+class SpriteBatcher;
 }
 }
 
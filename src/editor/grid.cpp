@@ -20,12 +20,15 @@
 #include "engine/script/script_write.h"
 #include "engine/script/script_read.h"
 
+#include "common/map_binary.h"
+
 #include <QScrollBar>
 
 #include <sstream>
 #include <iostream>
 
 using namespace hoa_script;
+using namespace hoa_common;
 using namespace hoa_map::private_map;
 using namespace hoa_video;
 
@@ -544,6 +547,14 @@ void Grid::SaveMap()
         return;
     }
 
+    // The tile layers, contexts and collision grid are also saved in the map binary file
+    MapBinaryData map_data;
+    map_data.num_tile_rows = _height;
+    map_data.num_tile_cols = _width;
+    map_data.context_data.resize(_tile_contexts.size());
+    map_data.num_grid_rows = _height * 2;
+    map_data.num_grid_cols = _width * 2;
+
     write_data.WriteLine(BEFORE_TEXT_MARKER);
     write_data.InsertNewLine();
     write_data.WriteComment("Set the namespace according to the map name.");
@@ -581,6 +592,7 @@ void Grid::SaveMap()
         write_data.WriteString("name", _tile_contexts[context_id].name);
         write_data.WriteInt("inherit_from", _tile_contexts[context_id].inherit_from_context_id);
         write_data.EndTable();
+        map_data.context_inherits.push_back(_tile_contexts[context_id].inherit_from_context_id);
     }
     write_data.EndTable();
 
@@ -702,6 +714,8 @@ void Grid::SaveMap()
 
         write_data.WriteIntVector(y * 2,   map_row_north);
         write_data.WriteIntVector(y * 2 + 1, map_row_south);
+        map_data.collision_grid.insert(map_data.collision_grid.end(), map_row_north.begin(), map_row_north.end());
+        map_data.collision_grid.insert(map_data.collision_grid.end(), map_row_south.begin(), map_row_south.end());
         map_row_north.assign(_width * 2, 0);
         map_row_south.assign(_width * 2, 0);
     } // iterate through the rows (y axis) of the layers
@@ -718,6 +732,8 @@ void Grid::SaveMap()
 
         write_data.WriteString("type", getTypeFromLayer(_tile_contexts[0].layers[layer_id].layer_type));
         write_data.WriteString("name", _tile_contexts[0].layers[layer_id].name);
+        map_data.layer_types.push_back(getTypeFromLayer(_tile_contexts[0].layers[layer_id].layer_type));
+        map_data.layer_tiles.push_back(std::vector<int32>());
 
         std::vector<int32> layer_row;
 
@@ -726,6 +742,7 @@ void Grid::SaveMap()
                 layer_row.push_back(_tile_contexts[0].layers[layer_id].tiles[y][x]);
             } // iterate through the columns of the lower layer
             write_data.WriteIntVector(y, layer_row);
+            map_data.layer_tiles.back().insert(map_data.layer_tiles.back().end(), layer_row.begin(), layer_row.end());
             layer_row.clear();
         } // iterate through the rows of each layer
 
@@ -779,6 +796,7 @@ void Grid::SaveMap()
 
             write_data.WriteIntVector(context.str(), context_data);
             write_data.InsertNewLine();
+            map_data.context_data[context_id].swap(context_data);
             context_data.clear();
         } // write the vector if it has data in it
     } // iterate through all contexts of all layers, assuming all layers have same number of contexts
@@ -791,6 +809,10 @@ void Grid::SaveMap()
 
     write_data.CloseFile();
 
+    // The binary file must be written after the Lua file, as it keeps track of the Lua file it was made from
+    if(!map_data.Save(std::string(_file_name.toAscii())))
+        QMessageBox::warning(this, "Saving File...", QString("ERROR: could not write the binary map file of %1!").arg(_file_name));
+
     _changed = false;
 } // Grid::SaveMap()
 
@@ -1161,6 +1183,9 @@ void Grid::paintGL()
 
     if(_debug_textures_on)
         VideoManager->Textures()->DEBUG_ShowTexSheet();
+
+    // Draw the images still waiting in the sprite batch
+    VideoManager->FlushSprites();
 } // void Grid::paintGL()
 
 
@@ -19,6 +19,7 @@
 *** \note This code uses the OpenAL audio library. See http://www.openal.com/
 *** ***************************************************************************/
 #include <iostream>
+#include <algorithm>
 
 #include "engine/audio/audio.h"
 #include "engine/system.h"
@@ -46,7 +47,11 @@ AudioEngine::AudioEngine() :
     _context(0),
     _max_sources(MAX_DEFAULT_AUDIO_SOURCES),
     _active_music(NULL),
-    _max_cache_size(MAX_DEFAULT_AUDIO_SOURCES / 4)
+    _max_cache_size(MAX_DEFAULT_AUDIO_SOURCES / 4),
+    _streaming_thread(NULL),
+    _streaming_thread_done(false),
+    _streams_semaphore(NULL),
+    _decoding_stream(NULL)
 {}
 
 bool AudioEngine::SingletonInitialize()
@@ -143,6 +148,14 @@ bool AudioEngine::SingletonInitialize()
         return false;
     }
 
+    // Start decoding the streaming audio in the background
+    _streams_semaphore = SystemManager->CreateSemaphore(1);
+#if (THREAD_TYPE == SDL_THREADS)
+    _streaming_thread = SystemManager->SpawnThread(&AudioEngine::_StreamAudio, this);
+    if(_streaming_thread == NULL)
+        IF_PRINT_WARNING(AUDIO_DEBUG) << "failed to create the streaming thread, streams will be decoded when played" << std::endl;
+#endif
+
     return true;
 } // bool AudioEngine::SingletonInitialize()
 
@@ -151,6 +164,13 @@ AudioEngine::~AudioEngine()
     if(!AUDIO_ENABLE)
         return;
 
+    // Stop the streaming thread before any stream gets deleted
+    if(_streaming_thread != NULL) {
+        _streaming_thread_done = true;
+        SystemManager->WaitForThread(_streaming_thread);
+        _streaming_thread = NULL;
+    }
+
     // Delete all entries in the sound cache
     for(std::map<std::string, private_audio::AudioCacheElement>::iterator i = _audio_cache.begin(); i != _audio_cache.end(); i++) {
         delete i->second.audio;
@@ -200,6 +220,9 @@ AudioEngine::~AudioEngine()
         }
     }
 
+    if(_streams_semaphore != NULL)
+        SystemManager->DestroySemaphore(_streams_semaphore);
+
     alcMakeContextCurrent(0);
     alcDestroyContext(_context);
     alcCloseDevice(_device);
@@ -217,6 +240,51 @@ void AudioEngine::Update()
     }
 }
 
+void AudioEngine::_AddStream(AudioStream *stream)
+{
+    SystemManager->LockThread(_streams_semaphore);
+    _streams.push_back(stream);
+    SystemManager->UnlockThread(_streams_semaphore);
+}
+
+void AudioEngine::_RemoveStream(AudioStream *stream)
+{
+    SystemManager->LockThread(_streams_semaphore);
+    std::vector<AudioStream *>::iterator it = std::find(_streams.begin(), _streams.end(), stream);
+    if(it != _streams.end())
+        _streams.erase(it);
+
+    // Waits for the streaming thread to be done with the stream, if it is decoding it
+    while(_decoding_stream == stream) {
+        SystemManager->UnlockThread(_streams_semaphore);
+        SDL_Delay(1);
+        SystemManager->LockThread(_streams_semaphore);
+    }
+    SystemManager->UnlockThread(_streams_semaphore);
+}
+
+void AudioEngine::_StreamAudio()
+{
+    while(!_streaming_thread_done) {
+        // The list is only locked between two streams, so that adding or removing
+        // a stream never waits for all of them to be decoded
+        SystemManager->LockThread(_streams_semaphore);
+        for(uint32 i = 0; i < _streams.size(); ++i) {
+            AudioStream *stream = _streams[i];
+            _decoding_stream = stream;
+            SystemManager->UnlockThread(_streams_semaphore);
+
+            stream->DecodeAhead();
+
+            SystemManager->LockThread(_streams_semaphore);
+            _decoding_stream = NULL;
+        }
+        SystemManager->UnlockThread(_streams_semaphore);
+
+        SDL_Delay(AUDIO_STREAMING_THREAD_DELAY);
+    }
+}
+
 void AudioEngine::SetSoundVolume(float volume)
 {
     if(volume < 0.0f) {
@@ -28,6 +28,8 @@
 #include "audio_descriptor.h"
 #include "audio_effects.h"
 
+#include "engine/system.h"
+
 #ifdef __MACH__
 #include <OpenAL/al.h>
 #include <OpenAL/alc.h>
@@ -58,6 +60,9 @@ namespace private_audio
 //! \brief The maximum default number of audio sources that the engine tries to create
 const uint16 MAX_DEFAULT_AUDIO_SOURCES = 64;
 
+//! \brief The number of milliseconds the streaming thread waits between two passes over the audio streams
+const uint32 AUDIO_STREAMING_THREAD_DELAY = 10;
+
 
 
 //! \brief A container class for an element of the LRU audio cache managed by the AudioEngine class
@@ -409,6 +414,33 @@ private:
     **/
     uint16 _max_cache_size;
 
+    /** \brief The thread decoding the audio streams in advance
+    *** Streaming audio is decoded by this thread into the ring buffer of each stream, so that
+    *** the game thread only has to copy the decoded data when refilling the OpenAL buffers.
+    **/
+    Thread *_streaming_thread;
+
+    //! \brief Set to true to make the streaming thread exit
+    volatile bool _streaming_thread_done;
+
+    //! \brief All the audio streams currently loaded, which the streaming thread decodes
+    std::vector<private_audio::AudioStream *> _streams;
+
+    //! \brief Protects the _streams list and _decoding_stream
+    Semaphore *_streams_semaphore;
+
+    //! \brief The stream the streaming thread is decoding, if any
+    private_audio::AudioStream *_decoding_stream;
+
+    //! \brief Adds or removes a stream from those decoded by the streaming thread
+    //@{
+    void _AddStream(private_audio::AudioStream *stream);
+    void _RemoveStream(private_audio::AudioStream *stream);
+    //@}
+
+    //! \brief The streaming thread loop, decoding the registered streams until _streaming_thread_done is set
+    void _StreamAudio();
+
     /** \brief Acquires an available audio source that may be used
     *** \return A pointer to the available source, or NULL if no available source could be found
     *** \todo Add an algoihtm to give priority to some sounds/music over others.
@@ -230,7 +230,8 @@ bool AudioDescriptor::LoadAudio(const std::string &filename, AUDIO_LOAD load_typ
     // Stream the audio from the file data
     else if(load_type == AUDIO_LOAD_STREAM_FILE) {
         _buffer = new AudioBuffer[NUMBER_STREAMING_BUFFERS]; // For streaming we need to use multiple buffers
-        _stream = new AudioStream(_input, _looping);
+        _stream = new AudioStream(_input, _looping, stream_buffer_size);
+        AudioManager->_AddStream(_stream);
         _stream_buffer_size = stream_buffer_size;
 
         _data = new uint8[_stream_buffer_size * _input->GetSampleSize()];
@@ -245,16 +246,19 @@ bool AudioDescriptor::LoadAudio(const std::string &filename, AUDIO_LOAD load_typ
     // Allocate memory for the audio data to remain in and stream it from that location
     else if(load_type == AUDIO_LOAD_STREAM_MEMORY) {
         _buffer = new AudioBuffer[NUMBER_STREAMING_BUFFERS]; // For streaming we need to use multiple buffers
-        _stream = new AudioStream(_input, _looping);
         _stream_buffer_size = stream_buffer_size;
 
         _data = new uint8[_stream_buffer_size * _input->GetSampleSize()];
 
         // We need to replace the _input member with a AudioMemory class object
+        // before the stream is created, so that it doesn't read from the deleted input
         AudioInput *temp_input = _input;
         _input = new AudioMemory(temp_input);
         delete temp_input;
 
+        _stream = new AudioStream(_input, _looping, stream_buffer_size);
+        AudioManager->_AddStream(_stream);
+
         // Attempt to acquire a source for the new audio to use
         _AcquireSource();
         if(_source == NULL) {
@@ -291,21 +295,24 @@ void AudioDescriptor::FreeAudio()
         _source = NULL;
     }
 
+    _free_buffers.clear();
     if(_buffer != NULL) {
         delete[] _buffer;
         _buffer = NULL;
     }
 
-    if(_input != NULL) {
-        delete _input;
-        _input = NULL;
-    }
-
+    // The stream is deleted first, as the streaming thread may be reading from the input
     if(_stream != NULL) {
+        AudioManager->_RemoveStream(_stream);
         delete _stream;
         _stream = NULL;
     }
 
+    if(_input != NULL) {
+        delete _input;
+        _input = NULL;
+    }
+
     if(_data != NULL) {
         delete[] _data;
         _data = NULL;
@@ -729,7 +736,9 @@ void AudioDescriptor::_Update()
         if(AudioManager->CheckALError()) {
             IF_PRINT_WARNING(AUDIO_DEBUG) << "getting the source's state failed: " << AudioManager->CreateALErrorString() << std::endl;
         }
-        if(source_state != AL_PLAYING) {
+        // A stream whose buffers ran dry before the streaming thread decoded more data
+        // is only starved, and is played again once its buffers are refilled below.
+        if(source_state != AL_PLAYING && (!_stream || _stream->GetEndOfStream())) {
             _state = AUDIO_STATE_STOPPED;
         }
     }
@@ -751,7 +760,7 @@ void AudioDescriptor::_Update()
     }
 
     // Only streaming audio that is being played requires periodic updates
-    if(!_stream)
+    if(!_stream || !_source || _state == AUDIO_STATE_STOPPED)
         return;
 
     ALint queued = 0;
@@ -772,35 +781,32 @@ void AudioDescriptor::_Update()
         IF_PRINT_WARNING(AUDIO_DEBUG) << "getting processed sources failed: " << AudioManager->CreateALErrorString() << std::endl;
     }
 
-    // If any buffers have finished playing, attempt to refill them
-    if(buffers_processed > 0) {
+    // The buffers which have finished playing are kept aside until they can be refilled
+    while(buffers_processed > 0) {
         ALuint buffer_finished;
         alSourceUnqueueBuffers(_source->source, 1, &buffer_finished);
         if(AudioManager->CheckALError()) {
             IF_PRINT_WARNING(AUDIO_DEBUG) << "unqueuing a source failed: " << AudioManager->CreateALErrorString() << std::endl;
+            break;
         }
+        _free_buffers.push_back(buffer_finished);
+        --buffers_processed;
+    }
 
-        uint32 size = _stream->FillBuffer(_data, _stream_buffer_size);
-        if(size > 0) {  // Make sure that there is data available to fill
-            alBufferData(buffer_finished, _format, _data, size * _input->GetSampleSize(), _input->GetSamplesPerSecond());
-            if(AudioManager->CheckALError()) {
-                IF_PRINT_WARNING(AUDIO_DEBUG) << "buffering data failed: " << AudioManager->CreateALErrorString() << std::endl;
-            }
-            alSourceQueueBuffers(_source->source, 1, &buffer_finished);
-            if(AudioManager->CheckALError()) {
-                IF_PRINT_WARNING(AUDIO_DEBUG) << "queueing a source failed: " << AudioManager->CreateALErrorString() << std::endl;
-            }
-        }
+    if(_free_buffers.empty())
+        return;
 
-        // This ensures that if a streaming audio piece is stopped because the buffers ran out
-        // of audio data for the source to play, the audio will be automatically replayed again.
-        ALint state;
-        alGetSourcei(_source->source, AL_SOURCE_STATE, &state);
-        if(state != AL_PLAYING) {
-            alSourcePlay(_source->source);
-            if(AudioManager->CheckALError()) {
-                IF_PRINT_WARNING(AUDIO_DEBUG) << "playing a source failed: " << AudioManager->CreateALErrorString() << std::endl;
-            }
+    _QueueStreamingBuffers();
+
+    // This ensures that if a streaming audio piece is stopped because the buffers ran out
+    // of audio data for the source to play, the audio will be automatically replayed again.
+    ALint state;
+    alGetSourcei(_source->source, AL_SOURCE_STATE, &state);
+    alGetSourcei(_source->source, AL_BUFFERS_QUEUED, &queued);
+    if(state != AL_PLAYING && queued > 0) {
+        alSourcePlay(_source->source);
+        if(AudioManager->CheckALError()) {
+            IF_PRINT_WARNING(AUDIO_DEBUG) << "playing a source failed: " << AudioManager->CreateALErrorString() << std::endl;
         }
     }
 } // void AudioDescriptor::_Update()
@@ -944,25 +950,37 @@ void AudioDescriptor::_PrepareStreamingBuffers()
     }
     alSourcei(_source->source, AL_BUFFER, 0);
 
-    // Fill each buffer with audio data
-    for(uint32 i = 0; i < NUMBER_STREAMING_BUFFERS; i++) {
-        uint32 read = _stream->FillBuffer(_data, _stream_buffer_size);
-        if(read > 0) {
-            _buffer[i].FillBuffer(_data, _format, read * _input->GetSampleSize(), _input->GetSamplesPerSecond());
-            if(_source != NULL)
-                alSourceQueueBuffers(_source->source, 1, &_buffer[i].buffer);
-        }
-    }
-
-    if(AudioManager->CheckALError()) {
-        IF_PRINT_WARNING(AUDIO_DEBUG) << "failed to fill all buffers: " << AudioManager->CreateALErrorString() << std::endl;
-    }
+    // Fill each buffer with the audio data already decoded. After a seek, the streaming
+    // thread may not have decoded anything yet: the buffers are then filled by _Update().
+    _free_buffers.clear();
+    for(uint32 i = 0; i < NUMBER_STREAMING_BUFFERS; i++)
+        _free_buffers.push_back(_buffer[i].buffer);
+    _QueueStreamingBuffers();
 
     if(was_playing) {
         Play();
     }
 }
 
+
+
+void AudioDescriptor::_QueueStreamingBuffers()
+{
+    while(!_free_buffers.empty()) {
+        uint32 read = _stream->FillBuffer(_data, _stream_buffer_size);
+        if(read == 0)
+            break;
+
+        ALuint buffer = _free_buffers.front();
+        alBufferData(buffer, _format, _data, read * _input->GetSampleSize(), _input->GetSamplesPerSecond());
+        alSourceQueueBuffers(_source->source, 1, &buffer);
+        if(AudioManager->CheckALError()) {
+            IF_PRINT_WARNING(AUDIO_DEBUG) << "failed to fill and queue a buffer: " << AudioManager->CreateALErrorString() << std::endl;
+        }
+        _free_buffers.erase(_free_buffers.begin());
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // SoundDescriptor class methods
 ////////////////////////////////////////////////////////////////////////////////
@@ -377,6 +377,9 @@ protected:
     //! \brief A pointer to where the data is streamed to
     uint8 *_data;
 
+    //! \brief The streaming buffers which are not queued on the source, waiting for decoded data
+    std::vector<ALuint> _free_buffers;
+
     //! \brief The format of the audio (mono/stereo, 8/16 bits per second).
     ALenum _format;
 
@@ -460,6 +463,12 @@ private:
     *** ones must be refilled. This function should only be called for streaming audio.
     **/
     void _PrepareStreamingBuffers();
+
+    /** \brief Fills the free streaming buffers with the decoded data and queues them on the source
+    *** The buffers are only filled with the data the streaming thread has already decoded. Those
+    *** it had no data for yet stay in _free_buffers and are filled at a later update.
+    **/
+    void _QueueStreamingBuffers();
 }; // class AudioDescriptor
 
 
@@ -21,7 +21,11 @@
 
 #include "audio_input.h"
 
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
+
+using namespace hoa_system;
 
 namespace hoa_audio
 {
@@ -29,13 +33,23 @@ namespace hoa_audio
 namespace private_audio
 {
 
-AudioStream::AudioStream(AudioInput *input, bool loop) :
+AudioStream::AudioStream(AudioInput *input, bool loop, uint32 buffer_size) :
     _audio_input(input),
     _looping(loop),
     _loop_start_position(0),
     _loop_end_position(0),
     _read_position(0),
-    _end_of_stream(false)
+    _end_of_stream(false),
+    _buffer_size(buffer_size),
+    _decoded_data(NULL),
+    _decoded_capacity(0),
+    _decoded_start(0),
+    _decoded_size(0),
+    _decoded_end(false),
+    _decoded_position(0),
+    _decode_buffer(NULL),
+    _input_semaphore(NULL),
+    _data_semaphore(NULL)
 {
     if(_audio_input == NULL) {
         PRINT_ERROR << "input argument was NULL -- terminating program" << std::endl;
@@ -44,36 +58,75 @@ AudioStream::AudioStream(AudioInput *input, bool loop) :
 
     // Loop end is initially set to the final sample
     _loop_end_position = _audio_input->GetTotalNumberSamples();
+
+    _decoded_capacity = AUDIO_STREAM_DECODED_BUFFERS * _buffer_size * _audio_input->GetSampleSize();
+    _decoded_data = new uint8[_decoded_capacity];
+    _decode_buffer = new uint8[_buffer_size * _audio_input->GetSampleSize()];
+
+    _input_semaphore = SystemManager->CreateSemaphore(1);
+    _data_semaphore = SystemManager->CreateSemaphore(1);
+}
+
+
+
+AudioStream::~AudioStream()
+{
+    SystemManager->DestroySemaphore(_input_semaphore);
+    SystemManager->DestroySemaphore(_data_semaphore);
+
+    delete[] _decoded_data;
+    delete[] _decode_buffer;
 }
 
 
 
 uint32 AudioStream::FillBuffer(uint8 *buffer, uint32 size)
 {
-    uint32 num_samples_read = 0; // The number of samples which have been read
-    uint32 read_samples; // The number of samples to request the audio input to read
+    uint32 sample_size = _audio_input->GetSampleSize();
+    uint32 bytes = size * sample_size;
 
-    while(num_samples_read < size) {
-        // If looping is enabled and the end of the stream has been reached, seek to the starting position
-        if(_looping == true && (_read_position == _loop_end_position || _read_position == _audio_input->GetTotalNumberSamples())) {
-            _audio_input->Seek(_loop_start_position);
-            _read_position = _loop_start_position;
-        }
+    // Only the streaming thread decodes. If it has not decoded a whole buffer yet,
+    // nothing is read and the caller retries at the next update.
+    uint32 read = 0;
+    SystemManager->LockThread(_data_semaphore);
+    if(_decoded_size >= bytes || _decoded_end)
+        read = _PopDecodedData(buffer, bytes);
+    SystemManager->UnlockThread(_data_semaphore);
 
-        // Determine the number of samples we should request for the input to read
-        uint32 remaining_data = (_looping == true) ? _loop_end_position : _audio_input->GetTotalNumberSamples();
-        remaining_data -= _read_position;
-        read_samples = (size - num_samples_read < remaining_data) ? size - num_samples_read : remaining_data;
-        num_samples_read += _audio_input->Read(buffer + num_samples_read * _audio_input->GetSampleSize(), read_samples, _end_of_stream);
-        _read_position += num_samples_read;
+    return read / sample_size;
+}
 
-        // Detect early exit condition
-        if(_looping == false && _end_of_stream == true) {
-            return num_samples_read;
+
+
+void AudioStream::DecodeAhead()
+{
+    uint32 chunk_size = _buffer_size * _audio_input->GetSampleSize();
+
+    // The input is released after each chunk, so that the game thread never waits for long
+    while(true) {
+        SystemManager->LockThread(_input_semaphore);
+
+        SystemManager->LockThread(_data_semaphore);
+        bool full = _decoded_end || _decoded_capacity - _decoded_size < chunk_size;
+        SystemManager->UnlockThread(_data_semaphore);
+
+        if(full) {
+            SystemManager->UnlockThread(_input_semaphore);
+            return;
         }
-    }
 
-    return num_samples_read;
+        uint32 read = _Decode(_decode_buffer, _buffer_size) * _audio_input->GetSampleSize();
+
+        SystemManager->LockThread(_data_semaphore);
+        _PushDecodedData(_decode_buffer, read);
+        _decoded_end = _end_of_stream;
+        SystemManager->UnlockThread(_data_semaphore);
+
+        SystemManager->UnlockThread(_input_semaphore);
+
+        if(read == 0)
+            return;
+    }
 }
 
 
@@ -83,13 +136,49 @@ void AudioStream::Seek(uint32 sample)
     if(sample >= _audio_input->GetTotalNumberSamples()) {
         IF_PRINT_WARNING(AUDIO_DEBUG) << "tried to seek to position beyond sample range: " << sample << std::endl;
     }
+
+    SystemManager->LockThread(_input_semaphore);
     _audio_input->Seek(sample);
     _read_position = sample;
     _end_of_stream = false;
+
+    // The data decoded in advance is no longer valid
+    SystemManager->LockThread(_data_semaphore);
+    _decoded_start = 0;
+    _decoded_size = 0;
+    _decoded_end = false;
+    _decoded_position = sample;
+    SystemManager->UnlockThread(_data_semaphore);
+    SystemManager->UnlockThread(_input_semaphore);
+}
+
+
+
+void AudioStream::SetLooping(bool loop)
+{
+    SystemManager->LockThread(_input_semaphore);
+    SystemManager->LockThread(_data_semaphore);
+    if(loop != _looping) {
+        _FlushDecodedData();
+        _looping = loop;
+        _end_of_stream = !_looping && _read_position >= _audio_input->GetTotalNumberSamples();
+        _decoded_end = _end_of_stream;
+    }
+    SystemManager->UnlockThread(_data_semaphore);
+    SystemManager->UnlockThread(_input_semaphore);
 }
 
 
 
+bool AudioStream::GetEndOfStream() const
+{
+    SystemManager->LockThread(_data_semaphore);
+    bool end_of_stream = _decoded_end && _decoded_size == 0;
+    SystemManager->UnlockThread(_data_semaphore);
+    return end_of_stream;
+}
+
+
 
 void AudioStream::SetLoopStart(uint32 sample)
 {
@@ -98,7 +187,14 @@ void AudioStream::SetLoopStart(uint32 sample)
         return;
     }
 
-    _loop_start_position = sample;
+    SystemManager->LockThread(_input_semaphore);
+    SystemManager->LockThread(_data_semaphore);
+    if(sample != _loop_start_position) {
+        _FlushDecodedData();
+        _loop_start_position = sample;
+    }
+    SystemManager->UnlockThread(_data_semaphore);
+    SystemManager->UnlockThread(_input_semaphore);
 }
 
 
@@ -110,7 +206,97 @@ void AudioStream::SetLoopEnd(uint32 sample)
         return;
     }
 
-    _loop_end_position = sample;
+    SystemManager->LockThread(_input_semaphore);
+    SystemManager->LockThread(_data_semaphore);
+    if(sample != _loop_end_position) {
+        _FlushDecodedData();
+        _loop_end_position = sample;
+    }
+    SystemManager->UnlockThread(_data_semaphore);
+    SystemManager->UnlockThread(_input_semaphore);
+}
+
+
+
+uint32 AudioStream::_Decode(uint8 *buffer, uint32 size)
+{
+    uint32 num_samples_read = 0; // The number of samples which have been read
+    uint32 read_samples; // The number of samples to request the audio input to read
+
+    while(num_samples_read < size) {
+        // If looping is enabled and the end of the stream has been reached, seek to the starting position
+        if(_looping == true && (_read_position == _loop_end_position || _read_position == _audio_input->GetTotalNumberSamples())) {
+            _audio_input->Seek(_loop_start_position);
+            _read_position = _loop_start_position;
+        }
+
+        // Determine the number of samples we should request for the input to read
+        uint32 remaining_data = (_looping == true) ? _loop_end_position : _audio_input->GetTotalNumberSamples();
+        remaining_data -= _read_position;
+        read_samples = (size - num_samples_read < remaining_data) ? size - num_samples_read : remaining_data;
+        uint32 samples = _audio_input->Read(buffer + num_samples_read * _audio_input->GetSampleSize(), read_samples, _end_of_stream);
+        num_samples_read += samples;
+        _read_position += samples;
+
+        // Detect early exit condition
+        if(_looping == false && _end_of_stream == true) {
+            return num_samples_read;
+        }
+    }
+
+    return num_samples_read;
+}
+
+
+
+void AudioStream::_PushDecodedData(const uint8 *data, uint32 size)
+{
+    uint32 end = (_decoded_start + _decoded_size) % _decoded_capacity;
+    uint32 first_part = std::min(size, _decoded_capacity - end);
+    memcpy(_decoded_data + end, data, first_part);
+    memcpy(_decoded_data, data + first_part, size - first_part);
+    _decoded_size += size;
+}
+
+
+
+uint32 AudioStream::_PopDecodedData(uint8 *data, uint32 size)
+{
+    size = std::min(size, _decoded_size);
+    uint32 first_part = std::min(size, _decoded_capacity - _decoded_start);
+    memcpy(data, _decoded_data + _decoded_start, first_part);
+    memcpy(data + first_part, _decoded_data, size - first_part);
+    _decoded_start = (_decoded_start + size) % _decoded_capacity;
+    _decoded_size -= size;
+
+    // Follows the samples taken the way _Decode() read them, looping included
+    uint32 samples = size / _audio_input->GetSampleSize();
+    uint32 total_samples = _audio_input->GetTotalNumberSamples();
+    while(samples > 0) {
+        if(_looping && (_decoded_position == _loop_end_position || _decoded_position == total_samples))
+            _decoded_position = _loop_start_position;
+
+        uint32 end = _looping ? _loop_end_position : total_samples;
+        if(end <= _decoded_position)
+            break;
+        uint32 step = std::min(samples, end - _decoded_position);
+        _decoded_position += step;
+        samples -= step;
+    }
+    return size;
+}
+
+
+
+void AudioStream::_FlushDecodedData()
+{
+    _audio_input->Seek(_decoded_position);
+    _read_position = _decoded_position;
+    _end_of_stream = !_looping && _read_position >= _audio_input->GetTotalNumberSamples();
+
+    _decoded_start = 0;
+    _decoded_size = 0;
+    _decoded_end = _end_of_stream;
 }
 
 } // namespace private_audio
@@ -32,12 +32,17 @@
 
 #include "audio_input.h"
 
+#include "engine/system.h"
+
 namespace hoa_audio
 {
 
 namespace private_audio
 {
 
+//! \brief The number of streaming buffers worth of audio data decoded ahead by the streaming thread
+const uint32 AUDIO_STREAM_DECODED_BUFFERS = 8;
+
 /** ****************************************************************************
 *** \brief Handles streaming audio from input data sources
 ***
@@ -46,9 +51,19 @@ namespace private_audio
 *** where specific parts of a piece of audio can be looped rather than the
 *** entire audio itself.
 ***
+*** The audio data is decoded ahead of playback by the audio engine streaming
+*** thread (see AudioEngine::_StreamAudio) and kept in a ring buffer, so that
+*** the game thread only has to copy it when an OpenAL buffer needs to be
+*** refilled. When the ring buffer doesn't hold enough data, the missing part
+*** is decoded directly by the caller.
+***
 *** \note The _end_of_stream will never be set to true while the stream has
 *** looping enabled.
 ***
+*** \note Two semaphores protect the stream: _input_semaphore for the input and
+*** the read and loop positions, and _data_semaphore for the ring buffer. When
+*** both are needed, _input_semaphore is always locked first.
+***
 *** \todo Customized looping support is only very rudimentary right now (one
 *** start, one end position). We need full support added to this class to be
 *** able to do operations such as: play section A once, loop section B 3 times,
@@ -61,19 +76,26 @@ public:
     /** \brief Class constructor which initializes the audio stream
     *** \param input A pointer to the AudioInput object which will manage the input data
     *** \param loop If true, enables looping for the audio stream
+    *** \param buffer_size The number of samples read each time a streaming buffer is filled
     **/
-    AudioStream(AudioInput *input, bool loop);
+    AudioStream(AudioInput *input, bool loop, uint32 buffer_size);
 
-    ~AudioStream()
-    {}
+    ~AudioStream();
 
-    /** \brief Fills a buffer with data read from the stream
+    /** \brief Fills a buffer with the data decoded in advance by the streaming thread
     *** \param buffer A pointer to the buffer where the data will be loaded to
     *** \param size The total number of samples to read
     *** \return The number of samples which were read, which may be different from size
+    *** \note This never decodes. It returns 0 when less than size samples were decoded
+    *** yet and the end of the stream wasn't reached, so that the buffer is filled later.
     **/
     uint32 FillBuffer(uint8 *buffer, uint32 size);
 
+    /** \brief Decodes data in advance until the ring buffer is full or the end of the stream is reached
+    *** \note This is called by the streaming thread, one buffer size at a time.
+    **/
+    void DecodeAhead();
+
     /** \brief Seeks the audio stream to the specified sample
     *** \param sample The sample number to seek the stream to
     *** \note This will also automatically invoke the Seek method on the AudioInput object
@@ -88,10 +110,7 @@ public:
     /** \brief Enables/disables looping for this stream
     *** \param loop True to enable looping, false to disable it.
     **/
-    void SetLooping(bool loop) {
-        _looping = loop;
-        if(loop) _end_of_stream = false;
-    }
+    void SetLooping(bool loop);
 
     /** \brief Sets the sample to serve as the start position for looping
     *** \param sample The sample number to be the new starting position
@@ -103,10 +122,8 @@ public:
     **/
     void SetLoopEnd(uint32 sample);
 
-    //! \brief Returns true if the stream has finished playing
-    bool GetEndOfStream() const {
-        return _end_of_stream;
-    }
+    //! \brief Returns true if the stream has finished playing, i.e. all of its data was read
+    bool GetEndOfStream() const;
 
 private:
     //! \brief Pointer to an AudioInput object that holds the audio data
@@ -126,6 +143,61 @@ private:
 
     //! \brief True if the end of the stream was reached, false otherwise
     bool _end_of_stream;
+
+    //! \brief The number of samples decoded at once by the streaming thread
+    uint32 _buffer_size;
+
+    //! \brief The ring buffer holding the data decoded in advance
+    uint8 *_decoded_data;
+
+    //! \brief The size of the ring buffer, in bytes
+    uint32 _decoded_capacity;
+
+    //! \brief The position of the first byte of decoded data in the ring buffer
+    uint32 _decoded_start;
+
+    //! \brief The number of bytes of decoded data available in the ring buffer
+    uint32 _decoded_size;
+
+    //! \brief Set when the decoded data reaches the end of the stream
+    bool _decoded_end;
+
+    //! \brief The sample position of the first decoded sample in the ring buffer
+    uint32 _decoded_position;
+
+    //! \brief The buffer the streaming thread decodes into before copying to the ring buffer
+    uint8 *_decode_buffer;
+
+    //! \brief Protects the input, the read and loop positions and _end_of_stream
+    Semaphore *_input_semaphore;
+
+    //! \brief Protects the ring buffer members
+    Semaphore *_data_semaphore;
+
+    /** \brief Reads data from the input, looping if needed
+    *** \param buffer A pointer to the buffer where the data will be loaded to
+    *** \param size The total number of samples to read
+    *** \return The number of samples which were read
+    *** \note _input_semaphore must be locked by the caller.
+    **/
+    uint32 _Decode(uint8 *buffer, uint32 size);
+
+    /** \brief Adds data at the end of the ring buffer, or takes data from its start
+    *** \param data The data to add, or the buffer to copy the data to
+    *** \param size The number of bytes to add or take
+    *** \return The number of bytes taken
+    *** \note _data_semaphore must be locked by the caller.
+    **/
+    //@{
+    void _PushDecodedData(const uint8 *data, uint32 size);
+    uint32 _PopDecodedData(uint8 *data, uint32 size);
+    //@}
+
+    /** \brief Drops the data decoded in advance, and rewinds the input to the first sample not read yet
+    *** This is needed when the looping settings change, as the data was decoded with the former ones.
+    *** \note Both semaphores must be locked by the caller.
+    **/
+    void _FlushDecodedData();
 }; // class AudioStream
 
 } // namespace private_audio
@@ -127,6 +127,7 @@ void BindEngineCode()
         [
             luabind::class_<ParticleManager>("ParticleManager")
             .def("AddParticleEffect", &ParticleManager::AddParticleEffect)
+            .def("PreloadParticleEffect", &ParticleManager::PreloadParticleEffect)
             .def("StopAll", &ParticleManager::StopAll)
         ];
 
@@ -338,6 +338,10 @@ void InputEngine::_KeyEventHandler(SDL_KeyboardEvent &key_event)
                 // Display and cycle through the texture sheets
                 VideoManager->Textures()->DEBUG_NextTexSheet();
                 return;
+            } else if(key_event.keysym.sym == SDLK_p) {
+                // Toggle the frame profiler and its display
+                hoa_system::SystemManager->EnableProfiling(!hoa_system::SystemManager->IsProfiling());
+                return;
             }
 #endif
 
@@ -41,7 +41,8 @@ const uint32 FADE_IN_OUT_TIME = 800;
 // ***** GameMode class
 // ****************************************************************************
 
-GameMode::GameMode()
+GameMode::GameMode() :
+    _update_count(0)
 {
     IF_PRINT_WARNING(MODE_MANAGER_DEBUG)
             << "MODE MANAGER: GameMode constructor invoked" << std::endl;
@@ -51,7 +52,8 @@ GameMode::GameMode()
 }
 
 
-GameMode::GameMode(uint8 mt)
+GameMode::GameMode(uint8 mt) :
+    _update_count(0)
 {
     IF_PRINT_WARNING(MODE_MANAGER_DEBUG)
             << "MODE MANAGER: GameMode constructor invoked" << std::endl;
@@ -76,6 +78,16 @@ void GameMode::Update()
     _script_supervisor.Update();
     _effect_supervisor.Update(frame_time);
     _particle_manager.Update(frame_time);
+
+    _update_count = hoa_system::SystemManager->GetUpdateCount();
+}
+
+
+float GameMode::GetUpdateInterpolation() const
+{
+    if(_update_count == 0 || _update_count != hoa_system::SystemManager->GetUpdateCount())
+        return 1.0f;
+    return hoa_system::SystemManager->GetUpdateInterpolation();
 }
 
 
@@ -258,7 +270,8 @@ void ModeEngine::Update()
                 _pop_count = 0;
                 break; // Exit the loop
             }
-            delete _game_stack.back();
+            if(!_game_stack.back()->Detach())
+                delete _game_stack.back();
             _game_stack.pop_back();
             _pop_count--;
         }
@@ -109,6 +109,14 @@ public:
     virtual void Deactivate()
     {}
 
+    /** \brief Called when a game mode is popped off the game stack
+    *** \return True if the game mode is kept alive by other means, in which case
+    *** the mode engine doesn't delete it. E.g.: The maps kept in the map cache.
+    **/
+    virtual bool Detach() {
+        return false;
+    }
+
     EffectSupervisor &GetEffectSupervisor() {
         return _effect_supervisor;
     }
@@ -121,7 +129,17 @@ public:
         return _script_supervisor;
     }
 
+    /** \brief Returns how far the frame drawn is between the last two updates of the mode
+    *** \return The value of SystemEngine::GetUpdateInterpolation(), or 1.0f when the mode
+    *** wasn't updated by the last game update, e.g. while it is paused, so that its last
+    *** state is drawn as is.
+    **/
+    float GetUpdateInterpolation() const;
+
 private:
+    //! \brief The game update count when the mode was last updated, 0 if it never was.
+    uint32 _update_count;
+
     //! \brief Handles all the custom scripted animation for the given mode.
     ScriptSupervisor _script_supervisor;
 
@@ -0,0 +1,318 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012 by Bertram
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    script_cache.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fre
+*** \brief   Source file for the compiled script chunks cache
+*** ***************************************************************************/
+
+#include "script_cache.h"
+
+#include <cstring>
+#include <sys/stat.h>
+
+using namespace hoa_utils;
+
+namespace hoa_script
+{
+
+namespace
+{
+
+//! \brief Identifies the cache files, and their format version
+const char SCRIPT_CACHE_MAGIC[] = "VTLC0002";
+
+//! \brief The Lua version which compiled the chunks, as they can't be loaded by other versions
+const std::string SCRIPT_CACHE_LUA_VERSION = LUA_RELEASE;
+
+//! \brief The largest chunk accepted, so that a damaged cache file can't exhaust the memory
+const uint32 SCRIPT_CACHE_MAX_CHUNK_SIZE = 64 * 1024 * 1024;
+
+//! \brief A Lua source file, read only when needed
+struct _SourceFile {
+    std::string filename;
+    uint32 size;
+    uint32 modification_time;
+    bool read;
+    std::vector<char> text;
+};
+
+//! \brief Reads the source file text if not already done
+bool _ReadSource(_SourceFile &source)
+{
+    if(source.read)
+        return true;
+
+    std::ifstream file(source.filename.c_str(), std::ios::in | std::ios::binary);
+    if(!file)
+        return false;
+
+    source.text.resize(source.size);
+    if(source.size > 0 && !file.read(&source.text[0], source.size))
+        return false;
+
+    source.read = true;
+    return true;
+}
+
+//! \brief Returns the cache file name of a source file within a cache directory
+std::string _GetCacheFilename(const std::string &directory, const std::string &filename)
+{
+    std::string name = filename;
+    for(uint32 i = 0; i < name.size(); ++i) {
+        if(name[i] == '/' || name[i] == '\\')
+            name[i] = '_';
+    }
+    return directory + name + "c";
+}
+
+//! \brief Returns the user cache directory, creating it when needed
+const std::string &_GetUserCacheDirectory()
+{
+    static std::string directory;
+    if(directory.empty()) {
+        directory = GetUserDataPath() + "script_cache/";
+        MakeDirectory(directory);
+    }
+    return directory;
+}
+
+void _WriteUInt(std::ofstream &file, uint32 value)
+{
+    file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+bool _ReadUInt(std::ifstream &file, uint32 &value)
+{
+    return static_cast<bool>(file.read(reinterpret_cast<char *>(&value), sizeof(value)));
+}
+
+void _WriteChecksum(std::ofstream &file, uint64_t value)
+{
+    file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+bool _ReadChecksum(std::ifstream &file, uint64_t &value)
+{
+    return static_cast<bool>(file.read(reinterpret_cast<char *>(&value), sizeof(value)));
+}
+
+void _WriteString(std::ofstream &file, const std::string &text)
+{
+    _WriteUInt(file, text.size());
+    file.write(text.data(), text.size());
+}
+
+bool _ReadString(std::ifstream &file, std::string &text)
+{
+    uint32 size = 0;
+    if(!_ReadUInt(file, size) || size > 4096)
+        return false;
+    text.resize(size);
+    return size == 0 || static_cast<bool>(file.read(&text[0], size));
+}
+
+//! \brief Collects the chunk data given by lua_dump()
+int _DumpWriter(lua_State * /*state*/, const void *data, size_t size, void *chunk)
+{
+    const char *bytes = static_cast<const char *>(data);
+    std::vector<char> *buffer = static_cast<std::vector<char> *>(chunk);
+    buffer->insert(buffer->end(), bytes, bytes + size);
+    return 0;
+}
+
+/** \brief Loads the chunk of a source file from a cache directory, if it is up to date
+*** \return True if the chunk function was pushed on the stack
+**/
+bool _LoadCachedChunk(lua_State *state, _SourceFile &source, const std::string &directory)
+{
+    std::ifstream file(_GetCacheFilename(directory, source.filename).c_str(), std::ios::in | std::ios::binary);
+    if(!file)
+        return false;
+
+    char magic[sizeof(SCRIPT_CACHE_MAGIC) - 1];
+    std::string lua_version;
+    std::string filename;
+    uint32 size = 0;
+    uint32 modification_time = 0;
+    uint64_t checksum = 0;
+    uint32 chunk_size = 0;
+    if(!file.read(magic, sizeof(magic)) || memcmp(magic, SCRIPT_CACHE_MAGIC, sizeof(magic)) != 0
+            || !_ReadString(file, lua_version) || lua_version != SCRIPT_CACHE_LUA_VERSION
+            || !_ReadString(file, filename) || filename != source.filename
+            || !_ReadUInt(file, size) || size != source.size
+            || !_ReadUInt(file, modification_time) || !_ReadChecksum(file, checksum)
+            || !_ReadUInt(file, chunk_size) || chunk_size == 0 || chunk_size > SCRIPT_CACHE_MAX_CHUNK_SIZE)
+        return false;
+
+    // The checksum is only computed when the modification times differ
+    if(modification_time != source.modification_time) {
+        if(!_ReadSource(source) || ComputeChecksum(source.text) != checksum)
+            return false;
+    }
+
+    std::vector<char> chunk(chunk_size);
+    if(!file.read(&chunk[0], chunk_size))
+        return false;
+
+    std::string chunk_name = "@" + source.filename;
+    if(luaL_loadbuffer(state, &chunk[0], chunk.size(), chunk_name.c_str()) != 0) {
+        // Most likely dumped by an incompatible build of the same Lua version
+        lua_pop(state, 1);
+        return false;
+    }
+    return true;
+}
+
+/** \brief Dumps the chunk function on top of the stack in a cache directory
+*** \return False if the cache file couldn't be written
+**/
+bool _WriteCachedChunk(lua_State *state, _SourceFile &source, const std::string &directory)
+{
+    std::vector<char> chunk;
+    if(lua_dump(state, _DumpWriter, &chunk) != 0 || chunk.empty() || !_ReadSource(source))
+        return false;
+
+    std::string cache_filename = _GetCacheFilename(directory, source.filename);
+    std::ofstream file(cache_filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if(!file)
+        return false;
+
+    file.write(SCRIPT_CACHE_MAGIC, sizeof(SCRIPT_CACHE_MAGIC) - 1);
+    _WriteString(file, SCRIPT_CACHE_LUA_VERSION);
+    _WriteString(file, source.filename);
+    _WriteUInt(file, source.size);
+    _WriteUInt(file, source.modification_time);
+    _WriteChecksum(file, ComputeChecksum(source.text));
+    _WriteUInt(file, chunk.size());
+    file.write(&chunk[0], chunk.size());
+    file.close();
+
+    // A partly written entry would be rejected anyway, but is better removed
+    if(file.fail()) {
+        DeleteFile(cache_filename);
+        return false;
+    }
+    return true;
+}
+
+//! \brief Loads a source file from its text, giving the same error messages as luaL_loadfile()
+int32 _LoadSource(lua_State *state, _SourceFile &source)
+{
+    if(!_ReadSource(source)) {
+        lua_pushfstring(state, "cannot read %s", source.filename.c_str());
+        return LUA_ERRFILE;
+    }
+
+    std::string chunk_name = "@" + source.filename;
+    const char *text = source.text.empty() ? "" : &source.text[0];
+    return luaL_loadbuffer(state, text, source.text.size(), chunk_name.c_str());
+}
+
+//! \brief Gets the size and modification time of a source file
+bool _StatSource(const std::string &filename, _SourceFile &source)
+{
+    struct stat file_info;
+    if(stat(filename.c_str(), &file_info) != 0)
+        return false;
+
+    source.filename = filename;
+    source.size = static_cast<uint32>(file_info.st_size);
+    source.modification_time = static_cast<uint32>(file_info.st_mtime);
+    source.read = false;
+    return true;
+}
+
+//! \brief Compiles the Lua files of a directory recursively, and counts them
+bool _PrecompileDirectory(lua_State *state, const std::string &directory, uint32 &count)
+{
+    bool success = true;
+    std::vector<std::string> files = ListDirectory(directory, "");
+    for(uint32 i = 0; i < files.size(); ++i) {
+        if(files[i] == "." || files[i] == "..")
+            continue;
+
+        std::string filename = directory + "/" + files[i];
+        struct stat file_info;
+        if(stat(filename.c_str(), &file_info) != 0)
+            continue;
+
+        if(S_ISDIR(file_info.st_mode)) {
+            success = _PrecompileDirectory(state, filename, count) && success;
+            continue;
+        }
+
+        if(filename.size() < 4 || filename.compare(filename.size() - 4, 4, ".lua") != 0)
+            continue;
+
+        _SourceFile source;
+        if(!_StatSource(filename, source) || _LoadSource(state, source) != 0) {
+            PRINT_ERROR << "Couldn't compile the script file: " << filename << std::endl;
+            if(lua_gettop(state) > 0)
+                std::cerr << lua_tostring(state, private_script::STACK_TOP) << std::endl;
+            lua_settop(state, 0);
+            success = false;
+            continue;
+        }
+
+        if(!_WriteCachedChunk(state, source, SCRIPT_CACHE_DIRECTORY)) {
+            PRINT_ERROR << "Couldn't write the compiled script file: " << filename << std::endl;
+            success = false;
+        } else {
+            ++count;
+        }
+        lua_settop(state, 0);
+    }
+    return success;
+}
+
+} // namespace
+
+bool PrecompileScripts(const std::string &directory)
+{
+    if(!MakeDirectory(SCRIPT_CACHE_DIRECTORY))
+        return false;
+
+    // Compiling doesn't run anything, so a bare Lua state is enough
+    lua_State *state = luaL_newstate();
+    uint32 count = 0;
+    bool success = _PrecompileDirectory(state, directory, count);
+    lua_close(state);
+
+    std::cout << count << " script files compiled in " << SCRIPT_CACHE_DIRECTORY << std::endl;
+    return success;
+}
+
+namespace private_script
+{
+
+int32 LoadScriptFile(lua_State *state, const std::string &filename)
+{
+    _SourceFile source;
+    if(!_StatSource(filename, source))
+        return luaL_loadfile(state, filename.c_str());
+
+    if(_LoadCachedChunk(state, source, SCRIPT_CACHE_DIRECTORY)
+            || _LoadCachedChunk(state, source, _GetUserCacheDirectory()))
+        return 0;
+
+    int32 error = _LoadSource(state, source);
+    if(error != 0)
+        return error;
+
+    // The cache is only an optimization, the script is loaded even when it can't be written
+    if(!_WriteCachedChunk(state, source, _GetUserCacheDirectory()))
+        IF_PRINT_WARNING(SCRIPT_DEBUG) << "couldn't write the compiled script file of: " << filename << std::endl;
+    return 0;
+}
+
+} // namespace private_script
+
+} // namespace hoa_script
@@ -0,0 +1,64 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012 by Bertram
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    script_cache.h
+*** \author  Yohann Ferreira, yohann ferreira orange fre
+*** \brief   Header file for the compiled script chunks cache
+***
+*** Parsing the Lua files takes most of the time spent opening them. The chunks
+*** compiled by Lua are thus dumped in cache files, which are loaded instead of
+*** the source files as long as they are up to date.
+***
+*** A cache entry is valid when it was made by the same Lua version from a
+*** source file of the same path and size, and with the same modification time
+*** or 64-bit checksum. The checksum lets the caches built before installing the
+*** game be used even though the installation changed the files modification times.
+***
+*** The entries are looked for in the game cache directory, filled before
+*** release by PrecompileScripts(), then in the user cache directory, where
+*** the entries missing are written.
+*** ***************************************************************************/
+
+#ifndef __SCRIPT_CACHE_HEADER__
+#define __SCRIPT_CACHE_HEADER__
+
+#include "script.h"
+
+namespace hoa_script
+{
+
+//! \brief The directory of the cache entries shipped with the game
+const std::string SCRIPT_CACHE_DIRECTORY = "dat/script_cache/";
+
+/** \brief Compiles all the Lua files of a directory and its sub-directories in the game cache
+*** \param directory The directory to look for Lua files into
+*** \return False if any file couldn't be compiled or written
+***
+*** This is meant to be run before releasing the game, so that the scripts are never
+*** parsed on the players computers.
+**/
+bool PrecompileScripts(const std::string &directory);
+
+namespace private_script
+{
+
+/** \brief Loads a Lua file as a function on top of the stack, from its cached chunk when possible
+*** \param state The Lua state to load the file into
+*** \param filename The Lua source file name
+*** \return 0 on success, or the Lua error code with the error message on top of the stack,
+*** like luaL_loadfile().
+**/
+int32 LoadScriptFile(lua_State *state, const std::string &filename);
+
+} // namespace private_script
+
+} // namespace hoa_script
+
+#endif // __SCRIPT_CACHE_HEADER__
@@ -18,6 +18,9 @@
 
 #include "script.h"
 #include "script_read.h"
+#include "script_cache.h"
+
+#include "engine/system.h"
 
 using namespace luabind;
 
@@ -66,8 +69,8 @@ bool ReadScriptDescriptor::OpenFile(const std::string &filename)
         lua_checkstack(ScriptManager->GetGlobalState(), 1);
         _lstack = lua_newthread(ScriptManager->GetGlobalState());
 
-        // Attempt to load and execute the Lua file
-        if(luaL_loadfile(_lstack, filename.c_str()) != 0 || lua_pcall(_lstack, 0, 0, 0)) {
+        // Attempt to load and execute the Lua file, compiled in advance when possible
+        if(LoadScriptFile(_lstack, filename) != 0 || lua_pcall(_lstack, 0, 0, 0)) {
             PRINT_ERROR << "could not open script file: " << filename << ", error message:" << std::endl
                         << lua_tostring(_lstack, private_script::STACK_TOP) << std::endl;
             _access_mode = SCRIPT_CLOSED;
@@ -344,6 +347,33 @@ void ReadScriptDescriptor::OpenTable(int32 table_name)
 } // void ReadScriptDescriptor::OpenTable(int32 key)
 
 
+bool ReadScriptDescriptor::_OpenTableIfExists(const std::string &key)
+{
+    // OpenTable() leaves the value read on the stack when it isn't a table
+    int32 stack_size = lua_gettop(_lstack);
+    size_t open_tables = _open_tables.size();
+    OpenTable(key);
+    if(_open_tables.size() > open_tables)
+        return true;
+
+    lua_settop(_lstack, stack_size);
+    return false;
+}
+
+
+bool ReadScriptDescriptor::_OpenTableIfExists(int32 key)
+{
+    int32 stack_size = lua_gettop(_lstack);
+    size_t open_tables = _open_tables.size();
+    OpenTable(key);
+    if(_open_tables.size() > open_tables)
+        return true;
+
+    lua_settop(_lstack, stack_size);
+    return false;
+}
+
+
 std::string ReadScriptDescriptor::OpenTablespace()
 {
     if(!IsFileOpen()) {
@@ -500,6 +530,7 @@ bool ReadScriptDescriptor::RunScriptObject(const luabind::object &object)
     if(!object.is_valid())
         return true;
 
+    hoa_system::ProfileTimer profile(hoa_system::PROFILE_SCRIPT_CALLS);
     try {
         ScriptCallFunction<void>(object);
     } catch(const luabind::error &e) {
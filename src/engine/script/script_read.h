@@ -296,6 +296,63 @@ public:
     }
     //@}
 
+    /** \name Number Array Read Functions
+    *** \brief These functions fill a buffer with the numbers of a Lua array, read with the raw Lua API.
+    *** \param key The name of the array table to read.
+    *** \param data The buffer to fill, resized to the array length.
+    *** \return False if the table didn't exist or contained anything other than numbers.
+    ***
+    *** They do the same as the ReadIntVector() and ReadUIntVector() functions, without making
+    *** a luabind object and a cast for every value, which matters for the large tables of the
+    *** map files. The array must be a Lua sequence, with its values indexed from 1.
+    **/
+    //@{
+    bool ReadIntArray(const std::string &key, std::vector<int32>& data) {
+        return _ReadNumberArray<int32>(key, data);
+    }
+
+    bool ReadIntArray(int32 key, std::vector<int32>& data) {
+        return _ReadNumberArray<int32>(key, data);
+    }
+
+    bool ReadUIntArray(const std::string &key, std::vector<uint32>& data) {
+        return _ReadNumberArray<uint32>(key, data);
+    }
+
+    bool ReadUIntArray(int32 key, std::vector<uint32>& data) {
+        return _ReadNumberArray<uint32>(key, data);
+    }
+    //@}
+
+    /** \name Number Grid Read Functions
+    *** \brief These functions fill a buffer with a table of number rows, as the map files layers.
+    *** \param key The name of the table of rows to read. When none is given, the open table is read.
+    *** \param data The buffer to fill with the rows one after the other.
+    *** \param rows Set to the number of rows read.
+    *** \param columns Set to the number of values of each row.
+    *** \return False if the table didn't exist, or if the rows didn't all have the same number of values.
+    ***
+    *** The rows are indexed from 0 as written by the map editor, or from 1, and
+    *** must all be arrays of numbers of the same length. The other keys of the table are ignored.
+    **/
+    //@{
+    bool ReadIntGrid(const std::string &key, std::vector<int32>& data, uint32 &rows, uint32 &columns) {
+        return _ReadNumberGrid<int32>(key, data, rows, columns);
+    }
+
+    bool ReadIntGrid(std::vector<int32>& data, uint32 &rows, uint32 &columns) {
+        return _ReadNumberGridHelper<int32>(data, rows, columns);
+    }
+
+    bool ReadUIntGrid(const std::string &key, std::vector<uint32>& data, uint32 &rows, uint32 &columns) {
+        return _ReadNumberGrid<uint32>(key, data, rows, columns);
+    }
+
+    bool ReadUIntGrid(std::vector<uint32>& data, uint32 &rows, uint32 &columns) {
+        return _ReadNumberGridHelper<uint32>(data, rows, columns);
+    }
+    //@}
+
     /** \name Function Pointer Read Functions
     *** \param key The name of the function if it is contained in the global space, or the key
     *** if the function is embedded in a table.
@@ -511,6 +568,29 @@ protected:
     template <class T> void _ReadDataVectorHelper(std::vector<T>& vect);
     //@}
 
+    /** \name Number Array Read Templates
+    *** \brief These template functions are called by the public ReadTYPEArray and ReadTYPEGrid functions.
+    *** The helpers read the table on top of the stack.
+    **/
+    //@{
+    /** \brief Opens a table like OpenTable(), leaving the stack as it was when the table doesn't exist
+    *** \return True if the table was opened
+    **/
+    bool _OpenTableIfExists(const std::string &key);
+    bool _OpenTableIfExists(int32 key);
+    template <class T> bool _ReadNumberArray(const std::string &key, std::vector<T>& data);
+    template <class T> bool _ReadNumberArray(int32 key, std::vector<T>& data);
+    template <class T> bool _ReadNumberGrid(const std::string &key, std::vector<T>& data, uint32 &rows, uint32 &columns);
+    /** \brief Reads the numbers of the array at the given stack index into a buffer
+    *** \param index The stack index of the array table
+    *** \param data Where to write the array numbers, which must have room for all of them
+    *** \param size The number of values to read
+    **/
+    template <class T> bool _ReadNumbers(int32 index, T *data, uint32 size);
+    template <class T> bool _ReadNumberArrayHelper(std::vector<T>& data);
+    template <class T> bool _ReadNumberGridHelper(std::vector<T>& data, uint32 &rows, uint32 &columns);
+    //@}
+
     /** \name Table Key Template
     *** \brief This template function fills a vector with all of the keys contained by the table
     *** \param vect A reference to the vector where the keys should be stored
@@ -641,6 +721,143 @@ template <class T> void ReadScriptDescriptor::_ReadDataVectorHelper(std::vector<
 
 
 
+template <class T> bool ReadScriptDescriptor::_ReadNumberArray(const std::string &key, std::vector<T>& data)
+{
+    if(!_OpenTableIfExists(key)) {
+        data.clear();
+        return false;
+    }
+
+    bool success = _ReadNumberArrayHelper(data);
+    CloseTable();
+    return success;
+} // template <class T> bool ReadScriptDescriptor::_ReadNumberArray(const std::string &key, std::vector<T>& data)
+
+
+
+template <class T> bool ReadScriptDescriptor::_ReadNumberArray(int32 key, std::vector<T>& data)
+{
+    if(!_OpenTableIfExists(key)) {
+        data.clear();
+        return false;
+    }
+
+    bool success = _ReadNumberArrayHelper(data);
+    CloseTable();
+    return success;
+} // template <class T> bool ReadScriptDescriptor::_ReadNumberArray(int32 key, std::vector<T>& data)
+
+
+
+template <class T> bool ReadScriptDescriptor::_ReadNumberGrid(const std::string &key, std::vector<T>& data,
+                                                              uint32 &rows, uint32 &columns)
+{
+    if(!_OpenTableIfExists(key)) {
+        data.clear();
+        rows = 0;
+        columns = 0;
+        return false;
+    }
+
+    bool success = _ReadNumberGridHelper(data, rows, columns);
+    CloseTable();
+    return success;
+} // template <class T> bool ReadScriptDescriptor::_ReadNumberGrid(const std::string &key, std::vector<T>& data, ...)
+
+
+
+template <class T> bool ReadScriptDescriptor::_ReadNumbers(int32 index, T *data, uint32 size)
+{
+    for(uint32 i = 0; i < size; ++i) {
+        lua_rawgeti(_lstack, index, i + 1);
+        if(!lua_isnumber(_lstack, private_script::STACK_TOP)) {
+            lua_pop(_lstack, 1);
+            IF_PRINT_WARNING(SCRIPT_DEBUG) << "failed because the value " << i + 1 << " of the table was not a number" << std::endl;
+            return false;
+        }
+        data[i] = static_cast<T>(lua_tointeger(_lstack, private_script::STACK_TOP));
+        lua_pop(_lstack, 1);
+    }
+    return true;
+} // template <class T> bool ReadScriptDescriptor::_ReadNumbers(int32 index, T *data, uint32 size)
+
+
+
+template <class T> bool ReadScriptDescriptor::_ReadNumberArrayHelper(std::vector<T>& data)
+{
+    data.clear();
+    if(!lua_istable(_lstack, private_script::STACK_TOP)) {
+        IF_PRINT_WARNING(SCRIPT_DEBUG) << "failed because the top of the stack was not a table" << std::endl;
+        return false;
+    }
+
+    data.resize(lua_objlen(_lstack, private_script::STACK_TOP));
+    if(data.empty())
+        return true;
+
+    if(!_ReadNumbers(lua_gettop(_lstack), &data[0], data.size())) {
+        data.clear();
+        return false;
+    }
+    return true;
+} // template <class T> bool ReadScriptDescriptor::_ReadNumberArrayHelper(std::vector<T>& data)
+
+
+
+template <class T> bool ReadScriptDescriptor::_ReadNumberGridHelper(std::vector<T>& data, uint32 &rows, uint32 &columns)
+{
+    data.clear();
+    rows = 0;
+    columns = 0;
+    int32 table = lua_gettop(_lstack);
+    if(!lua_istable(_lstack, table)) {
+        IF_PRINT_WARNING(SCRIPT_DEBUG) << "failed because the top of the stack was not a table" << std::endl;
+        return false;
+    }
+
+    // The map files index their rows from 0, unlike the Lua arrays
+    lua_rawgeti(_lstack, table, 0);
+    int32 first_row = lua_istable(_lstack, private_script::STACK_TOP) ? 0 : 1;
+    lua_pop(_lstack, 1);
+
+    // The buffer is sized after the first row, and grown by whole rows
+    for(int32 row = first_row; ; ++row) {
+        lua_rawgeti(_lstack, table, row);
+        if(!lua_istable(_lstack, private_script::STACK_TOP)) {
+            lua_pop(_lstack, 1);
+            break;
+        }
+
+        uint32 size = lua_objlen(_lstack, private_script::STACK_TOP);
+        if(rows == 0) {
+            columns = size;
+            data.reserve(columns * (lua_objlen(_lstack, table) + 1));
+        } else if(size != columns) {
+            lua_pop(_lstack, 1);
+            IF_PRINT_WARNING(SCRIPT_DEBUG) << "failed because the row " << row << " had " << size
+                                           << " values instead of " << columns << std::endl;
+            data.clear();
+            rows = 0;
+            columns = 0;
+            return false;
+        }
+
+        data.resize(data.size() + columns);
+        if(columns > 0 && !_ReadNumbers(lua_gettop(_lstack), &data[data.size() - columns], columns)) {
+            lua_pop(_lstack, 1);
+            data.clear();
+            rows = 0;
+            columns = 0;
+            return false;
+        }
+        lua_pop(_lstack, 1);
+        ++rows;
+    }
+    return true;
+} // template <class T> bool ReadScriptDescriptor::_ReadNumberGridHelper(std::vector<T>& data, uint32 &rows, uint32 &columns)
+
+
+
 template <class T> void ReadScriptDescriptor::_ReadTableKeys(std::vector<T>& keys)
 {
     keys.clear();
@@ -34,7 +34,14 @@
 #include <limits.h>
 #endif
 
+#ifdef __MACH__
+#include <mach/mach_time.h>
+#elif !defined _WIN32
+#include <time.h>
+#endif
+
 #include <libintl.h>
+#include <cstring>
 
 using namespace hoa_utils;
 using namespace hoa_script;
@@ -47,6 +54,7 @@ namespace hoa_system
 
 SystemEngine *SystemManager = NULL;
 bool SYSTEM_DEBUG = false;
+std::string SYSTEM_PROFILE_FILENAME;
 
 std::string Translate(const std::string &text)
 {
@@ -59,6 +67,70 @@ ustring UTranslate(const std::string &text)
     return MakeUnicodeString(Translate(text));
 }
 
+uint32 GetProfileTime()
+{
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    if(frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    // Split the computation to avoid overflowing when the counter is high
+    return static_cast<uint32>((counter.QuadPart / frequency.QuadPart) * 1000000
+                               + (counter.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart);
+#elif defined __MACH__
+    static mach_timebase_info_data_t timebase;
+    if(timebase.denom == 0)
+        mach_timebase_info(&timebase);
+
+    return static_cast<uint32>(mach_absolute_time() * timebase.numer / timebase.denom / 1000);
+#else
+    // A monotonic clock doesn't jump when the system time is changed
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return static_cast<uint32>(time.tv_sec * 1000000 + time.tv_nsec / 1000);
+#endif
+}
+
+// -----------------------------------------------------------------------------
+// ProfileTimer Class
+// -----------------------------------------------------------------------------
+
+ProfileTimer::ProfileTimer(PROFILE_SECTION section) :
+    _section(section),
+    _start_time(0),
+    _active(SystemManager != NULL && SystemManager->IsProfiling())
+{
+    if(_active)
+        _start_time = GetProfileTime();
+}
+
+
+
+void ProfileTimer::Switch(PROFILE_SECTION section)
+{
+    _Stop();
+
+    _section = section;
+    _active = (SystemManager != NULL && SystemManager->IsProfiling());
+    if(_active)
+        _start_time = GetProfileTime();
+}
+
+
+
+void ProfileTimer::_Stop()
+{
+    if(!_active)
+        return;
+
+    // The profiler may have been disabled in the meantime
+    if(SystemManager->IsProfiling())
+        SystemManager->AddProfileTime(_section, GetProfileTime() - _start_time);
+    _active = false;
+}
+
 // -----------------------------------------------------------------------------
 // SystemTimer Class
 // -----------------------------------------------------------------------------
@@ -258,6 +330,11 @@ SystemEngine::SystemEngine()
 
     _not_done = true;
     SetLanguage("en@quot"); //Default language is English
+
+    SetFramePacing(SYSTEM_DEFAULT_FRAME_RATE, true);
+    InitializeTimers();
+
+    EnableProfiling(false);
 }
 
 
@@ -325,13 +402,35 @@ void SystemEngine::SetLanguage(const std::string& lang)
 
 bool SystemEngine::SingletonInitialize()
 {
+    if(!SYSTEM_PROFILE_FILENAME.empty()) {
+        _profile_file.open(SYSTEM_PROFILE_FILENAME.c_str(), std::ios::out | std::ios::trunc);
+        if(!_profile_file) {
+            PRINT_WARNING << "Couldn't open the profile file: " << SYSTEM_PROFILE_FILENAME << std::endl;
+        } else {
+            // The CSV header, the times of each frame are then written in microseconds
+            for(uint32 i = 0; i < PROFILE_TOTAL; ++i)
+                _profile_file << (i > 0 ? "," : "") << GetProfileSectionName(static_cast<PROFILE_SECTION>(i));
+            for(uint32 i = 0; i < PROFILE_COUNTER_TOTAL; ++i)
+                _profile_file << "," << GetProfileCounterName(static_cast<PROFILE_COUNTER>(i));
+            _profile_file << std::endl;
+            EnableProfiling(true);
+        }
+    }
+
     return true;
 }
 
 
 void SystemEngine::InitializeTimers()
 {
-    _last_update = SDL_GetTicks();
+    _frame_start = GetProfileTime();
+    _frame_time = 0;
+    _update_accumulator = 0;
+    _update_remainder = 0;
+    _frame_updates = 0;
+    _missed_frames = 0;
+    _dropped_updates = 0;
+    _update_count = 0;
     _update_time = 1; // Set to non-zero, otherwise bad things may happen...
     _hours_played = 0;
     _minutes_played = 0;
@@ -378,12 +477,64 @@ void SystemEngine::RemoveAutoTimer(SystemTimer *timer)
 
 
 
-void SystemEngine::UpdateTimers()
+void SystemEngine::WaitForNextFrame()
+{
+    uint32 work_time = GetProfileTime() - _frame_start;
+
+    if(_frame_rate > 0) {
+        uint32 frame_budget = 1000000 / _frame_rate;
+        if(work_time > frame_budget) {
+            // With vsync, the frame only really missed its deadline when a display refresh was skipped
+            if(!_vsync || work_time > frame_budget + frame_budget / 2)
+                ++_missed_frames;
+        } else if(!_vsync || work_time < frame_budget / 2) {
+            // Also wait when the driver ignores the vsync request, which makes the frames too short.
+            // SDL_Delay() can only wait whole milliseconds.
+            SDL_Delay((frame_budget - work_time) / 1000);
+        }
+    }
+
+    uint32 frame_start = GetProfileTime();
+    _frame_time = frame_start - _frame_start;
+    _update_accumulator += _frame_time;
+    _frame_start = frame_start;
+    _frame_updates = 0;
+}
+
+
+
+bool SystemEngine::UpdateTimers()
 {
     // ----- (1): Update the update game timer
-    uint32 tmp = _last_update;
-    _last_update = SDL_GetTicks();
-    _update_time = _last_update - tmp;
+    const uint32 update_step = 1000000 / SYSTEM_UPDATE_RATE;
+    if(_update_accumulator < update_step)
+        return false;
+
+    if(_frame_updates >= SYSTEM_MAX_FRAME_UPDATES) {
+        _dropped_updates += _update_accumulator / update_step;
+        _update_accumulator %= update_step;
+        return false;
+    }
+
+    _update_accumulator -= update_step;
+    ++_frame_updates;
+
+    _UpdateGameTime(update_step);
+    return true;
+}
+
+void SystemEngine::SimulateUpdate()
+{
+    _UpdateGameTime(1000000 / SYSTEM_UPDATE_RATE);
+}
+
+void SystemEngine::_UpdateGameTime(uint32 update_step)
+{
+    // The update time is in milliseconds, so the fractions are carried over to the next updates
+    _update_remainder += update_step;
+    _update_time = _update_remainder / 1000;
+    _update_remainder %= 1000;
+    ++_update_count;
 
     // ----- (2): Update the game play timer
     _milliseconds_played += _update_time;
@@ -405,6 +556,89 @@ void SystemEngine::UpdateTimers()
         (*i)->_AutoUpdate();
 }
 
+void SystemEngine::EnableProfiling(bool enable)
+{
+    _profiling = enable;
+    _profile_frame_start = GetProfileTime();
+    _profile_frame_index = 0;
+    _profile_num_frames = 0;
+    memset(_profile_current_frame, 0, sizeof(_profile_current_frame));
+    memset(_profile_frames, 0, sizeof(_profile_frames));
+    memset(_profile_current_counts, 0, sizeof(_profile_current_counts));
+    memset(_profile_last_counts, 0, sizeof(_profile_last_counts));
+}
+
+
+
+void SystemEngine::EndProfileFrame()
+{
+    if(!_profiling)
+        return;
+
+    uint32 frame_end = GetProfileTime();
+    _profile_current_frame[PROFILE_FRAME] = frame_end - _profile_frame_start;
+    _profile_frame_start = frame_end;
+
+    memcpy(_profile_frames[_profile_frame_index], _profile_current_frame, sizeof(_profile_current_frame));
+    _profile_frame_index = (_profile_frame_index + 1) % PROFILE_FRAMES;
+    if(_profile_num_frames < PROFILE_FRAMES)
+        ++_profile_num_frames;
+
+    if(_profile_file.is_open()) {
+        for(uint32 i = 0; i < PROFILE_TOTAL; ++i)
+            _profile_file << (i > 0 ? "," : "") << _profile_current_frame[i];
+        for(uint32 i = 0; i < PROFILE_COUNTER_TOTAL; ++i)
+            _profile_file << "," << _profile_current_counts[i];
+        _profile_file << '\n';
+    }
+
+    memset(_profile_current_frame, 0, sizeof(_profile_current_frame));
+    memcpy(_profile_last_counts, _profile_current_counts, sizeof(_profile_current_counts));
+    memset(_profile_current_counts, 0, sizeof(_profile_current_counts));
+}
+
+
+
+uint32 SystemEngine::GetProfileAverage(PROFILE_SECTION section) const
+{
+    if(_profile_num_frames == 0)
+        return 0;
+
+    uint32 sum = 0;
+    for(uint32 i = 0; i < _profile_num_frames; ++i)
+        sum += _profile_frames[i][section];
+    return sum / _profile_num_frames;
+}
+
+
+
+const char *SystemEngine::GetProfileSectionName(PROFILE_SECTION section)
+{
+    static const char *names[PROFILE_TOTAL] = {
+        "Clear", "Mode draw", "Video draw", "Effects draw", "Swap buffers",
+        "Timers update", "Input", "Video update", "Audio update", "Mode update",
+        "Map tiles", "Map objects", "Battle update", "Script calls", "Texture upload",
+        "Frame"
+    };
+
+    if(section < 0 || section >= PROFILE_TOTAL)
+        return "";
+    return names[section];
+}
+
+
+
+const char *SystemEngine::GetProfileCounterName(PROFILE_COUNTER counter)
+{
+    static const char *names[PROFILE_COUNTER_TOTAL] = {
+        "Map objects at full rate", "Map objects at reduced rate", "Map objects sleeping"
+    };
+
+    if(counter < 0 || counter >= PROFILE_COUNTER_TOTAL)
+        return "";
+    return names[counter];
+}
+
 // Avoid a useless dependency on the mode manager for the editor build
 #ifndef EDITOR_BUILD
 void SystemEngine::ExamineSystemTimers()
@@ -24,6 +24,7 @@
 #define __SYSTEM_HEADER__
 
 #include <set>
+#include <fstream>
 #include <SDL/SDL.h>
 
 #include "utils.h"
@@ -56,6 +57,11 @@ extern SystemEngine *SystemManager;
 //! \brief Determines whether the code in the hoa_system namespace should print debug statements or not.
 extern bool SYSTEM_DEBUG;
 
+/** \brief The file where the frame profiler samples are written, in the CSV format.
+*** When not empty, the profiler is enabled at startup and each frame is written as a line of the file.
+**/
+extern std::string SYSTEM_PROFILE_FILENAME;
+
 /** \brief A constant that represents an "infinite" number of milliseconds that can never be reached
 *** \note This value is technically not infinite. It is the maximum value of a 32-bit
 *** unsigned integer (2^32 - 1). This value will only be reached after ~49.7 consecutive
@@ -75,6 +81,18 @@ const int32 SYSTEM_TIMER_NO_LOOPS = 0;
 **/
 const int32 SYSTEM_TIMER_INFINITE_LOOP = -1;
 
+//! \brief The number of game updates per second. Each update makes the game time advance by the same amount.
+const uint32 SYSTEM_UPDATE_RATE = 60;
+
+/** \brief The maximum number of game updates done for a single frame
+*** When the game can't keep up, the updates beyond this number are dropped, so that
+*** slow frames don't lead to even slower frames.
+**/
+const uint32 SYSTEM_MAX_FRAME_UPDATES = 5;
+
+//! \brief The default number of frames per second the main loop tries to run at.
+const uint32 SYSTEM_DEFAULT_FRAME_RATE = 60;
+
 //! \brief All of the possible states which a SystemTimer classs object may be in
 enum SYSTEM_TIMER_STATE {
     SYSTEM_TIMER_INVALID  = -1,
@@ -86,6 +104,47 @@ enum SYSTEM_TIMER_STATE {
 };
 
 
+//! \brief The parts of a frame measured by the frame profiler
+enum PROFILE_SECTION {
+    //! The main loop phases, in the order they are run
+    PROFILE_CLEAR          =  0,
+    PROFILE_MODE_DRAW      =  1,
+    PROFILE_VIDEO_DRAW     =  2,
+    PROFILE_EFFECTS_DRAW   =  3,
+    PROFILE_SWAP_BUFFERS   =  4,
+    PROFILE_TIMERS_UPDATE  =  5,
+    PROFILE_INPUT          =  6,
+    PROFILE_VIDEO_UPDATE   =  7,
+    PROFILE_AUDIO_UPDATE   =  8,
+    PROFILE_MODE_UPDATE    =  9,
+    //! Parts of the phases above
+    PROFILE_MAP_TILES      = 10,
+    PROFILE_MAP_OBJECTS    = 11,
+    PROFILE_BATTLE_UPDATE  = 12,
+    PROFILE_SCRIPT_CALLS   = 13,
+    PROFILE_TEXTURE_UPLOAD = 14,
+    //! The whole frame, including the time spent waiting
+    PROFILE_FRAME          = 15,
+    PROFILE_TOTAL          = 16
+};
+
+//! \brief The numbers counted by the frame profiler at each frame, along with the section times
+enum PROFILE_COUNTER {
+    PROFILE_MAP_OBJECTS_FULL_RATE    = 0,
+    PROFILE_MAP_OBJECTS_REDUCED_RATE = 1,
+    PROFILE_MAP_OBJECTS_SLEEPING     = 2,
+    PROFILE_COUNTER_TOTAL            = 3
+};
+
+//! \brief The number of frames kept by the frame profiler to compute its averages
+const uint32 PROFILE_FRAMES = 128;
+
+/** \brief Returns a time in microseconds, which only has a meaning when compared to another one
+*** \note The value wraps around every 71 minutes, so only the difference between two close times should be used.
+**/
+uint32 GetProfileTime();
+
+
 /** \brief Returns a standard string translated into the game's current language
 *** \param text A const reference to the string that should be translated
 *** \return Translated text in the form of a std::string
@@ -106,6 +165,47 @@ std::string Translate(const std::string &text);
 hoa_utils::ustring UTranslate(const std::string &text);
 
 
+/** ****************************************************************************
+*** \brief Measures the time spent in a section of the code for the frame profiler
+***
+*** The time is measured from the creation of the object to its destruction,
+*** or to the next call to Switch(), which starts measuring another section.
+*** Nothing is measured when the profiler is disabled.
+***
+*** \code
+*** ProfileTimer profile(PROFILE_MODE_DRAW);
+*** ModeManager->Draw();
+*** profile.Switch(PROFILE_VIDEO_DRAW);
+*** VideoManager->Draw();
+*** \endcode
+*** ***************************************************************************/
+class ProfileTimer
+{
+public:
+    ProfileTimer(PROFILE_SECTION section);
+
+    ~ProfileTimer() {
+        _Stop();
+    }
+
+    //! \brief Stops measuring the current section and starts measuring the given one.
+    void Switch(PROFILE_SECTION section);
+
+private:
+    //! \brief The section currently measured.
+    PROFILE_SECTION _section;
+
+    //! \brief The time the section started to be measured, in microseconds.
+    uint32 _start_time;
+
+    //! \brief Whether the profiler was enabled when the section started.
+    bool _active;
+
+    //! \brief Adds the time spent in the current section to the profiler.
+    void _Stop();
+}; // class ProfileTimer
+
+
 /** ****************************************************************************
 *** \brief A timer assistant useful for monitoring progress and processing event sequences
 ***
@@ -348,10 +448,32 @@ public:
     *** the active game mode's execution begins with only 1 millisecond of time expired instead of several.
     **/
     void InitializeUpdateTimer() {
-        _last_update = SDL_GetTicks();
+        _frame_start = GetProfileTime();
+        _update_accumulator = 0;
         _update_time = 1;
     }
 
+    /** \brief Sets how the main loop paces the frames
+    *** \param frame_rate The number of frames per second to aim for, or 0 to not limit it.
+    *** \param vsync Whether the buffer swap waits for the display refresh, in which case
+    *** the main loop doesn't need to wait by itself.
+    **/
+    void SetFramePacing(uint32 frame_rate, bool vsync) {
+        _frame_rate = frame_rate;
+        _vsync = vsync;
+    }
+
+    uint32 GetFrameRate() const {
+        return _frame_rate;
+    }
+
+    /** \brief Waits for what remains of the current frame budget, and starts a new frame
+    *** This function should only be called <b>once</b> for each cycle through the main game loop,
+    *** before updating the game and drawing the frame. A frame which took longer than its budget
+    *** is counted as missed.
+    **/
+    void WaitForNextFrame();
+
     /** \brief Adds a timer to the set system timers for auto updating
     *** \param timer A pointer to the timer to add
     ***
@@ -368,12 +490,54 @@ public:
     **/
     void RemoveAutoTimer(SystemTimer *timer);
 
-    /** \brief Updates the game timer variables.
-    *** This function should only be called <b>once</b> for each cycle through the main game loop. Since
-    *** it is called inside the loop in main.cpp, you should have no reason to call this function anywhere
-    *** else.
+    /** \brief Updates the game timer variables by one game update step, when one is due.
+    *** \return Whether a game update should be done.
+    ***
+    *** The game is updated SYSTEM_UPDATE_RATE times per second, whatever the frame rate is,
+    *** so this function must be called in a loop before each frame until it returns false.
+    *** The time left over is then used to draw the frame between the last two updates.
+    *** Since it is called inside the loop in main.cpp, you should have no reason to call this
+    *** function anywhere else.
     **/
-    void UpdateTimers();
+    bool UpdateTimers();
+
+    /** \brief Updates the game timer variables by one game update step, whatever the time elapsed.
+    ***
+    *** This is used to run the game faster than real time, when nothing is drawn,
+    *** like in the battle simulations. The frame pacing members are left untouched.
+    **/
+    void SimulateUpdate();
+
+    /** \brief Returns the real time between the start of the last two frames, in microseconds
+    *** Unlike GetUpdateTime(), which is the fixed game update step, this follows the frame rate.
+    **/
+    uint32 GetFrameTime() const {
+        return _frame_time;
+    }
+
+    /** \brief Returns how far the game time is between the last game update and the next one
+    *** \return A value between 0.0f and 1.0f, which the drawing code uses to interpolate
+    *** the state of the last two updates.
+    **/
+    float GetUpdateInterpolation() const {
+        float interpolation = static_cast<float>(_update_accumulator) / (1000000 / SYSTEM_UPDATE_RATE);
+        return interpolation < 1.0f ? interpolation : 1.0f;
+    }
+
+    //! \brief Returns the number of game updates done since the timers were initialized.
+    uint32 GetUpdateCount() const {
+        return _update_count;
+    }
+
+    //! \brief Returns the number of frames which took longer than their budget.
+    uint32 GetMissedFrames() const {
+        return _missed_frames;
+    }
+
+    //! \brief Returns the number of game updates dropped because the game couldn't keep up.
+    uint32 GetDroppedUpdates() const {
+        return _dropped_updates;
+    }
 
     /** \brief Checks all system timers for whether they should be paused or resumed
     *** This function is typically called whenever the ModeEngine class has changed the active game mode.
@@ -396,6 +560,14 @@ public:
         return _update_time;
     }
 
+    /** \brief Changes the update time seen by the code updated next
+    *** This lets parts of a mode be updated less often, with all the time elapsed since their last update.
+    *** The time of the current update must be set back afterwards.
+    **/
+    void SetUpdateTime(uint32 update_time) {
+        _update_time = update_time;
+    }
+
     /** \brief Sets the play time of a game instance
     *** \param h The amount of hours to set.
     *** \param m The amount of minutes to set.
@@ -453,6 +625,49 @@ public:
         _not_done = false;
     }
 
+    /** \name Frame profiler methods
+    *** The profiler adds up the time spent in each PROFILE_SECTION during a frame,
+    *** and keeps the sums of the last PROFILE_FRAMES frames.
+    **/
+    //@{
+    //! \brief Enables or disables the profiler. The kept frames are discarded on both cases.
+    void EnableProfiling(bool enable);
+
+    bool IsProfiling() const {
+        return _profiling;
+    }
+
+    //! \brief Adds the given time, in microseconds, to a section of the current frame.
+    void AddProfileTime(PROFILE_SECTION section, uint32 time) {
+        _profile_current_frame[section] += time;
+    }
+
+    //! \brief Adds the given number to a counter of the current frame, when the profiler is enabled.
+    void AddProfileCount(PROFILE_COUNTER counter, uint32 count) {
+        if(_profiling)
+            _profile_current_counts[counter] += count;
+    }
+
+    //! \brief Returns the value of a counter on the last complete frame.
+    uint32 GetProfileCount(PROFILE_COUNTER counter) const {
+        return _profile_last_counts[counter];
+    }
+
+    /** \brief Ends the current frame and starts a new one
+    *** This function should only be called <b>once</b> for each cycle through the main game loop.
+    **/
+    void EndProfileFrame();
+
+    //! \brief Returns the average time spent in a section over the kept frames, in microseconds.
+    uint32 GetProfileAverage(PROFILE_SECTION section) const;
+
+    //! \brief Returns the name of a section, as used in the profiler overlay and CSV file.
+    static const char *GetProfileSectionName(PROFILE_SECTION section);
+
+    //! \brief Returns the name of a counter, as used in the profiler overlay and CSV file.
+    static const char *GetProfileCounterName(PROFILE_COUNTER counter);
+    //@}
+
     //! Threading classes
     template <class T> Thread *SpawnThread(void (T:: *)(), T *);
     void WaitForThread(Thread *thread);
@@ -466,12 +681,43 @@ public:
 private:
     SystemEngine();
 
-    //! \brief The last time that the UpdateTimers function was called, in milliseconds.
-    uint32 _last_update;
-
     //! \brief The number of milliseconds that have transpired on the last timer update.
     uint32 _update_time;
 
+    /** \name Frame pacing members
+    **/
+    //@{
+    //! \brief The number of frames per second to aim for, 0 meaning no limit.
+    uint32 _frame_rate;
+
+    //! \brief Whether the buffer swap waits for the display refresh.
+    bool _vsync;
+
+    //! \brief The time the current frame started, in microseconds.
+    uint32 _frame_start;
+
+    //! \brief The time between the start of the last two frames, in microseconds.
+    uint32 _frame_time;
+
+    //! \brief The time elapsed and not yet processed by game updates, in microseconds.
+    uint32 _update_accumulator;
+
+    //! \brief The fraction of millisecond carried over from the last game updates, in microseconds.
+    uint32 _update_remainder;
+
+    //! \brief The number of game updates done since the current frame started.
+    uint32 _frame_updates;
+
+    //! \brief The number of frames which took longer than their budget.
+    uint32 _missed_frames;
+
+    //! \brief The number of game updates dropped because the game couldn't keep up.
+    uint32 _dropped_updates;
+
+    //! \brief The number of game updates done since the timers were initialized.
+    uint32 _update_count;
+    //@}
+
     /** \name Play time members
     *** \brief Timers that retain the total amount of time that the user has been playing
     *** When the player starts a new game or loads an existing game, these timers are reset.
@@ -493,6 +739,38 @@ private:
     *** The timers in this container are updated on each call to UpdateTimers().
     **/
     std::set<SystemTimer *> _auto_system_timers;
+
+    /** \name Frame profiler members
+    **/
+    //@{
+    //! \brief Whether the frame profiler is enabled.
+    bool _profiling;
+
+    //! \brief The time the current frame started, in microseconds.
+    uint32 _profile_frame_start;
+
+    //! \brief The time spent in each section during the current frame.
+    uint32 _profile_current_frame[PROFILE_TOTAL];
+
+    //! \brief A circular array of the time spent in each section during the last frames.
+    uint32 _profile_frames[PROFILE_FRAMES][PROFILE_TOTAL];
+
+    //! \brief The index of the next frame to write in _profile_frames, and the number of valid frames in it.
+    uint32 _profile_frame_index;
+    uint32 _profile_num_frames;
+
+    //! \brief The counters of the current frame, and of the last complete one.
+    uint32 _profile_current_counts[PROFILE_COUNTER_TOTAL];
+    uint32 _profile_last_counts[PROFILE_COUNTER_TOTAL];
+
+    //! \brief The file where each frame is written, when SYSTEM_PROFILE_FILENAME is set.
+    std::ofstream _profile_file;
+    //@}
+
+    /** \brief Advances the update time, the play time and the automatic timers.
+    *** \param update_step The time elapsed, in microseconds
+    **/
+    void _UpdateGameTime(uint32 update_step);
 }; // class SystemEngine : public hoa_utils::Singleton<SystemEngine>
 
 
@@ -20,11 +20,9 @@
 #include "engine/script/script_read.h"
 #include "engine/system.h"
 
-
-#include <png.h>
-extern "C" {
-#include <jpeglib.h>
-}
+#include <cstring>
+#include <map>
+#include <sys/stat.h>
 
 using namespace hoa_utils;
 using namespace hoa_video::private_video;
@@ -32,6 +30,31 @@ using namespace hoa_video::private_video;
 namespace hoa_video
 {
 
+namespace
+{
+
+//! \brief The properties of an image file, as found in its header
+struct _ImageInfo {
+    //! \brief The modification time of the file when its header was read
+    time_t modification_time;
+
+    uint32 rows;
+    uint32 cols;
+    uint32 bpp;
+};
+
+//! \brief The image files properties already read, by filename
+std::map<std::string, _ImageInfo> _image_info_cache;
+
+//! \brief Reads a 32 bits big endian value, as found in the PNG files
+uint32 _ReadBigEndian32(const uint8 *data)
+{
+    return (static_cast<uint32>(data[0]) << 24) | (static_cast<uint32>(data[1]) << 16) |
+           (static_cast<uint32>(data[2]) << 8) | static_cast<uint32>(data[3]);
+}
+
+} // anonymous namespace
+
 // -----------------------------------------------------------------------------
 // ImageDescriptor class
 // -----------------------------------------------------------------------------
@@ -203,6 +226,21 @@ void ImageDescriptor::SetVertexColors(const Color &tl, const Color &tr, const Co
 
 void ImageDescriptor::GetImageInfo(const std::string &filename, uint32 &rows, uint32 &cols, uint32 &bpp) throw(Exception)
 {
+    // The properties read earlier are still valid as long as the file wasn't modified
+    struct stat file_stat;
+    if(stat(filename.c_str(), &file_stat) != 0) {
+        throw Exception("failed to open file: " + filename, __FILE__, __LINE__, __FUNCTION__);
+        return;
+    }
+
+    std::map<std::string, _ImageInfo>::const_iterator it = _image_info_cache.find(filename);
+    if(it != _image_info_cache.end() && it->second.modification_time == file_stat.st_mtime) {
+        rows = it->second.rows;
+        cols = it->second.cols;
+        bpp = it->second.bpp;
+        return;
+    }
+
     // Isolate the file extension
     size_t ext_position = filename.rfind('.');
 
@@ -219,6 +257,12 @@ void ImageDescriptor::GetImageInfo(const std::string &filename, uint32 &rows, ui
         _GetJpgImageInfo(filename, rows, cols, bpp);
     else
         throw Exception("unsupported image file extension \"" + extension + "\" for filename: " + filename, __FILE__, __LINE__, __FUNCTION__);
+
+    _ImageInfo &info = _image_info_cache[filename];
+    info.modification_time = file_stat.st_mtime;
+    info.rows = rows;
+    info.cols = cols;
+    info.bpp = bpp;
 }
 
 
@@ -517,8 +561,8 @@ void ImageDescriptor::_DrawOrientation() const
 
     if(VideoManager->_shake_forces.size() > 0) {
         // Calculate x and y draw offsets due to any screen shaking effects
-        float x_shake = VideoManager->_x_shake * (current_context.coordinate_system.GetRight() - current_context.coordinate_system.GetLeft()) / VIDEO_STANDARD_RES_WIDTH;
-        float y_shake = VideoManager->_y_shake * (current_context.coordinate_system.GetTop() - current_context.coordinate_system.GetBottom()) / VIDEO_STANDARD_RES_HEIGHT;
+        float x_shake, y_shake;
+        VideoManager->GetShakeOffsets(x_shake, y_shake);
         x_off += x_shake;
         y_off += y_shake;
     }
@@ -533,45 +577,55 @@ void ImageDescriptor::_DrawOrientation() const
         x_scale = -x_scale;
     if(current_context.coordinate_system.GetVerticalDirection() < 0.0f)
         y_scale = -y_scale;
-    glScalef(x_scale, y_scale, 1.0f);
+    VideoManager->Scale(x_scale, y_scale);
 }
 
 
 
 void ImageDescriptor::_DrawTexture(const Color *draw_color) const
 {
-    // Array of the four vertexes defined on the 2D plane for glDrawArrays()
-    // This is no longer const, because when tiling the background for the menu's
-    // sometimes you need to draw part of a texture
-    float vert_coords[] = {
-        _u1, _v1,
-        _u2, _v1,
-        _u2, _v2,
-        _u1, _v2,
-    };
+    // The four vertexes defined on the 2D plane, transformed by the current modelview transformation
+    // so that images drawn at different places can be sent to OpenGL at once by the sprite batcher.
+    const Transform2D &transform = VideoManager->_transform;
+    float vert_coords[8];
+    transform.Apply(_u1, _v1, vert_coords[0], vert_coords[1]);
+    transform.Apply(_u2, _v1, vert_coords[2], vert_coords[3]);
+    transform.Apply(_u2, _v2, vert_coords[4], vert_coords[5]);
+    transform.Apply(_u1, _v2, vert_coords[6], vert_coords[7]);
 
     // If no color array was passed, use the image's own vertex colors
     if(!draw_color)
         draw_color = _color;
 
-    // Set blending parameters
+    // Unichrome images only have their first vertex color set
+    Color colors[4];
+    if(_unichrome_vertices) {
+        colors[0] = draw_color[0];
+        colors[1] = draw_color[0];
+        colors[2] = draw_color[0];
+        colors[3] = draw_color[0];
+    } else {
+        colors[0] = draw_color[0];
+        colors[1] = draw_color[1];
+        colors[2] = draw_color[2];
+        colors[3] = draw_color[3];
+    }
+
+    // Set blending parameters: 0 = none, 1 = normal, 2 = additive
+    uint8 blend = 0;
     if(VideoManager->_current_context.blend) {
-        VideoManager->EnableBlending();
         if(VideoManager->_current_context.blend == 1)
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // Normal blending
+            blend = 1; // Normal blending
         else
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE); // Additive blending
+            blend = 2; // Additive blending
     } else if(_blend) {
-        VideoManager->EnableBlending();
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // Normal blending
-    } else {
-        VideoManager->DisableBlending();
+        blend = 1; // Normal blending
     }
 
-    VideoManager->EnableVertexArray();
-    glVertexPointer(2, GL_FLOAT, 0, vert_coords);
-
-    // If we have a valid image texture poiner, setup texture coordinates and the texture coordinate array for glDrawArrays()
+    // If we have a valid image texture poiner, setup texture coordinates.
+    // Otherwise there is no image texture, so we're drawing pure color on the vertices
+    float tex_coords[8] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    TexSheet *sheet = NULL;
     if(_texture) {
         // Set the texture coordinates
         float s0, s1, t0, t1;
@@ -595,56 +649,27 @@ void ImageDescriptor::_DrawTexture(const Color *draw_color) const
             t1 = temp;
         }
 
-        // Place the texture coordinates in a 4x2 array mirroring the structure of the vertex array for use in glDrawArrays().
-        float tex_coords[] = {
-            s0, t1,
-            s1, t1,
-            s1, t0,
-            s0, t0,
-        };
-
-        // Enable texturing and bind texture
-        VideoManager->EnableTexture2D();
-        TextureManager->_BindTexture(_texture->texture_sheet->tex_id);
-        _texture->texture_sheet->Smooth(_smooth);
-
-        // Enable and setup the texture coordinate array
-        VideoManager->EnableTextureCoordArray();
-        glTexCoordPointer(2, GL_FLOAT, 0, tex_coords);
-
-        if(_unichrome_vertices) {
-            glColor4fv((GLfloat *)draw_color[0].GetColors());
-            VideoManager->DisableColorArray();
-        } else {
-            VideoManager->EnableColorArray();
-            glColorPointer(4, GL_FLOAT, 0, (GLfloat *)draw_color);
-        }
-    } // if (_texture)
-    else {
-        // Otherwise there is no image texture, so we're drawing pure color on the vertices
-
-        // Use a single call to glColor for unichrome images, or a setup a gl color array for multiple colors
-        if(_unichrome_vertices) {
-            glColor4fv((GLfloat *)draw_color[0].GetColors());
-            VideoManager->DisableColorArray();
-        } else {
-            VideoManager->EnableColorArray();
-            glColorPointer(4, GL_FLOAT, 0, (GLfloat *)draw_color);
-        }
+        // Place the texture coordinates in a 4x2 array mirroring the structure of the vertex array.
+        tex_coords[0] = s0;
+        tex_coords[1] = t1;
+        tex_coords[2] = s1;
+        tex_coords[3] = t1;
+        tex_coords[4] = s1;
+        tex_coords[5] = t0;
+        tex_coords[6] = s0;
+        tex_coords[7] = t0;
 
-        // Disable texturing as we're using pure colour
-        VideoManager->DisableTexture2D();
+        sheet = _texture->texture_sheet;
     }
 
-    // Use a vertex array to draw all of the vertices
-    glDrawArrays(GL_QUADS, 0, 4);
+    // The quad will be drawn along with the following ones sharing the same texture sheet
+    VideoManager->_sprite_batcher.AddQuad(sheet, _smooth, blend, vert_coords, tex_coords, colors);
 } // void ImageDescriptor::_DrawTexture(const Color* color_array) const
 
 
 
 void ImageDescriptor::_GetPngImageInfo(const std::string &filename, uint32 &rows, uint32 &cols, uint32 &bpp) throw(Exception)
 {
-    // first, we start by reading from the file
     FILE *fp = fopen(filename.c_str(), "rb");
 
     if(fp == NULL) {
@@ -652,68 +677,55 @@ void ImageDescriptor::_GetPngImageInfo(const std::string &filename, uint32 &rows
         return;
     }
 
-    // check the signature - make sure it is actually a PNG! otherwise BAD THINGS would happen
-    uint8 test_buffer[8];
-
-    fread(test_buffer, 1, 8, fp);
-    if(png_sig_cmp(test_buffer, 0, 8)) {
-        throw Exception("png_sig_cmp() failed for file: " + filename, __FILE__, __LINE__, __FUNCTION__);
-        fclose(fp);
-        return;
-    }
-
-    // open up our PNG file
-    png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, (png_voidp)NULL, NULL, NULL);
+    // The PNG signature is always followed by the IHDR chunk, which holds the image properties:
+    // the signature (8 bytes), the chunk length (4) and type (4), then the width (4), height (4),
+    // bit depth (1) and color type (1)
+    uint8 header[26];
+    size_t read_size = fread(header, 1, sizeof(header), fp);
+    fclose(fp);
 
-    if(png_ptr == NULL) {
-        fclose(fp);
+    static const uint8 png_signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    if(read_size != sizeof(header) || memcmp(header, png_signature, 8) != 0) {
+        throw Exception("invalid PNG signature for file: " + filename, __FILE__, __LINE__, __FUNCTION__);
         return;
     }
 
-    // grab the info structure
-    png_infop info_ptr = png_create_info_struct(png_ptr);
-
-    if(!info_ptr) {
-        png_destroy_read_struct(&png_ptr, NULL, (png_infopp)NULL);
-        fclose(fp);
-        throw Exception("png_create_info_struct() returned NULL for file: " + filename, __FILE__, __LINE__, __FUNCTION__);
+    if(memcmp(header + 12, "IHDR", 4) != 0) {
+        throw Exception("missing PNG header chunk for file: " + filename, __FILE__, __LINE__, __FUNCTION__);
         return;
     }
 
-    // error checking
-    if(setjmp(png_jmpbuf(png_ptr))) {
-        png_destroy_read_struct(&png_ptr, NULL, (png_infopp)NULL);
-        fclose(fp);
-        throw Exception("setjmp returned non-zero value for file: " + filename, __FILE__, __LINE__, __FUNCTION__);
+    cols = _ReadBigEndian32(header + 16);
+    rows = _ReadBigEndian32(header + 20);
+
+    // The images are always expanded to 8 bits per channel when loaded
+    uint8 color_type = header[25];
+    uint32 channels = 0;
+    switch(color_type) {
+    case 0: // Gray
+        channels = 1;
+        break;
+    case 2: // RGB
+    case 3: // Palette, expanded to RGB
+        channels = 3;
+        break;
+    case 4: // Gray and alpha
+        channels = 2;
+        break;
+    case 6: // RGB and alpha
+        channels = 4;
+        break;
+    default:
+        throw Exception("invalid PNG color type for file: " + filename, __FILE__, __LINE__, __FUNCTION__);
         return;
     }
-
-    // open up the IO stuff and read the PNG
-    png_init_io(png_ptr, fp);
-    png_set_sig_bytes(png_ptr, 8);
-    png_read_png(png_ptr, info_ptr, PNG_TRANSFORM_STRIP_16 | PNG_TRANSFORM_PACKING | PNG_TRANSFORM_EXPAND, NULL);
-
-    // grab the relevant data...
-#if PNG_LIBPNG_VER_SONUM == 15
-    cols = png_get_image_width(png_ptr, info_ptr);
-    rows = png_get_image_height(png_ptr, info_ptr);
-    bpp = png_get_bit_depth(png_ptr, info_ptr) * 8;
-#else
-    cols = info_ptr->width;
-    rows = info_ptr->height;
-    bpp = info_ptr->channels * 8;
-#endif
-
-    // and clean up.
-    png_destroy_read_struct(&png_ptr, &info_ptr, (png_infopp)NULL);
-    fclose(fp);
+    bpp = channels * 8;
 } // void ImageDescriptor::_GetPngImageInfo(const std::string& filename, uint32& rows, uint32& cols, uint32& bpp)
 
 
 
 void ImageDescriptor::_GetJpgImageInfo(const std::string &filename, uint32 &rows, uint32 &cols, uint32 &bpp) throw(Exception)
 {
-    // open up the file (with C IO)
     FILE *fp = fopen(filename.c_str(), "rb");
 
     if(fp == NULL) {
@@ -721,27 +733,50 @@ void ImageDescriptor::_GetJpgImageInfo(const std::string &filename, uint32 &rows
         return;
     }
 
-    // do our magical setup: create a jpeg decompressor and the relevant error stuff
-    jpeg_decompress_struct cinfo;
-    jpeg_error_mgr jerr;
+    // The file must start with the start of image marker
+    uint8 buffer[8];
+    if(fread(buffer, 1, 2, fp) != 2 || buffer[0] != 0xFF || buffer[1] != 0xD8) {
+        fclose(fp);
+        throw Exception("invalid JPG signature for file: " + filename, __FILE__, __LINE__, __FUNCTION__);
+        return;
+    }
 
-    cinfo.err = jpeg_std_error(&jerr);
-    jpeg_create_decompress(&cinfo);
+    // Skip the segments until the start of frame one, which holds the image properties
+    while(true) {
+        if(fread(buffer, 1, 4, fp) != 4 || buffer[0] != 0xFF)
+            break;
 
-    // tell jpeg where to look for the data...
-    jpeg_stdio_src(&cinfo, fp);
-    // and read the header
-    jpeg_read_header(&cinfo, TRUE);
+        // Markers may be padded with any number of 0xFF bytes
+        uint8 marker = buffer[1];
+        if(marker == 0xFF) {
+            fseek(fp, -3, SEEK_CUR);
+            continue;
+        }
 
-    // grab the relevant information from the header...
-    cols = cinfo.output_width;
-    rows = cinfo.output_height;
-    bpp = cinfo.output_components;
+        uint32 length = (static_cast<uint32>(buffer[2]) << 8) | buffer[3];
+        if(length < 2)
+            break;
+
+        // Start of frame markers, except the DHT (0xC4), JPG (0xC8) and DAC (0xCC) ones
+        if(marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            // The precision (1 byte), height (2), width (2) and number of components (1)
+            if(fread(buffer, 1, 6, fp) != 6)
+                break;
+            fclose(fp);
+
+            rows = (static_cast<uint32>(buffer[1]) << 8) | buffer[2];
+            cols = (static_cast<uint32>(buffer[3]) << 8) | buffer[4];
+            bpp = buffer[5] * 8;
+            return;
+        }
 
-    // clean up
-    jpeg_destroy_decompress(&cinfo);
+        // The start of scan marker means there is no frame header before the compressed data
+        if(marker == 0xDA || fseek(fp, length - 2, SEEK_CUR) != 0)
+            break;
+    }
 
     fclose(fp);
+    throw Exception("could not find the JPG frame header for file: " + filename, __FILE__, __LINE__, __FUNCTION__);
 } // void ImageDescriptor::_GetJpgImageInfo(const std::string& filename, uint32& rows, uint32& cols, uint32& bpp)
 
 
@@ -1026,7 +1061,7 @@ void StillImage::Draw(const Color &draw_color) const
         return;
     }
 
-    glPushMatrix();
+    VideoManager->PushMatrix();
     _DrawOrientation();
 
     float modulation = VideoManager->_screen_fader.GetFadeModulation();
@@ -1046,7 +1081,7 @@ void StillImage::Draw(const Color &draw_color) const
         _DrawTexture(modulated_colors);
     }
 
-    glPopMatrix();
+    VideoManager->PopMatrix();
 } // void StillImage::Draw(const Color& draw_color) const
 
 
@@ -1631,7 +1666,7 @@ void CompositeImage::Draw(const Color &draw_color) const
                            coord_sys.GetVerticalDirection();
 
     // Save the draw cursor position as we move to draw each element
-    glPushMatrix();
+    VideoManager->PushMatrix();
 
     VideoManager->MoveRelative(x_align_offset, y_align_offset);
 
@@ -1659,7 +1694,7 @@ void CompositeImage::Draw(const Color &draw_color) const
         x_off += x_shake;
         y_off += y_shake;
 
-        glPushMatrix();
+        VideoManager->PushMatrix();
         VideoManager->MoveRelative(x_off * coord_sys.GetHorizontalDirection(),
                                    y_off * coord_sys.GetVerticalDirection());
 
@@ -1671,7 +1706,7 @@ void CompositeImage::Draw(const Color &draw_color) const
         if(coord_sys.GetVerticalDirection() < 0.0f)
             y_scale = -y_scale;
 
-        glScalef(x_scale, y_scale, 1.0f);
+        VideoManager->Scale(x_scale, y_scale);
 
         if(skip_modulation)
             _elements[i].image._DrawTexture(_color);
@@ -1683,9 +1718,9 @@ void CompositeImage::Draw(const Color &draw_color) const
             modulated_colors[3] = _color[3] * fade_color;
             _elements[i].image._DrawTexture(modulated_colors);
         }
-        glPopMatrix();
+        VideoManager->PopMatrix();
     }
-    glPopMatrix();
+    VideoManager->PopMatrix();
 } // void CompositeImage::Draw(const Color& draw_color) const
 
 
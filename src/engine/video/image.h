@@ -54,6 +54,14 @@ namespace hoa_mode_manager
 class ParticleSystem;
 }
 
+namespace hoa_map
+{
+namespace private_map
+{
+class TileSupervisor;
+}
+}
+
 namespace hoa_video
 {
 
@@ -201,6 +209,9 @@ public:
     *** \param cols The number of columns of pixels in the image
     *** \param bpp The number of bits per pixel of the image
     *** \throw Exception If any of the properties are not retrieved successfully
+    ***
+    *** Only the file header is read, and the properties are kept until the file is
+    *** modified, so that probing the same file again doesn't even open it.
     **/
     static void GetImageInfo(const std::string &filename, uint32 &rows, uint32 &cols, uint32 &bpp) throw(hoa_utils::Exception);
 
@@ -313,7 +324,7 @@ protected:
     void _DrawTexture(const Color *draw_color) const;
 
 private:
-    /** \brief Retrieves various properties about a PNG image file
+    /** \brief Retrieves various properties about a PNG image file, from its IHDR chunk
     *** \param filename The name of the PNG image file to retrieve the properties of
     *** \param rows The number of rows of pixels in the image
     *** \param cols The number of columns of pixels in the image
@@ -322,7 +333,7 @@ private:
     **/
     static void _GetPngImageInfo(const std::string &filename, uint32 &rows, uint32 &cols, uint32 &bpp) throw(hoa_utils::Exception);
 
-    /** \brief Retrieves various properties about a JPG image file
+    /** \brief Retrieves various properties about a JPG image file, from its start of frame segment
     *** \param filename The name of the JPG image file to retrieve the properties of
     *** \param rows The number of rows of pixels in the image
     *** \param cols The number of columns of pixels in the image
@@ -358,6 +369,7 @@ class StillImage : public ImageDescriptor
     friend class CompositeImage;
     friend class TextureController;
     friend class hoa_mode_manager::ParticleSystem;
+    friend class hoa_map::private_map::TileSupervisor;
 
 public:
     //! \brief Supply the constructor with "true" if you want this to represent a grayscale image
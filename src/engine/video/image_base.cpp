@@ -16,16 +16,26 @@
 #include "image_base.h"
 #include "video.h"
 
+#include "engine/system.h"
+
 #include <png.h>
 extern "C" {
 #include <jpeglib.h>
 }
 
 #include <cstdarg>
+#include <cstring>
+#include <iomanip>
 #include <math.h>
 
 #include <SDL_image.h>
 
+#include <sys/stat.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 using namespace hoa_utils;
 
 namespace hoa_video
@@ -34,6 +44,339 @@ namespace hoa_video
 namespace private_video
 {
 
+namespace
+{
+
+//! \brief Set by BenchmarkImageLoading() for the loaded images to be converted by _ConvertWithFormerLoop()
+bool _former_conversion_used = false;
+
+/** \brief Converts a row of pixels of an SDL surface to the RGBA byte order
+*** \param src The first pixel of the surface row
+*** \param dst Where to write the converted pixels, four bytes each
+*** \param width The number of pixels in the row
+*** \param bytes_per_pixel The size of the source pixels
+*** \param swap_red_blue Whether the first and third bytes of each pixel are swapped
+*** \param use_fast_path Whether the SSE2 code is used when available, only disabled for the benchmarks
+***
+*** The color of the fully transparent pixels is also made black, to prevent OpenGL from
+*** averaging it with the neighbouring pixels when smoothing. This removes the white
+*** edges often seen around sprites.
+**/
+void _ConvertPixelRow(const uint8 *src, uint8 *dst, uint32 width, uint32 bytes_per_pixel, bool swap_red_blue,
+                      bool use_fast_path = true)
+{
+    uint32 x = 0;
+
+#if defined(__SSE2__) && SDL_BYTEORDER == SDL_LIL_ENDIAN
+    // Four pixels at a time, handled as 32 bits values
+    if(bytes_per_pixel == 4 && use_fast_path) {
+        const __m128i red_blue_mask = _mm_set1_epi32(0x00FF00FF);
+        const __m128i zero = _mm_setzero_si128();
+
+        for(; x + 4 <= width; x += 4) {
+            __m128i four_pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x * 4));
+            if(swap_red_blue) {
+                // Swaps the 16 bits halves holding the red and blue values
+                __m128i red_blue = _mm_and_si128(four_pixels, red_blue_mask);
+                red_blue = _mm_shufflelo_epi16(red_blue, _MM_SHUFFLE(2, 3, 0, 1));
+                red_blue = _mm_shufflehi_epi16(red_blue, _MM_SHUFFLE(2, 3, 0, 1));
+                four_pixels = _mm_or_si128(_mm_andnot_si128(red_blue_mask, four_pixels), red_blue);
+            }
+            // Clears the pixels with no alpha value
+            __m128i transparent = _mm_cmpeq_epi32(_mm_srli_epi32(four_pixels, 24), zero);
+            four_pixels = _mm_andnot_si128(transparent, four_pixels);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x * 4), four_pixels);
+        }
+    }
+#endif
+
+    const uint8 red_index = swap_red_blue ? 2 : 0;
+    const uint8 blue_index = swap_red_blue ? 0 : 2;
+    for(; x < width; ++x) {
+        const uint8 *src_pixel = src + x * bytes_per_pixel;
+        uint8 *dst_pixel = dst + x * 4;
+        if(src_pixel[3] == 0) {
+            dst_pixel[0] = 0;
+            dst_pixel[1] = 0;
+            dst_pixel[2] = 0;
+            dst_pixel[3] = 0;
+        } else {
+            dst_pixel[0] = src_pixel[red_index];
+            dst_pixel[1] = src_pixel[1];
+            dst_pixel[2] = src_pixel[blue_index];
+            dst_pixel[3] = src_pixel[3];
+        }
+    }
+}
+
+/** \brief Converts RGBA pixels to grayscale, leaving their alpha value unchanged
+***
+*** The grayscale value is computed from the RGB values as 0.30R + 0.59G + 0.11B,
+*** rounded down. The SSE2 code is only skipped when use_fast_path is false.
+**/
+void _ConvertRGBAToGrayscale(uint8 *pixels, uint32 count, bool use_fast_path = true)
+{
+    uint32 i = 0;
+
+#if defined(__SSE2__) && SDL_BYTEORDER == SDL_LIL_ENDIAN
+    const __m128i byte_mask = _mm_set1_epi32(0xFF);
+    const __m128i alpha_mask = _mm_set1_epi32(static_cast<int32>(0xFF000000));
+    const __m128i red_weight = _mm_set1_epi32(30);
+    const __m128i green_weight = _mm_set1_epi32(59);
+    const __m128i blue_weight = _mm_set1_epi32(11);
+    // (x * 5243) >> 19 equals x / 100 for all the possible weighted sums (0 to 25500)
+    const __m128i divisor = _mm_set1_epi32(5243);
+
+    for(; use_fast_path && i + 4 <= count; i += 4) {
+        __m128i four_pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pixels + i * 4));
+        __m128i red = _mm_and_si128(four_pixels, byte_mask);
+        __m128i green = _mm_and_si128(_mm_srli_epi32(four_pixels, 8), byte_mask);
+        __m128i blue = _mm_and_si128(_mm_srli_epi32(four_pixels, 16), byte_mask);
+
+        // The weighted sums fit in the lower 16 bits of each value
+        __m128i sum = _mm_add_epi16(_mm_mullo_epi16(red, red_weight), _mm_mullo_epi16(green, green_weight));
+        sum = _mm_add_epi16(sum, _mm_mullo_epi16(blue, blue_weight));
+        __m128i gray = _mm_srli_epi32(_mm_mulhi_epu16(sum, divisor), 3);
+
+        gray = _mm_or_si128(gray, _mm_or_si128(_mm_slli_epi32(gray, 8), _mm_slli_epi32(gray, 16)));
+        four_pixels = _mm_or_si128(_mm_and_si128(four_pixels, alpha_mask), gray);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(pixels + i * 4), four_pixels);
+    }
+#endif
+
+    for(uint8 *pixel = pixels + i * 4; i < count; ++i, pixel += 4) {
+        uint8 value = static_cast<uint8>((30 * pixel[0] + 59 * pixel[1] + 11 * pixel[2]) / 100);
+        pixel[0] = value;
+        pixel[1] = value;
+        pixel[2] = value;
+    }
+}
+
+//! \brief Removes the alpha value of RGBA pixels, in place
+void _PackRGBAToRGB(uint8 *pixels, uint32 count)
+{
+    // Copying the pixels as 32 or 64 bits values was measured no faster than this loop.
+    for(uint32 i = 0; i < count; ++i) {
+        pixels[i * 3] = pixels[i * 4];
+        pixels[i * 3 + 1] = pixels[i * 4 + 1];
+        pixels[i * 3 + 2] = pixels[i * 4 + 2];
+    }
+}
+
+/** \brief Converts the pixels of an SDL surface to the RGBA byte order, one pixel at a time
+***
+*** This is the conversion loop used before _ConvertPixelRow(), only kept as the reference
+*** the image loading is benchmarked against.
+**/
+void _ConvertWithFormerLoop(const SDL_Surface *surface, uint8 *pixels, bool alpha_format)
+{
+    const uint8 *img_pixel = NULL;
+    uint8 *dst_pixel = NULL;
+    uint32 width = surface->w;
+    uint32 height = surface->h;
+
+    for(uint32 y = 0; y < height; ++y) {
+        for(uint32 x = 0; x < width; ++x) {
+            img_pixel = static_cast<const uint8 *>(surface->pixels) + y * surface->pitch + x * surface->format->BytesPerPixel;
+            dst_pixel = pixels + ((y * width) + x) * 4;
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+            if(alpha_format) {
+                dst_pixel[0] = img_pixel[0];
+                dst_pixel[1] = img_pixel[1];
+                dst_pixel[2] = img_pixel[2];
+                dst_pixel[3] = img_pixel[3];
+            } else {
+                dst_pixel[2] = img_pixel[0];
+                dst_pixel[1] = img_pixel[1];
+                dst_pixel[0] = img_pixel[2];
+                dst_pixel[3] = img_pixel[3];
+            }
+#else
+            if(alpha_format) {
+                dst_pixel[2] = img_pixel[0];
+                dst_pixel[1] = img_pixel[1];
+                dst_pixel[0] = img_pixel[2];
+                dst_pixel[3] = img_pixel[3];
+            } else {
+                dst_pixel[0] = img_pixel[0];
+                dst_pixel[1] = img_pixel[1];
+                dst_pixel[2] = img_pixel[2];
+                dst_pixel[3] = img_pixel[3];
+            }
+#endif
+            // GL_LINEAR white artifact removal
+            if(dst_pixel[3] == 0) {
+                dst_pixel[0] = 0;
+                dst_pixel[1] = 0;
+                dst_pixel[2] = 0;
+            }
+        }
+    }
+}
+
+//! \brief Adds the .png and .jpg files of a directory and of its subdirectories to the list
+void _ListImageFiles(const std::string &directory, std::vector<std::string> &image_files)
+{
+    std::vector<std::string> files = ListDirectory(directory, "");
+    for(uint32 i = 0; i < files.size(); ++i) {
+        if(files[i] == "." || files[i] == "..")
+            continue;
+
+        std::string filename = directory + "/" + files[i];
+        struct stat file_info;
+        if(stat(filename.c_str(), &file_info) != 0)
+            continue;
+
+        if(S_ISDIR(file_info.st_mode)) {
+            _ListImageFiles(filename, image_files);
+            continue;
+        }
+
+        if(filename.size() < 4)
+            continue;
+        std::string extension = filename.substr(filename.size() - 4);
+        if(extension == ".png" || extension == ".jpg")
+            image_files.push_back(filename);
+    }
+}
+
+//! \brief Prints whether the fast and scalar paths of a pixel conversion gave the same results, and their times
+void _PrintConversionResults(const std::string &name, bool same_results, uint32 fast_time, uint32 scalar_time)
+{
+    std::cout << name << ": " << (same_results ? "same results" : "DIFFERENT RESULTS")
+              << ", fast path " << fast_time << " us, scalar path " << scalar_time << " us";
+    if(fast_time > 0)
+        std::cout << " (" << std::fixed << std::setprecision(2)
+                  << static_cast<float>(scalar_time) / fast_time << "x)";
+    std::cout << std::endl;
+}
+
+} // anonymous namespace
+
+bool BenchmarkPixelConversions()
+{
+    bool success = true;
+
+    // Every value of every byte, the alpha value included, is found in the row. The last
+    // pixels are always converted by the scalar code, as the row width isn't a multiple of 4.
+    const uint32 row_width = 256 * 256 + 3;
+    std::vector<uint8> row(row_width * 4);
+    for(uint32 i = 0; i < row_width; ++i) {
+        row[i * 4] = static_cast<uint8>(i);
+        row[i * 4 + 1] = static_cast<uint8>(i >> 8);
+        row[i * 4 + 2] = static_cast<uint8>(i + (i >> 8));
+        row[i * 4 + 3] = static_cast<uint8>(i ^ (i >> 8));
+    }
+    std::vector<uint8> fast_result(row_width * 4);
+    std::vector<uint8> scalar_result(row_width * 4);
+
+    // The rows are converted several times for the times to be measurable
+    const uint32 runs = 100;
+    for(uint32 swap = 0; swap < 2; ++swap) {
+        uint32 start = hoa_system::GetProfileTime();
+        for(uint32 run = 0; run < runs; ++run)
+            _ConvertPixelRow(&row[0], &fast_result[0], row_width, 4, swap == 1, true);
+        uint32 fast_time = hoa_system::GetProfileTime() - start;
+
+        start = hoa_system::GetProfileTime();
+        for(uint32 run = 0; run < runs; ++run)
+            _ConvertPixelRow(&row[0], &scalar_result[0], row_width, 4, swap == 1, false);
+        uint32 scalar_time = hoa_system::GetProfileTime() - start;
+
+        bool same_results = (fast_result == scalar_result);
+        success = success && same_results;
+        _PrintConversionResults(swap == 1 ? "Pixel rows conversion, red and blue swapped" : "Pixel rows conversion",
+                                same_results, fast_time, scalar_time);
+    }
+
+    // The grayscale values depend on the three colors, so all their combinations are checked,
+    // one red value at a time.
+    uint32 fast_time = 0;
+    uint32 scalar_time = 0;
+    bool same_results = true;
+    for(uint32 red = 0; red < 256; ++red) {
+        for(uint32 i = 0; i < row_width; ++i) {
+            fast_result[i * 4] = static_cast<uint8>(red);
+            fast_result[i * 4 + 1] = static_cast<uint8>(i);
+            fast_result[i * 4 + 2] = static_cast<uint8>(i >> 8);
+            fast_result[i * 4 + 3] = static_cast<uint8>(i + red);
+        }
+        scalar_result = fast_result;
+
+        uint32 start = hoa_system::GetProfileTime();
+        _ConvertRGBAToGrayscale(&fast_result[0], row_width, true);
+        fast_time += hoa_system::GetProfileTime() - start;
+
+        start = hoa_system::GetProfileTime();
+        _ConvertRGBAToGrayscale(&scalar_result[0], row_width, false);
+        scalar_time += hoa_system::GetProfileTime() - start;
+
+        same_results = same_results && (fast_result == scalar_result);
+    }
+    success = success && same_results;
+    _PrintConversionResults("Grayscale conversion", same_results, fast_time, scalar_time);
+
+    return success;
+} // bool BenchmarkPixelConversions()
+
+bool BenchmarkImageLoading(const std::string &directory)
+{
+    std::vector<std::string> image_files;
+    _ListImageFiles(directory, image_files);
+    if(image_files.empty()) {
+        PRINT_ERROR << "No image found in the directory: " << directory << std::endl;
+        return false;
+    }
+
+    bool success = true;
+    uint32 former_time = 0;
+    uint32 current_time = 0;
+    uint32 different_images = 0;
+    for(uint32 i = 0; i < image_files.size(); ++i) {
+        // The first load isn't timed, so that both conversions find the file in the disk cache
+        ImageMemory former_image;
+        if(!former_image.LoadImage(image_files[i])) {
+            success = false;
+            continue;
+        }
+        free(former_image.pixels);
+        former_image.pixels = NULL;
+
+        _former_conversion_used = true;
+        uint32 start = hoa_system::GetProfileTime();
+        bool loaded = former_image.LoadImage(image_files[i]);
+        former_time += hoa_system::GetProfileTime() - start;
+        _former_conversion_used = false;
+
+        ImageMemory current_image;
+        start = hoa_system::GetProfileTime();
+        loaded = current_image.LoadImage(image_files[i]) && loaded;
+        current_time += hoa_system::GetProfileTime() - start;
+
+        if(loaded && (former_image.width != current_image.width || former_image.height != current_image.height
+                      || memcmp(former_image.pixels, current_image.pixels, current_image.width * current_image.height * 4) != 0)) {
+            std::cout << image_files[i] << ": DIFFERENT PIXELS" << std::endl;
+            ++different_images;
+        }
+        success = success && loaded;
+
+        free(former_image.pixels);
+        former_image.pixels = NULL;
+        free(current_image.pixels);
+        current_image.pixels = NULL;
+    }
+    success = success && different_images == 0;
+
+    std::cout << image_files.size() << " images loaded from " << directory << ": "
+              << (different_images == 0 ? "same pixels" : "DIFFERENT PIXELS")
+              << ", former loop " << former_time << " us, current conversion " << current_time << " us";
+    if(current_time > 0)
+        std::cout << " (" << std::fixed << std::setprecision(2)
+                  << static_cast<float>(former_time) / current_time << "x)";
+    std::cout << std::endl;
+    return success;
+} // bool BenchmarkImageLoading(const std::string &directory)
+
 // -----------------------------------------------------------------------------
 // ImageMemory class
 // -----------------------------------------------------------------------------
@@ -68,16 +411,35 @@ bool ImageMemory::LoadImage(const std::string &filename)
         pixels = NULL;
     }
 
+    // The image may have been decoded in advance by the image loader
+    if(TextureManager != NULL && TextureManager->_image_loader.TakeDecodedImage(filename, *this))
+        return true;
+
+    return _DecodeImage(filename);
+}
+
+
+
+bool ImageMemory::_DecodeImage(const std::string &filename)
+{
     SDL_Surface *temp_surf = NULL;
     SDL_Surface *alpha_surf = NULL;
 
+    if(TextureManager != NULL)
+        TextureManager->_image_loader.LockDecoding();
+
     if((temp_surf = IMG_Load(filename.c_str())) == NULL) {
+        if(TextureManager != NULL)
+            TextureManager->_image_loader.UnlockDecoding();
         PRINT_ERROR << "Couldn't load image file: " << filename << std::endl;
         return false;
     }
 
     alpha_surf = SDL_DisplayFormatAlpha(temp_surf);
 
+    if(TextureManager != NULL)
+        TextureManager->_image_loader.UnlockDecoding();
+
     // Tells whether the alpha image will be used
     bool alpha_format = true;
     if(alpha_surf == NULL) {
@@ -95,47 +457,18 @@ bool ImageMemory::LoadImage(const std::string &filename)
     rgb_format = false;
 
     // convert the data so that it works in our format
-    uint8 *img_pixel = NULL;
-    uint8 *dst_pixel = NULL;
-
-    for(uint32 y = 0; y < height; ++y) {
-        for(uint32 x = 0; x < width; ++x) {
-            img_pixel = (uint8 *)alpha_surf->pixels + y * alpha_surf->pitch + x * alpha_surf->format->BytesPerPixel;
-            dst_pixel = ((uint8 *)pixels) + ((y * width) + x) * 4;
 #if SDL_BYTEORDER == SDL_BIG_ENDIAN
-            if(alpha_format) {
-                dst_pixel[0] = img_pixel[0];
-                dst_pixel[1] = img_pixel[1];
-                dst_pixel[2] = img_pixel[2];
-                dst_pixel[3] = img_pixel[3];
-            } else {
-                dst_pixel[2] = img_pixel[0];
-                dst_pixel[1] = img_pixel[1];
-                dst_pixel[0] = img_pixel[2];
-                dst_pixel[3] = img_pixel[3];
-            }
+    bool swap_red_blue = !alpha_format;
 #else
-            if(alpha_format) {
-                dst_pixel[2] = img_pixel[0];
-                dst_pixel[1] = img_pixel[1];
-                dst_pixel[0] = img_pixel[2];
-                dst_pixel[3] = img_pixel[3];
-            } else {
-                dst_pixel[0] = img_pixel[0];
-                dst_pixel[1] = img_pixel[1];
-                dst_pixel[2] = img_pixel[2];
-                dst_pixel[3] = img_pixel[3];
-            }
+    bool swap_red_blue = alpha_format;
 #endif
-            // GL_LINEAR white artifact removal
-            // Make the r,g,b values black to prevent OpenGL to make linear average with
-            // another color when smoothing.
-            // This is removing the white edges often seen on sprites.
-            if(dst_pixel[3] == 0) {
-                dst_pixel[0] = 0;
-                dst_pixel[1] = 0;
-                dst_pixel[2] = 0;
-            }
+    if(_former_conversion_used) {
+        _ConvertWithFormerLoop(alpha_surf, static_cast<uint8 *>(pixels), alpha_format);
+    } else {
+        for(uint32 y = 0; y < height; ++y) {
+            _ConvertPixelRow(static_cast<uint8 *>(alpha_surf->pixels) + y * alpha_surf->pitch,
+                             static_cast<uint8 *>(pixels) + y * width * 4,
+                             width, alpha_surf->format->BytesPerPixel, swap_red_blue);
         }
     }
 
@@ -176,16 +509,19 @@ void ImageMemory::ConvertToGrayscale()
         return;
     }
 
-    uint8 format_bytes = (rgb_format ? 3 : 4);
-    uint8 *end_position = static_cast<uint8 *>(pixels) + (width * height * format_bytes);
+    if(!rgb_format) {
+        _ConvertRGBAToGrayscale(static_cast<uint8 *>(pixels), width * height);
+        return;
+    }
+
+    uint8 *end_position = static_cast<uint8 *>(pixels) + (width * height * 3);
 
-    for(uint8 *i = static_cast<uint8 *>(pixels); i < end_position; i += format_bytes) {
+    for(uint8 *i = static_cast<uint8 *>(pixels); i < end_position; i += 3) {
         // Compute the grayscale value for this pixel based on RGB values: 0.30R + 0.59G + 0.11B
-        uint8 value = static_cast<uint8>((30 * *(i) + 59 * *(i + 1) + 11 * *(i + 2)) * 0.01f);
+        uint8 value = static_cast<uint8>((30 * *(i) + 59 * *(i + 1) + 11 * *(i + 2)) / 100);
         *i = value;
         *(i + 1) = value;
         *(i + 2) = value;
-        // *(i + 3) for RGBA is the alpha value and is left unmodified
     }
 }
 
@@ -207,15 +543,7 @@ void ImageMemory::RGBAToRGB()
         return;
     }
 
-    uint8 *pixel_index = static_cast<uint8 *>(pixels);
-    uint8 *pixel_source = pixel_index;
-
-    for(uint32 i = 0; i < height * width; ++i, pixel_index += 4) {
-        int32 index = 3 * i;
-        pixel_source[index] = *pixel_index;
-        pixel_source[index + 1] = *(pixel_index + 1);
-        pixel_source[index + 2] = *(pixel_index + 2);
-    }
+    _PackRGBAToRGB(static_cast<uint8 *>(pixels), width * height);
 
     // Reduce the memory consumed by 1/4 since we no longer need to contain alpha data
     void *new_pixels = realloc(pixels, width * height * 3);
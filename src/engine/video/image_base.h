@@ -63,6 +63,8 @@ namespace private_video
 *** ***************************************************************************/
 class ImageMemory
 {
+    friend class ImageLoader;
+
 public:
     ImageMemory();
 
@@ -83,6 +85,8 @@ public:
     /** \brief Loads raw image data from a file and stores the data in the class members
     *** \param file_name The filename of the image to load, which should have a .png or .jpg extension
     *** \return True if the image was loaded successfully, false if it was not
+    ***
+    *** If the file was prefetched by the image loader, its decoded data is used instead.
     **/
     bool LoadImage(const std::string &filename);
 
@@ -124,6 +128,13 @@ public:
     void CopyFromImage(BaseTexture *img);
 
 private:
+    /** \brief Reads and decodes an image file
+    *** \param filename The filename of the image to load
+    *** \return True if the image was loaded successfully, false if it was not
+    *** \note This is called by the image loader thread as well.
+    **/
+    bool _DecodeImage(const std::string &filename);
+
     /** \brief Saves image data to a PNG file
     *** \param filename Name of the file, without the extension
     *** \return True if the process was carried out with no problem, false otherwise
@@ -280,6 +291,22 @@ private:
     ImageTexture &operator=(const ImageTexture &copy);
 }; // class ImageTexture : public BaseTexture
 
+/** \brief Checks the fast paths of the pixel conversions done when loading the images against their scalar code
+*** \return False if any conversion gave different results.
+***
+*** All the byte values are converted by both paths, whose times are printed.
+**/
+bool BenchmarkPixelConversions();
+
+/** \brief Loads all the .png and .jpg images of a directory tree with ImageMemory::LoadImage(), twice
+*** \param directory The directory the images are looked for in, recursively
+*** \return False if an image couldn't be loaded, or if any was given different pixels.
+***
+*** Each image is loaded once with the pixel conversion loop used before _ConvertPixelRow(),
+*** and once with the current conversion. The total times of both are printed.
+**/
+bool BenchmarkImageLoading(const std::string &directory);
+
 } // namespace private_video
 
 } // namespace hoa_video
@@ -0,0 +1,343 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012 by Bertram
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    image_loader.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fre
+*** \brief   Source file for the background image loader
+*** ***************************************************************************/
+
+#include "image_loader.h"
+
+#include "video.h"
+
+#include <algorithm>
+
+using namespace hoa_utils;
+using namespace hoa_system;
+
+namespace hoa_video
+{
+
+namespace private_video
+{
+
+ImageLoader::ImageLoader() :
+    _thread(NULL),
+    _thread_done(false),
+    _requests_semaphore(NULL),
+    _work_semaphore(NULL),
+    _decoding_semaphore(NULL)
+{}
+
+
+
+ImageLoader::~ImageLoader()
+{
+    Shutdown();
+}
+
+
+
+void ImageLoader::Prefetch(const std::string &filename, uint32 grid_rows, uint32 grid_cols)
+{
+    if(filename.empty())
+        return;
+
+    // Nothing to do when the image is already in texture memory
+    std::string nametag = filename;
+    if(grid_rows > 0 && grid_cols > 0)
+        nametag += "<X0_" + NumberToString(grid_rows) + "><Y0_" + NumberToString(grid_cols) + ">";
+    if(TextureManager->_IsImageTextureRegistered(nametag))
+        return;
+
+    // The filenames are never changed once set, so they can be read without locking
+    for(std::list<_Request *>::iterator it = _requests.begin(); it != _requests.end(); ++it) {
+        if((*it)->filename == filename)
+            return;
+    }
+
+    if(!_StartThread())
+        return;
+
+    _Request *request = new _Request();
+    request->filename = filename;
+    request->grid_rows = grid_rows;
+    request->grid_cols = grid_cols;
+    request->state = REQUEST_PENDING;
+
+    SystemManager->LockThread(_requests_semaphore);
+    _requests.push_back(request);
+    SystemManager->UnlockThread(_requests_semaphore);
+
+    // Wakes the loader thread up
+    SystemManager->UnlockThread(_work_semaphore);
+}
+
+
+
+bool ImageLoader::TakeDecodedImage(const std::string &filename, ImageMemory &image)
+{
+    if(_requests.empty())
+        return false;
+
+    while(true) {
+        SystemManager->LockThread(_requests_semaphore);
+
+        _Request *request = NULL;
+        for(std::list<_Request *>::iterator it = _requests.begin(); it != _requests.end(); ++it) {
+            if((*it)->filename == filename) {
+                request = *it;
+                break;
+            }
+        }
+
+        if(request == NULL) {
+            SystemManager->UnlockThread(_requests_semaphore);
+            return false;
+        }
+
+        // Waiting for the loader thread is still faster than decoding the file again
+        if(request->state == REQUEST_DECODING) {
+            SystemManager->UnlockThread(_requests_semaphore);
+            SDL_Delay(1);
+            continue;
+        }
+
+        // A pending request is dropped, as the caller will decode the file itself
+        bool decoded = (request->state == REQUEST_DECODED);
+        if(decoded) {
+            image.width = request->image.width;
+            image.height = request->image.height;
+            image.rgb_format = request->image.rgb_format;
+            image.pixels = request->image.pixels;
+            request->image.pixels = NULL;
+        }
+        _DeleteRequest(request);
+
+        SystemManager->UnlockThread(_requests_semaphore);
+        return decoded;
+    }
+}
+
+
+
+void ImageLoader::Update()
+{
+    if(_requests.empty())
+        return;
+
+    uint32 start_time = GetProfileTime();
+    do {
+        SystemManager->LockThread(_requests_semaphore);
+        // Failed requests are dropped, the error will show up again when the image is really loaded
+        _Request *request = NULL;
+        while((request = _FindRequest(REQUEST_FAILED)) != NULL)
+            _DeleteRequest(request);
+        request = _FindRequest(REQUEST_DECODED);
+        SystemManager->UnlockThread(_requests_semaphore);
+
+        if(request == NULL)
+            return;
+
+        // The images load takes the decoded data from the request, which gets deleted
+        std::string filename = request->filename;
+        uint32 grid_rows = request->grid_rows;
+        uint32 grid_cols = request->grid_cols;
+
+        std::vector<StillImage> *images = NULL;
+        bool loaded = false;
+        if(grid_rows > 0 && grid_cols > 0) {
+            images = new std::vector<StillImage>(grid_rows * grid_cols);
+            loaded = ImageDescriptor::LoadMultiImageFromElementGrid(*images, filename, grid_rows, grid_cols);
+        } else {
+            images = new std::vector<StillImage>(1);
+            loaded = images->front().Load(filename);
+        }
+
+        if(loaded) {
+            _prefetched_images.push_back(images);
+        } else {
+            IF_PRINT_WARNING(VIDEO_DEBUG) << "failed to load prefetched image: " << filename << std::endl;
+            delete images;
+        }
+
+        // If the image was already in texture memory, the request wasn't taken
+        SystemManager->LockThread(_requests_semaphore);
+        std::list<_Request *>::iterator it = std::find(_requests.begin(), _requests.end(), request);
+        if(it != _requests.end())
+            _DeleteRequest(request);
+        SystemManager->UnlockThread(_requests_semaphore);
+    } while(GetProfileTime() - start_time < IMAGE_LOADER_UPLOAD_TIME);
+}
+
+
+
+void ImageLoader::ReleasePrefetchedImages()
+{
+    for(uint32 i = 0; i < _prefetched_images.size(); ++i)
+        delete _prefetched_images[i];
+    _prefetched_images.clear();
+
+    if(_requests.empty())
+        return;
+
+    // The requests being decoded are kept, they will be uploaded and released later on
+    SystemManager->LockThread(_requests_semaphore);
+    for(std::list<_Request *>::iterator it = _requests.begin(); it != _requests.end();) {
+        _Request *request = *it;
+        ++it;
+        if(request->state != REQUEST_DECODING)
+            _DeleteRequest(request);
+    }
+    SystemManager->UnlockThread(_requests_semaphore);
+}
+
+
+
+void ImageLoader::Shutdown()
+{
+    if(_thread != NULL) {
+        _thread_done = true;
+        SystemManager->UnlockThread(_work_semaphore);
+        SystemManager->WaitForThread(_thread);
+        _thread = NULL;
+    }
+
+    for(uint32 i = 0; i < _prefetched_images.size(); ++i)
+        delete _prefetched_images[i];
+    _prefetched_images.clear();
+
+    while(!_requests.empty())
+        _DeleteRequest(_requests.front());
+
+    if(_requests_semaphore != NULL) {
+        SystemManager->DestroySemaphore(_requests_semaphore);
+        SystemManager->DestroySemaphore(_work_semaphore);
+        SystemManager->DestroySemaphore(_decoding_semaphore);
+        _requests_semaphore = NULL;
+        _work_semaphore = NULL;
+        _decoding_semaphore = NULL;
+    }
+}
+
+
+
+void ImageLoader::LockDecoding()
+{
+    if(_decoding_semaphore != NULL)
+        SystemManager->LockThread(_decoding_semaphore);
+}
+
+
+
+void ImageLoader::UnlockDecoding()
+{
+    if(_decoding_semaphore != NULL)
+        SystemManager->UnlockThread(_decoding_semaphore);
+}
+
+
+
+bool ImageLoader::_StartThread()
+{
+    if(_thread != NULL)
+        return true;
+
+    // The map editor has no system engine, and never prefetches images anyway
+    if(SystemManager == NULL)
+        return false;
+
+#if (THREAD_TYPE == SDL_THREADS)
+    _requests_semaphore = SystemManager->CreateSemaphore(1);
+    _work_semaphore = SystemManager->CreateSemaphore(0);
+    _decoding_semaphore = SystemManager->CreateSemaphore(1);
+    _thread_done = false;
+
+    _thread = SystemManager->SpawnThread(&ImageLoader::_DecodeImages, this);
+    if(_thread == NULL) {
+        SystemManager->DestroySemaphore(_requests_semaphore);
+        SystemManager->DestroySemaphore(_work_semaphore);
+        SystemManager->DestroySemaphore(_decoding_semaphore);
+        _requests_semaphore = NULL;
+        _work_semaphore = NULL;
+        _decoding_semaphore = NULL;
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+
+ImageLoader::_Request *ImageLoader::_FindRequest(REQUEST_STATE state)
+{
+    for(std::list<_Request *>::iterator it = _requests.begin(); it != _requests.end(); ++it) {
+        if((*it)->state == state)
+            return *it;
+    }
+    return NULL;
+}
+
+
+
+void ImageLoader::_DeleteRequest(_Request *request)
+{
+    if(request->image.pixels != NULL) {
+        free(request->image.pixels);
+        request->image.pixels = NULL;
+    }
+    _requests.remove(request);
+    delete request;
+}
+
+
+
+void ImageLoader::_DecodeImages()
+{
+    while(true) {
+        // Waits for a request
+        SystemManager->LockThread(_work_semaphore);
+        if(_thread_done)
+            return;
+
+        SystemManager->LockThread(_requests_semaphore);
+        _Request *request = _FindRequest(REQUEST_PENDING);
+        if(request != NULL)
+            request->state = REQUEST_DECODING;
+        SystemManager->UnlockThread(_requests_semaphore);
+
+        // The request may have been taken over by the main thread in the meantime
+        if(request == NULL)
+            continue;
+
+        // The main thread never deletes a request being decoded
+        ImageMemory image;
+        bool decoded = image._DecodeImage(request->filename);
+
+        SystemManager->LockThread(_requests_semaphore);
+        if(decoded) {
+            request->image.width = image.width;
+            request->image.height = image.height;
+            request->image.rgb_format = image.rgb_format;
+            request->image.pixels = image.pixels;
+            image.pixels = NULL;
+            request->state = REQUEST_DECODED;
+        } else {
+            request->state = REQUEST_FAILED;
+        }
+        SystemManager->UnlockThread(_requests_semaphore);
+    }
+}
+
+} // namespace private_video
+
+} // namespace hoa_video
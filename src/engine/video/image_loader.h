@@ -0,0 +1,160 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012 by Bertram
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    image_loader.h
+*** \author  Yohann Ferreira, yohann ferreira orange fre
+*** \brief   Header file for the background image loader
+***
+*** Decoding image files is by far the slowest part of loading an image. The
+*** image loader decodes the files it is asked to prefetch in a separate
+*** thread, then inserts them in texture sheets on the main thread, a few at
+*** a time each frame. When the images are later loaded normally, they are
+*** either found already in texture memory, or their decoded data is taken
+*** from the loader instead of reading the file again.
+*** ***************************************************************************/
+
+#ifndef __IMAGE_LOADER_HEADER__
+#define __IMAGE_LOADER_HEADER__
+
+#include "utils.h"
+#include "image_base.h"
+
+#include "engine/system.h"
+
+#include <list>
+
+namespace hoa_video
+{
+
+class StillImage;
+
+namespace private_video
+{
+
+//! \brief The maximum time spent in uploading prefetched images each frame, in microseconds
+const uint32 IMAGE_LOADER_UPLOAD_TIME = 3000;
+
+/** ****************************************************************************
+*** \brief Decodes image files in a background thread
+***
+*** The loader thread is only started at the first prefetch request, so that
+*** programs never prefetching images, like the map editor, don't use it.
+***
+*** \note All the methods must be called from the main thread. The thread only
+*** decodes the files and changes the state of the requests.
+*** ***************************************************************************/
+class ImageLoader
+{
+public:
+    ImageLoader();
+
+    ~ImageLoader();
+
+    /** \brief Requests an image file to be loaded in advance
+    *** \param filename The name of the image file
+    *** \param grid_rows The number of rows of the image grid, or 0 for a single image
+    *** \param grid_cols The number of columns of the image grid, or 0 for a single image
+    ***
+    *** The grid dimensions must be the ones given later to the
+    *** ImageDescriptor::LoadMultiImageFromElementGrid() call, so that the sub-images
+    *** are found in texture memory.
+    **/
+    void Prefetch(const std::string &filename, uint32 grid_rows, uint32 grid_cols);
+
+    /** \brief Gives the decoded data of an image file, if it was prefetched
+    *** \param filename The name of the image file
+    *** \param image The image memory which receives the pixels
+    *** \return False if the file was not decoded in advance, in which case it has to be read as usual.
+    ***
+    *** If the file is being decoded, this waits for the decoding to end.
+    **/
+    bool TakeDecodedImage(const std::string &filename, ImageMemory &image);
+
+    //! \brief Inserts the decoded images in texture sheets, until the time given for this frame is spent.
+    void Update();
+
+    /** \brief Drops the references kept on the prefetched images, and any request not yet decoded
+    ***
+    *** This should be called once the images were loaded by their final user. The
+    *** prefetched images not used in the meantime are then freed.
+    **/
+    void ReleasePrefetchedImages();
+
+    //! \brief Returns the images uploaded in advance and not yet released
+    const std::vector<std::vector<StillImage> *> &GetPrefetchedImages() const {
+        return _prefetched_images;
+    }
+
+    //! \brief Stops the loader thread and frees everything. Called before the texture sheets are deleted.
+    void Shutdown();
+
+    //! \brief Locks and unlocks the image file decoding, which the image library doesn't support in several threads at once.
+    //@{
+    void LockDecoding();
+    void UnlockDecoding();
+    //@}
+
+private:
+    //! \brief The states of an image request
+    enum REQUEST_STATE {
+        REQUEST_PENDING,
+        REQUEST_DECODING,
+        REQUEST_DECODED,
+        REQUEST_FAILED
+    };
+
+    //! \brief An image file to load in advance
+    struct _Request {
+        std::string filename;
+        uint32 grid_rows;
+        uint32 grid_cols;
+        REQUEST_STATE state;
+        ImageMemory image;
+    };
+
+    //! \brief The requests not yet uploaded, in the order they were made. Only the main thread adds or removes elements.
+    std::list<_Request *> _requests;
+
+    //! \brief The images uploaded in advance, kept until ReleasePrefetchedImages() is called
+    std::vector<std::vector<StillImage> *> _prefetched_images;
+
+    //! \brief The loader thread, or NULL if it was not started
+    Thread *_thread;
+
+    //! \brief Set to true to make the loader thread exit
+    volatile bool _thread_done;
+
+    //! \brief Protects the requests list and the requests members
+    Semaphore *_requests_semaphore;
+
+    //! \brief Counts the requests the loader thread has to handle
+    Semaphore *_work_semaphore;
+
+    //! \brief Serializes the image files decoding between the threads
+    Semaphore *_decoding_semaphore;
+
+    //! \brief Starts the loader thread, if it is not already running
+    bool _StartThread();
+
+    //! \brief Returns the first request in the given state, or NULL. The requests semaphore must be locked.
+    _Request *_FindRequest(REQUEST_STATE state);
+
+    //! \brief Removes a request from the list and frees it. The requests semaphore must be locked.
+    void _DeleteRequest(_Request *request);
+
+    //! \brief The loader thread loop
+    void _DecodeImages();
+}; // class ImageLoader
+
+} // namespace private_video
+
+} // namespace hoa_video
+
+#endif // __IMAGE_LOADER_HEADER__
@@ -12,11 +12,11 @@
  * \author  Raj Sharma, roos@allacrost.org
  * \brief   Header file for particle data
  *
- * This file contains structure(s) for representing a single particle. In theory,
- * we should be able to just have one structure which holds all properties for
- * a particle, but in fact we have two: one for the position, and one for everything
- * else. The reason is that having the positions separated is more efficient
- * for rendering.
+ * This file contains the structures for representing the particles of a system.
+ * The particle properties are stored as one array per property rather than one
+ * structure per particle, so that the update loops only touch the properties
+ * they work on, and can be vectorized by the compiler. The vertices generated
+ * for rendering are stored apart, in the format expected by OpenGL.
  *****************************************************************************/
 
 #ifndef __PARTICLE_HEADER__
@@ -70,133 +70,117 @@ public:
 
 
 /*!***************************************************************************
- *  \brief this is the structure we use to represent a particle
+ *  \brief this is the structure we use to represent the particles of a system.
+ *         Each property is an array holding its value for every particle, the
+ *         particle at index i having its properties at index i of each array.
  *****************************************************************************/
 
-
-class Particle
+class ParticleArray
 {
 public:
-    Particle():
-        x(0.0f),
-        y(0.0f),
-        size_x(0.0f),
-        size_y(0.0f),
-        velocity_x(0.0f),
-        velocity_y(0.0f),
-        combined_velocity_x(0.0f),
-        combined_velocity_y(0.0f),
-        rotation_angle(0.0f),
-        rotation_speed(0.0f),
-        time(0.0f),
-        lifetime(0.0f),
-        wave_length_coefficient(0.0f),
-        wave_half_amplitude(0.0f),
-        acceleration_x(0.0f),
-        acceleration_y(0.0f),
-        tangential_acceleration(0.0f),
-        radial_acceleration(0.0f),
-        wind_velocity_x(0.0f),
-        wind_velocity_y(0.0f),
-        damping(0.0f),
-        rotation_direction(0.0f),
-        current_size_variation_x(0.0f),
-        current_size_variation_y(0.0f),
-        next_size_variation_x(0.0f),
-        next_size_variation_y(0.0f),
-        current_rotation_speed_variation(0.0f),
-        next_rotation_speed_variation(0.0f),
-        current_keyframe(NULL),
-        next_keyframe(NULL)
-    {}
+    /*!
+     *  \brief sets the number of particles the arrays can hold
+     * \param size the number of particles
+     */
+    void Resize(size_t size);
+
+    /*!
+     *  \brief frees the arrays
+     */
+    void Clear();
+
+    /*!
+     *  \brief copies the properties of the particle at index src to the one at index dest
+     */
+    void Move(size_t src, size_t dest);
 
     //! position
-    float x;
-    float y;
+    std::vector<float> x;
+    std::vector<float> y;
 
     //! size
-    float size_x;
-    float size_y;
+    std::vector<float> size_x;
+    std::vector<float> size_y;
 
     //! velocity
-    float velocity_x;
-    float velocity_y;
+    std::vector<float> velocity_x;
+    std::vector<float> velocity_y;
 
     //! store the combined velocity (particle + wind + wave) so we only have
     //! to calculate it once
-    float combined_velocity_x;
-    float combined_velocity_y;
+    std::vector<float> combined_velocity_x;
+    std::vector<float> combined_velocity_y;
 
     //! color
-    hoa_video::Color color;
+    std::vector<hoa_video::Color> color;
 
     //! current rotation angle
-    float rotation_angle;
+    std::vector<float> rotation_angle;
 
     //! rotation speed
-    float rotation_speed;
+    std::vector<float> rotation_speed;
 
     //! seconds since particle was spawned
-    float time;
+    std::vector<float> time;
 
     //! lifetime (when the particle is supposed to die)
-    float lifetime;
+    std::vector<float> lifetime;
 
     //! this is 2 * pi / wavelength. The reason we store this weird
     //! number instead of the wavelength is because that's what we
     //! will ultimately plug into the sin function
-    float wave_length_coefficient;
+    std::vector<float> wave_length_coefficient;
 
     //! half the amplitude of the wave. We store half the amplitude
     //! instead of the whole amplitude because that's what gets multiplied
     //! with the sin function
-    float wave_half_amplitude;
+    std::vector<float> wave_half_amplitude;
 
     //! acceleration, i.e. change in velocity per second. The most common use
     //! for this is for simulating gravity. If you have multiple constant
     //! forces acting on particles, then this vector should be the sum of
     //! those forces.
-    float acceleration_x;
-    float acceleration_y;
+    std::vector<float> acceleration_x;
+    std::vector<float> acceleration_y;
 
     //! tangential acceleration- just like normal acceleration, except it
     //! is applied in the tangent direction. positive = clockwise.
-    float tangential_acceleration;
+    std::vector<float> tangential_acceleration;
 
     //! radial acceleration- acceleration towards (negative) or away (positive)
     //! from an attractor. Note that the default attractor is the emitter position.
     //! The client can set an attractor for the entire effect by calling
     //! ParticleEffect::SetAttractor(x,y)
-    float radial_acceleration;
+    std::vector<float> radial_acceleration;
 
     //! wind velocity. this gets added to the particle's velocity each frame.
     //! note that different particles might also have a slightly different wind
     //! velocity, if the system has some wind velocity variation
-    float wind_velocity_x;
-    float wind_velocity_y;
+    std::vector<float> wind_velocity_x;
+    std::vector<float> wind_velocity_y;
 
     //! damping- the particle's velocity gets multiplied by this value each second.
     //! So for example, a damping of .6 means that a particle slows down by 40% each
     //! second.
-    float damping;
+    std::vector<float> damping;
 
     //! when a particle is created, it is given a rotation direction: either
     //! 1 (clockwise) or -1 (counterclockwise)
-    float rotation_direction;
+    std::vector<float> rotation_direction;
 
     //! property variations
-    float current_size_variation_x;
-    float current_size_variation_y;
-    float next_size_variation_x;
-    float next_size_variation_y;
-    float current_rotation_speed_variation;
-    float next_rotation_speed_variation;
-    hoa_video::Color current_color_variation;
-    hoa_video::Color next_color_variation;
+    std::vector<float> current_size_variation_x;
+    std::vector<float> current_size_variation_y;
+    std::vector<float> next_size_variation_x;
+    std::vector<float> next_size_variation_y;
+    std::vector<float> current_rotation_speed_variation;
+    std::vector<float> next_rotation_speed_variation;
+    std::vector<hoa_video::Color> current_color_variation;
+    std::vector<hoa_video::Color> next_color_variation;
 
     //! keep track of current and next keyframes
-    ParticleKeyframe *current_keyframe;
-    ParticleKeyframe *next_keyframe;
+    std::vector<const ParticleKeyframe *> current_keyframe;
+    std::vector<const ParticleKeyframe *> next_keyframe;
 };
 
 } // hoa_mode_manager
@@ -9,6 +9,7 @@
 
 #include "engine/video/particle_effect.h"
 #include "engine/video/particle_system.h"
+#include "engine/video/particle_manager.h"
 
 #include "engine/system.h"
 #include "engine/video/video.h"
@@ -20,10 +21,30 @@ using namespace hoa_video;
 namespace hoa_mode_manager
 {
 
-bool ParticleEffect::_LoadEffectDef(const std::string &particle_file)
+namespace
 {
-    _effect_def.Clear();
-    _loaded = false;
+
+//! \brief A helper function reading a lua subtable of 4 float values.
+Color _ReadColor(hoa_script::ReadScriptDescriptor &particle_script,
+                 const std::string &param_name)
+{
+    std::vector<float> float_vec;
+    particle_script.ReadFloatVector(param_name, float_vec);
+    if(float_vec.size() < 4) {
+        PRINT_WARNING << "Invalid color read in parameter: " << param_name
+                      << " for file: " << particle_script.GetFilename() << std::endl;
+        return Color();
+    }
+    Color new_color(float_vec[0], float_vec[1], float_vec[2], float_vec[3]);
+
+    return new_color;
+}
+
+} // anonymous namespace
+
+bool ParticleEffectDef::Load(const std::string &particle_file)
+{
+    Clear();
 
     hoa_script::ReadScriptDescriptor particle_script;
     if(!particle_script.OpenFile(particle_file)) {
@@ -34,15 +55,14 @@ bool ParticleEffect::_LoadEffectDef(const std::string &particle_file)
     }
 
     // Read the particle image rectangle when existing
-    _effect_def.effect_collision_width = particle_script.ReadFloat("effect_collision_width");
-    _effect_def.effect_collision_height = particle_script.ReadFloat("effect_collision_height");
+    effect_collision_width = particle_script.ReadFloat("effect_collision_width");
+    effect_collision_height = particle_script.ReadFloat("effect_collision_height");
 
     if(!particle_script.DoesTableExist("systems")) {
         PRINT_WARNING << "Could not find the 'systems' array in particle effect "
                       << particle_file << std::endl;
         particle_script.CloseFile();
-        _effect_def.Clear();
-        _loaded = false;
+        Clear();
         return false;
     }
 
@@ -53,8 +73,7 @@ bool ParticleEffect::_LoadEffectDef(const std::string &particle_file)
                       << particle_file << std::endl;
         particle_script.CloseTable();
         particle_script.CloseFile();
-        _effect_def.Clear();
-        _loaded = false;
+        Clear();
         return false;
     }
 
@@ -65,8 +84,7 @@ bool ParticleEffect::_LoadEffectDef(const std::string &particle_file)
                           << " in particle effect " << particle_file << std::endl;
             particle_script.CloseAllTables();
             particle_script.CloseFile();
-            _effect_def.Clear();
-            _loaded = false;
+            Clear();
             return false;
         }
         particle_script.OpenTable(sys);
@@ -77,8 +95,7 @@ bool ParticleEffect::_LoadEffectDef(const std::string &particle_file)
                           << sys << " in particle effect " << particle_file << std::endl;
             particle_script.CloseAllTables();
             particle_script.CloseFile();
-            _effect_def.Clear();
-            _loaded = false;
+            Clear();
             return false;
         }
         particle_script.OpenTable("emitter");
@@ -143,8 +160,7 @@ bool ParticleEffect::_LoadEffectDef(const std::string &particle_file)
                           << sys << " in particle effect " << particle_file << std::endl;
             particle_script.CloseAllTables();
             particle_script.CloseFile();
-            _effect_def.Clear();
-            _loaded = false;
+            Clear();
             return false;
         }
         particle_script.OpenTable("keyframes");
@@ -182,8 +198,7 @@ bool ParticleEffect::_LoadEffectDef(const std::string &particle_file)
                           << particle_file << std::endl;
             particle_script.CloseAllTables();
             particle_script.CloseFile();
-            _effect_def.Clear();
-            _loaded = false;
+            Clear();
             return false;
         }
 
@@ -199,8 +214,7 @@ bool ParticleEffect::_LoadEffectDef(const std::string &particle_file)
                               << particle_file << std::endl;
                 particle_script.CloseAllTables();
                 particle_script.CloseFile();
-                _effect_def.Clear();
-                _loaded = false;
+                Clear();
                 return false;
             }
         }
@@ -210,8 +224,7 @@ bool ParticleEffect::_LoadEffectDef(const std::string &particle_file)
                           << particle_file << std::endl;
             particle_script.CloseAllTables();
             particle_script.CloseFile();
-            _effect_def.Clear();
-            _loaded = false;
+            Clear();
             return false;
         }
 
@@ -279,29 +292,12 @@ bool ParticleEffect::_LoadEffectDef(const std::string &particle_file)
         // pop the system table
         particle_script.CloseTable();
 
-        _effect_def._systems.push_back(sys_def);
+        _systems.push_back(sys_def);
     }
 
-    _loaded = true;
     return true;
 }
 
-// A helper function reading a lua subtable of 4 float values.
-Color ParticleEffect::_ReadColor(hoa_script::ReadScriptDescriptor &particle_script,
-                                 const std::string &param_name)
-{
-    std::vector<float> float_vec;
-    particle_script.ReadFloatVector(param_name, float_vec);
-    if(float_vec.size() < 4) {
-        PRINT_WARNING << "Invalid color read in parameter: " << param_name
-                      << " for file: " << particle_script.GetFilename() << std::endl;
-        return Color();
-    }
-    Color new_color(float_vec[0], float_vec[1], float_vec[2], float_vec[3]);
-
-    return new_color;
-}
-
 bool ParticleEffect::_CreateEffect()
 {
     // The effect isn't loaded, so we can't create the effect.
@@ -310,8 +306,8 @@ bool ParticleEffect::_CreateEffect()
 
     // Initialize systems
     _systems.clear();
-    std::vector<ParticleSystemDef>::iterator it = _effect_def._systems.begin();
-    for(; it != _effect_def._systems.end(); ++it) {
+    std::vector<ParticleSystemDef>::const_iterator it = _effect_def->_systems.begin();
+    for(; it != _effect_def->_systems.end(); ++it) {
         if((*it).enabled) {
             ParticleSystem sys(&(*it));
             if(!sys.IsAlive()) {
@@ -334,7 +330,10 @@ bool ParticleEffect::_CreateEffect()
 
 bool ParticleEffect::LoadEffect(const std::string &filename)
 {
-    if(!_LoadEffectDef(filename)) {
+    // The definition files are only read the first time they are used
+    _effect_def = ParticleManager::GetEffectDef(filename);
+    _loaded = (_effect_def != NULL);
+    if(!_loaded) {
         PRINT_WARNING << "Failed to load particle definition file: "
                       << filename << std::endl;
         return false;
@@ -436,6 +435,7 @@ void ParticleEffect::_Destroy()
 
     _systems.clear();
 
+    _effect_def = NULL;
     _loaded = false;
 }
 
@@ -69,6 +69,13 @@ public:
         _systems.clear();
     }
 
+    /*!
+     * \brief loads the effect definition from a particle file
+     * \param filename file to load the effect from
+     * \return Whether the effect def is valid
+     */
+    bool Load(const std::string &filename);
+
     /** The effect size in pixels, used to know when to display it when it used as
     *** a map object fir instance. It is used to compute the image rectangle.
     *** \note Not used if equal to 0.
@@ -94,11 +101,13 @@ public:
     /*!
      *  \brief Constructor
      */
-    ParticleEffect() {
+    ParticleEffect():
+        _effect_def(NULL) {
         _Destroy();
     }
 
-    ParticleEffect(const std::string &effect_filename) {
+    ParticleEffect(const std::string &effect_filename):
+        _effect_def(NULL) {
         _Destroy();
         LoadEffect(effect_filename);
     }
@@ -207,10 +216,10 @@ public:
 
     //! \brief Get the overall effect width/height in pixels.
     float GetEffectWidth() const {
-        return _effect_def.effect_collision_width;
+        return _effect_def ? _effect_def->effect_collision_width : 0.0f;
     }
     float GetEffectHeight() const {
-        return _effect_def.effect_collision_height;
+        return _effect_def ? _effect_def->effect_collision_height : 0.0f;
     }
 
     bool IsLoaded() const {
@@ -237,24 +246,14 @@ private:
      */
     void _Destroy();
 
-    /*!
-     * \brief loads an effect definition from a particle file
-     * \param filename file to load the effect from
-     * \return Whether the effect def is valid
-     */
-    bool _LoadEffectDef(const std::string &filename);
-
     /** Creates the effect based on the particle effect definition.
-    *** _LoadEffectDef() must be called before this one.
+    *** LoadEffect() must be called before this one.
     **/
     bool _CreateEffect();
 
-    //! \brief Helper function used to read a color subtable.
-    hoa_video::Color _ReadColor(hoa_script::ReadScriptDescriptor &particle_script,
-                                const std::string &param_name);
-
-    //! The effect definition
-    ParticleEffectDef _effect_def;
+    //! The effect definition, shared by all the effects loaded from the same file.
+    //! It is owned by the ParticleManager cache and never modified.
+    const ParticleEffectDef *_effect_def;
 
     //! list of subsystems that make up the effect. (for example, a fire effect might consist
     //! of a flame + smoke + embers)
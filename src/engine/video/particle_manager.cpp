@@ -19,6 +19,15 @@ using namespace hoa_video;
 namespace hoa_mode_manager
 {
 
+namespace
+{
+
+//! The particle effect definitions read so far, by filename. The invalid files
+//! are kept as empty definitions, so that they are not read again.
+std::map<std::string, ParticleEffectDef> _effect_defs;
+
+} // anonymous namespace
+
 bool ParticleManager::AddParticleEffect(const std::string &effect_filename, float x, float y)
 {
 
@@ -37,6 +46,25 @@ bool ParticleManager::AddParticleEffect(const std::string &effect_filename, floa
     return true;
 }
 
+bool ParticleManager::PreloadParticleEffect(const std::string &effect_filename)
+{
+    return (GetEffectDef(effect_filename) != NULL);
+}
+
+const ParticleEffectDef *ParticleManager::GetEffectDef(const std::string &effect_filename)
+{
+    std::map<std::string, ParticleEffectDef>::iterator it = _effect_defs.find(effect_filename);
+    if(it == _effect_defs.end()) {
+        it = _effect_defs.insert(std::make_pair(effect_filename, ParticleEffectDef())).first;
+        it->second.Load(effect_filename);
+    }
+
+    // A valid definition has at least one system
+    if(it->second._systems.empty())
+        return NULL;
+    return &it->second;
+}
+
 void ParticleManager::_DEBUG_ShowParticleStats()
 {
     char text[50];
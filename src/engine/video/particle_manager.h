@@ -55,6 +55,23 @@ public:
      */
     bool AddParticleEffect(const std::string &effect_filename, float x, float y);
 
+    /*!
+     *  \brief Reads a particle effect file in advance, so that triggering the effect
+     *         later on doesn't need to access the disk or run any script.
+     * \param effect_filename the particle effect file to load
+     * \return whether the effect definition is valid
+     */
+    bool PreloadParticleEffect(const std::string &effect_filename);
+
+    /*!
+     *  \brief Returns the definition of a particle effect, reading it from its file
+     *         the first time it is requested. The definitions are shared by all the
+     *         effects and the game modes, and kept until the program exits.
+     * \param effect_filename the particle effect file
+     * \return the effect definition, or NULL if the file is invalid
+     */
+    static const ParticleEffectDef *GetEffectDef(const std::string &effect_filename);
+
     /*!
      *  \brief draws all active effects
      * \return success/failure
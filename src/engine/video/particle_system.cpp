@@ -19,7 +19,86 @@ using namespace hoa_video;
 namespace hoa_mode_manager
 {
 
-bool ParticleSystem::_Create(ParticleSystemDef *sys_def)
+void ParticleArray::Resize(size_t size)
+{
+    x.resize(size);
+    y.resize(size);
+    size_x.resize(size);
+    size_y.resize(size);
+    velocity_x.resize(size);
+    velocity_y.resize(size);
+    combined_velocity_x.resize(size);
+    combined_velocity_y.resize(size);
+    color.resize(size);
+    rotation_angle.resize(size);
+    rotation_speed.resize(size);
+    time.resize(size);
+    lifetime.resize(size);
+    wave_length_coefficient.resize(size);
+    wave_half_amplitude.resize(size);
+    acceleration_x.resize(size);
+    acceleration_y.resize(size);
+    tangential_acceleration.resize(size);
+    radial_acceleration.resize(size);
+    wind_velocity_x.resize(size);
+    wind_velocity_y.resize(size);
+    damping.resize(size);
+    rotation_direction.resize(size);
+    current_size_variation_x.resize(size);
+    current_size_variation_y.resize(size);
+    next_size_variation_x.resize(size);
+    next_size_variation_y.resize(size);
+    current_rotation_speed_variation.resize(size);
+    next_rotation_speed_variation.resize(size);
+    current_color_variation.resize(size);
+    next_color_variation.resize(size);
+    current_keyframe.resize(size, NULL);
+    next_keyframe.resize(size, NULL);
+}
+
+void ParticleArray::Clear()
+{
+    Resize(0);
+}
+
+void ParticleArray::Move(size_t src, size_t dest)
+{
+    x[dest] = x[src];
+    y[dest] = y[src];
+    size_x[dest] = size_x[src];
+    size_y[dest] = size_y[src];
+    velocity_x[dest] = velocity_x[src];
+    velocity_y[dest] = velocity_y[src];
+    combined_velocity_x[dest] = combined_velocity_x[src];
+    combined_velocity_y[dest] = combined_velocity_y[src];
+    color[dest] = color[src];
+    rotation_angle[dest] = rotation_angle[src];
+    rotation_speed[dest] = rotation_speed[src];
+    time[dest] = time[src];
+    lifetime[dest] = lifetime[src];
+    wave_length_coefficient[dest] = wave_length_coefficient[src];
+    wave_half_amplitude[dest] = wave_half_amplitude[src];
+    acceleration_x[dest] = acceleration_x[src];
+    acceleration_y[dest] = acceleration_y[src];
+    tangential_acceleration[dest] = tangential_acceleration[src];
+    radial_acceleration[dest] = radial_acceleration[src];
+    wind_velocity_x[dest] = wind_velocity_x[src];
+    wind_velocity_y[dest] = wind_velocity_y[src];
+    damping[dest] = damping[src];
+    rotation_direction[dest] = rotation_direction[src];
+    current_size_variation_x[dest] = current_size_variation_x[src];
+    current_size_variation_y[dest] = current_size_variation_y[src];
+    next_size_variation_x[dest] = next_size_variation_x[src];
+    next_size_variation_y[dest] = next_size_variation_y[src];
+    current_rotation_speed_variation[dest] = current_rotation_speed_variation[src];
+    next_rotation_speed_variation[dest] = next_rotation_speed_variation[src];
+    current_color_variation[dest] = current_color_variation[src];
+    next_color_variation[dest] = next_color_variation[src];
+    current_keyframe[dest] = current_keyframe[src];
+    next_keyframe[dest] = next_keyframe[src];
+}
+
+bool ParticleSystem::_Create(const ParticleSystemDef *sys_def)
 {
     // Make sure the system def is valid before initializing.
     if(!sys_def) {
@@ -31,10 +110,15 @@ bool ParticleSystem::_Create(ParticleSystemDef *sys_def)
     _system_def = sys_def;
     _num_particles = 0;
 
-    _particles.resize(_system_def->max_particles);
+    _particles.Resize(_system_def->max_particles);
     _particle_vertices.resize(_system_def->max_particles * 4);
     _particle_texcoords.resize(_system_def->max_particles * 4);
     _particle_colors.resize(_system_def->max_particles * 4);
+    _num_texcoords = 0;
+    _texcoords_image = NULL;
+
+    // Each system has its own random sequence, which must never be zero
+    _random_state = (static_cast<uint32>(rand()) * 2654435761u) | 1;
 
     _alive = true;
     _stopped = false;
@@ -62,6 +146,9 @@ bool ParticleSystem::Draw()
     if(!_alive || !_system_def->enabled || _age < _system_def->emitter._start_time)
         return true;
 
+    // The particles are drawn directly through OpenGL
+    VideoManager->FlushSprites();
+
     // set blending parameters
     if(_system_def->blend_mode == VIDEO_NO_BLEND) {
         VideoManager->DisableBlending();
@@ -112,39 +199,42 @@ bool ParticleSystem::Draw()
     private_video::ImageTexture *img = id->_image_texture;
     TextureManager->_BindTexture(img->texture_sheet->tex_id);
 
+    if(_num_particles == 0)
+        return true;
 
     float frame_progress = _animation.GetPercentProgress();
 
-    float u1 = img->u1;
-    float u2 = img->u2;
-    float v1 = img->v1;
-    float v2 = img->v2;
+    float img_width_half = static_cast<float>(img->width) * 0.5f;
+    float img_height_half = static_cast<float>(img->height) * 0.5f;
 
-    float img_width  = static_cast<float>(img->width);
-    float img_height = static_cast<float>(img->height);
+    // fill the vertex array. The vertices are written four at a time, straight from the
+    // particle properties arrays
+    ParticleVertex *vertex = &_particle_vertices[0];
+    const float *x = &_particles.x[0];
+    const float *y = &_particles.y[0];
+    const float *size_x = &_particles.size_x[0];
+    const float *size_y = &_particles.size_y[0];
 
-    float img_width_half = img_width * 0.5f;
-    float img_height_half = img_height * 0.5f;
-
-    // fill the vertex array
     if(_system_def->rotation_used) {
-        int32 v = 0;
+        const float *rotation_angle = &_particles.rotation_angle[0];
+        const float *combined_velocity_x = &_particles.combined_velocity_x[0];
+        const float *combined_velocity_y = &_particles.combined_velocity_y[0];
 
-        for(int32 j = 0; j < _num_particles; ++j) {
-            float scaled_width_half  = img_width_half * _particles[j].size_x;
-            float scaled_height_half = img_height_half * _particles[j].size_y;
+        for(int32 j = 0; j < _num_particles; ++j, vertex += 4) {
+            float scaled_width_half  = img_width_half * size_x[j];
+            float scaled_height_half = img_height_half * size_y[j];
 
-            float rotation_angle = _particles[j].rotation_angle;
+            float angle = rotation_angle[j];
 
             if(_system_def->rotate_to_velocity) {
                 // calculate the angle based on the velocity
-                rotation_angle += UTILS_HALF_PI + atan2f(_particles[j].combined_velocity_y, _particles[j].combined_velocity_x);
+                angle += UTILS_HALF_PI + atan2f(combined_velocity_y[j], combined_velocity_x[j]);
 
                 // calculate the scaling due to speed
                 if(_system_def->speed_scale_used) {
                     // speed is magnitude of velocity
-                    float speed = sqrtf(_particles[j].combined_velocity_x * _particles[j].combined_velocity_x
-                                        + _particles[j].combined_velocity_y * _particles[j].combined_velocity_y);
+                    float speed = sqrtf(combined_velocity_x[j] * combined_velocity_x[j]
+                                        + combined_velocity_y[j] * combined_velocity_y[j]);
                     float scale_factor = _system_def->speed_scale * speed;
 
                     if(scale_factor < _system_def->min_speed_scale)
@@ -156,112 +246,62 @@ bool ParticleSystem::Draw()
                 }
             }
 
+            // the four corners are rotated by the same angle, so its sine and cosine are
+            // only computed once
+            float cos_angle = cosf(angle);
+            float sin_angle = sinf(angle);
+            float width_cos = scaled_width_half * cos_angle;
+            float width_sin = scaled_width_half * sin_angle;
+            float height_cos = scaled_height_half * cos_angle;
+            float height_sin = scaled_height_half * sin_angle;
+
             // upper-left vertex
-            _particle_vertices[v]._x = -scaled_width_half;
-            _particle_vertices[v]._y = -scaled_height_half;
-            RotatePoint(_particle_vertices[v]._x, _particle_vertices[v]._y, rotation_angle);
-            _particle_vertices[v]._x += _particles[j].x;
-            _particle_vertices[v]._y += _particles[j].y;
-            ++v;
+            vertex[0]._x = x[j] - width_cos + height_sin;
+            vertex[0]._y = y[j] - height_cos - width_sin;
 
             // upper-right vertex
-            _particle_vertices[v]._x = scaled_width_half;
-            _particle_vertices[v]._y = -scaled_height_half;
-            RotatePoint(_particle_vertices[v]._x, _particle_vertices[v]._y, rotation_angle);
-            _particle_vertices[v]._x += _particles[j].x;
-            _particle_vertices[v]._y += _particles[j].y;
-            ++v;
+            vertex[1]._x = x[j] + width_cos + height_sin;
+            vertex[1]._y = y[j] - height_cos + width_sin;
 
             // lower-right vertex
-            _particle_vertices[v]._x = scaled_width_half;
-            _particle_vertices[v]._y = scaled_height_half;
-            RotatePoint(_particle_vertices[v]._x, _particle_vertices[v]._y, rotation_angle);
-            _particle_vertices[v]._x += _particles[j].x;
-            _particle_vertices[v]._y += _particles[j].y;
-            ++v;
+            vertex[2]._x = x[j] + width_cos - height_sin;
+            vertex[2]._y = y[j] + height_cos + width_sin;
 
             // lower-left vertex
-            _particle_vertices[v]._x = -scaled_width_half;
-            _particle_vertices[v]._y = scaled_height_half;
-            RotatePoint(_particle_vertices[v]._x, _particle_vertices[v]._y, rotation_angle);
-            _particle_vertices[v]._x += _particles[j].x;
-            _particle_vertices[v]._y += _particles[j].y;
-            ++v;
-
-
+            vertex[3]._x = x[j] - width_cos - height_sin;
+            vertex[3]._y = y[j] + height_cos - width_sin;
         }
     } else {
-        int32 v = 0;
+        for(int32 j = 0; j < _num_particles; ++j, vertex += 4) {
+            float scaled_width_half  = img_width_half * size_x[j];
+            float scaled_height_half = img_height_half * size_y[j];
 
-        for(int32 j = 0; j < _num_particles; ++j) {
-            float scaled_width_half  = img_width_half * _particles[j].size_x;
-            float scaled_height_half = img_height_half * _particles[j].size_y;
+            float left = x[j] - scaled_width_half;
+            float right = x[j] + scaled_width_half;
+            float top = y[j] - scaled_height_half;
+            float bottom = y[j] + scaled_height_half;
 
             // upper-left vertex
-            _particle_vertices[v]._x = _particles[j].x - scaled_width_half;
-            _particle_vertices[v]._y = _particles[j].y - scaled_height_half;
-            ++v;
+            vertex[0]._x = left;
+            vertex[0]._y = top;
 
             // upper-right vertex
-            _particle_vertices[v]._x = _particles[j].x + scaled_width_half;
-            _particle_vertices[v]._y = _particles[j].y - scaled_height_half;
-            ++v;
+            vertex[1]._x = right;
+            vertex[1]._y = top;
 
             // lower-right vertex
-            _particle_vertices[v]._x = _particles[j].x + scaled_width_half;
-            _particle_vertices[v]._y = _particles[j].y + scaled_height_half;
-            ++v;
+            vertex[2]._x = right;
+            vertex[2]._y = bottom;
 
             // lower-left vertex
-            _particle_vertices[v]._x = _particles[j].x - scaled_width_half;
-            _particle_vertices[v]._y = _particles[j].y + scaled_height_half;
-            ++v;
+            vertex[3]._x = left;
+            vertex[3]._y = bottom;
         }
     }
 
-    // fill the color array
-
-    int32 c = 0;
-    for(int32 j = 0; j < _num_particles; ++j) {
-        Color color = _particles[j].color;
-
-        if(_system_def->smooth_animation)
-            color = color * (1.0f - frame_progress);
-
-        _particle_colors[c] = color;
-        ++c;
-        _particle_colors[c] = color;
-        ++c;
-        _particle_colors[c] = color;
-        ++c;
-        _particle_colors[c] = color;
-        ++c;
-    }
-
-    // fill the texcoord array
-
-    int32 t = 0;
-    for(int32 j = 0; j < _num_particles; ++j) {
-        // upper-left
-        _particle_texcoords[t]._t0 = u1;
-        _particle_texcoords[t]._t1 = v1;
-        ++t;
-
-        // upper-right
-        _particle_texcoords[t]._t0 = u2;
-        _particle_texcoords[t]._t1 = v1;
-        ++t;
-
-        // lower-right
-        _particle_texcoords[t]._t0 = u2;
-        _particle_texcoords[t]._t1 = v2;
-        ++t;
-
-        // lower-left
-        _particle_texcoords[t]._t0 = u1;
-        _particle_texcoords[t]._t1 = v2;
-        ++t;
-    }
+    // fill the color and texcoord arrays
+    _FillColors(_system_def->smooth_animation ? 1.0f - frame_progress : 1.0f);
+    _FillTexCoords(img);
 
     VideoManager->EnableVertexArray();
     VideoManager->EnableColorArray();
@@ -280,48 +320,8 @@ bool ParticleSystem::Draw()
         private_video::ImageTexture *img2 = id2->_image_texture;
         TextureManager->_BindTexture(img2->texture_sheet->tex_id);
 
-        u1 = img2->u1;
-        u2 = img2->u2;
-        v1 = img2->v1;
-        v2 = img2->v2;
-
-        t = 0;
-        for(int32 j = 0; j < _num_particles; ++j) {
-            // upper-left
-            _particle_texcoords[t]._t0 = u1;
-            _particle_texcoords[t]._t1 = v1;
-            ++t;
-
-            // upper-right
-            _particle_texcoords[t]._t0 = u2;
-            _particle_texcoords[t]._t1 = v1;
-            ++t;
-
-            // lower-right
-            _particle_texcoords[t]._t0 = u2;
-            _particle_texcoords[t]._t1 = v2;
-            ++t;
-
-            // lower-left
-            _particle_texcoords[t]._t0 = u1;
-            _particle_texcoords[t]._t1 = v2;
-            ++t;
-        }
-
-        c = 0;
-        for(int32 j = 0; j < _num_particles; ++j) {
-            Color color = _particles[j].color;
-            color = color * frame_progress;
-
-            _particle_colors[c] = color;
-            ++c;
-            _particle_colors[c] = color;
-            ++c;
-            _particle_colors[c] = color;
-            ++c;
-            _particle_colors[c] = color;
-            ++c;
-        }
+        _FillTexCoords(img2);
+        _FillColors(frame_progress);
 
         glVertexPointer(2, GL_FLOAT, 0, &_particle_vertices[0]);
         glColorPointer(4, GL_FLOAT, 0, &_particle_colors[0]);
@@ -333,6 +333,54 @@ bool ParticleSystem::Draw()
     return true;
 }
 
+void ParticleSystem::_FillColors(float alpha_scale)
+{
+    Color *color = &_particle_colors[0];
+    const Color *particle_color = &_particles.color[0];
+
+    for(int32 j = 0; j < _num_particles; ++j, color += 4) {
+        Color c = (alpha_scale == 1.0f) ? particle_color[j] : particle_color[j] * alpha_scale;
+        color[0] = c;
+        color[1] = c;
+        color[2] = c;
+        color[3] = c;
+    }
+}
+
+void ParticleSystem::_FillTexCoords(const private_video::ImageTexture *img)
+{
+    // All the particles use the same texture coordinates, so they only need to be
+    // written for the new particles as long as the animation frame doesn't change
+    if(img != _texcoords_image) {
+        _texcoords_image = img;
+        _num_texcoords = 0;
+    }
+
+    ParticleTexCoord *texcoord = &_particle_texcoords[0];
+    for(int32 j = _num_texcoords; j < _num_particles; ++j) {
+        int32 t = j * 4;
+
+        // upper-left
+        texcoord[t]._t0 = img->u1;
+        texcoord[t]._t1 = img->v1;
+
+        // upper-right
+        texcoord[t + 1]._t0 = img->u2;
+        texcoord[t + 1]._t1 = img->v1;
+
+        // lower-right
+        texcoord[t + 2]._t0 = img->u2;
+        texcoord[t + 2]._t1 = img->v2;
+
+        // lower-left
+        texcoord[t + 3]._t0 = img->u1;
+        texcoord[t + 3]._t1 = img->v2;
+    }
+
+    if(_num_particles > _num_texcoords)
+        _num_texcoords = _num_particles;
+}
+
 //-----------------------------------------------------------------------------
 // Update: updates particle positions and properties, and emits/kills particles
 //-----------------------------------------------------------------------------
@@ -410,144 +458,106 @@ void ParticleSystem::_Destroy()
     _alive = false;
     _stopped = false;
 
-    _particles.clear();
+    _particles.Clear();
     _particle_vertices.clear();
+    _particle_colors.clear();
+    _particle_texcoords.clear();
+    _num_texcoords = 0;
+    _texcoords_image = NULL;
     // Don't delete it, since it's handled by the ParticleEffectDef
     _system_def = 0;
 }
 
 void ParticleSystem::_UpdateParticles(float t, const EffectParameters &params)
 {
-    for(int j = 0; j < _num_particles; ++j) {
-        // calculate a time for the particle from 0 to 1 since this is what
-        // the keyframes are based on
-        float scaled_time = _particles[j].time / _particles[j].lifetime;
-
-        // figure out which keyframe we're on
-        if(_particles[j].next_keyframe) {
-            ParticleKeyframe *old_next = _particles[j].next_keyframe;
-
-            // check if we need to advance the keyframe
-            if(scaled_time >= _particles[j].next_keyframe->time) {
-                // figure out what keyframe we're on
-                size_t num_keyframes = _system_def->keyframes.size();
-
-                size_t k;
-                for(k = 0; k < num_keyframes; ++k) {
-                    if(_system_def->keyframes[k].time > scaled_time) {
-                        _particles[j].current_keyframe = &_system_def->keyframes[k - 1];
-                        _particles[j].next_keyframe    = &_system_def->keyframes[k];
-                        break;
-                    }
-                }
-
-                // if we didn't find any keyframe whose time is larger than this
-                // particle's time, then we are on the last one
-                if(k == num_keyframes) {
-                    _particles[j].current_keyframe = &_system_def->keyframes[k - 1];
-                    _particles[j].next_keyframe = NULL;
-
-                    // set all of the keyframed properties to the value stored in the last
-                    // keyframe
-                    _particles[j].color          = _particles[j].current_keyframe->color;
-                    _particles[j].rotation_speed = _particles[j].current_keyframe->rotation_speed;
-                    _particles[j].size_x         = _particles[j].current_keyframe->size_x;
-                    _particles[j].size_y         = _particles[j].current_keyframe->size_y;
-                }
-
-                // if we skipped ahead only 1 keyframe, then inherit the current variations
-                // from the next ones
-                if(_particles[j].current_keyframe == old_next) {
-                    _particles[j].current_color_variation = _particles[j].next_color_variation;
-                    _particles[j].current_rotation_speed_variation = _particles[j].current_rotation_speed_variation;
-                    _particles[j].current_size_variation_x = _particles[j].next_size_variation_x;
-                    _particles[j].current_size_variation_y = _particles[j].next_size_variation_y;
-                } else {
-                    _particles[j].current_rotation_speed_variation = RandomFloat(-_particles[j].current_keyframe->rotation_speed_variation, _particles[j].current_keyframe->rotation_speed_variation);
-                    for(int32 c = 0; c < 4; ++c)
-                        _particles[j].current_color_variation[c] = RandomFloat(-_particles[j].current_keyframe->color_variation[c], _particles[j].current_keyframe->color_variation[c]);
-                    _particles[j].current_size_variation_x = RandomFloat(-_particles[j].current_keyframe->size_variation_x, _particles[j].current_keyframe->size_variation_x);
-                    _particles[j].current_size_variation_y = RandomFloat(-_particles[j].current_keyframe->size_variation_y, _particles[j].current_keyframe->size_variation_y);
-                }
-
-                // if there is a next keyframe, generate variations for it
-                if(_particles[j].next_keyframe) {
-                    _particles[j].next_rotation_speed_variation = RandomFloat(-_particles[j].next_keyframe->rotation_speed_variation, _particles[j].next_keyframe->rotation_speed_variation);
-                    for(int32 c = 0; c < 4; ++c)
-                        _particles[j].next_color_variation[c] = RandomFloat(-_particles[j].next_keyframe->color_variation[c], _particles[j].next_keyframe->color_variation[c]);
-                    _particles[j].next_size_variation_x = RandomFloat(-_particles[j].next_keyframe->size_variation_x, _particles[j].next_keyframe->size_variation_x);
-                    _particles[j].next_size_variation_y = RandomFloat(-_particles[j].next_keyframe->size_variation_y, _particles[j].next_keyframe->size_variation_y);
-                }
-            }
-        }
-
-        // if we aren't already at the last keyframe, interpolate to figure out the
-        // current keyframed properties
-        if(_particles[j].next_keyframe) {
-            // figure out how far we are from the current to the next (0.0 to 1.0)
-            float a = (scaled_time - _particles[j].current_keyframe->time) / (_particles[j].next_keyframe->time - _particles[j].current_keyframe->time);
-
-            _particles[j].rotation_speed = Lerp(a, _particles[j].current_keyframe->rotation_speed + _particles[j].current_rotation_speed_variation, _particles[j].next_keyframe->rotation_speed + _particles[j].next_rotation_speed_variation);
-            _particles[j].size_x         = Lerp(a, _particles[j].current_keyframe->size_x + _particles[j].current_size_variation_x, _particles[j].next_keyframe->size_x + _particles[j].next_size_variation_x);
-            _particles[j].size_y         = Lerp(a, _particles[j].current_keyframe->size_y + _particles[j].current_size_variation_y, _particles[j].next_keyframe->size_y + _particles[j].next_size_variation_y);
-            _particles[j].color[0]       = Lerp(a, _particles[j].current_keyframe->color[0] + _particles[j].current_color_variation[0], _particles[j].next_keyframe->color[0] + _particles[j].next_color_variation[0]);
-            _particles[j].color[1]       = Lerp(a, _particles[j].current_keyframe->color[1] + _particles[j].current_color_variation[1], _particles[j].next_keyframe->color[1] + _particles[j].next_color_variation[1]);
-            _particles[j].color[2]       = Lerp(a, _particles[j].current_keyframe->color[2] + _particles[j].current_color_variation[2], _particles[j].next_keyframe->color[2] + _particles[j].next_color_variation[2]);
-            _particles[j].color[3]       = Lerp(a, _particles[j].current_keyframe->color[3] + _particles[j].current_color_variation[3], _particles[j].next_keyframe->color[3] + _particles[j].next_color_variation[3]);
-        }
+    if(_num_particles == 0)
+        return;
+
+    // The particles are updated one property at a time, so that each loop only works
+    // on a few arrays. Most of these loops are then simple enough to be vectorized.
+    _UpdateKeyframedProperties();
+
+    float *x = &_particles.x[0];
+    float *y = &_particles.y[0];
+    float *velocity_x = &_particles.velocity_x[0];
+    float *velocity_y = &_particles.velocity_y[0];
+    float *combined_velocity_x = &_particles.combined_velocity_x[0];
+    float *combined_velocity_y = &_particles.combined_velocity_y[0];
+    float *rotation_angle = &_particles.rotation_angle[0];
+    float *time = &_particles.time[0];
+    const float *rotation_speed = &_particles.rotation_speed[0];
+    const float *rotation_direction = &_particles.rotation_direction[0];
+    const float *wind_velocity_x = &_particles.wind_velocity_x[0];
+    const float *wind_velocity_y = &_particles.wind_velocity_y[0];
+    const float *acceleration_x = &_particles.acceleration_x[0];
+    const float *acceleration_y = &_particles.acceleration_y[0];
+
+    for(int32 j = 0; j < _num_particles; ++j)
+        rotation_angle[j] += rotation_speed[j] * rotation_direction[j] * t;
 
-        _particles[j].rotation_angle += _particles[j].rotation_speed * _particles[j].rotation_direction * t;
+    for(int32 j = 0; j < _num_particles; ++j) {
+        combined_velocity_x[j] = velocity_x[j] + wind_velocity_x[j];
+        combined_velocity_y[j] = velocity_y[j] + wind_velocity_y[j];
+    }
 
-        float wind_velocity_x = _particles[j].wind_velocity_x;
-        float wind_velocity_y = _particles[j].wind_velocity_y;
+    if(_system_def->wave_motion_used) {
+        const float *wave_half_amplitude = &_particles.wave_half_amplitude[0];
+        const float *wave_length_coefficient = &_particles.wave_length_coefficient[0];
 
-        _particles[j].combined_velocity_x = _particles[j].velocity_x + wind_velocity_x;
-        _particles[j].combined_velocity_y = _particles[j].velocity_y + wind_velocity_y;
+        for(int32 j = 0; j < _num_particles; ++j) {
+            if(wave_half_amplitude[j] <= 0.0f)
+                continue;
 
-        if(_system_def->wave_motion_used && _particles[j].wave_half_amplitude > 0.0f) {
             // find the magnitude of the wave velocity
-            float wave_speed = _particles[j].wave_half_amplitude * sinf(_particles[j].wave_length_coefficient * _particles[j].time);
+            float wave_speed = wave_half_amplitude[j] * sinf(wave_length_coefficient[j] * time[j]);
 
             // now the wave velocity is just that wave speed times the particle's tangential vector
-            float tangent_x = -_particles[j].combined_velocity_y;
-            float tangent_y = _particles[j].combined_velocity_x;
+            float tangent_x = -combined_velocity_y[j];
+            float tangent_y = combined_velocity_x[j];
             float speed = sqrtf(tangent_x * tangent_x + tangent_y * tangent_y);
             tangent_x /= speed;
             tangent_y /= speed;
 
-            float wave_velocity_x = tangent_x * wave_speed;
-            float wave_velocity_y = tangent_y * wave_speed;
-
-            _particles[j].combined_velocity_x += wave_velocity_x;
-            _particles[j].combined_velocity_y += wave_velocity_y;
+            combined_velocity_x[j] += tangent_x * wave_speed;
+            combined_velocity_y[j] += tangent_y * wave_speed;
         }
+    }
 
-        _particles[j].x += (_particles[j].combined_velocity_x) * t;
-        _particles[j].y += (_particles[j].combined_velocity_y) * t;
+    for(int32 j = 0; j < _num_particles; ++j) {
+        x[j] += combined_velocity_x[j] * t;
+        y[j] += combined_velocity_y[j] * t;
+    }
 
+    // client-specified acceleration (dv = a * t)
+    for(int32 j = 0; j < _num_particles; ++j) {
+        velocity_x[j] += acceleration_x[j] * t;
+        velocity_y[j] += acceleration_y[j] * t;
+    }
 
-        // client-specified acceleration (dv = a * t)
-        _particles[j].velocity_x += _particles[j].acceleration_x * t;
-        _particles[j].velocity_y += _particles[j].acceleration_y * t;
+    // radial acceleration: calculate unit vector from emitter center to each particle,
+    // and scale by the radial acceleration, if there is any
+    if(_system_def->radial_acceleration != 0.0f || _system_def->radial_acceleration_variation != 0.0f
+            || _system_def->tangential_acceleration != 0.0f || _system_def->tangential_acceleration_variation != 0.0f) {
+        const float *radial_acceleration = &_particles.radial_acceleration[0];
+        const float *tangential_acceleration = &_particles.tangential_acceleration[0];
+
+        float attractor_x = _system_def->emitter._center_x;
+        float attractor_y = _system_def->emitter._center_y;
+        if(_system_def->user_defined_attractor) {
+            attractor_x = params.attractor_x;
+            attractor_y = params.attractor_y;
+        }
 
-        // radial acceleration: calculate unit vector from emitter center to this particle,
-        // and scale by the radial acceleration, if there is any
+        for(int32 j = 0; j < _num_particles; ++j) {
+            bool use_radial     = (radial_acceleration[j] != 0.0f);
+            bool use_tangential = (tangential_acceleration[j] != 0.0f);
 
-        bool use_radial     = (_particles[j].radial_acceleration != 0.0f);
-        bool use_tangential = (_particles[j].tangential_acceleration != 0.0f);
+            if(!use_radial && !use_tangential)
+                continue;
 
-        if(use_radial || use_tangential) {
             // unit vector from attractor to particle
-            float attractor_to_particle_x;
-            float attractor_to_particle_y;
-
-            if(_system_def->user_defined_attractor) {
-                attractor_to_particle_x = _particles[j].x - params.attractor_x;
-                attractor_to_particle_y = _particles[j].y - params.attractor_y;
-            } else {
-                attractor_to_particle_x = _particles[j].x - _system_def->emitter._center_x;
-                attractor_to_particle_y = _particles[j].y - _system_def->emitter._center_y;
-            }
+            float attractor_to_particle_x = x[j] - attractor_x;
+            float attractor_to_particle_y = y[j] - attractor_y;
 
             float distance = sqrtf(attractor_to_particle_x * attractor_to_particle_x
                                    + attractor_to_particle_y * attractor_to_particle_y);
@@ -562,12 +572,12 @@ void ParticleSystem::_UpdateParticles(float t, const EffectParameters &params)
                 if(_system_def->attractor_falloff != 0.0f) {
                     float attraction = 1.0f - _system_def->attractor_falloff * distance;
                     if(attraction > 0.0f) {
-                        _particles[j].velocity_x += attractor_to_particle_x * _particles[j].radial_acceleration * t * attraction;
-                        _particles[j].velocity_y += attractor_to_particle_y * _particles[j].radial_acceleration * t * attraction;
+                        velocity_x[j] += attractor_to_particle_x * radial_acceleration[j] * t * attraction;
+                        velocity_y[j] += attractor_to_particle_y * radial_acceleration[j] * t * attraction;
                     }
                 } else {
-                    _particles[j].velocity_x += attractor_to_particle_x * _particles[j].radial_acceleration * t;
-                    _particles[j].velocity_y += attractor_to_particle_y * _particles[j].radial_acceleration * t;
+                    velocity_x[j] += attractor_to_particle_x * radial_acceleration[j] * t;
+                    velocity_y[j] += attractor_to_particle_y * radial_acceleration[j] * t;
                 }
             }
 
@@ -577,19 +587,123 @@ void ParticleSystem::_UpdateParticles(float t, const EffectParameters &params)
                 float tangent_x = -attractor_to_particle_y;
                 float tangent_y = attractor_to_particle_x;
 
-                _particles[j].velocity_x += tangent_x * _particles[j].tangential_acceleration * t;
-                _particles[j].velocity_y += tangent_y * _particles[j].tangential_acceleration * t;
+                velocity_x[j] += tangent_x * tangential_acceleration[j] * t;
+                velocity_y[j] += tangent_y * tangential_acceleration[j] * t;
+            }
+        }
+    }
+
+    // damp the velocity
+    if(_system_def->damping != 1.0f || _system_def->damping_variation != 0.0f) {
+        const float *damping = &_particles.damping[0];
+
+        for(int32 j = 0; j < _num_particles; ++j) {
+            if(damping[j] != 1.0f) {
+                float damping_factor = powf(damping[j], t);
+                velocity_x[j] *= damping_factor;
+                velocity_y[j] *= damping_factor;
             }
         }
+    }
+
+    for(int32 j = 0; j < _num_particles; ++j)
+        time[j] += t;
+}
+
+void ParticleSystem::_UpdateKeyframedProperties()
+{
+    // With a single keyframe, the properties never change
+    if(_system_def->keyframes.size() < 2)
+        return;
+
+    for(int32 j = 0; j < _num_particles; ++j) {
+        const ParticleKeyframe *&current_keyframe = _particles.current_keyframe[j];
+        const ParticleKeyframe *&next_keyframe = _particles.next_keyframe[j];
 
-        // damp the velocity
+        // the particles at their last keyframe keep its properties
+        if(!next_keyframe)
+            continue;
 
-        if(_particles[j].damping != 1.0f) {
-            _particles[j].velocity_x *= pow(_particles[j].damping, t);
-            _particles[j].velocity_y *= pow(_particles[j].damping, t);
+        // calculate a time for the particle from 0 to 1 since this is what
+        // the keyframes are based on
+        float scaled_time = _particles.time[j] / _particles.lifetime[j];
+
+        // check if we need to advance the keyframe
+        if(scaled_time >= next_keyframe->time) {
+            const ParticleKeyframe *old_next = next_keyframe;
+
+            // figure out what keyframe we're on
+            size_t num_keyframes = _system_def->keyframes.size();
+
+            size_t k;
+            for(k = 0; k < num_keyframes; ++k) {
+                if(_system_def->keyframes[k].time > scaled_time) {
+                    current_keyframe = &_system_def->keyframes[k - 1];
+                    next_keyframe    = &_system_def->keyframes[k];
+                    break;
+                }
+            }
+
+            // if we didn't find any keyframe whose time is larger than this
+            // particle's time, then we are on the last one
+            if(k == num_keyframes) {
+                current_keyframe = &_system_def->keyframes[k - 1];
+                next_keyframe = NULL;
+
+                // set all of the keyframed properties to the value stored in the last
+                // keyframe
+                _particles.color[j]          = current_keyframe->color;
+                _particles.rotation_speed[j] = current_keyframe->rotation_speed;
+                _particles.size_x[j]         = current_keyframe->size_x;
+                _particles.size_y[j]         = current_keyframe->size_y;
+            }
+
+            // if we skipped ahead only 1 keyframe, then inherit the current variations
+            // from the next ones
+            if(current_keyframe == old_next) {
+                _particles.current_color_variation[j] = _particles.next_color_variation[j];
+                _particles.current_rotation_speed_variation[j] = _particles.next_rotation_speed_variation[j];
+                _particles.current_size_variation_x[j] = _particles.next_size_variation_x[j];
+                _particles.current_size_variation_y[j] = _particles.next_size_variation_y[j];
+            } else {
+                _particles.current_rotation_speed_variation[j] = _RandomFloat(-current_keyframe->rotation_speed_variation, current_keyframe->rotation_speed_variation);
+                for(int32 c = 0; c < 4; ++c)
+                    _particles.current_color_variation[j][c] = _RandomFloat(-current_keyframe->color_variation[c], current_keyframe->color_variation[c]);
+                _particles.current_size_variation_x[j] = _RandomFloat(-current_keyframe->size_variation_x, current_keyframe->size_variation_x);
+                _particles.current_size_variation_y[j] = _RandomFloat(-current_keyframe->size_variation_y, current_keyframe->size_variation_y);
+            }
+
+            // if there is a next keyframe, generate variations for it
+            if(next_keyframe) {
+                _particles.next_rotation_speed_variation[j] = _RandomFloat(-next_keyframe->rotation_speed_variation, next_keyframe->rotation_speed_variation);
+                for(int32 c = 0; c < 4; ++c)
+                    _particles.next_color_variation[j][c] = _RandomFloat(-next_keyframe->color_variation[c], next_keyframe->color_variation[c]);
+                _particles.next_size_variation_x[j] = _RandomFloat(-next_keyframe->size_variation_x, next_keyframe->size_variation_x);
+                _particles.next_size_variation_y[j] = _RandomFloat(-next_keyframe->size_variation_y, next_keyframe->size_variation_y);
+            }
         }
 
-        _particles[j].time += t;
+        if(!next_keyframe)
+            continue;
+
+        // we aren't at the last keyframe, so interpolate to figure out the current
+        // keyframed properties. a tells how far we are from the current to the next
+        // keyframe (0.0 to 1.0)
+        float a = (scaled_time - current_keyframe->time) / (next_keyframe->time - current_keyframe->time);
+        float b = 1.0f - a;
+
+        _particles.rotation_speed[j] = a * (next_keyframe->rotation_speed + _particles.next_rotation_speed_variation[j])
+                                       + b * (current_keyframe->rotation_speed + _particles.current_rotation_speed_variation[j]);
+        _particles.size_x[j] = a * (next_keyframe->size_x + _particles.next_size_variation_x[j])
+                               + b * (current_keyframe->size_x + _particles.current_size_variation_x[j]);
+        _particles.size_y[j] = a * (next_keyframe->size_y + _particles.next_size_variation_y[j])
+                               + b * (current_keyframe->size_y + _particles.current_size_variation_y[j]);
+
+        Color &color = _particles.color[j];
+        const Color &current_variation = _particles.current_color_variation[j];
+        const Color &next_variation = _particles.next_color_variation[j];
+        for(int32 c = 0; c < 4; ++c)
+            color[c] = a * (next_keyframe->color[c] + next_variation[c]) + b * (current_keyframe->color[c] + current_variation[c]);
     }
 }
 
@@ -605,7 +719,7 @@ void ParticleSystem::_KillParticles(int32 &num, const EffectParameters &params)
 {
     // check each active particle to see if it is expired
     for(int j = 0; j < _num_particles; ++j) {
-        if(_particles[j].time > _particles[j].lifetime) {
+        if(_particles.time[j] > _particles.lifetime[j]) {
             if(num > 0) {
                 // if we still have particles to emit, then instead of killing the particle,
                 // respawn it as a new one
@@ -644,7 +758,7 @@ void ParticleSystem::_EmitParticles(int32 num, const EffectParameters &params)
 
 void ParticleSystem::_MoveParticle(int32 src, int32 dest)
 {
-    _particles[dest] = _particles[src];
+    _particles.Move(src, dest);
 }
 
 
@@ -659,22 +773,22 @@ void ParticleSystem::_RespawnParticle(int32 i, const EffectParameters &params)
 
     switch(emitter._shape) {
     case EMITTER_SHAPE_POINT: {
-        _particles[i].x = emitter._x;
-        _particles[i].y = emitter._y;
+        _particles.x[i] = emitter._x;
+        _particles.y[i] = emitter._y;
         break;
     }
     case EMITTER_SHAPE_LINE: {
-        _particles[i].x = RandomFloat(emitter._x, emitter._x2);
-        _particles[i].y = RandomFloat(emitter._y, emitter._y2);
+        _particles.x[i] = _RandomFloat(emitter._x, emitter._x2);
+        _particles.y[i] = _RandomFloat(emitter._y, emitter._y2);
         break;
     }
     case EMITTER_SHAPE_CIRCLE: {
-        float angle = RandomFloat(0.0f, UTILS_2PI);
-        _particles[i].x = emitter._radius * cosf(angle);
-        _particles[i].y = emitter._radius * sinf(angle);
+        float angle = _RandomFloat(0.0f, UTILS_2PI);
+        _particles.x[i] = emitter._radius * cosf(angle);
+        _particles.y[i] = emitter._radius * sinf(angle);
         // Apply offset
-        _particles[i].x += emitter._x;
-        _particles[i].y += emitter._y;
+        _particles.x[i] += emitter._x;
+        _particles.y[i] += emitter._y;
         break;
     }
     case EMITTER_SHAPE_FILLED_CIRCLE: {
@@ -685,18 +799,18 @@ void ParticleSystem::_RespawnParticle(int32 i, const EffectParameters &params)
         // this may need to be replaced by a speedier algorithm later on
         do {
             float half_radius = emitter._radius * 0.5f;
-            _particles[i].x = RandomFloat(-half_radius, half_radius);
-            _particles[i].y = RandomFloat(-half_radius, half_radius);
-        } while(_particles[i].x * _particles[i].x +
-                _particles[i].y * _particles[i].y > radius_squared);
+            _particles.x[i] = _RandomFloat(-half_radius, half_radius);
+            _particles.y[i] = _RandomFloat(-half_radius, half_radius);
+        } while(_particles.x[i] * _particles.x[i] +
+                _particles.y[i] * _particles.y[i] > radius_squared);
         // Apply offset
-        _particles[i].x += emitter._x;
-        _particles[i].y += emitter._y;
+        _particles.x[i] += emitter._x;
+        _particles.y[i] += emitter._y;
         break;
     }
     case EMITTER_SHAPE_FILLED_RECTANGLE: {
-        _particles[i].x = RandomFloat(emitter._x, emitter._x2);
-        _particles[i].y = RandomFloat(emitter._y, emitter._y2);
+        _particles.x[i] = _RandomFloat(emitter._x, emitter._x2);
+        _particles.y[i] = _RandomFloat(emitter._y, emitter._y2);
         break;
     }
     default:
@@ -704,40 +818,40 @@ void ParticleSystem::_RespawnParticle(int32 i, const EffectParameters &params)
     };
 
 
-    _particles[i].x += RandomFloat(-emitter._x_variation, emitter._x_variation);
-    _particles[i].y += RandomFloat(-emitter._y_variation, emitter._y_variation);
+    _particles.x[i] += _RandomFloat(-emitter._x_variation, emitter._x_variation);
+    _particles.y[i] += _RandomFloat(-emitter._y_variation, emitter._y_variation);
 
     if(params.orientation != 0.0f)
-        RotatePoint(_particles[i].x, _particles[i].y, params.orientation);
+        RotatePoint(_particles.x[i], _particles.y[i], params.orientation);
 
-    _particles[i].color = _system_def->keyframes[0].color;
+    _particles.color[i] = _system_def->keyframes[0].color;
 
-    _particles[i].rotation_speed  = _system_def->keyframes[0].rotation_speed;
-    _particles[i].time            = 0.0f;
-    _particles[i].size_x          = _system_def->keyframes[0].size_x;
-    _particles[i].size_y          = _system_def->keyframes[0].size_y;
+    _particles.rotation_speed[i]  = _system_def->keyframes[0].rotation_speed;
+    _particles.time[i]            = 0.0f;
+    _particles.size_x[i]          = _system_def->keyframes[0].size_x;
+    _particles.size_y[i]          = _system_def->keyframes[0].size_y;
 
     if(_system_def->random_initial_angle)
-        _particles[i].rotation_angle = RandomFloat(0.0f, UTILS_2PI);
+        _particles.rotation_angle[i] = _RandomFloat(0.0f, UTILS_2PI);
     else
-        _particles[i].rotation_angle = 0.0f;
+        _particles.rotation_angle[i] = 0.0f;
 
-    _particles[i].current_keyframe = &_system_def->keyframes[0];
+    _particles.current_keyframe[i] = &_system_def->keyframes[0];
 
     if(_system_def->keyframes.size() > 1)
-        _particles[i].next_keyframe = &_system_def->keyframes[1];
+        _particles.next_keyframe[i] = &_system_def->keyframes[1];
     else
-        _particles[i].next_keyframe = NULL;
+        _particles.next_keyframe[i] = NULL;
 
     float speed = _system_def->emitter._initial_speed;
-    speed += RandomFloat(-emitter._initial_speed_variation, emitter._initial_speed_variation);
+    speed += _RandomFloat(-emitter._initial_speed_variation, emitter._initial_speed_variation);
 
     if(_system_def->emitter._spin == EMITTER_SPIN_CLOCKWISE) {
-        _particles[i].rotation_direction = 1.0f;
+        _particles.rotation_direction[i] = 1.0f;
     } else if(_system_def->emitter._spin == EMITTER_SPIN_COUNTERCLOCKWISE) {
-        _particles[i].rotation_direction = -1.0f;
+        _particles.rotation_direction[i] = -1.0f;
     } else {
-        _particles[i].rotation_direction = static_cast<float>(2 * (rand() % 2)) - 1.0f;
+        _particles.rotation_direction[i] = (_RandomFloat(0.0f, 1.0f) < 0.5f) ? -1.0f : 1.0f;
     }
 
     // figure out the orientation
@@ -745,111 +859,111 @@ void ParticleSystem::_RespawnParticle(int32 i, const EffectParameters &params)
     float angle = 0.0f;
 
     if(emitter._omnidirectional) {
-        angle = RandomFloat(0.0f, UTILS_2PI);
+        angle = _RandomFloat(0.0f, UTILS_2PI);
     } else if(emitter._inner_cone == 0.0f && emitter._outer_cone == 0.0f) {
         angle = emitter._orientation + params.orientation;
     }
 
-    _particles[i].velocity_x = speed * cosf(angle);
-    _particles[i].velocity_y = speed * sinf(angle);
+    _particles.velocity_x[i] = speed * cosf(angle);
+    _particles.velocity_y[i] = speed * sinf(angle);
 
     // figure out property variations
 
-    _particles[i].current_size_variation_x  = RandomFloat(-_system_def->keyframes[0].size_variation_x,
+    _particles.current_size_variation_x[i]  = _RandomFloat(-_system_def->keyframes[0].size_variation_x,
             _system_def->keyframes[0].size_variation_x);
-    _particles[i].current_size_variation_y  = RandomFloat(-_system_def->keyframes[0].size_variation_y,
+    _particles.current_size_variation_y[i]  = _RandomFloat(-_system_def->keyframes[0].size_variation_y,
             _system_def->keyframes[0].size_variation_y);
 
     for(int32 j = 0; j < 4; ++j) {
-        _particles[i].current_color_variation[j] = RandomFloat(-_system_def->keyframes[0].color_variation[j],
+        _particles.current_color_variation[i][j] = _RandomFloat(-_system_def->keyframes[0].color_variation[j],
                 _system_def->keyframes[0].color_variation[j]);
     }
 
-    _particles[i].current_rotation_speed_variation = RandomFloat(-_system_def->keyframes[0].rotation_speed_variation,
+    _particles.current_rotation_speed_variation[i] = _RandomFloat(-_system_def->keyframes[0].rotation_speed_variation,
             _system_def->keyframes[0].rotation_speed_variation);
 
     if(_system_def->keyframes.size() > 1) {
         // figure out the next keyframe's variations
-        _particles[i].next_size_variation_x  = RandomFloat(-_system_def->keyframes[1].size_variation_x,
+        _particles.next_size_variation_x[i]  = _RandomFloat(-_system_def->keyframes[1].size_variation_x,
                                                _system_def->keyframes[1].size_variation_x);
-        _particles[i].next_size_variation_y  = RandomFloat(-_system_def->keyframes[1].size_variation_y,
+        _particles.next_size_variation_y[i]  = _RandomFloat(-_system_def->keyframes[1].size_variation_y,
                                                _system_def->keyframes[1].size_variation_y);
 
         for(int32 j = 0; j < 4; ++j) {
-            _particles[i].next_color_variation[j] = RandomFloat(-_system_def->keyframes[1].color_variation[j],
+            _particles.next_color_variation[i][j] = _RandomFloat(-_system_def->keyframes[1].color_variation[j],
                                                     _system_def->keyframes[1].color_variation[j]);
         }
 
-        _particles[i].next_rotation_speed_variation = RandomFloat(-_system_def->keyframes[1].rotation_speed_variation,
+        _particles.next_rotation_speed_variation[i] = _RandomFloat(-_system_def->keyframes[1].rotation_speed_variation,
                 _system_def->keyframes[1].rotation_speed_variation);
     } else {
         // if there's only 1 keyframe, then apply the variations now
         for(int32 j = 0; j < 4; ++j) {
-            _particles[i].color[j] += RandomFloat(-_particles[i].current_color_variation[j],
-                                                  _particles[i].current_color_variation[j]);
+            _particles.color[i][j] += _RandomFloat(-_particles.current_color_variation[i][j],
+                                                  _particles.current_color_variation[i][j]);
         }
 
-        _particles[i].size_x += RandomFloat(-_particles[i].current_size_variation_x,
-                                            _particles[i].current_size_variation_x);
-        _particles[i].size_y += RandomFloat(-_particles[i].current_size_variation_y,
-                                            _particles[i].current_size_variation_y);
+        _particles.size_x[i] += _RandomFloat(-_particles.current_size_variation_x[i],
+                                            _particles.current_size_variation_x[i]);
+        _particles.size_y[i] += _RandomFloat(-_particles.current_size_variation_y[i],
+                                            _particles.current_size_variation_y[i]);
 
-        _particles[i].rotation_speed += RandomFloat(-_particles[i].current_rotation_speed_variation,
-                                        _particles[i].current_rotation_speed_variation);
+        _particles.rotation_speed[i] += _RandomFloat(-_particles.current_rotation_speed_variation[i],
+                                        _particles.current_rotation_speed_variation[i]);
     }
 
-    _particles[i].tangential_acceleration = _system_def->tangential_acceleration;
+    _particles.tangential_acceleration[i] = _system_def->tangential_acceleration;
     if(_system_def->tangential_acceleration_variation != 0.0f)
-        _particles[i].tangential_acceleration += RandomFloat(-_system_def->tangential_acceleration_variation,
+        _particles.tangential_acceleration[i] += _RandomFloat(-_system_def->tangential_acceleration_variation,
                 _system_def->tangential_acceleration_variation);
 
-    _particles[i].radial_acceleration = _system_def->radial_acceleration;
+    _particles.radial_acceleration[i] = _system_def->radial_acceleration;
     if(_system_def->radial_acceleration_variation != 0.0f)
-        _particles[i].radial_acceleration += RandomFloat(-_system_def->radial_acceleration_variation,
+        _particles.radial_acceleration[i] += _RandomFloat(-_system_def->radial_acceleration_variation,
                                              _system_def->radial_acceleration_variation);
 
-    _particles[i].acceleration_x = _system_def->acceleration_x;
+    _particles.acceleration_x[i] = _system_def->acceleration_x;
     if(_system_def->acceleration_variation_x != 0.0f)
-        _particles[i].acceleration_x += RandomFloat(-_system_def->acceleration_variation_x,
+        _particles.acceleration_x[i] += _RandomFloat(-_system_def->acceleration_variation_x,
                                         _system_def->acceleration_variation_x);
 
-    _particles[i].acceleration_y = _system_def->acceleration_y;
+    _particles.acceleration_y[i] = _system_def->acceleration_y;
     if(_system_def->acceleration_variation_y != 0.0f)
-        _particles[i].acceleration_y += RandomFloat(-_system_def->acceleration_variation_y,
+        _particles.acceleration_y[i] += _RandomFloat(-_system_def->acceleration_variation_y,
                                         _system_def->acceleration_variation_y);
 
-    _particles[i].wind_velocity_x = _system_def->wind_velocity_x;
+    _particles.wind_velocity_x[i] = _system_def->wind_velocity_x;
     if(_system_def->wind_velocity_variation_x != 0.0f)
-        _particles[i].wind_velocity_x += RandomFloat(-_system_def->wind_velocity_variation_x,
+        _particles.wind_velocity_x[i] += _RandomFloat(-_system_def->wind_velocity_variation_x,
                                          _system_def->wind_velocity_variation_x);
 
-    _particles[i].wind_velocity_y = _system_def->wind_velocity_y;
+    _particles.wind_velocity_y[i] = _system_def->wind_velocity_y;
     if(_system_def->wind_velocity_variation_y != 0.0f)
-        _particles[i].wind_velocity_y += RandomFloat(-_system_def->wind_velocity_variation_y,
+        _particles.wind_velocity_y[i] += _RandomFloat(-_system_def->wind_velocity_variation_y,
                                          _system_def->wind_velocity_variation_y);
 
-    _particles[i].damping = _system_def->damping;
+    _particles.damping[i] = _system_def->damping;
     if(_system_def->damping_variation != 0.0f)
-        _particles[i].damping += RandomFloat(-_system_def->damping_variation,
+        _particles.damping[i] += _RandomFloat(-_system_def->damping_variation,
                                              _system_def->damping_variation);
 
     if(_system_def->wave_motion_used) {
-        _particles[i].wave_length_coefficient = _system_def->wave_length;
+        _particles.wave_length_coefficient[i] = _system_def->wave_length;
         if(_system_def->wave_length_variation != 0.0f)
-            _particles[i].wave_length_coefficient += RandomFloat(-_system_def->wave_length_variation,
+            _particles.wave_length_coefficient[i] += _RandomFloat(-_system_def->wave_length_variation,
                     _system_def->wave_length_variation);
 
-        _particles[i].wave_length_coefficient = UTILS_2PI / _particles[i].wave_length_coefficient;
+        _particles.wave_length_coefficient[i] = UTILS_2PI / _particles.wave_length_coefficient[i];
 
-        _particles[i].wave_half_amplitude = _system_def->wave_amplitude;
+        _particles.wave_half_amplitude[i] = _system_def->wave_amplitude;
         if(_system_def->wave_amplitude != 0.0f)
-            _particles[i].wave_half_amplitude += RandomFloat(-_system_def->wave_amplitude_variation,
+            _particles.wave_half_amplitude[i] += _RandomFloat(-_system_def->wave_amplitude_variation,
                                                  _system_def->wave_amplitude_variation);
-        _particles[i].wave_half_amplitude *= 0.5f;
+        _particles.wave_half_amplitude[i] *= 0.5f;
     }
 
-    _particles[i].lifetime = _system_def->particle_lifetime
-                             + RandomFloat(-_system_def->particle_lifetime_variation,
+    _particles.lifetime[i] = _system_def->particle_lifetime
+                             + _RandomFloat(-_system_def->particle_lifetime_variation,
                                            _system_def->particle_lifetime_variation);
 }
 
@@ -291,7 +291,7 @@ public:
     /*!
      *  \brief Constructor
      */
-    ParticleSystem(ParticleSystemDef *sys_def) {
+    ParticleSystem(const ParticleSystemDef *sys_def) {
         _Destroy();
         _Create(sys_def);
     }
@@ -360,7 +360,7 @@ private:
      * \param sys_def particle definition to base the system off of
      * \return success/failure
      */
-    bool _Create(ParticleSystemDef *sys_def);
+    bool _Create(const ParticleSystemDef *sys_def);
 
     /*!
      *  \brief destroys the system
@@ -374,6 +374,12 @@ private:
      */
     void _UpdateParticles(float t, const EffectParameters &params);
 
+    /*!
+     *  \brief helper function to _UpdateParticles() which advances the particles
+     *         keyframes and interpolates the keyframed properties
+     */
+    void _UpdateKeyframedProperties();
+
     /*!
      *  \brief helper function to kill off any particles that have died
      *
@@ -412,11 +418,37 @@ private:
      */
     void _RespawnParticle(int32 i, const EffectParameters &params);
 
+    /*!
+     *  \brief writes the color of each particle to its four vertices
+     * \param alpha_scale the value the colors are multiplied by
+     */
+    void _FillColors(float alpha_scale);
+
+    /*!
+     *  \brief writes the texture coordinates of the given image to the particles vertices
+     * \param img the image texture of the current animation frame
+     */
+    void _FillTexCoords(const hoa_video::private_video::ImageTexture *img);
+
+    /*!
+     *  \brief returns a random value between a and b
+     *
+     *  This uses the system's own xorshift generator, which is much cheaper than rand()
+     *  and gives enough randomness for the particles properties.
+     */
+    float _RandomFloat(float a, float b) {
+        _random_state ^= _random_state << 13;
+        _random_state ^= _random_state >> 17;
+        _random_state ^= _random_state << 5;
+        // the upper 24 bits give a value from 0.0 to 1.0 with a float's precision
+        return a + (b - a) * (static_cast<float>(_random_state >> 8) * (1.0f / 16777215.0f));
+    }
+
     //! The system definition, contains information like the emitter properties, lifetime of
     //! particles, particle keyframes, etc. Basically everything which isn't instance-specific
     //! Note that this pointer shouldn't be deleted by the particle system, since it's handled by
     //! the corresponding ParticleEffectDef instance.
-    ParticleSystemDef *_system_def;
+    const ParticleSystemDef *_system_def;
 
     //! Animation for each particle. If it's non-animated, it just has 1 frame
     hoa_video::AnimatedImage _animation;
@@ -431,9 +463,15 @@ private:
     std::vector<hoa_video::Color> _particle_colors;
     std::vector<ParticleTexCoord> _particle_texcoords;
 
-    //! This array holds everything except positions and colors. The reason we keep positions and
-    //! colors separate is so that they can be efficiently fed to OpenGL for rendering.
-    std::vector<Particle> _particles;
+    //! The number of particles whose texture coordinates are written, and the image they come from
+    int32 _num_texcoords;
+    const hoa_video::private_video::ImageTexture *_texcoords_image;
+
+    //! The properties of the particles, from which the vertices are generated when drawing
+    ParticleArray _particles;
+
+    //! The state of the random numbers generator of this system. Never zero.
+    uint32 _random_state;
 
     //! if stopped is true, no new particles should be emitted
     bool _stopped;
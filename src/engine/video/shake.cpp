@@ -135,6 +135,21 @@ void VideoEngine::_UpdateShake(uint32 frame_time)
 
 
 
+void VideoEngine::GetShakeOffsets(float &x, float &y) const
+{
+    if(_shake_forces.empty()) {
+        x = 0.0f;
+        y = 0.0f;
+        return;
+    }
+
+    const CoordSys &coord_sys = _current_context.coordinate_system;
+    x = _x_shake * (coord_sys.GetRight() - coord_sys.GetLeft()) / VIDEO_STANDARD_RES_WIDTH;
+    y = _y_shake * (coord_sys.GetTop() - coord_sys.GetBottom()) / VIDEO_STANDARD_RES_HEIGHT;
+}
+
+
+
 float VideoEngine::_RoundForce(float force)
 {
     int32 fraction_percent = static_cast<int32>(force * 100.0f) - (static_cast<int32>(force) * 100);
@@ -0,0 +1,135 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012 by Bertram
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    sprite_batcher.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fre
+*** \brief   Source file for the sprite batching code
+*** ***************************************************************************/
+
+#include "sprite_batcher.h"
+
+#include "video.h"
+
+#include <cmath>
+
+using namespace hoa_utils;
+
+namespace hoa_video
+{
+
+namespace private_video
+{
+
+void Transform2D::Rotate(float angle)
+{
+    // OpenGL expects degrees
+    float radians = angle * UTILS_PI / 180.0f;
+    float cos_angle = cosf(radians);
+    float sin_angle = sinf(radians);
+
+    float new_a = a * cos_angle + c * sin_angle;
+    float new_b = b * cos_angle + d * sin_angle;
+    c = c * cos_angle - a * sin_angle;
+    d = d * cos_angle - b * sin_angle;
+    a = new_a;
+    b = new_b;
+}
+
+
+
+SpriteBatcher::SpriteBatcher() :
+    _sheet(NULL),
+    _smooth(false),
+    _blend(0),
+    _num_batches(0),
+    _num_quads(0),
+    _last_frame_num_batches(0),
+    _last_frame_num_quads(0)
+{}
+
+
+
+void SpriteBatcher::AddQuad(TexSheet *sheet, bool smooth, uint8 blend,
+                            const float vertices[8], const float tex_coords[8], const Color colors[4])
+{
+    // Draw the pending quads if they can't share the draw call of the new one
+    if(!_vertices.empty() && (sheet != _sheet || smooth != _smooth || blend != _blend))
+        _DrawBatch();
+
+    _sheet = sheet;
+    _smooth = smooth;
+    _blend = blend;
+
+    _vertices.insert(_vertices.end(), vertices, vertices + 8);
+    _tex_coords.insert(_tex_coords.end(), tex_coords, tex_coords + 8);
+    _colors.insert(_colors.end(), colors, colors + 4);
+
+    ++_num_quads;
+}
+
+
+
+void SpriteBatcher::ResetFrameStats()
+{
+    _last_frame_num_batches = _num_batches;
+    _last_frame_num_quads = _num_quads;
+    _num_batches = 0;
+    _num_quads = 0;
+}
+
+
+
+void SpriteBatcher::_DrawBatch()
+{
+    // The vertices were already transformed when added
+    glPushMatrix();
+    glLoadIdentity();
+
+    if(_blend) {
+        VideoManager->EnableBlending();
+        if(_blend == 1)
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // Normal blending
+        else
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE); // Additive blending
+    } else {
+        VideoManager->DisableBlending();
+    }
+
+    VideoManager->EnableVertexArray();
+    glVertexPointer(2, GL_FLOAT, 0, &_vertices[0]);
+
+    if(_sheet) {
+        VideoManager->EnableTexture2D();
+        TextureManager->_BindTexture(_sheet->tex_id);
+        _sheet->Smooth(_smooth);
+
+        VideoManager->EnableTextureCoordArray();
+        glTexCoordPointer(2, GL_FLOAT, 0, &_tex_coords[0]);
+    } else {
+        // Untextured quads are drawn using pure colors
+        VideoManager->DisableTexture2D();
+    }
+
+    VideoManager->EnableColorArray();
+    glColorPointer(4, GL_FLOAT, 0, (GLfloat *)&_colors[0]);
+
+    glDrawArrays(GL_QUADS, 0, _vertices.size() / 2);
+
+    glPopMatrix();
+
+    _vertices.clear();
+    _tex_coords.clear();
+    _colors.clear();
+    ++_num_batches;
+}
+
+} // namespace private_video
+
+} // namespace hoa_video
@@ -0,0 +1,170 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012 by Bertram
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    sprite_batcher.h
+*** \author  Yohann Ferreira, yohann ferreira orange fre
+*** \brief   Header file for the sprite batching code
+***
+*** This file contains two classes:
+***
+*** - <b>Transform2D</b>: a CPU-side copy of the 2D part of the OpenGL modelview
+*** matrix, kept up to date by the video engine transformation methods.
+***
+*** - <b>SpriteBatcher</b>: collects the image quads drawn by the video engine
+*** and sends them to OpenGL in as few draw calls as possible.
+*** ***************************************************************************/
+
+#ifndef __SPRITE_BATCHER_HEADER__
+#define __SPRITE_BATCHER_HEADER__
+
+#include "utils.h"
+#include "color.h"
+
+namespace hoa_video
+{
+
+namespace private_video
+{
+
+class TexSheet;
+
+/** ****************************************************************************
+*** \brief Mirrors the 2D affine part of the OpenGL modelview matrix
+***
+*** The transformation is stored in the same order as an OpenGL matrix restricted
+*** to the x and y axes, so that a point (x, y) is transformed into
+*** (a * x + c * y + tx, b * x + d * y + ty).
+*** ***************************************************************************/
+class Transform2D
+{
+public:
+    Transform2D() {
+        LoadIdentity();
+    }
+
+    //! \brief Resets the transformation
+    void LoadIdentity() {
+        a = 1.0f;
+        b = 0.0f;
+        c = 0.0f;
+        d = 1.0f;
+        tx = 0.0f;
+        ty = 0.0f;
+    }
+
+    //! \brief Same as glTranslatef(x, y, 0)
+    void Translate(float x, float y) {
+        tx += a * x + c * y;
+        ty += b * x + d * y;
+    }
+
+    //! \brief Same as glScalef(x, y, 1)
+    void Scale(float x, float y) {
+        a *= x;
+        b *= x;
+        c *= y;
+        d *= y;
+    }
+
+    //! \brief Same as glRotatef(angle, 0, 0, 1)
+    void Rotate(float angle);
+
+    //! \brief Loads the 2D part of a column-major 4x4 OpenGL matrix
+    void LoadMatrix(const float matrix[16]) {
+        a = matrix[0];
+        b = matrix[1];
+        c = matrix[4];
+        d = matrix[5];
+        tx = matrix[12];
+        ty = matrix[13];
+    }
+
+    //! \brief Transforms the given point
+    void Apply(float x, float y, float &out_x, float &out_y) const {
+        out_x = a * x + c * y + tx;
+        out_y = b * x + d * y + ty;
+    }
+
+    float a, b, c, d;
+    float tx, ty;
+}; // class Transform2D
+
+
+/** ****************************************************************************
+*** \brief Collects image quads and draws them in batches
+***
+*** Each added quad is already transformed by the modelview transformation,
+*** so quads drawn at different positions can share the same draw call.
+*** A batch is drawn when a quad using another texture sheet, smoothing or
+*** blending mode is added, or when the video engine is about to change
+*** a state the pending quads depend on (coordinate system, viewport,
+*** scissoring, ...) or to draw something without the batcher.
+*** ***************************************************************************/
+class SpriteBatcher
+{
+public:
+    SpriteBatcher();
+
+    /** \brief Adds a quad to the current batch
+    *** \param sheet The texture sheet of the quad, or NULL for untextured quads
+    *** \param smooth Whether the texture sheet should be smoothed
+    *** \param blend The blending mode: 0 for none, 1 for normal and 2 for additive blending
+    *** \param vertices The four vertices of the quad, already transformed
+    *** \param tex_coords The four texture coordinates of the quad
+    *** \param colors The four vertex colors of the quad
+    **/
+    void AddQuad(TexSheet *sheet, bool smooth, uint8 blend,
+                 const float vertices[8], const float tex_coords[8], const Color colors[4]);
+
+    //! \brief Draws the pending quads, if any.
+    void Flush() {
+        if(!_vertices.empty())
+            _DrawBatch();
+    }
+
+    //! \brief Resets the per frame statistics, saving the current ones as the last frame ones.
+    void ResetFrameStats();
+
+    //! \brief Returns the number of batches drawn during the last complete frame.
+    uint32 GetLastFrameNumBatches() const {
+        return _last_frame_num_batches;
+    }
+
+    //! \brief Returns the number of quads drawn during the last complete frame.
+    uint32 GetLastFrameNumQuads() const {
+        return _last_frame_num_quads;
+    }
+
+private:
+    //! \brief The state shared by the pending quads.
+    TexSheet *_sheet;
+    bool _smooth;
+    uint8 _blend;
+
+    //! \brief The pending quads data, ready to be used by glDrawArrays().
+    std::vector<float> _vertices;
+    std::vector<float> _tex_coords;
+    std::vector<Color> _colors;
+
+    //! \brief Statistics about the current frame and the last complete one.
+    uint32 _num_batches;
+    uint32 _num_quads;
+    uint32 _last_frame_num_batches;
+    uint32 _last_frame_num_quads;
+
+    //! \brief Sends the pending quads to OpenGL and empties the batch.
+    void _DrawBatch();
+}; // class SpriteBatcher
+
+}  // namespace private_video
+
+}  // namespace hoa_video
+
+#endif  // __SPRITE_BATCHER_HEADER__
@@ -268,7 +268,7 @@ void TextElement::Draw(const Color &draw_color) const
         return;
     }
 
-    glPushMatrix();
+    VideoManager->PushMatrix();
     _DrawOrientation();
 
     float modulation = VideoManager->_screen_fader.GetFadeModulation();
@@ -288,7 +288,7 @@ void TextElement::Draw(const Color &draw_color) const
         _DrawTexture(modulated_colors);
     }
 
-    glPopMatrix();
+    VideoManager->PopMatrix();
 } // void TextElement::Draw(const Color& draw_color) const
 
 
@@ -408,12 +408,12 @@ void TextImage::Clear()
 
 void TextImage::Draw() const
 {
-    glPushMatrix();
+    VideoManager->PushMatrix();
     for(uint32 i = 0; i < _text_sections.size(); ++i) {
         _text_sections[i]->Draw();
         VideoManager->MoveRelative(0.0f, TextManager->GetFontProperties(_style.font)->line_skip * -VideoManager->_current_context.coordinate_system.GetVerticalDirection());
     }
-    glPopMatrix();
+    VideoManager->PopMatrix();
 }
 
 
@@ -425,12 +425,12 @@ void TextImage::Draw(const Color &draw_color) const
         return;
     }
 
-    glPushMatrix();
+    VideoManager->PushMatrix();
     for(uint32 i = 0; i < _text_sections.size(); ++i) {
         _text_sections[i]->Draw(draw_color);
         VideoManager->MoveRelative(0.0f, TextManager->GetFontProperties(_style.font)->line_skip * -VideoManager->_current_context.coordinate_system.GetVerticalDirection());
     }
-    glPopMatrix();
+    VideoManager->PopMatrix();
 }
 
 
@@ -532,6 +532,10 @@ TextSupervisor::~TextSupervisor()
         if(fp->glyph_cache) {
             std::vector<hoa_video::FontGlyph *>::const_iterator it_end = fp->glyph_cache->end();
             for(std::vector<FontGlyph *>::iterator j = fp->glyph_cache->begin(); j != it_end; ++j) {
+                if(*j && (*j)->texture) {
+                    (*j)->texture->texture_sheet->RemoveTexture((*j)->texture);
+                    delete (*j)->texture;
+                }
                 delete *j;
             }
             delete fp->glyph_cache;
@@ -617,13 +621,17 @@ FontProperties *TextSupervisor::GetFontProperties(const std::string &font_name)
 
 
 
-void TextSupervisor::Draw(const ustring &text, const TextStyle &style)
+void TextSupervisor::Draw(const ustring &text, const TextStyle &style, size_t first_char, size_t num_chars)
 {
-    if(text.empty()) {
+    if(text.empty() || num_chars == 0 || first_char >= text.length()) {
         IF_PRINT_WARNING(VIDEO_DEBUG) << "empty string was passed to function" << std::endl;
         return;
     }
 
+    size_t end_char = first_char + num_chars;
+    if(end_char > text.length())
+        end_char = text.length();
+
     if(IsFontValid(style.font) == false) {
         IF_PRINT_WARNING(VIDEO_DEBUG) << "failed because font was invalid: " << style.font << std::endl;
         return;
@@ -635,11 +643,11 @@ void TextSupervisor::Draw(const ustring &text, const TextStyle &style)
     // Break the string into lines and render the shadow and text for each line
     uint16 buffer[2048];
     const uint16 NEWLINE = '\n';
-    size_t last_line = 0;
+    size_t last_line = first_char;
     do {
         // Find the next new line character in the string and save the line
         size_t next_line;
-        for(next_line = last_line; next_line < text.length(); next_line++) {
+        for(next_line = last_line; next_line < end_char; next_line++) {
             if(text[next_line] == NEWLINE)
                 break;
 
@@ -655,26 +663,26 @@ void TextSupervisor::Draw(const ustring &text, const TextStyle &style)
         }
 
         // Save the draw cursor position before drawing this text
-        glPushMatrix();
+        VideoManager->PushMatrix();
 
         // If text shadows are enabled, draw the shadow first
         if(style.shadow_style != VIDEO_TEXT_SHADOW_NONE) {
-            glPushMatrix();
+            VideoManager->PushMatrix();
             VideoManager->MoveRelative(VideoManager->_current_context.coordinate_system.GetHorizontalDirection() * style.shadow_offset_x, 0.0f);
             VideoManager->MoveRelative(0.0f, VideoManager->_current_context.coordinate_system.GetVerticalDirection() * style.shadow_offset_y);
             _DrawTextHelper(buffer, fp, _GetTextShadowColor(style));
-            glPopMatrix();
+            VideoManager->PopMatrix();
         }
 
         // Now draw the text itself, restore the position of the draw cursor, and move the draw cursor one line down
         _DrawTextHelper(buffer, fp, style.color);
-        glPopMatrix();
+        VideoManager->PopMatrix();
         VideoManager->MoveRelative(0, -fp->line_skip * VideoManager->_current_context.coordinate_system.GetVerticalDirection());
 
-    } while(last_line < text.length());
+    } while(last_line < end_char);
 
     VideoManager->PopState();
-} // void TextSupervisor::Draw(const ustring& text)
+} // void TextSupervisor::Draw(const ustring& text, const TextStyle& style, size_t first_char, size_t num_chars)
 
 
 
@@ -771,7 +779,6 @@ void TextSupervisor::_CacheGlyphs(const uint16 *text, FontProperties *fp)
     SDL_Surface *initial = NULL;
     SDL_Surface *intermediary = NULL;
     int32 w, h;
-    GLuint texture;
 
     // Go through each character in the string and cache those glyphs that have not already been cached
     for(const uint16 *character_ptr = text; *character_ptr != 0; ++character_ptr) {
@@ -797,8 +804,9 @@ void TextSupervisor::_CacheGlyphs(const uint16 *text, FontProperties *fp)
             }
         }
 
-        w = RoundUpPow2(initial->w + 1);
-        h = RoundUpPow2(initial->h + 1);
+        // The glyph is stored in a texture sheet, so there is no need for power of two dimensions
+        w = initial->w + 1;
+        h = initial->h + 1;
 
         intermediary = SDL_CreateRGBSurface(0, w, h, 32, RMASK, GMASK, BMASK, AMASK);
         if(intermediary == NULL) {
@@ -815,9 +823,15 @@ void TextSupervisor::_CacheGlyphs(const uint16 *text, FontProperties *fp)
             return;
         }
 
-        glGenTextures(1, &texture);
-        TextureManager->_BindTexture(texture);
-
+        int minx, maxx;
+        int miny, maxy;
+        int advance;
+        if(TTF_GlyphMetrics(font, character, &minx, &maxx, &miny, &maxy, &advance) != 0) {
+            SDL_FreeSurface(initial);
+            SDL_FreeSurface(intermediary);
+            IF_PRINT_WARNING(VIDEO_DEBUG) << "call to TTF_GlyphMetrics() failed" << std::endl;
+            return;
+        }
 
         SDL_LockSurface(intermediary);
 
@@ -829,25 +843,23 @@ void TextSupervisor::_CacheGlyphs(const uint16 *text, FontProperties *fp)
             (static_cast<uint8 *>(intermediary->pixels))[j + 2] = 0xff;
         }
 
-        glTexImage2D(GL_TEXTURE_2D, 0, 4, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, intermediary->pixels);
-        SDL_UnlockSurface(intermediary);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        // Copy the glyph into a font glyphs texture sheet
+        ImageMemory buffer;
+        buffer.width = w;
+        buffer.height = h;
+        buffer.pixels = intermediary->pixels;
+        buffer.rgb_format = false;
 
-        if(VideoManager->CheckGLError()) {
-            SDL_FreeSurface(initial);
-            SDL_FreeSurface(intermediary);
-            IF_PRINT_WARNING(VIDEO_DEBUG) << "an OpenGL error was detected: " << VideoManager->CreateGLErrorString() << std::endl;
-            return;
-        }
+        BaseTexture *texture = new BaseTexture(w, h);
+        TexSheet *sheet = TextureManager->_InsertGlyphInTexSheet(texture, buffer);
+        buffer.pixels = NULL;
+        SDL_UnlockSurface(intermediary);
 
-        int minx, maxx;
-        int miny, maxy;
-        int advance;
-        if(TTF_GlyphMetrics(font, character, &minx, &maxx, &miny, &maxy, &advance) != 0) {
+        if(sheet == NULL) {
+            delete texture;
             SDL_FreeSurface(initial);
             SDL_FreeSurface(intermediary);
-            IF_PRINT_WARNING(VIDEO_DEBUG) << "call to TTF_GlyphMetrics() failed" << std::endl;
+            IF_PRINT_WARNING(VIDEO_DEBUG) << "call to TextureController::_InsertGlyphInTexSheet() failed" << std::endl;
             return;
         }
 
@@ -856,10 +868,8 @@ void TextSupervisor::_CacheGlyphs(const uint16 *text, FontProperties *fp)
         glyph->min_x = minx;
         glyph->min_y = miny;
         glyph->top_y = fp->ascent - maxy;
-        glyph->width = initial->w + 1;
-        glyph->height = initial->h + 1;
-        glyph->max_x = static_cast<float>(initial->w + 1) / static_cast<float>(w);
-        glyph->max_y = static_cast<float>(initial->h + 1) / static_cast<float>(h);
+        glyph->width = w;
+        glyph->height = h;
         glyph->advance = advance;
 
         (*fp->glyph_cache)[character] = glyph;
@@ -883,18 +893,10 @@ void TextSupervisor::_DrawTextHelper(const uint16 *const text, FontProperties *f
         return;
     }
 
-    glBlendFunc(GL_ONE, GL_ONE);
-    VideoManager->EnableBlending();
-
     CoordSys &cs = VideoManager->_current_context.coordinate_system;
 
     _CacheGlyphs(text, fp);
 
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    VideoManager->EnableTexture2D();
-
-    glPushMatrix();
-
     int font_width, font_height;
     if(TTF_SizeUNICODE(fp->ttf_font, text, &font_width, &font_height) != 0) {
         IF_PRINT_WARNING(VIDEO_DEBUG) << "call to TTF_SizeUNICODE() failed" << std::endl;
@@ -904,69 +906,51 @@ void TextSupervisor::_DrawTextHelper(const uint16 *const text, FontProperties *f
     float xoff = ((VideoManager->_current_context.x_align + 1) * font_width) * 0.5f * -cs.GetHorizontalDirection();
     float yoff = ((VideoManager->_current_context.y_align + 1) * font_height) * 0.5f * -cs.GetVerticalDirection();
 
-    VideoManager->MoveRelative(xoff, yoff);
-
     float modulation = VideoManager->_screen_fader.GetFadeModulation();
     Color final_color = text_color * modulation;
+    Color colors[4] = { final_color, final_color, final_color, final_color };
 
-    VideoManager->EnableVertexArray();
-    VideoManager->EnableTextureCoordArray();
-
-    GLint vertices[8];
-    GLfloat tex_coords[8];
-    glVertexPointer(2, GL_INT, 0, vertices);
-    glTexCoordPointer(2, GL_FLOAT, 0, tex_coords);
+    // The glyphs are sent to the sprite batcher, so that all the glyphs stored
+    // in the same texture sheet are drawn at once.
+    const Transform2D &transform = VideoManager->_transform;
+    float vertices[8];
+    float tex_coords[8];
 
-    // Iterate through each character in the string and render the character glyphs one at a time
     int xpos = 0;
     for(const uint16 *glyph = text; *glyph != 0; ++glyph) {
         FontGlyph *glyph_info = (*fp->glyph_cache)[*glyph];
+        if(glyph_info == NULL)
+            continue;
 
-        int x_hi = glyph_info->width;
-        int y_hi = glyph_info->height;
+        float x_hi = static_cast<float>(glyph_info->width);
+        float y_hi = static_cast<float>(glyph_info->height);
         if(cs.GetHorizontalDirection() < 0.0f)
             x_hi = -x_hi;
         if(cs.GetVerticalDirection() < 0.0f)
             y_hi = -y_hi;
 
-        int min_x, min_y;
-        min_x = glyph_info->min_x * static_cast<int>(cs.GetHorizontalDirection()) + xpos;
-        min_y = glyph_info->min_y * static_cast<int>(cs.GetVerticalDirection());
+        float min_x = xoff + static_cast<float>(glyph_info->min_x * static_cast<int>(cs.GetHorizontalDirection()) + xpos);
+        float min_y = yoff + static_cast<float>(glyph_info->min_y * static_cast<int>(cs.GetVerticalDirection()));
 
-        float tx, ty;
-        tx = glyph_info->max_x;
-        ty = glyph_info->max_y;
+        transform.Apply(min_x, min_y, vertices[0], vertices[1]);
+        transform.Apply(min_x + x_hi, min_y, vertices[2], vertices[3]);
+        transform.Apply(min_x + x_hi, min_y + y_hi, vertices[4], vertices[5]);
+        transform.Apply(min_x, min_y + y_hi, vertices[6], vertices[7]);
 
-        TextureManager->_BindTexture(glyph_info->texture);
-        if(VideoManager->CheckGLError()) {
-            IF_PRINT_WARNING(VIDEO_DEBUG) << "OpenGL error detected: " << VideoManager->CreateGLErrorString() << std::endl;
-            return;
-        }
+        const BaseTexture *texture = glyph_info->texture;
+        tex_coords[0] = texture->u1;
+        tex_coords[1] = texture->v2;
+        tex_coords[2] = texture->u2;
+        tex_coords[3] = texture->v2;
+        tex_coords[4] = texture->u2;
+        tex_coords[5] = texture->v1;
+        tex_coords[6] = texture->u1;
+        tex_coords[7] = texture->v1;
 
-        vertices[0] = min_x;
-        vertices[1] = min_y;
-        vertices[2] = min_x + x_hi;
-        vertices[3] = min_y;
-        vertices[4] = min_x + x_hi;
-        vertices[5] = min_y + y_hi;
-        vertices[6] = min_x;
-        vertices[7] = min_y + y_hi;
-        tex_coords[0] = 0.0f;
-        tex_coords[1] = ty;
-        tex_coords[2] = tx;
-        tex_coords[3] = ty;
-        tex_coords[4] = tx;
-        tex_coords[5] = 0.0f;
-        tex_coords[6] = 0.0f;
-        tex_coords[7] = 0.0f;
-
-        glColor4fv((GLfloat *)&final_color);
-        glDrawArrays(GL_QUADS, 0, 4);
+        VideoManager->_sprite_batcher.AddQuad(texture->texture_sheet, true, 1, vertices, tex_coords, colors);
 
         xpos += glyph_info->advance;
     } // for (const uint16* glyph = text; *glyph != 0; glyph++)
-
-    glPopMatrix();
 } // void TextSupervisor::_DrawTextHelper(const uint16* const text, FontProperties* fp, Color color)
 
 
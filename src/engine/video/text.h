@@ -69,8 +69,10 @@ enum TEXT_SHADOW_STYLE {
 class FontGlyph
 {
 public:
-    //! \brief The index of the GL texture for this glyph.
-    GLuint texture;
+    /** \brief The glyph image, stored in a font glyphs texture sheet.
+    *** The texture coordinates of the glyph are the ones of this texture.
+    **/
+    private_video::BaseTexture *texture;
 
     //! \brief The width and height of the glyph in pixels.
     int32 width, height;
@@ -78,9 +80,6 @@ public:
     //! \brief The mininum x and y pixel coordinates of the glyph in texture space (refer to TTF_GlyphMetrics).
     int min_x, min_y;
 
-    //! \brief The maximum x and y pixel coordinates of the glyph in texture space (refer to TTF_GlyphMetrics).
-    float max_x, max_y;
-
     //! \brief The amount of space between glyphs.
     int32 advance;
 
@@ -485,7 +484,18 @@ public:
     *** \param text The text string to draw in unicode format
     *** \param style A reference to the TextStyle to use for drawing the string
     **/
-    void Draw(const hoa_utils::ustring &text, const TextStyle &style);
+    void Draw(const hoa_utils::ustring &text, const TextStyle &style) {
+        Draw(text, style, 0, text.length());
+    }
+
+    /** \brief Draws a part of a unicode string of text to the screen in a desired text style
+    *** \param text The text string to draw in unicode format
+    *** \param style A reference to the TextStyle to use for drawing the string
+    *** \param first_char The index of the first character of the text to draw
+    *** \param num_chars The number of characters to draw, starting from first_char
+    *** This lets gradually displayed text be drawn without building substrings every frame.
+    **/
+    void Draw(const hoa_utils::ustring &text, const TextStyle &style, size_t first_char, size_t num_chars);
 
     /** \brief Renders and draws a standard string of text to the screen in the default text style
     *** \param text The text string to draw in standard format
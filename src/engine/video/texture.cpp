@@ -17,6 +17,10 @@
 
 #include "texture.h"
 
+#include "engine/system.h"
+
+#include <algorithm>
+
 using namespace hoa_utils;
 
 namespace hoa_video
@@ -103,6 +107,10 @@ bool TexSheet::Reload()
 
 bool TexSheet::CopyRect(int32 x, int32 y, ImageMemory &data)
 {
+    // Pending images may still use the texture area about to be overwritten
+    VideoManager->FlushSprites();
+
+    hoa_system::ProfileTimer profile(hoa_system::PROFILE_TEXTURE_UPLOAD);
     TextureManager->_BindTexture(tex_id);
 
     glTexSubImage2D(
@@ -129,6 +137,9 @@ bool TexSheet::CopyRect(int32 x, int32 y, ImageMemory &data)
 
 bool TexSheet::CopyScreenRect(int32 x, int32 y, const ScreenRect &screen_rect)
 {
+    // Every pending image must be drawn on the screen before copying it
+    VideoManager->FlushSprites();
+
     TextureManager->_BindTexture(tex_id);
 
     glCopyTexSubImage2D(
@@ -185,6 +196,9 @@ void TexSheet::DEBUG_Draw() const
         0.0f, 0.0f, // Upper left
     };
 
+    // The texture sheet is drawn directly through OpenGL
+    VideoManager->FlushSprites();
+
     // Enable texturing and bind the texture
     VideoManager->DisableBlending();
     VideoManager->EnableTexture2D();
@@ -196,6 +210,8 @@ void TexSheet::DEBUG_Draw() const
 
     // Use a vertex array to draw all of the vertices
     VideoManager->EnableVertexArray();
+    VideoManager->DisableColorArray();
+    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
     glVertexPointer(2, GL_FLOAT, 0, vertex_coords);
     glDrawArrays(GL_QUADS, 0, 4);
 } // void TexSheet::DEBUG_Draw() const
@@ -437,11 +453,17 @@ FixedTexNode *FixedTexSheet::_RemoveOpenNode()
 // -----------------------------------------------------------------------------
 
 VariableTexSheet::VariableTexSheet(int32 sheet_width, int32 sheet_height, GLuint sheet_id, TexSheetType sheet_type, bool sheet_static) :
-    TexSheet(sheet_width, sheet_height, sheet_id, sheet_type, sheet_static)
+    TexSheet(sheet_width, sheet_height, sheet_id, sheet_type, sheet_static),
+    _max_free_width(0),
+    _max_free_height(0),
+    _used_area(0)
 {
-    _block_width = width / 16;
-    _block_height = height / 16;
-    _blocks = new VariableTexNode[_block_width * _block_height];
+    _block_width = 0;
+    _block_height = 0;
+
+    // The whole sheet is free, the padding of the textures on the edges being outside of it
+    _free_rects.push_back(VariableTexRect(0, 0, width + VIDEO_VARIABLE_TEXSHEET_PADDING, height + VIDEO_VARIABLE_TEXSHEET_PADDING));
+    _PruneFreeRects();
 }
 
 
@@ -450,8 +472,6 @@ VariableTexSheet::~VariableTexSheet()
 {
     if(GetNumberTextures() != 0)
         IF_PRINT_WARNING(VIDEO_DEBUG) << "texture sheet being deleted when it has a non-zero allocated texture count: " << GetNumberTextures() << std::endl;
-
-    delete[] _blocks;
 }
 
 
@@ -479,69 +499,28 @@ bool VariableTexSheet::InsertTexture(BaseTexture *img)
         return false;
     }
 
-    // Don't allow insertions into a texture sheet containing a texture larger than 512x512.
-    // Texture sheets with this property may only be used by one texture at a time
-    if(_block_width > 32 || _block_height > 32) {  // 32 blocks == 512 pixels
-        if(_blocks[0].free_image == false)
-            return false;
-    }
-
-    // Attempt to find an open region in the texture sheet to fit this texture
-    int32 block_x = -1, block_y = -1;
-    int32 w = (img->width + 15) / 16;
-    int32 h = (img->height + 15) / 16;
-
-    // This is a brute force algorithm to try and find space to allocate the texture.
-    // If this becomes a bottleneck, we may wish to use a more intellegent algorithm here.
-    bool continue_search = true;
-    for(int32 y = 0; y < _block_height - h + 1 && continue_search; y++) {
-        for(int32 x = 0; x < _block_width - w + 1; x++) {
-            int32 furthest_blocker = -1;
-
-            bool continue_neighbor_search = true;
-            for(int32 dy = 0; dy < h && continue_neighbor_search; dy++) {
-                for(int32 dx = 0; dx < w; dx++) {
-                    if(_blocks[(x + dx) + ((y + dy) * _block_width)].free_image == false) {
-                        furthest_blocker = x + dx;
-                        continue_neighbor_search = false;
-                        break;
-                    }
-                }
-            }
+    int32 rect_width = img->width + VIDEO_VARIABLE_TEXSHEET_PADDING;
+    int32 rect_height = img->height + VIDEO_VARIABLE_TEXSHEET_PADDING;
 
-            if(furthest_blocker == -1) {
-                block_x = x;
-                block_y = y;
-                continue_search = false;
-                break;
-            }
-        }
+    int32 index = _FindFreeRect(rect_width, rect_height);
+
+    // The freed textures are only removed when their space is needed
+    if(index < 0 && !_freed_textures.empty()) {
+        while(!_freed_textures.empty())
+            RemoveTexture(*_freed_textures.begin());
+        index = _FindFreeRect(rect_width, rect_height);
     }
 
-    // If either of these conditions is true, it means we were unable to allocate enough space to insert this texture
-    if(block_x == -1 || block_y == -1)
+    // The texture doesn't fit in this sheet
+    if(index < 0)
         return false;
 
-    // Go through each block that is to be occupied by the new texture and set its properties
-    for(int32 y = block_y; y < block_y + h; y++) {
-        for(int32 x = block_x; x < block_x + w; x++) {
-            int32 index = x + (y * _block_width);
-
-            // If the texture pointer for the block is not NULL, this means it contains a freed texture.
-            // Now we must remove that texture entirely since we are overwriting at least one of its blocks.
-            if(_blocks[index].image) {
-                RemoveTexture(_blocks[index].image);
-            }
-
-            _blocks[index].free_image = false;
-            _blocks[index].image = img;
-        }
-    }
-
-    // Calculate the pixel and uv coordinates for the newly inserted texture
-    img->x = block_x * 16;
-    img->y = block_y * 16;
+    img->x = _free_rects[index].x;
+    img->y = _free_rects[index].y;
+    _SplitFreeRects(VariableTexRect(img->x, img->y, rect_width, rect_height));
+    _used_area += img->width * img->height;
 
+    // Calculate the uv coordinates for the newly inserted texture
     float sheet_width = static_cast<float>(width);
     float sheet_height = static_cast<float>(height);
 
@@ -560,40 +539,212 @@ bool VariableTexSheet::InsertTexture(BaseTexture *img)
 
 void VariableTexSheet::RemoveTexture(BaseTexture *img)
 {
-    _SetBlockProperties(img, NULL, true);
-    _textures.erase(img);
+    if(img == NULL) {
+        IF_PRINT_WARNING(VIDEO_DEBUG) << "NULL pointer was given as function argument" << std::endl;
+        return;
+    }
+
+    if(_textures.erase(img) == 0) {
+        IF_PRINT_WARNING(VIDEO_DEBUG) << "texture pointer argument was not contained within this texture sheet" << std::endl;
+        return;
+    }
+
+    _freed_textures.erase(img);
+    _used_area -= img->width * img->height;
+
+    // An empty sheet gets back a single free rectangle
+    if(_textures.empty()) {
+        _free_rects.clear();
+        _free_rects.push_back(VariableTexRect(0, 0, width + VIDEO_VARIABLE_TEXSHEET_PADDING, height + VIDEO_VARIABLE_TEXSHEET_PADDING));
+        _PruneFreeRects();
+        return;
+    }
+
+    _AddFreeRect(_GetTextureRect(img));
 }
 
 
 
-void VariableTexSheet::_SetBlockProperties(BaseTexture *tex, BaseTexture *new_tex, bool free)
+void VariableTexSheet::FreeTexture(BaseTexture *img)
 {
-    if(tex == NULL) {
-        IF_PRINT_WARNING(VIDEO_DEBUG) << "NULL pointer was given as function argument" << std::endl;
+    if(_textures.find(img) == _textures.end()) {
+        IF_PRINT_WARNING(VIDEO_DEBUG) << "texture pointer argument was not contained within this texture sheet" << std::endl;
         return;
     }
 
-    if(_textures.find(tex) == _textures.end()) {
-        IF_PRINT_WARNING(VIDEO_DEBUG) << "texture pointer argument was not contained within this texture sheet" << std::endl;
+    _freed_textures.insert(img);
+}
+
+
+
+void VariableTexSheet::RestoreTexture(BaseTexture *img)
+{
+    _freed_textures.erase(img);
+}
+
+
+
+float VariableTexSheet::GetOccupancy() const
+{
+    if(width == 0 || height == 0)
+        return 0.0f;
+
+    return static_cast<float>(_used_area) / (static_cast<float>(width) * static_cast<float>(height));
+}
+
+
+
+void VariableTexSheet::GetLargestFreeRect(int32 &rect_width, int32 &rect_height) const
+{
+    rect_width = 0;
+    rect_height = 0;
+    for(uint32 i = 0; i < _free_rects.size(); ++i) {
+        if(_free_rects[i].width * _free_rects[i].height > rect_width * rect_height) {
+            rect_width = _free_rects[i].width;
+            rect_height = _free_rects[i].height;
+        }
+    }
+
+    // Don't report the padding of the last row and column
+    rect_width = std::max(0, rect_width - VIDEO_VARIABLE_TEXSHEET_PADDING);
+    rect_height = std::max(0, rect_height - VIDEO_VARIABLE_TEXSHEET_PADDING);
+}
+
+
+
+int32 VariableTexSheet::_FindFreeRect(int32 rect_width, int32 rect_height) const
+{
+    if(rect_width > _max_free_width || rect_height > _max_free_height)
+        return -1;
+
+    // Best short side fit: the rectangle leaving the smallest leftover on one of its sides
+    int32 best_index = -1;
+    int32 best_short_side = 0;
+    int32 best_long_side = 0;
+    for(uint32 i = 0; i < _free_rects.size(); ++i) {
+        const VariableTexRect &rect = _free_rects[i];
+        if(rect.width < rect_width || rect.height < rect_height)
+            continue;
+
+        int32 leftover_x = rect.width - rect_width;
+        int32 leftover_y = rect.height - rect_height;
+        int32 short_side = std::min(leftover_x, leftover_y);
+        int32 long_side = std::max(leftover_x, leftover_y);
+        if(best_index < 0 || short_side < best_short_side ||
+                (short_side == best_short_side && long_side < best_long_side)) {
+            best_index = i;
+            best_short_side = short_side;
+            best_long_side = long_side;
+        }
+    }
+
+    return best_index;
+}
+
+
+
+void VariableTexSheet::_SplitFreeRects(const VariableTexRect &used)
+{
+    std::vector<VariableTexRect> new_rects;
+
+    for(uint32 i = 0; i < _free_rects.size();) {
+        const VariableTexRect rect = _free_rects[i];
+        if(!rect.Intersects(used)) {
+            ++i;
+            continue;
+        }
+
+        // Keep the parts of the free rectangle on each side of the used one
+        if(used.x > rect.x)
+            new_rects.push_back(VariableTexRect(rect.x, rect.y, used.x - rect.x, rect.height));
+        if(used.x + used.width < rect.x + rect.width)
+            new_rects.push_back(VariableTexRect(used.x + used.width, rect.y,
+                                                rect.x + rect.width - used.x - used.width, rect.height));
+        if(used.y > rect.y)
+            new_rects.push_back(VariableTexRect(rect.x, rect.y, rect.width, used.y - rect.y));
+        if(used.y + used.height < rect.y + rect.height)
+            new_rects.push_back(VariableTexRect(rect.x, used.y + used.height,
+                                                rect.width, rect.y + rect.height - used.y - used.height));
+
+        _free_rects[i] = _free_rects.back();
+        _free_rects.pop_back();
     }
 
-    // Calculate upper-left corner in blocks
-    int32 block_x = tex->x / 16;
-    int32 block_y = tex->y / 16;
+    _free_rects.insert(_free_rects.end(), new_rects.begin(), new_rects.end());
+    _PruneFreeRects();
+}
+
+
+
+void VariableTexSheet::_AddFreeRect(const VariableTexRect &rect)
+{
+    _free_rects.push_back(rect);
+
+    // Merge the free rectangles sharing a whole side, until none can be merged anymore
+    bool merged = true;
+    while(merged) {
+        merged = false;
+        for(uint32 i = 0; i < _free_rects.size() && !merged; ++i) {
+            for(uint32 j = i + 1; j < _free_rects.size() && !merged; ++j) {
+                VariableTexRect &a = _free_rects[i];
+                const VariableTexRect &b = _free_rects[j];
+
+                if(a.x == b.x && a.width == b.width && a.y <= b.y + b.height && b.y <= a.y + a.height) {
+                    int32 bottom = std::max(a.y + a.height, b.y + b.height);
+                    a.y = std::min(a.y, b.y);
+                    a.height = bottom - a.y;
+                    merged = true;
+                } else if(a.y == b.y && a.height == b.height && a.x <= b.x + b.width && b.x <= a.x + a.width) {
+                    int32 right = std::max(a.x + a.width, b.x + b.width);
+                    a.x = std::min(a.x, b.x);
+                    a.width = right - a.x;
+                    merged = true;
+                }
+
+                if(merged) {
+                    _free_rects[j] = _free_rects.back();
+                    _free_rects.pop_back();
+                }
+            }
+        }
+    }
+
+    _PruneFreeRects();
+}
+
 
-    // Calculate width and height in blocks
-    int32 w = (tex->width  + 15) / 16;
-    int32 h = (tex->height + 15) / 16;
 
-    for(int32 y = block_y; y < block_y + h; y++) {
-        for(int32 x = block_x; x < block_x + w; x++) {
-            int32 index = x + y * _block_width;
-            if(_blocks[index].image == tex) {
-                _blocks[index].free_image = free;
-                _blocks[index].image = new_tex;
+void VariableTexSheet::_PruneFreeRects()
+{
+    for(int32 i = 0; i < static_cast<int32>(_free_rects.size()); ++i) {
+        for(int32 j = i + 1; j < static_cast<int32>(_free_rects.size());) {
+            if(_free_rects[j].Contains(_free_rects[i])) {
+                _free_rects.erase(_free_rects.begin() + i);
+                --i;
+                break;
             }
+
+            if(_free_rects[i].Contains(_free_rects[j]))
+                _free_rects.erase(_free_rects.begin() + j);
+            else
+                ++j;
         }
     }
+
+    _max_free_width = 0;
+    _max_free_height = 0;
+    for(uint32 i = 0; i < _free_rects.size(); ++i) {
+        _max_free_width = std::max(_max_free_width, _free_rects[i].width);
+        _max_free_height = std::max(_max_free_height, _free_rects[i].height);
+    }
+}
+
+
+
+VariableTexRect VariableTexSheet::_GetTextureRect(BaseTexture *img) const
+{
+    return VariableTexRect(img->x, img->y, img->width + VIDEO_VARIABLE_TEXSHEET_PADDING,
+                           img->height + VIDEO_VARIABLE_TEXSHEET_PADDING);
 }
 
 } // namespace private_video
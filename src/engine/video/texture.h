@@ -34,8 +34,7 @@
 *** This sheet allows textures of any size to be inserted, but has slower
 *** performance than the FixedTexSheet.
 ***
-*** - <b>VariableTexNode</b>: represents a texture node entry for the
-*** VariableTexSheet class.
+*** - <b>VariableTexRect</b>: a rectangle of free space in a VariableTexSheet.
 *** ***************************************************************************/
 
 #ifndef __TEXTURE_HEADER__
@@ -57,6 +56,7 @@
 #endif
 
 #include <set>
+#include <vector>
 
 namespace hoa_video
 {
@@ -72,6 +72,14 @@ class ImageMemory;
 //! \brief Used to indicate an invalid texture ID
 const GLuint INVALID_TEXTURE_ID = 0xFFFFFFFF;
 
+/** \brief The maximum size of the variable size texture sheets created when the first ones are full
+*** The actual size is lowered to the maximum texture size supported by the driver when needed.
+**/
+const int32 VIDEO_VARIABLE_TEXSHEET_MAX_SIZE = 2048;
+
+//! \brief The number of pixels left empty on the right and bottom of each texture in a variable size sheet
+const int32 VIDEO_VARIABLE_TEXSHEET_PADDING = 1;
+
 //! \brief Represents the different image sizes that a texture sheet can hold
 enum TexSheetType {
     VIDEO_TEXSHEET_INVALID = -1,
@@ -80,8 +88,10 @@ enum TexSheetType {
     VIDEO_TEXSHEET_32x64 = 1,
     VIDEO_TEXSHEET_64x64 = 2,
     VIDEO_TEXSHEET_ANY = 3,
+    //! \brief Variable size sheet only holding font glyphs, filled by the text supervisor
+    VIDEO_TEXSHEET_GLYPHS = 4,
 
-    VIDEO_TEXSHEET_TOTAL = 4
+    VIDEO_TEXSHEET_TOTAL = 5
 };
 
 
@@ -347,30 +357,44 @@ private:
 
 
 /** ****************************************************************************
-*** \brief Keeps track of which images are used/freed in the variable texture mem manager
+*** \brief A rectangle of free space in a variable size texture sheet, in pixels
 *** ***************************************************************************/
-class VariableTexNode
+class VariableTexRect
 {
 public:
-    VariableTexNode() :
-        image(NULL), free_image(true) {}
+    VariableTexRect(int32 rect_x, int32 rect_y, int32 rect_width, int32 rect_height) :
+        x(rect_x), y(rect_y), width(rect_width), height(rect_height) {}
 
-    //! \brief A pointer to the image
-    BaseTexture *image;
+    //! \brief Returns true if the given rectangle is entirely inside this one
+    bool Contains(const VariableTexRect &rect) const {
+        return rect.x >= x && rect.y >= y &&
+               rect.x + rect.width <= x + width && rect.y + rect.height <= y + height;
+    }
 
-    //! \brief Set to true if the image is freed
-    bool free_image;
-}; // class VariableTexNode
+    //! \brief Returns true if the given rectangle overlaps this one
+    bool Intersects(const VariableTexRect &rect) const {
+        return rect.x < x + width && rect.x + rect.width > x &&
+               rect.y < y + height && rect.y + rect.height > y;
+    }
+
+    int32 x, y, width, height;
+}; // class VariableTexRect
 
 
 /** ****************************************************************************
 *** \brief Used to manage texture sheets of variable image sizes
 ***
-*** This class divides a texture sheet up into 16x16 pixel blocks, and keeps
-*** track of which images have allocated which blocks. This is done to reduce
-*** the time complexity for doing texture insertion and removal operations, but
-*** the downside is that it may leave some space in the texture sheet occupied
-*** but unused for images that are not divisible by 16 in width or height.
+*** This class uses the MaxRects packing algorithm: it keeps the list of the
+*** largest free rectangles of the sheet, which may overlap each other. A new
+*** texture is placed in the free rectangle it fits best, then every free
+*** rectangle it overlaps is split in the (up to four) parts left around it.
+*** Free rectangles contained in others are dropped so that the list stays short.
+***
+*** Each texture is followed by a padding of VIDEO_VARIABLE_TEXSHEET_PADDING pixels,
+*** so that the free space is handled as if the sheet was as much larger.
+***
+*** \note The freed textures keep their space until another texture doesn't
+*** fit anywhere else in the sheet, so that they can still be restored.
 *** ***************************************************************************/
 class VariableTexSheet : public TexSheet
 {
@@ -394,36 +418,67 @@ public:
 
     void RemoveTexture(BaseTexture *img);
 
-    void FreeTexture(BaseTexture *img) {
-        _SetBlockProperties(img, img, true);
-    }
+    void FreeTexture(BaseTexture *img);
 
-    void RestoreTexture(BaseTexture *img) {
-        _SetBlockProperties(img, img, false);
-    }
+    void RestoreTexture(BaseTexture *img);
 
     uint32 GetNumberTextures() {
         return _textures.size();
     }
     //@}
 
+    //! \brief Returns the ratio of the sheet pixels used by textures, in the [0.0, 1.0] range.
+    float GetOccupancy() const;
+
+    //! \brief Returns the number of pixels used by the textures, freed ones included.
+    uint32 GetUsedArea() const {
+        return _used_area;
+    }
+
+    //! \brief Returns the number of free rectangles currently tracked.
+    uint32 GetNumberFreeRects() const {
+        return _free_rects.size();
+    }
+
+    //! \brief Returns the dimensions of the largest free rectangle, padding excluded.
+    void GetLargestFreeRect(int32 &rect_width, int32 &rect_height) const;
+
 private:
-    /** \brief The list of 16x16 pixel blocks in the sheet.
-    *** The size of this structure is: (width / 16) * (height / 16)
+    //! \brief The free rectangles of the sheet, none of them being contained in another
+    std::vector<VariableTexRect> _free_rects;
+
+    /** \brief The largest width and height among the free rectangles, padding included
+    *** They permit to reject the textures which can't fit without going through the free rectangles.
     **/
-    VariableTexNode *_blocks;
+    int32 _max_free_width, _max_free_height;
+
+    //! \brief The number of pixels used by the textures
+    uint32 _used_area;
 
     /** \brief A set containing each texture that has been inserted into this class
     *** This container is used to be able to quickly determine if a texture is loaded by an object of this class
     **/
     std::set<BaseTexture *> _textures;
 
-    /** \brief Updates the properties of all of the blocks associated with a given texture
-    *** \param tex The texture to update
-    *** \param new_tex The texture pointer to set the block to
-    *** \param new_image The boolean value to set the free status flag to
+    //! \brief The textures which were freed, but still occupy their space until it is needed
+    std::set<BaseTexture *> _freed_textures;
+
+    /** \brief Finds the free rectangle where a texture of the given size fits best
+    *** \return The index of the rectangle in _free_rects, or -1 if the texture doesn't fit
     **/
-    void _SetBlockProperties(BaseTexture *tex, BaseTexture *new_tex, bool free);
+    int32 _FindFreeRect(int32 rect_width, int32 rect_height) const;
+
+    //! \brief Splits the free rectangles overlapping the given used rectangle
+    void _SplitFreeRects(const VariableTexRect &used);
+
+    //! \brief Adds the space of a removed texture to the free rectangles, merging it with its neighbours when possible
+    void _AddFreeRect(const VariableTexRect &rect);
+
+    //! \brief Removes the free rectangles contained in another one and updates the largest free dimensions
+    void _PruneFreeRects();
+
+    //! \brief Returns the rectangle occupied by a texture, padding included
+    VariableTexRect _GetTextureRect(BaseTexture *img) const;
 }; // class VariableTexSheet : public TexSheet
 
 }  // namespace private_video
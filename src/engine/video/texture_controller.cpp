@@ -17,6 +17,8 @@
 
 #include "texture_controller.h"
 
+#include <algorithm>
+
 using namespace hoa_utils;
 using namespace hoa_video::private_video;
 
@@ -32,6 +34,7 @@ TextureController *TextureManager = NULL;
 TextureController::TextureController() :
     debug_current_sheet(-1),
     _last_tex_id(INVALID_TEXTURE_ID),
+    _variable_sheet_size(512),
     _debug_num_tex_switches(0)
 {}
 
@@ -39,6 +42,9 @@ TextureController::TextureController() :
 
 TextureController::~TextureController()
 {
+    // The prefetched images must be released while the texture sheets exist
+    _image_loader.Shutdown();
+
     IF_PRINT_DEBUG(VIDEO_DEBUG) << "Deleting all remaining ImageTextures, a total of: " << _images.size() << std::endl;
 
     // Invoking the ImageTexture destructor will erase the entry in the _images map that corresponds to that object
@@ -59,6 +65,13 @@ TextureController::~TextureController()
 
 bool TextureController::SingletonInitialize()
 {
+    // The variable size sheets created later on are as large as the driver permits, up to a limit
+    GLint max_texture_size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
+    _variable_sheet_size = 512;
+    while(_variable_sheet_size * 2 <= std::min<int32>(max_texture_size, VIDEO_VARIABLE_TEXSHEET_MAX_SIZE))
+        _variable_sheet_size *= 2;
+
     // Create a default set of texture sheets
     if(_CreateTexSheet(512, 512, VIDEO_TEXSHEET_32x32, false) == NULL) {
         PRINT_ERROR << "could not create default 32x32 texture sheet" << std::endl;
@@ -124,8 +137,10 @@ bool TextureController::UnloadTextures()
             std::vector<hoa_video::FontGlyph *>::iterator it_end = glyph_cache->end();
             for(std::vector<FontGlyph *>::iterator k = glyph_cache->begin();
                     k != it_end; ++k) {
-                if(*k)
-                    _DeleteTexture((*k)->texture);
+                if(*k && (*k)->texture) {
+                    (*k)->texture->texture_sheet->RemoveTexture((*k)->texture);
+                    delete (*k)->texture;
+                }
                 delete *k;
             }
 
@@ -166,6 +181,42 @@ bool TextureController::ReloadTextures()
 
 
 
+void TextureController::GetImageReferences(std::map<const ImageTexture *, int32> &references) const
+{
+    references.clear();
+    for(std::map<std::string, ImageTexture *>::const_iterator i = _images.begin(); i != _images.end(); ++i) {
+        if(i->second != NULL && i->second->ref_count > 0)
+            references[i->second] = i->second->ref_count;
+    }
+
+    const std::vector<std::vector<StillImage> *> &prefetched_images = _image_loader.GetPrefetchedImages();
+    for(uint32 i = 0; i < prefetched_images.size(); ++i) {
+        const std::vector<StillImage> &images = *prefetched_images[i];
+        for(uint32 j = 0; j < images.size(); ++j) {
+            std::map<const ImageTexture *, int32>::iterator it = references.find(images[j]._image_texture);
+            if(it != references.end() && --it->second <= 0)
+                references.erase(it);
+        }
+    }
+}
+
+
+
+uint32 TextureController::GetTextureMemory(const std::map<const ImageTexture *, int32> &previous_references) const
+{
+    std::map<const ImageTexture *, int32> references;
+    GetImageReferences(references);
+
+    uint32 memory = 0;
+    for(std::map<const ImageTexture *, int32>::const_iterator i = references.begin(); i != references.end(); ++i) {
+        if(previous_references.find(i->first) == previous_references.end())
+            memory += i->first->width * i->first->height * 4;
+    }
+    return memory;
+}
+
+
+
 void TextureController::DEBUG_NextTexSheet()
 {
     debug_current_sheet++;
@@ -217,13 +268,13 @@ void TextureController::DEBUG_ShowTexSheet()
     VideoManager->SetDrawFlags(VIDEO_NO_BLEND, VIDEO_X_LEFT, VIDEO_Y_BOTTOM, 0);
     VideoManager->SetCoordSys(0.0f, VIDEO_STANDARD_RES_WIDTH, 0.0f, VIDEO_STANDARD_RES_HEIGHT);
 
-    glPushMatrix();
+    VideoManager->PushMatrix();
     VideoManager->Move(0.0f, 0.0f);
-    glScalef(sheet->width / 2.0f, sheet->height / 2.0f, 1.0f);
+    VideoManager->Scale(sheet->width / 2.0f, sheet->height / 2.0f);
 
     sheet->DEBUG_Draw();
 
-    glPopMatrix();
+    VideoManager->PopMatrix();
 
     char buf[200];
 
@@ -246,6 +297,8 @@ void TextureController::DEBUG_ShowTexSheet()
         sprintf(buf, "  Type:    64x64");
     else if(sheet->type == VIDEO_TEXSHEET_ANY)
         sprintf(buf, "  Type:    Any size");
+    else if(sheet->type == VIDEO_TEXSHEET_GLYPHS)
+        sprintf(buf, "  Type:    Font glyphs");
     else
         sprintf(buf, "  Type:    Unknown");
 
@@ -260,6 +313,39 @@ void TextureController::DEBUG_ShowTexSheet()
     VideoManager->MoveRelative(0, -20);
     TextManager->Draw(buf);
 
+    // Variable size sheets also report how much of their space is used
+    if(sheet->type == VIDEO_TEXSHEET_ANY || sheet->type == VIDEO_TEXSHEET_GLYPHS)
+        sprintf(buf, "  Used:    %d textures, %d%%", sheet->GetNumberTextures(),
+                static_cast<int32>(static_cast<VariableTexSheet *>(sheet)->GetOccupancy() * 100.0f));
+    else
+        sprintf(buf, "  Used:    %d textures", sheet->GetNumberTextures());
+    VideoManager->MoveRelative(0, -20);
+    TextManager->Draw(buf);
+
+    if(sheet->type == VIDEO_TEXSHEET_ANY || sheet->type == VIDEO_TEXSHEET_GLYPHS) {
+        VariableTexSheet *variable_sheet = static_cast<VariableTexSheet *>(sheet);
+        int32 free_width = 0;
+        int32 free_height = 0;
+        variable_sheet->GetLargestFreeRect(free_width, free_height);
+        sprintf(buf, "  Free:    %d rectangles, largest %dx%d", variable_sheet->GetNumberFreeRects(),
+                free_width, free_height);
+        VideoManager->MoveRelative(0, -20);
+        TextManager->Draw(buf);
+
+        // The packing efficiency of all the variable size sheets together
+        float used_area = 0.0f;
+        float total_area = 0.0f;
+        for(uint32 i = 0; i < _tex_sheets.size(); ++i) {
+            if(_tex_sheets[i]->type != VIDEO_TEXSHEET_ANY && _tex_sheets[i]->type != VIDEO_TEXSHEET_GLYPHS)
+                continue;
+            used_area += static_cast<VariableTexSheet *>(_tex_sheets[i])->GetUsedArea();
+            total_area += static_cast<float>(_tex_sheets[i]->width) * static_cast<float>(_tex_sheets[i]->height);
+        }
+        sprintf(buf, "  Packing: %d%% of all the variable size sheets", static_cast<int32>(used_area * 100.0f / total_area));
+        VideoManager->MoveRelative(0, -20);
+        TextManager->Draw(buf);
+    }
+
     VideoManager->PopState();
 } // void TextureController::DEBUG_ShowTexSheet()
 
@@ -317,6 +403,9 @@ void TextureController::_BindTexture(GLuint tex_id)
 
 void TextureController::_DeleteTexture(GLuint tex_id)
 {
+    // Pending images may still use that texture
+    VideoManager->FlushSprites();
+
     glDeleteTextures(1, &tex_id);
 
     if(_last_tex_id == tex_id)
@@ -415,8 +504,8 @@ void TextureController::_RemoveSheet(TexSheet *sheet)
 
 TexSheet *TextureController::_InsertImageInTexSheet(BaseTexture *image, ImageMemory &load_info, bool is_static)
 {
-    // Image sizes larger than 512 in either dimension require their own texture sheet
-    if(load_info.width > 512 || load_info.height > 512) {
+    // Image sizes larger than the variable size sheets in either dimension require their own texture sheet
+    if(load_info.width > static_cast<uint32>(_variable_sheet_size) || load_info.height > static_cast<uint32>(_variable_sheet_size)) {
         int32 round_width = RoundUpPow2(load_info.width);
         int32 round_height = RoundUpPow2(load_info.height);
         TexSheet *sheet = _CreateTexSheet(round_width, round_height, VIDEO_TEXSHEET_ANY, false);
@@ -448,7 +537,8 @@ TexSheet *TextureController::_InsertImageInTexSheet(BaseTexture *image, ImageMem
         type = VIDEO_TEXSHEET_ANY;
 
     // Look through all existing texture sheets and see if the image will fit in any of the ones which
-    // match the type and static status that we are looking for
+    // match the type and static status that we are looking for. The full variable size sheets reject
+    // the image at once, from the size of their largest free rectangle.
     for(uint32 i = 0; i < _tex_sheets.size(); i++) {
         TexSheet *sheet = _tex_sheets[i];
         if(sheet == NULL) {
@@ -464,7 +554,8 @@ TexSheet *TextureController::_InsertImageInTexSheet(BaseTexture *image, ImageMem
     }
 
     // We couldn't add it to any existing sheets, so we must create a new one for it
-    TexSheet *sheet = _CreateTexSheet(512, 512, type, is_static);
+    int32 sheet_size = (type == VIDEO_TEXSHEET_ANY) ? _variable_sheet_size : 512;
+    TexSheet *sheet = _CreateTexSheet(sheet_size, sheet_size, type, is_static);
     if(sheet == NULL) {
         IF_PRINT_WARNING(VIDEO_DEBUG) << "failed to create a new texture sheet for image" << std::endl;
         return NULL;
@@ -481,6 +572,35 @@ TexSheet *TextureController::_InsertImageInTexSheet(BaseTexture *image, ImageMem
 
 
 
+TexSheet *TextureController::_InsertGlyphInTexSheet(BaseTexture *glyph, ImageMemory &load_info)
+{
+    for(uint32 i = 0; i < _tex_sheets.size(); ++i) {
+        TexSheet *sheet = _tex_sheets[i];
+        if(sheet == NULL || sheet->type != VIDEO_TEXSHEET_GLYPHS)
+            continue;
+
+        if(sheet->AddTexture(glyph, load_info))
+            return sheet;
+    }
+
+    // All the glyphs texture sheets are full
+    TexSheet *sheet = _CreateTexSheet(512, 512, VIDEO_TEXSHEET_GLYPHS, true);
+    if(sheet == NULL) {
+        IF_PRINT_WARNING(VIDEO_DEBUG) << "failed to create a new texture sheet for font glyphs" << std::endl;
+        return NULL;
+    }
+
+    IF_PRINT_DEBUG(VIDEO_DEBUG) << "created a new font glyphs texture sheet, the previous ones being full" << std::endl;
+
+    if(sheet->AddTexture(glyph, load_info))
+        return sheet;
+
+    IF_PRINT_WARNING(VIDEO_DEBUG) << "font glyph could not be added to a new texture sheet" << std::endl;
+    return NULL;
+}
+
+
+
 bool TextureController::_ReloadImagesToSheet(TexSheet *sheet)
 {
     // Delete images
@@ -24,6 +24,7 @@
 
 #include "texture.h"
 #include "image_base.h"
+#include "image_loader.h"
 
 // OpenGL includes
 #ifdef __APPLE__
@@ -58,6 +59,9 @@ class TextureController : public hoa_utils::Singleton<TextureController>
     friend class private_video::VariableTexSheet;
 
     friend class hoa_mode_manager::ParticleSystem;
+    friend class hoa_map::private_map::TileSupervisor;
+    friend class private_video::SpriteBatcher;
+    friend class private_video::ImageLoader;
 
 public:
     TextureController();
@@ -81,6 +85,36 @@ public:
     **/
     bool ReloadTextures();
 
+    /** \brief Requests an image file to be decoded in the background and loaded in advance
+    *** \param filename The name of the image file
+    *** \param grid_rows, grid_cols The image grid dimensions, for images later loaded
+    *** with ImageDescriptor::LoadMultiImageFromElementGrid(), or 0 for a single image.
+    **/
+    void PrefetchImage(const std::string &filename, uint32 grid_rows = 0, uint32 grid_cols = 0) {
+        _image_loader.Prefetch(filename, grid_rows, grid_cols);
+    }
+
+    /** \brief Frees the prefetched images which were not loaded since they were requested
+    *** This should be called once the images a prefetch was made for have been loaded.
+    **/
+    void ReleasePrefetchedImages() {
+        _image_loader.ReleasePrefetchedImages();
+    }
+
+    /** \brief Gives the number of references to each loaded image
+    *** \param references Receives the reference count of each image with references
+    *** The references held by the prefetched images are not counted, as they are
+    *** dropped once their final user has loaded them.
+    **/
+    void GetImageReferences(std::map<const private_video::ImageTexture *, int32> &references) const;
+
+    /** \brief Returns the memory used by the images loaded or referenced only since an earlier call to GetImageReferences(), in bytes
+    *** \param previous_references The references given by the earlier call
+    *** This tells the memory which belongs to what was loaded in between, e.g. a map, and
+    *** would be freed along with it. The images already used before are not counted.
+    **/
+    uint32 GetTextureMemory(const std::map<const private_video::ImageTexture *, int32> &previous_references) const;
+
     //! \brief Cycles forward to show the next texture sheet
     void DEBUG_NextTexSheet();
 
@@ -102,6 +136,9 @@ private:
     //! \brief The ID of the last texture that was bound. Used to eliminate redundant binding of textures
     GLuint _last_tex_id;
 
+    //! \brief The size of the variable size texture sheets created when the default ones are full
+    int32 _variable_sheet_size;
+
     //! \brief A vector containing all of the texture sheets currently being managed by this class
     std::vector<private_video::TexSheet *> _tex_sheets;
 
@@ -114,6 +151,9 @@ private:
     //! \brief Keeps track of the number of texture switches per frame
     uint32 _debug_num_tex_switches;
 
+    //! \brief Decodes the prefetched image files in the background
+    private_video::ImageLoader _image_loader;
+
     // ---------- Private methods
 
     //! \name Texture Operations
@@ -181,6 +221,17 @@ private:
     **/
     private_video::TexSheet *_InsertImageInTexSheet(private_video::BaseTexture *image, private_video::ImageMemory &load_info, bool is_static);
 
+    /** \brief Inserts a font glyph into a font glyphs texture sheet
+    *** \param glyph A pointer to the glyph texture to insert
+    *** \param load_info The pixels of the glyph
+    *** \return The texture sheet now holding the glyph, or NULL if an error occured
+    ***
+    *** Glyphs are kept apart from the other images so that a whole text can be drawn
+    *** from a few texture sheets. A new glyphs texture sheet is created when the
+    *** existing ones are full.
+    **/
+    private_video::TexSheet *_InsertGlyphInTexSheet(private_video::BaseTexture *glyph, private_video::ImageMemory &load_info);
+
     /** \brief Iterate through all currently loaded images and if they belong to the specified TexSheet, reload them into it
     *** \param sheet A pointer to the TexSheet whose images we wish to reload
     *** \return True only if every single image owned by the TexSheet was successfully reloaded back into it
@@ -89,8 +89,10 @@ VideoEngine::VideoEngine():
     _screen_width(0),
     _screen_height(0),
     _fullscreen(false),
+    _vsync(true),
     _x_cursor(0),
     _y_cursor(0),
+    _debug_last_num_tex_switches(0),
     _debug_info(false),
     _x_shake(0),
     _y_shake(0),
@@ -128,13 +130,15 @@ void VideoEngine::DrawFPS()
     if(!_fps_display)
         return;
 
-    uint32 frame_time = hoa_system::SystemManager->GetUpdateTime();
+    // The real frame time, as the game update time is a fixed step
+    uint32 frame_time_us = hoa_system::SystemManager->GetFrameTime();
+    uint32 frame_time = frame_time_us / 1000;
     SetDrawFlags(VIDEO_X_LEFT, VIDEO_Y_BOTTOM, VIDEO_X_NOFLIP, VIDEO_Y_NOFLIP, VIDEO_BLEND, 0);
 
     // Calculate the FPS for the current frame
     uint32 current_fps = 1000;
-    if(frame_time) {
-        current_fps /= frame_time;
+    if(frame_time_us) {
+        current_fps = 1000000 / frame_time_us;
     }
 
     // The number of times to insert the current FPS sample into the fps_samples array
@@ -179,9 +183,50 @@ void VideoEngine::DrawFPS()
     Move(930.0f, 720.0f); // Upper right hand corner of the screen
     Text()->Draw(fps_text, TextStyle("text20", Color::white));
 
+    // Display the drawing statistics of the last frame
+    char batch_text[64];
+    sprintf(batch_text, "Batches: %d - Quads: %d - Tex: %d", _sprite_batcher.GetLastFrameNumBatches(),
+            _sprite_batcher.GetLastFrameNumQuads(), _debug_last_num_tex_switches);
+    Move(680.0f, 695.0f);
+    Text()->Draw(batch_text, TextStyle("text20", Color::white));
+
 } // void GUISystem::_DrawFPS(uint32 frame_time)
 
 
+
+void VideoEngine::DrawProfile()
+{
+    if(!hoa_system::SystemManager || !hoa_system::SystemManager->IsProfiling())
+        return;
+
+    SetDrawFlags(VIDEO_X_LEFT, VIDEO_Y_BOTTOM, VIDEO_X_NOFLIP, VIDEO_Y_NOFLIP, VIDEO_BLEND, 0);
+
+    // One line per section, below the FPS and drawing statistics
+    char profile_text[64];
+    sprintf(profile_text, "Missed frames: %d - Dropped updates: %d", hoa_system::SystemManager->GetMissedFrames(),
+            hoa_system::SystemManager->GetDroppedUpdates());
+    Move(680.0f, 670.0f);
+    Text()->Draw(profile_text, TextStyle("text20", Color::white));
+
+    for(uint32 i = 0; i < hoa_system::PROFILE_TOTAL; ++i) {
+        hoa_system::PROFILE_SECTION section = static_cast<hoa_system::PROFILE_SECTION>(i);
+        sprintf(profile_text, "%s: %.2f ms", hoa_system::SystemEngine::GetProfileSectionName(section),
+                hoa_system::SystemManager->GetProfileAverage(section) / 1000.0f);
+        Move(780.0f, 645.0f - i * 20.0f);
+        Text()->Draw(profile_text, TextStyle("text20", Color::white));
+    }
+
+    // The counters of the last frame, below the sections
+    for(uint32 i = 0; i < hoa_system::PROFILE_COUNTER_TOTAL; ++i) {
+        hoa_system::PROFILE_COUNTER counter = static_cast<hoa_system::PROFILE_COUNTER>(i);
+        sprintf(profile_text, "%s: %d", hoa_system::SystemEngine::GetProfileCounterName(counter),
+                hoa_system::SystemManager->GetProfileCount(counter));
+        Move(780.0f, 645.0f - (hoa_system::PROFILE_TOTAL + i) * 20.0f);
+        Text()->Draw(profile_text, TextStyle("text20", Color::white));
+    }
+} // void VideoEngine::DrawProfile()
+
+
 VideoEngine::~VideoEngine()
 {
     TextManager->SingletonDestroy();
@@ -189,6 +234,10 @@ VideoEngine::~VideoEngine()
     _default_menu_cursor.Clear();
     _rectangle_image.Clear();
 
+    for(uint32 i = 0; i < _screen_captures.size(); ++i)
+        _ReleaseScreenCapture(_screen_captures[i]);
+    _screen_captures.clear();
+
     TextureManager->SingletonDestroy();
 }
 
@@ -358,11 +407,15 @@ void VideoEngine::Clear()
 
 void VideoEngine::Clear(const Color &c)
 {
+    FlushSprites();
+
     _current_context.viewport = ScreenRect(0, 0, _screen_width, _screen_height);
     glViewport(0, 0, _screen_width, _screen_height);
     glClearColor(c[0], c[1], c[2], c[3]);
     glClear(GL_COLOR_BUFFER_BIT);
 
+    _sprite_batcher.ResetFrameStats();
+    _debug_last_num_tex_switches = TextureManager->_debug_num_tex_switches;
     TextureManager->_debug_num_tex_switches = 0;
 }
 
@@ -375,6 +428,9 @@ void VideoEngine::Update()
     _UpdateShake(frame_time);
 
     _screen_fader.Update(frame_time);
+
+    // Upload some of the images decoded in the background
+    TextureManager->_image_loader.Update();
 }
 
 
@@ -390,7 +446,10 @@ void VideoEngine::Draw()
 
     // Draw FPS Counter If We Need To
     DrawFPS();
+    DrawProfile();
     PopState();
+
+    FlushSprites();
 } // void VideoEngine::Draw()
 
 
@@ -420,6 +479,9 @@ void VideoEngine::GetPixelSize(float &x, float &y)
 bool VideoEngine::ApplySettings()
 {
     if(_target == VIDEO_TARGET_SDL_WINDOW) {
+        // The pending images can't be drawn once their textures are unloaded
+        FlushSprites();
+
         // Losing GL context, so unload images first
         if(TextureManager && TextureManager->UnloadTextures() == false) {
             IF_PRINT_WARNING(VIDEO_DEBUG) << "failed to delete OpenGL textures during a context change" << std::endl;
@@ -449,7 +511,7 @@ bool VideoEngine::ApplySettings()
         SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
         SDL_GL_SetAttribute(SDL_GL_MULTISAMPLEBUFFERS, 2);
         SDL_GL_SetAttribute(SDL_GL_MULTISAMPLESAMPLES, 4);
-        SDL_GL_SetAttribute(SDL_GL_SWAP_CONTROL, 1);
+        SDL_GL_SetAttribute(SDL_GL_SWAP_CONTROL, _vsync ? 1 : 0);
 
         if(SDL_SetVideoMode(_temp_width, _temp_height, 0, flags) == false) {
             // RGB values of 1 for each and 8 for depth seemed to be sufficient.
@@ -462,7 +524,7 @@ bool VideoEngine::ApplySettings()
             SDL_GL_SetAttribute(SDL_GL_ALPHA_SIZE, 0);
             SDL_GL_SetAttribute(SDL_GL_MULTISAMPLEBUFFERS, 0);
             SDL_GL_SetAttribute(SDL_GL_MULTISAMPLESAMPLES, 0);
-            SDL_GL_SetAttribute(SDL_GL_SWAP_CONTROL, 1);
+            SDL_GL_SetAttribute(SDL_GL_SWAP_CONTROL, _vsync ? 1 : 0);
 
             if(SDL_SetVideoMode(_temp_width, _temp_height, 0, flags) == false) {
                 IF_PRINT_WARNING(VIDEO_DEBUG) << "SDL_SetVideoMode() failed with error: " << SDL_GetError() << std::endl;
@@ -509,6 +571,9 @@ bool VideoEngine::ApplySettings()
 
 void VideoEngine::SetCoordSys(const CoordSys &coordinate_system)
 {
+    // The pending images were transformed using the previous projection
+    FlushSprites();
+
     _current_context.coordinate_system = coordinate_system;
 
     glMatrixMode(GL_PROJECTION);
@@ -522,10 +587,13 @@ void VideoEngine::SetCoordSys(const CoordSys &coordinate_system)
     // Reference: http://www.opengl.org/resources/faq/technical/transformations.htm#tran0030
     // Changed to 32/1024 or 24/768 since it's the size of one pixel for the map mode.
     glTranslatef(0.03125, 0.03125, 0);
+    _transform.LoadIdentity();
+    _transform.Translate(0.03125, 0.03125);
 }
 
 void VideoEngine::EnableScissoring()
 {
+    FlushSprites();
     _current_context.scissoring_enabled = true;
     if(!_gl_scissor_test_is_active) {
         glEnable(GL_SCISSOR_TEST);
@@ -535,6 +603,7 @@ void VideoEngine::EnableScissoring()
 
 void VideoEngine::DisableScissoring()
 {
+    FlushSprites();
     _current_context.scissoring_enabled = false;
     if(_gl_scissor_test_is_active) {
         glDisable(GL_SCISSOR_TEST);
@@ -545,6 +614,7 @@ void VideoEngine::DisableScissoring()
 void VideoEngine::EnableAlphaTest()
 {
     if(!_gl_alpha_test_is_active) {
+        FlushSprites();
         glEnable(GL_ALPHA_TEST);
         _gl_alpha_test_is_active = true;
     }
@@ -553,6 +623,7 @@ void VideoEngine::EnableAlphaTest()
 void VideoEngine::DisableAlphaTest()
 {
     if(_gl_alpha_test_is_active) {
+        FlushSprites();
         glDisable(GL_ALPHA_TEST);
         _gl_alpha_test_is_active = false;
     }
@@ -577,6 +648,7 @@ void VideoEngine::DisableBlending()
 void VideoEngine::EnableStencilTest()
 {
     if(!_gl_stencil_test_is_active) {
+        FlushSprites();
         glEnable(GL_STENCIL_TEST);
         _gl_stencil_test_is_active = true;
     }
@@ -585,6 +657,7 @@ void VideoEngine::EnableStencilTest()
 void VideoEngine::DisableStencilTest()
 {
     if(_gl_stencil_test_is_active) {
+        FlushSprites();
         glDisable(GL_STENCIL_TEST);
         _gl_stencil_test_is_active = false;
     }
@@ -656,6 +729,7 @@ void VideoEngine::DisableTextureCoordArray()
 
 void VideoEngine::SetScissorRect(float left, float right, float bottom, float top)
 {
+    FlushSprites();
     _current_context.scissor_rectangle = CalculateScreenRect(left, right, bottom, top);
 
     glScissor(static_cast<GLint>((_current_context.scissor_rectangle.left / static_cast<float>(VIDEO_STANDARD_RES_WIDTH)) * _current_context.viewport.width),
@@ -669,6 +743,7 @@ void VideoEngine::SetScissorRect(float left, float right, float bottom, float to
 
 void VideoEngine::SetScissorRect(const ScreenRect &rect)
 {
+    FlushSprites();
     _current_context.scissor_rectangle = rect;
 
     glScissor(static_cast<GLint>((_current_context.scissor_rectangle.left / static_cast<float>(VIDEO_STANDARD_RES_WIDTH)) * _current_context.viewport.width),
@@ -718,6 +793,8 @@ void VideoEngine::Move(float x, float y)
 {
     glLoadIdentity();
     glTranslatef(x, y, 0);
+    _transform.LoadIdentity();
+    _transform.Translate(x, y);
     _x_cursor = x;
     _y_cursor = y;
 }
@@ -727,6 +804,7 @@ void VideoEngine::Move(float x, float y)
 void VideoEngine::MoveRelative(float x, float y)
 {
     glTranslatef(x, y, 0);
+    _transform.Translate(x, y);
     _x_cursor += x;
     _y_cursor += y;
 }
@@ -739,6 +817,7 @@ void VideoEngine::PushState()
     // Push current modelview transformation
     glMatrixMode(GL_MODELVIEW);
     glPushMatrix();
+    _transform_stack.push_back(_transform);
 
     _context_stack.push(_current_context);
 }
@@ -753,12 +832,19 @@ void VideoEngine::PopState()
         return;
     }
 
+    // The restored context may change the viewport and scissoring
+    FlushSprites();
+
     _current_context = _context_stack.top();
     _context_stack.pop();
 
     // Restore the modelview transformation
     glMatrixMode(GL_MODELVIEW);
     glPopMatrix();
+    if(!_transform_stack.empty()) {
+        _transform = _transform_stack.back();
+        _transform_stack.pop_back();
+    }
     glViewport(_current_context.viewport.left, _current_context.viewport.top, _current_context.viewport.width, _current_context.viewport.height);
 
     if(_current_context.scissoring_enabled) {
@@ -780,6 +866,7 @@ void VideoEngine::SetTransform(float matrix[16])
     glMatrixMode(GL_MODELVIEW);
     glLoadIdentity();
     glLoadMatrixf(matrix);
+    _transform.LoadMatrix(matrix);
 }
 
 void VideoEngine::DrawFadeEffect()
@@ -815,6 +902,9 @@ StillImage VideoEngine::CaptureScreen() throw(Exception)
 
     StillImage screen_image;
 
+    // Make sure every image is drawn on the screen before capturing it
+    FlushSprites();
+
     // Retrieve width/height of the viewport. viewport_dimensions[2] is the width, [3] is the height
     GLint viewport_dimensions[4];
     glGetIntegerv(GL_VIEWPORT, viewport_dimensions);
@@ -823,6 +913,32 @@ StillImage VideoEngine::CaptureScreen() throw(Exception)
     // Set up the screen rectangle to copy
     ScreenRect screen_rect(0, viewport_dimensions[3], viewport_dimensions[2], viewport_dimensions[3]);
 
+    // Look for a pooled capture texture of the screen size only referenced by the pool
+    std::vector<ImageTexture *>::iterator it = _screen_captures.begin();
+    while(it != _screen_captures.end()) {
+        ImageTexture *capture = *it;
+        if(capture->ref_count > 1) {
+            ++it;
+            continue;
+        }
+
+        if(capture->width == static_cast<uint32>(viewport_dimensions[2])
+                && capture->height == static_cast<uint32>(viewport_dimensions[3])) {
+            // The texture keeps the flipped v coordinates of its first capture
+            if(capture->texture_sheet->CopyScreenRect(capture->x, capture->y, screen_rect) == false)
+                throw Exception("call to TexSheet::CopyScreenRect() failed", __FILE__, __LINE__, __FUNCTION__);
+
+            capture->AddReference();
+            screen_image._image_texture = capture;
+            screen_image._texture = capture;
+            return screen_image;
+        }
+
+        // Captured before a resolution change, it won't be reused
+        it = _screen_captures.erase(it);
+        _ReleaseScreenCapture(capture);
+    }
+
     // Create a new ImageTexture with a unique filename for this newly captured screen
     ImageTexture *new_image = new ImageTexture("capture_screen" + NumberToString(capture_id), "<T>", viewport_dimensions[2], viewport_dimensions[3]);
     new_image->AddReference();
@@ -862,10 +978,28 @@ StillImage VideoEngine::CaptureScreen() throw(Exception)
     new_image->v1 = new_image->v2;
     new_image->v2 = temp;
 
+    // Keeps the new texture to reuse it once the capture is not used anymore
+    if(_screen_captures.size() < SCREEN_CAPTURE_POOL_SIZE) {
+        new_image->AddReference();
+        _screen_captures.push_back(new_image);
+    }
+
     ++capture_id;
     return screen_image;
 }
 
+void VideoEngine::_ReleaseScreenCapture(ImageTexture *capture)
+{
+    // Still used by an image, which will delete it as any other texture
+    if(capture->RemoveReference() == false)
+        return;
+
+    TexSheet *sheet = capture->texture_sheet;
+    sheet->RemoveTexture(capture);
+    TextureManager->_RemoveSheet(sheet);
+    delete capture;
+}
+
 void VideoEngine::DrawText(const ustring &text, float x, float y, const Color &c)
 {
     Move(x, y);
@@ -896,6 +1030,9 @@ void VideoEngine::MakeScreenshot(const std::string &filename)
 {
     private_video::ImageMemory buffer;
 
+    // Make sure every image is drawn on the screen before reading it
+    FlushSprites();
+
     // Retrieve the width and height of the viewport.
     GLint viewport_dimensions[4]; // viewport_dimensions[2] is the width, [3] is the height
     glGetIntegerv(GL_VIEWPORT, viewport_dimensions);
@@ -1062,6 +1199,7 @@ void VideoEngine::DrawLine(float x1, float y1, float x2, float y2, float width,
         x1, y1,
         x2, y2
     };
+    FlushSprites();
     EnableBlending();
     DisableTexture2D();
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // Normal blending
@@ -1104,8 +1242,10 @@ void VideoEngine::DrawGrid(float x, float y, float x_step, float y_step, const C
         vertices.push_back(y);
         num_vertices += 2;
     }
+    FlushSprites();
     glColor4fv(&c[0]);
     DisableTexture2D();
+    DisableColorArray();
     EnableVertexArray();
     glVertexPointer(2, GL_FLOAT, 0, &(vertices[0]));
     glDrawArrays(GL_LINES, 0, num_vertices);
@@ -34,6 +34,7 @@
 #include "image.h"
 #include "interpolator.h"
 #include "shake.h"
+#include "sprite_batcher.h"
 #include "screen_rect.h"
 #include "texture_controller.h"
 #include "text.h"
@@ -84,6 +85,9 @@ const uint32 MAX_FTIME_DIFF = 5;
 
 //! \brief The number of samples to take if we need to play catchup with the current FPS
 const uint32 FPS_CATCHUP = 20;
+
+//! \brief The number of screen capture textures kept to be reused by VideoEngine::CaptureScreen()
+const uint32 SCREEN_CAPTURE_POOL_SIZE = 3;
 }
 
 //! \brief Draw flags to control x and y alignment, flipping, and texture blending.
@@ -242,6 +246,25 @@ public:
     **/
     void Draw();
 
+    /** \brief Draws the image quads still waiting in the sprite batch
+    *** Image draw calls are deferred so that consecutive images sharing the same
+    *** texture sheet can be drawn at once. This must be called before drawing anything
+    *** directly through OpenGL, and before swapping the screen buffers.
+    **/
+    void FlushSprites() {
+        _sprite_batcher.Flush();
+    }
+
+    //! \brief Returns the number of sprite batches drawn during the last frame.
+    uint32 GetNumSpriteBatches() const {
+        return _sprite_batcher.GetLastFrameNumBatches();
+    }
+
+    //! \brief Returns the number of image quads drawn during the last frame.
+    uint32 GetNumSpriteQuads() const {
+        return _sprite_batcher.GetLastFrameNumQuads();
+    }
+
     /** \brief Retrieves the OpenGL error code and retains it in the _gl_error_code member
     *** \return True if an OpenGL error has been detected, false if no errors were detected
     *** \note This function only produces a meaningful result if the VIDEO_DEBUG variable is set to true. This is done
@@ -310,6 +333,17 @@ public:
         SetFullscreen(!_temp_fullscreen);
     }
 
+    /** \brief Sets whether the buffer swaps should wait for the display refresh
+     *  \note  you must call ApplySettings() to actually apply the change
+     */
+    void SetVSync(bool vsync) {
+        _vsync = vsync;
+    }
+
+    bool IsVSyncEnabled() const {
+        return _vsync;
+    }
+
     //! \brief Will make the pixel art related images smoothed (only used for map tiles at the moment)
     void SetPixelArtSmoothed(bool smooth) {
         _smooth_pixel_art = smooth;
@@ -454,11 +488,16 @@ public:
     **/
     void PushMatrix() {
         glPushMatrix();
+        _transform_stack.push_back(_transform);
     }
 
     //! \brief Pops the modelview transformation from the stack
     void PopMatrix() {
         glPopMatrix();
+        if(!_transform_stack.empty()) {
+            _transform = _transform_stack.back();
+            _transform_stack.pop_back();
+        }
     }
 
     /** \brief Saves relevant state of the video engine on to an internal stack
@@ -484,6 +523,7 @@ public:
     **/
     void Rotate(float angle) {
         glRotatef(angle, 0, 0, 1);
+        _transform.Rotate(angle);
     }
 
     /** \brief Scales all subsequent image drawing calls in the horizontal and vertical direction
@@ -494,6 +534,7 @@ public:
     **/
     void Scale(float x, float y) {
         glScalef(x, y, 1.0f);
+        _transform.Scale(x, y);
     }
 
     /** \brief Sets the OpenGL transform to the contents of 4x4 matrix
@@ -511,7 +552,10 @@ public:
     *** being displayed on the current screen. This means that you can have multiple screen
     *** captures in memory at the same time. You should be careful not to have too many
     *** screen captures existing at one time, because each image capture requires a relatively
-    *** large amount of texutre memory (roughly 3GB for a 1024x768 screen).
+    *** large amount of texutre memory (roughly 3MB for a 1024x768 screen).
+    ***
+    *** The capture textures are pooled: the screen is copied into a previous capture texture
+    *** no image refers to anymore when there is one, instead of allocating a new one.
     **/
     StillImage CaptureScreen() throw(hoa_utils::Exception);
 
@@ -582,6 +626,11 @@ public:
         return _screen_fader.IsFading();
     }
 
+    //! \brief Returns the color modulation the screen fader currently applies to drawn images.
+    float GetFadeModulation() const {
+        return _screen_fader.GetFadeModulation();
+    }
+
     //! \brief A shortcut function used to make a fade in more explicitely.
     void FadeIn(uint32 time) {
         _screen_fader.FadeIn(time);
@@ -616,6 +665,12 @@ public:
         return (_shake_forces.empty() == false);
     }
 
+    /** \brief Gets the draw offsets currently caused by screen shaking
+    *** \param x stores the horizontal offset, in current coordinate system units
+    *** \param y stores the vertical offset, in current coordinate system units
+    **/
+    void GetShakeOffsets(float &x, float &y) const;
+
     //-- Miscellaneous --------------------------------------------------------
 
     /** \brief Sets a new gamma value using SDL_SetGamma()
@@ -715,6 +770,9 @@ public:
     //! \brief Updates the FPS counter and draws the current average FPS to the screen.
     void DrawFPS();
 
+    //! \brief Draws the average time spent in each part of a frame, when the frame profiler is enabled.
+    void DrawProfile();
+
     /** \brief toggles the FPS display
      */
     void ToggleFPS() {
@@ -788,9 +846,26 @@ private:
     //! \brief True if the game is currently running fullscreen
     bool _fullscreen;
 
+    //! \brief True if the buffer swaps wait for the display refresh
+    bool _vsync;
+
     //! \brief The x and y coordinates of the current draw cursor position
     float _x_cursor, _y_cursor;
 
+    /** \brief A copy of the current OpenGL modelview transformation
+    *** It is used to transform the image quads before adding them to the sprite batch.
+    **/
+    private_video::Transform2D _transform;
+
+    //! \brief The transformations saved by PushMatrix() and PushState()
+    std::vector<private_video::Transform2D> _transform_stack;
+
+    //! \brief Collects the image quads so that they can be drawn in as few draw calls as possible.
+    private_video::SpriteBatcher _sprite_batcher;
+
+    //! \brief The number of texture switches done during the last frame.
+    uint32 _debug_last_num_tex_switches;
+
     //! \brief Contains information about the current video engine's context, such as draw flags, the coordinate system, etc.
     private_video::Context _current_context;
 
@@ -842,6 +917,12 @@ private:
     //! Image used for rendering rectangles
     StillImage _rectangle_image;
 
+    /** \brief The screen capture textures kept to be reused by CaptureScreen()
+    *** The pool holds a reference to each of them, so that they are free to be
+    *** reused when their reference count goes back to one.
+    **/
+    std::vector<private_video::ImageTexture *> _screen_captures;
+
     //! stack containing context, i.e. draw flags plus coord sys. Context is pushed and popped by any VideoEngine functions that clobber these settings
     std::stack<private_video::Context> _context_stack;
 
@@ -900,6 +981,11 @@ private:
     *** \param frame_time The number of milliseconds that have elapsed for the current rendering frame
     **/
     void _UpdateShake(uint32 frame_time);
+
+    /** \brief Removes the pool reference to a screen capture texture, deleting it with its sheet if unused
+    *** \param capture The capture texture, which must have been removed from the pool
+    **/
+    void _ReleaseScreenCapture(private_video::ImageTexture *capture);
 }; // class VideoEngine : public hoa_utils::Singleton<VideoEngine>
 
 }  // namespace hoa_video
@@ -21,10 +21,12 @@
 ***
 *** The main game loop consists of the following steps.
 ***
+*** -# Wait for what remains of the frame budget.
 *** -# Render the newly drawn frame to the screen.
+*** -# Update the main loop timer, by a fixed game update step.
 *** -# Collect information on new user input events.
-*** -# Update the main loop timer.
-*** -# Update the game status based on how much time expired from the last update.
+*** -# Update the game status by the game update step.
+*** -# Repeat the three previous steps as long as there are game update steps due.
 *** ***************************************************************************/
 
 #include "engine/audio/audio.h"
@@ -37,6 +39,8 @@
 #include "common/gui/gui.h"
 
 #include "modes/boot/boot.h"
+#include "modes/battle/battle_simulator.h"
+#include "main_benchmark.h"
 #include "main_options.h"
 
 #ifdef __MACH__
@@ -85,8 +89,9 @@ void QuitApp()
     GUISystem::SingletonDestroy();
     AudioEngine::SingletonDestroy();
     InputEngine::SingletonDestroy();
-    SystemEngine::SingletonDestroy();
+    // The video engine image loader thread is stopped through the system engine
     VideoEngine::SingletonDestroy();
+    SystemEngine::SingletonDestroy();
     // Do it last since all luabind objects must be freed before closing the lua state.
     ScriptEngine::SingletonDestroy();
 } // void QuitApp()
@@ -169,6 +174,12 @@ bool LoadSettings()
     int32 resy = settings.ReadInt("screen_resy");
     VideoManager->SetInitialResolution(resx, resy);
     VideoManager->SetFullscreen(fullscreen);
+    // The frame pacing settings are optional, for older settings files
+    bool vsync = settings.DoesBoolExist("vsync") ? settings.ReadBool("vsync") : true;
+    uint32 frame_rate = settings.DoesUIntExist("frame_rate") ?
+                        settings.ReadUInt("frame_rate") : SYSTEM_DEFAULT_FRAME_RATE;
+    VideoManager->SetVSync(vsync);
+    SystemManager->SetFramePacing(frame_rate, vsync);
     settings.CloseTable();
 
     if(settings.IsErrorDetected()) {
@@ -512,38 +523,68 @@ int main(int argc, char *argv[])
         return EXIT_FAILURE;
     }
 
+    // The benchmarks replace the game too
+    if(hoa_main::BENCHMARK_MODE)
+        return hoa_main::RunBenchmarks() ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    // The battle simulations replace the game, and exit once done
+    if(!hoa_battle::BATTLE_SIMULATION_FILENAME.empty()) {
+        bool success = hoa_battle::SimulateBattles(hoa_battle::BATTLE_SIMULATION_FILENAME,
+                                                   hoa_battle::BATTLE_SIMULATION_RUNS,
+                                                   hoa_battle::BATTLE_SIMULATION_SEED);
+        return success ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
     ModeManager->Push(new BootMode(), false, true);
 
     try {
         // This is the main loop for the game. The loop iterates once for every frame drawn to the screen.
         while(SystemManager->NotDone()) {
-            // Update only every 10 milliseconds.
-            SDL_Delay(10);
+            // Wait for what remains of the frame budget, if anything.
+            SystemManager->WaitForNextFrame();
+
+            // Start a new frame for the profiler, each phase is then measured in turn
+            SystemManager->EndProfileFrame();
+
+            // 1) Update the game by fixed time steps, as many times as needed
+            // to catch up with the time elapsed since the last frame.
+            ProfileTimer profile(PROFILE_TIMERS_UPDATE);
+            while(SystemManager->UpdateTimers() && SystemManager->NotDone()) {
+                // Process all new events
+                profile.Switch(PROFILE_INPUT);
+                InputManager->EventHandler();
+
+                // Update video
+                profile.Switch(PROFILE_VIDEO_UPDATE);
+                VideoManager->Update();
+
+                // Update any streaming audio sources
+                profile.Switch(PROFILE_AUDIO_UPDATE);
+                AudioManager->Update();
 
-            // 1) Render the scene
+                // Update the game status
+                profile.Switch(PROFILE_MODE_UPDATE);
+                ModeManager->Update();
+
+                profile.Switch(PROFILE_TIMERS_UPDATE);
+            }
+
+            // 2) Render the scene. The time left over by the updates tells how far the
+            // frame is between the last two updates, for the modes to interpolate.
+            profile.Switch(PROFILE_CLEAR);
             VideoManager->Clear();
+            profile.Switch(PROFILE_MODE_DRAW);
             ModeManager->Draw();
+            profile.Switch(PROFILE_VIDEO_DRAW);
             VideoManager->Draw();
+            profile.Switch(PROFILE_EFFECTS_DRAW);
             ModeManager->DrawEffects();
             ModeManager->DrawPostEffects();
+            VideoManager->FlushSprites();
             // Swap the buffers once the draw operations are done.
+            profile.Switch(PROFILE_SWAP_BUFFERS);
             SDL_GL_SwapBuffers();
 
-            // Update timers for correct time-based movement operation
-            SystemManager->UpdateTimers();
-
-            // Process all new events
-            InputManager->EventHandler();
-
-            // Update video
-            VideoManager->Update();
-
-            // Update any streaming audio sources
-            AudioManager->Update();
-
-            // Update the game status
-            ModeManager->Update();
-
         } // while (SystemManager->NotDone())
     } catch(const Exception &e) {
 #ifdef WIN32
@@ -0,0 +1,306 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012 by Bertram
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    main_benchmark.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fre
+*** \brief   Source file for the engine benchmarks
+*** ***************************************************************************/
+
+#include "main_benchmark.h"
+
+#include "engine/script/script_read.h"
+#include "engine/system.h"
+#include "engine/video/image_base.h"
+#include "engine/video/particle_effect.h"
+#include "engine/video/particle_system.h"
+
+#include "common/global/global.h"
+
+#include "modes/map/map.h"
+#include "modes/map/map_objects.h"
+#include "modes/map/map_sprites.h"
+
+#include <fstream>
+#include <iomanip>
+
+using namespace hoa_utils;
+using namespace hoa_script;
+using namespace hoa_system;
+using namespace hoa_mode_manager;
+using namespace hoa_global;
+using namespace hoa_map;
+using namespace hoa_map::private_map;
+
+namespace hoa_main
+{
+
+bool BENCHMARK_MODE = false;
+
+namespace
+{
+
+//! \brief The maps the path finding is timed on
+const char *const BENCHMARK_PATH_MAPS[] = {
+    "dat/maps/layna_forest/layna_forest_north_east.lua",
+    "dat/maps/layna_forest/layna_forest_north_west.lua",
+    "dat/maps/layna_forest/layna_forest_south_east.lua",
+    "dat/maps/layna_forest/layna_forest_south_west.lua"
+};
+
+//! \brief The number of paths looked for on each map
+const uint32 BENCHMARK_PATH_SEARCHES = 200;
+
+/** \brief Times the search of paths from the camera sprite to random destinations on the forest maps
+*** \return False if a map couldn't be loaded.
+**/
+bool _BenchmarkPathFinding()
+{
+    // The map scripts show the first party member
+    GlobalManager->ClearAllData();
+    GlobalManager->AddCharacter(1);
+
+    bool success = true;
+    for(uint32 i = 0; i < sizeof(BENCHMARK_PATH_MAPS) / sizeof(BENCHMARK_PATH_MAPS[0]); ++i) {
+        // The destinations are the same for every run
+        srand(1);
+
+        MapMode *map = new MapMode(BENCHMARK_PATH_MAPS[i]);
+        ObjectSupervisor *objects = map->GetObjectSupervisor();
+        VirtualSprite *sprite = map->GetCamera();
+        if(sprite == NULL) {
+            PRINT_ERROR << "No camera sprite to find paths for on map: " << BENCHMARK_PATH_MAPS[i] << std::endl;
+            delete map;
+            success = false;
+            continue;
+        }
+
+        uint32 found = 0;
+        uint32 time = 0;
+        for(uint32 search = 0; search < BENCHMARK_PATH_SEARCHES; ++search) {
+            MapPosition destination(static_cast<float>(rand() % objects->GetGridXAxis()) + 0.5f,
+                                    static_cast<float>(rand() % objects->GetGridYAxis()) + 0.5f);
+            uint32 start = GetProfileTime();
+            Path path = objects->FindPath(sprite, destination);
+            time += GetProfileTime() - start;
+            if(!path.empty())
+                ++found;
+        }
+
+        std::cout << BENCHMARK_PATH_MAPS[i] << ": " << BENCHMARK_PATH_SEARCHES << " path searches, "
+                  << found << " paths found, " << time << " us ("
+                  << time / BENCHMARK_PATH_SEARCHES << " us per search)" << std::endl;
+        delete map;
+    }
+
+    GlobalManager->ClearAllData();
+    return success;
+}
+
+//! \brief The particle effect whose first system is run with more and more particles
+const std::string BENCHMARK_PARTICLE_EFFECT = "dat/effects/particles/snow.lua";
+
+//! \brief The number of updates and draws timed for each number of particles, 5 seconds of game
+const uint32 BENCHMARK_PARTICLE_FRAMES = 5 * SYSTEM_UPDATE_RATE;
+
+/** \brief Times the update and draw of a particle system for several numbers of particles
+*** \return False if the effect couldn't be loaded.
+**/
+bool _BenchmarkParticles()
+{
+    ParticleEffectDef effect_def;
+    if(!effect_def.Load(BENCHMARK_PARTICLE_EFFECT) || effect_def._systems.empty()) {
+        PRINT_ERROR << "Couldn't load the particle effect: " << BENCHMARK_PARTICLE_EFFECT << std::endl;
+        return false;
+    }
+
+    const float frame_time = 1.0f / SYSTEM_UPDATE_RATE;
+    const EffectParameters parameters;
+    for(int32 num_particles = 1000; num_particles <= 64000; num_particles *= 4) {
+        // Enough particles are emitted to keep the system full
+        ParticleSystemDef system_def = effect_def._systems[0];
+        system_def.max_particles = num_particles;
+        system_def.emitter._emission_rate = num_particles / system_def.particle_lifetime;
+
+        ParticleSystem system(&system_def);
+        for(float age = 0.0f; age < system_def.particle_lifetime; age += frame_time)
+            system.Update(frame_time, parameters);
+
+        uint32 start = GetProfileTime();
+        for(uint32 frame = 0; frame < BENCHMARK_PARTICLE_FRAMES; ++frame)
+            system.Update(frame_time, parameters);
+        uint32 update_time = GetProfileTime() - start;
+
+        start = GetProfileTime();
+        for(uint32 frame = 0; frame < BENCHMARK_PARTICLE_FRAMES; ++frame)
+            system.Draw();
+        uint32 draw_time = GetProfileTime() - start;
+
+        std::cout << num_particles << " particles: " << system.GetNumParticles() << " alive, update "
+                  << update_time / BENCHMARK_PARTICLE_FRAMES << " us, draw "
+                  << draw_time / BENCHMARK_PARTICLE_FRAMES << " us per frame" << std::endl;
+    }
+    return true;
+}
+
+//! \brief The directories of the maps whose number tables are read
+const char *const BENCHMARK_SCRIPT_MAP_DIRECTORIES[] = {
+    "dat/maps/layna_village",
+    "dat/maps/layna_forest"
+};
+
+//! \brief The number of times the tables of each map are read
+const uint32 BENCHMARK_SCRIPT_RUNS = 5;
+
+//! \brief Tells whether a Lua file was written by the map editor
+bool _IsMapFile(const std::string &filename)
+{
+    std::ifstream file(filename.c_str());
+    std::string line;
+    return std::getline(file, line) && line.find("map editor begin") != std::string::npos;
+}
+
+/** \brief Reads the tile layers and collision grid of a map one row at a time, as the map mode did
+*** before the number grid read functions were added.
+*** \param map_file The map file, with its tablespace open
+*** \param layers Filled with the tiles of each layer, row after row
+*** \param grid Filled with the collision grid, row after row
+**/
+void _ReadMapTablesByRow(ReadScriptDescriptor &map_file, std::vector<std::vector<int32> > &layers,
+                         std::vector<uint32> &grid)
+{
+    uint32 num_tile_rows = map_file.ReadUInt("num_tile_rows");
+
+    map_file.OpenTable("layers");
+    layers.resize(map_file.GetTableSize());
+    for(uint32 layer_id = 0; layer_id < layers.size(); ++layer_id) {
+        layers[layer_id].clear();
+        map_file.OpenTable(layer_id);
+        for(uint32 y = 0; y < num_tile_rows; ++y) {
+            std::vector<int32> row;
+            map_file.ReadIntVector(y, row);
+            layers[layer_id].insert(layers[layer_id].end(), row.begin(), row.end());
+        }
+        map_file.CloseTable(); // layers[layer_id]
+    }
+    map_file.CloseTable(); // layers
+
+    grid.clear();
+    map_file.OpenTable("map_grid");
+    for(uint32 y = 0; y < num_tile_rows * 2; ++y) {
+        std::vector<uint32> row;
+        map_file.ReadUIntVector(y, row);
+        grid.insert(grid.end(), row.begin(), row.end());
+    }
+    map_file.CloseTable(); // map_grid
+}
+
+//! \brief Reads the tile layers and collision grid of a map with the number grid read functions
+void _ReadMapTablesAsGrids(ReadScriptDescriptor &map_file, std::vector<std::vector<int32> > &layers,
+                           std::vector<uint32> &grid)
+{
+    uint32 num_tile_rows = map_file.ReadUInt("num_tile_rows");
+    uint32 rows = 0;
+    uint32 columns = 0;
+
+    map_file.OpenTable("layers");
+    layers.resize(map_file.GetTableSize());
+    for(uint32 layer_id = 0; layer_id < layers.size(); ++layer_id) {
+        map_file.OpenTable(layer_id);
+        map_file.ReadIntGrid(layers[layer_id], rows, columns);
+        layers[layer_id].resize(std::min(rows, num_tile_rows) * columns);
+        map_file.CloseTable(); // layers[layer_id]
+    }
+    map_file.CloseTable(); // layers
+
+    map_file.ReadUIntGrid("map_grid", grid, rows, columns);
+    grid.resize(std::min(rows, num_tile_rows * 2) * columns);
+}
+
+/** \brief Times the reading of the tile layers and collision grids of the Layna maps, row by row and as grids
+*** \return False if a map couldn't be opened, or if both ways didn't read the same values.
+**/
+bool _BenchmarkMapTables()
+{
+    bool success = true;
+    uint32 total_row_time = 0;
+    uint32 total_grid_time = 0;
+    for(uint32 i = 0; i < sizeof(BENCHMARK_SCRIPT_MAP_DIRECTORIES) / sizeof(BENCHMARK_SCRIPT_MAP_DIRECTORIES[0]); ++i) {
+        std::string directory = BENCHMARK_SCRIPT_MAP_DIRECTORIES[i];
+        std::vector<std::string> files = ListDirectory(directory, ".lua");
+        for(uint32 j = 0; j < files.size(); ++j) {
+            std::string filename = directory + "/" + files[j];
+            if(!_IsMapFile(filename))
+                continue;
+
+            ReadScriptDescriptor map_file;
+            if(!map_file.OpenFile(filename) || map_file.OpenTablespace().empty()) {
+                PRINT_ERROR << "Couldn't open the map file: " << filename << std::endl;
+                success = false;
+                continue;
+            }
+
+            std::vector<std::vector<int32> > row_layers;
+            std::vector<uint32> row_grid;
+            uint32 start = GetProfileTime();
+            for(uint32 run = 0; run < BENCHMARK_SCRIPT_RUNS; ++run)
+                _ReadMapTablesByRow(map_file, row_layers, row_grid);
+            uint32 row_time = (GetProfileTime() - start) / BENCHMARK_SCRIPT_RUNS;
+
+            std::vector<std::vector<int32> > grid_layers;
+            std::vector<uint32> grid;
+            start = GetProfileTime();
+            for(uint32 run = 0; run < BENCHMARK_SCRIPT_RUNS; ++run)
+                _ReadMapTablesAsGrids(map_file, grid_layers, grid);
+            uint32 grid_time = (GetProfileTime() - start) / BENCHMARK_SCRIPT_RUNS;
+
+            map_file.CloseAllTables();
+            map_file.CloseFile();
+
+            bool same_values = (row_layers == grid_layers && row_grid == grid);
+            success = success && same_values;
+            total_row_time += row_time;
+            total_grid_time += grid_time;
+            std::cout << filename << ": " << (same_values ? "same values" : "DIFFERENT VALUES")
+                      << ", by row " << row_time << " us, as grids " << grid_time << " us" << std::endl;
+        }
+    }
+
+    std::cout << "All the maps: by row " << total_row_time << " us, as grids " << total_grid_time << " us";
+    if(total_grid_time > 0)
+        std::cout << " (" << std::fixed << std::setprecision(2)
+                  << static_cast<float>(total_row_time) / total_grid_time << "x)";
+    std::cout << std::endl;
+    return success;
+}
+
+} // namespace
+
+bool RunBenchmarks()
+{
+    bool success = true;
+
+    std::cout << "--- Image loading ---" << std::endl;
+    success = hoa_video::private_video::BenchmarkPixelConversions() && success;
+    success = hoa_video::private_video::BenchmarkImageLoading("img") && success;
+
+    std::cout << "--- Map tables reading ---" << std::endl;
+    success = _BenchmarkMapTables() && success;
+
+    std::cout << "--- Map path finding ---" << std::endl;
+    success = _BenchmarkPathFinding() && success;
+
+    std::cout << "--- Particle systems ---" << std::endl;
+    success = _BenchmarkParticles() && success;
+
+    std::cout << (success ? "All the checks passed." : "Some checks FAILED.") << std::endl;
+    return success;
+}
+
+} // namespace hoa_main
@@ -0,0 +1,44 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012 by Bertram
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    main_benchmark.h
+*** \author  Yohann Ferreira, yohann ferreira orange fre
+*** \brief   Header file for the engine benchmarks
+***
+*** The benchmarks check the optimized code of the engine against its reference
+*** code where there is one, and print the time taken by both, so that the
+*** optimizations can be verified on the players machines. The others only
+*** time the engine on the game data, e.g. the path finding on the forest maps.
+*** \note    Only main.cpp and main_options.cpp should need to include this file.
+*** ***************************************************************************/
+
+#ifndef __MAIN_BENCHMARK_HEADER__
+#define __MAIN_BENCHMARK_HEADER__
+
+#include "defs.h"
+#include "utils.h"
+
+namespace hoa_main
+{
+
+//! \brief Whether the benchmarks are run instead of the game
+extern bool BENCHMARK_MODE;
+
+/** \brief Runs all the benchmarks and prints their results
+*** \return False if a benchmark couldn't be run, or if an optimized code gave different
+*** results than its reference code.
+***
+*** The game engines must be initialized.
+**/
+bool RunBenchmarks();
+
+} // namespace hoa_main
+
+#endif // __MAIN_BENCHMARK_HEADER__
@@ -19,12 +19,16 @@
 #include "engine/audio/audio.h"
 #include "engine/video/video.h"
 #include "engine/script/script.h"
+#include "engine/script/script_cache.h"
 #include "engine/input.h"
 #include "engine/system.h"
 #include "engine/mode_manager.h"
 
 #include "common/global/global.h"
 
+#include "modes/battle/battle_simulator.h"
+
+#include "main_benchmark.h"
 #include "main_options.h"
 
 using namespace hoa_utils;
@@ -39,7 +43,11 @@ bool ParseProgramOptions(int32 &return_code, int32 argc, char **argv)
     return_code = 0;
 
     for(uint32 i = 1; i < options.size(); i++) {
-        if(options[i] == "-c" || options[i] == "--check") {
+        if(options[i] == "--benchmark") {
+            // The benchmarks are timed, and don't need any sound
+            BENCHMARK_MODE = true;
+            hoa_audio::AUDIO_ENABLE = false;
+        } else if(options[i] == "-c" || options[i] == "--check") {
             if(CheckFiles() == true) {
                 return_code = 0;
             } else {
@@ -71,6 +79,22 @@ bool ParseProgramOptions(int32 &return_code, int32 argc, char **argv)
                 return_code = 1;
             }
             return false;
+        } else if(options[i] == "-p" || options[i] == "--profile") {
+            if((i + 1) >= options.size()) {
+                std::cerr << "Option " << options[i] << " requires an argument." << std::endl;
+                PrintUsage();
+                return_code = 1;
+                return false;
+            }
+            hoa_system::SYSTEM_PROFILE_FILENAME = options[i + 1];
+            i++;
+        } else if(options[i] == "--precompile-scripts") {
+            if(PrecompileScripts() == true) {
+                return_code = 0;
+            } else {
+                return_code = 1;
+            }
+            return false;
         } else if(options[i] == "-r" || options[i] == "--reset") {
             if(ResetSettings() == true) {
                 return_code = 0;
@@ -79,6 +103,30 @@ bool ParseProgramOptions(int32 &return_code, int32 argc, char **argv)
             }
             return_code = 0;
             return false;
+        } else if(options[i] == "--simulate-battle") {
+            if((i + 1) >= options.size()) {
+                std::cerr << "Option " << options[i] << " requires an argument." << std::endl;
+                PrintUsage();
+                return_code = 1;
+                return false;
+            }
+            // Nobody listens to the simulated battles
+            hoa_battle::BATTLE_SIMULATION_FILENAME = options[i + 1];
+            hoa_audio::AUDIO_ENABLE = false;
+            i++;
+        } else if(options[i] == "--simulation-runs" || options[i] == "--simulation-seed") {
+            if((i + 1) >= options.size() || !IsStringNumeric(options[i + 1])) {
+                std::cerr << "Option " << options[i] << " requires a number." << std::endl;
+                PrintUsage();
+                return_code = 1;
+                return false;
+            }
+            uint32 value = static_cast<uint32>(atoi(options[i + 1].c_str()));
+            if(options[i] == "--simulation-runs")
+                hoa_battle::BATTLE_SIMULATION_RUNS = value;
+            else
+                hoa_battle::BATTLE_SIMULATION_SEED = value;
+            i++;
         } else {
             std::cerr << "Unrecognized option: " << options[i] << std::endl;
             PrintUsage();
@@ -129,6 +177,8 @@ void PrintUsage()
 {
     std::cout
             << "usage: "APPSHORTNAME" [options]" << std::endl
+            << "  --benchmark       :: checks the optimized code of the engine against its" << std::endl
+            << "                       reference code, and prints the time taken by both" << std::endl
             << "  --check/-c        :: checks all files for integrity" << std::endl
             << "  --debug/-d <args> :: enables debug statements in specifed sections of the" << std::endl
             << "                       program, where <args> can be:" << std::endl
@@ -138,7 +188,15 @@ void PrintUsage()
             << "  --disable-audio   :: disables loading and playing audio" << std::endl
             << "  --help/-h         :: prints this help menu" << std::endl
             << "  --info/-i         :: prints information about the user's system" << std::endl
-            << "  --reset/-r        :: resets game configuration to use default settings" << std::endl;
+            << "  --profile/-p <file> :: enables the frame profiler and writes the time spent" << std::endl
+            << "                       in each part of each frame to <file>, as CSV" << std::endl
+            << "  --precompile-scripts :: compiles all the game scripts in advance, so that" << std::endl
+            << "                       they load faster" << std::endl
+            << "  --reset/-r        :: resets game configuration to use default settings" << std::endl
+            << "  --simulate-battle <file> :: plays the battle described in <file> without" << std::endl
+            << "                       any player, and prints the statistics of the results" << std::endl
+            << "  --simulation-runs <n> :: sets the number of simulated battles (100)" << std::endl
+            << "  --simulation-seed <n> :: sets the random seed of the first simulated battle (1)" << std::endl;
 }
 
 
@@ -284,6 +342,13 @@ bool CheckFiles()
 
 
 
+bool PrecompileScripts()
+{
+    return hoa_script::PrecompileScripts("dat");
+} // bool PrecompileScripts()
+
+
+
 bool EnableDebugging(const std::string &vars)
 {
     // A vector of all the debug arguments
@@ -47,6 +47,11 @@ bool PrintSystemInformation();
 **/
 bool CheckFiles();
 
+/** \brief Compiles all the game scripts in the game script cache, to be shipped with the game.
+*** \return False if a script could not be compiled or written.
+**/
+bool PrecompileScripts();
+
 /** \brief Resets the game settings (audio volume, key mappings, etc.) to their default values.
 *** \return False if the settings could not be restored, or if another problem occured.
 **/
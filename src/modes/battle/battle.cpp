@@ -259,6 +259,20 @@ StillImage *BattleMedia::GetStatusIcon(GLOBAL_STATUS type, GLOBAL_INTENSITY inte
     return &(_status_icons[(status_index * IMAGE_ROWS) + intensity_index]);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// BattleStatistics class
+////////////////////////////////////////////////////////////////////////////////
+
+void BattleStatistics::Reset()
+{
+    battle_time = 0;
+    character_actions = 0;
+    enemy_actions = 0;
+    damage_to_enemies = 0;
+    damage_to_characters = 0;
+    enemy_death_times.clear();
+}
+
 } // namespace private_battle
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -277,7 +291,8 @@ BattleMode::BattleMode() :
     _actor_state_paused(false),
     _battle_type(BATTLE_TYPE_WAIT),
     _highest_agility(0),
-    _battle_type_time_factor(BATTLE_WAIT_FACTOR)
+    _battle_type_time_factor(BATTLE_WAIT_FACTOR),
+    _simulated(false)
 {
     IF_PRINT_DEBUG(BATTLE_DEBUG) << "constructor invoked" << std::endl;
 
@@ -327,7 +342,7 @@ void BattleMode::Reset()
     VideoManager->SetCoordSys(0.0f, VIDEO_STANDARD_RES_WIDTH, 0.0f, VIDEO_STANDARD_RES_HEIGHT);
 
     // Load the default battle music track if no other music has been added
-    if(_battle_media.battle_music.GetState() == AUDIO_STATE_UNLOADED) {
+    if(!_simulated && _battle_media.battle_music.GetState() == AUDIO_STATE_UNLOADED) {
         if(!_battle_media.battle_music.LoadAudio(DEFAULT_BATTLE_MUSIC)) {
             IF_PRINT_WARNING(BATTLE_DEBUG) << "failed to load default battle music: " << DEFAULT_BATTLE_MUSIC << std::endl;
         }
@@ -373,6 +388,8 @@ static bool CompareObjectsYCoord(BattleObject *one, BattleObject *other)
 
 void BattleMode::Update()
 {
+    ProfileTimer profile(PROFILE_BATTLE_UPDATE);
+
     // Update potential battle animations
     _battle_media.Update();
     GameMode::Update();
@@ -387,7 +404,8 @@ void BattleMode::Update()
         return;
     }
 
-    if(_dialogue_supervisor->IsDialogueActive() == true) {
+    // Nobody would ever close the dialogues of a simulated battle
+    if(!_simulated && _dialogue_supervisor->IsDialogueActive() == true) {
         _dialogue_supervisor->Update();
 
         // Because the dialogue may have ended in the call to Update(), we have to check it again here.
@@ -398,6 +416,16 @@ void BattleMode::Update()
         }
     }
 
+    // The objects are drawn moving from where they were before this update
+    for(uint32 i = 0; i < _character_actors.size(); ++i) {
+        _character_actors[i]->SavePreviousLocation();
+        _character_actors[i]->GetAmmo().SavePreviousLocation();
+    }
+    for(uint32 i = 0; i < _enemy_actors.size(); ++i)
+        _enemy_actors[i]->SavePreviousLocation();
+    for(uint32 i = 0; i < _battle_particle_effects.size(); ++i)
+        _battle_particle_effects[i]->SavePreviousLocation();
+
     // Update all actors animations and y-sorting
     _battle_objects.clear();
     for(uint32 i = 0; i < _character_actors.size(); ++i) {
@@ -433,8 +461,16 @@ void BattleMode::Update()
     if(_last_enemy_dying == false && _NumberValidEnemies() == 0)
         _last_enemy_dying = true;
 
+    if(_state == BATTLE_STATE_NORMAL || _state == BATTLE_STATE_COMMAND)
+        _statistics.battle_time += SystemManager->GetUpdateTime();
+
+    // A simulated battle starts right away, there is nobody to watch the initial sequence
+    if(_state == BATTLE_STATE_INITIAL && _simulated) {
+        ChangeState(BATTLE_STATE_NORMAL);
+        return;
+    }
     // If the battle is transitioning to/from a different mode, the sequence supervisor has control
-    if(_state == BATTLE_STATE_INITIAL || _state == BATTLE_STATE_EXITING) {
+    else if(_state == BATTLE_STATE_INITIAL || _state == BATTLE_STATE_EXITING) {
         _sequence_supervisor->Update();
         return;
     }
@@ -494,6 +530,9 @@ void BattleMode::Update()
     }
     // If the battle is in either finish state, the finish supervisor has control
     else if((_state == BATTLE_STATE_VICTORY) || (_state == BATTLE_STATE_DEFEAT)) {
+        if(_simulated)
+            return;
+
         _finish_supervisor->Update();
 
         // Make the heroes and/or enemies stamina icons fade out
@@ -508,11 +547,20 @@ void BattleMode::Update()
         return;
     }
 
+    // Without any player, the characters choose their actions as soon as they can,
+    // and the battle never stays paused.
+    if(_simulated) {
+        for(uint32 i = 0; i < _character_actors.size(); i++) {
+            if(_character_actors[i]->GetState() == ACTOR_STATE_COMMAND)
+                _character_actors[i]->DecideAutomaticAction();
+        }
+        _actor_state_paused = false;
+    }
     // If the battle is running in the "wait" setting and a character reaches the command state,
     // we want to open the command menu for that character.
     // The battle will be paused until the player enters a command for all characters
     // that are in command state.
-    if(!_last_enemy_dying
+    else if(!_last_enemy_dying
         && (_battle_type == BATTLE_TYPE_WAIT || _battle_type == BATTLE_TYPE_SEMI_ACTIVE)) {
         for(uint32 i = 0; i < _character_actors.size(); i++) {
             if(_character_actors[i]->GetState() == ACTOR_STATE_COMMAND) {
@@ -534,6 +582,10 @@ void BattleMode::Update()
         BattleActor *acting_actor = _ready_queue.front();
         switch(acting_actor->GetState()) {
         case ACTOR_STATE_READY:
+            if(acting_actor->IsEnemy())
+                ++_statistics.enemy_actions;
+            else
+                ++_statistics.character_actions;
             acting_actor->ChangeState(ACTOR_STATE_ACTING);
             break;
         case ACTOR_STATE_ACTING:
@@ -628,6 +680,11 @@ void BattleMode::ChangeState(BATTLE_STATE new_state)
         _actor_state_paused = false;
         // Reset the stamina icons alpha
         _stamina_icon_alpha = 1.0f;
+        _statistics.Reset();
+        _statistics.enemy_death_times.resize(_enemy_actors.size(), 0);
+        if(_simulated)
+            break;
+
         // Start the music
         _battle_media.battle_music.FadeIn(1000);
 
@@ -657,11 +714,17 @@ void BattleMode::ChangeState(BATTLE_STATE new_state)
         // Remove the items used in battle from inventory.
         _command_supervisor->CommitChangesToInventory();
 
+        if(_simulated)
+            break;
+
         _battle_media.victory_music.Rewind();
         _battle_media.victory_music.Play();
         _finish_supervisor->Initialize(true);
         break;
     case BATTLE_STATE_DEFEAT:
+        if(_simulated)
+            break;
+
         _battle_media.defeat_music.Rewind();
         _battle_media.defeat_music.FadeIn(1000);
         _finish_supervisor->Initialize(false);
@@ -767,6 +830,33 @@ void BattleMode::NotifyActorDeath(BattleActor *actor)
     // Determine if the battle should proceed to the victory or defeat state
     if(IsBattleFinished())
         IF_PRINT_WARNING(BATTLE_DEBUG) << "actor death occurred after battle was finished" << std::endl;
+
+    // Record the time to kill the enemy. Enemies may have been added since the battle start.
+    if(actor->IsEnemy()) {
+        for(uint32 i = 0; i < _enemy_actors.size(); ++i) {
+            if(_enemy_actors[i] != actor)
+                continue;
+            if(i >= _statistics.enemy_death_times.size())
+                _statistics.enemy_death_times.resize(i + 1, 0);
+            _statistics.enemy_death_times[i] = _statistics.battle_time;
+            break;
+        }
+    }
+}
+
+
+
+void BattleMode::NotifyActorDamage(BattleActor *actor, uint32 hit_points)
+{
+    if(actor == NULL) {
+        IF_PRINT_WARNING(BATTLE_DEBUG) << "function received NULL argument" << std::endl;
+        return;
+    }
+
+    if(actor->IsEnemy())
+        _statistics.damage_to_enemies += hit_points;
+    else
+        _statistics.damage_to_characters += hit_points;
 }
 
 bool BattleMode::isOneCharacterDead() const
@@ -873,12 +963,31 @@ void BattleMode::_Initialize()
         _enemy_actors[i]->GetStateTimer().Update(RandomBoundedInteger(0, max_init_timer));
     }
 
+    _PreloadParticleEffects();
+
     // Init the script component.
     GetScriptSupervisor().Initialize(this);
 
     ChangeState(BATTLE_STATE_INITIAL);
 } // void BattleMode::_Initialize()
 
+void BattleMode::_PreloadParticleEffects()
+{
+    std::deque<BattleActor *> actors(_character_actors.begin(), _character_actors.end());
+    actors.insert(actors.end(), _enemy_actors.begin(), _enemy_actors.end());
+
+    for(uint32 i = 0; i < actors.size(); ++i) {
+        const std::map<uint32, GlobalSkill *> &skills = actors[i]->GetGlobalActor()->GetSkills();
+        for(std::map<uint32, GlobalSkill *>::const_iterator it = skills.begin(); it != skills.end(); ++it) {
+            const std::vector<std::string> &effects = it->second->GetParticleEffects();
+            for(uint32 j = 0; j < effects.size(); ++j) {
+                if(!GetParticleManager().PreloadParticleEffect(effects[j]))
+                    IF_PRINT_WARNING(BATTLE_DEBUG) << "Invalid particle effect file: " << effects[j] << std::endl;
+            }
+        }
+    }
+}
+
 void BattleMode::SetActorIdleStateTime(BattleActor *actor)
 {
     if(!actor || actor->GetAgility() == 0)
@@ -1058,13 +1167,13 @@ void BattleMode::_DrawSprites()
     if(draw_actor_selection == true) {
         VideoManager->SetDrawFlags(VIDEO_X_CENTER, VIDEO_Y_BOTTOM, VIDEO_BLEND, 0);
         if(actor_target != NULL) {
-            VideoManager->Move(actor_target->GetXLocation(), actor_target->GetYLocation());
+            VideoManager->Move(actor_target->GetDrawXLocation(), actor_target->GetDrawYLocation());
             VideoManager->MoveRelative(0.0f, -20.0f);
             _battle_media.actor_selection_image.Draw();
         } else if(IsTargetParty(target.GetType()) == true) {
             std::deque<BattleActor *>& party_target = *(target.GetParty());
             for(uint32 i = 0; i < party_target.size(); i++) {
-                VideoManager->Move(party_target[i]->GetXLocation(),  party_target[i]->GetYLocation());
+                VideoManager->Move(party_target[i]->GetDrawXLocation(), party_target[i]->GetDrawYLocation());
                 VideoManager->MoveRelative(0.0f, -20.0f);
                 _battle_media.actor_selection_image.Draw();
             }
@@ -1084,7 +1193,7 @@ void BattleMode::_DrawSprites()
         uint32 point = target.GetPoint();
 
         VideoManager->SetDrawFlags(VIDEO_X_CENTER, VIDEO_Y_CENTER, VIDEO_BLEND, 0);
-        VideoManager->Move(actor_target->GetXLocation(), actor_target->GetYLocation());
+        VideoManager->Move(actor_target->GetDrawXLocation(), actor_target->GetDrawYLocation());
         VideoManager->MoveRelative(actor_target->GetAttackPoint(point)->GetXPosition(), actor_target->GetAttackPoint(point)->GetYPosition());
         _battle_media.attack_point_indicator.Draw();
     }
@@ -225,6 +225,42 @@ private:
     hoa_video::StillImage _stunned_icon;
 }; // class BattleMedia
 
+
+/** ****************************************************************************
+*** \brief Figures gathered during a battle, to evaluate its balance
+***
+*** The times are counted from the moment the battle actually starts, after
+*** its initial sequence.
+*** ***************************************************************************/
+class BattleStatistics
+{
+public:
+    BattleStatistics()
+    {
+        Reset();
+    }
+
+    void Reset();
+
+    //! \brief The time spent fighting, in milliseconds
+    uint32 battle_time;
+
+    //! \brief The number of actions executed by the characters and by the enemies
+    //@{
+    uint32 character_actions;
+    uint32 enemy_actions;
+    //@}
+
+    //! \brief The hit points taken from the enemies and from the characters
+    //@{
+    uint32 damage_to_enemies;
+    uint32 damage_to_characters;
+    //@}
+
+    //! \brief The battle time at which each enemy died, in the enemy actors order, or 0 if it survived
+    std::vector<uint32> enemy_death_times;
+}; // class BattleStatistics
+
 } // namespace private_battle
 
 
@@ -373,8 +409,32 @@ public:
     *** \param actor A pointer to the actor who is now deceased
     **/
     void NotifyActorDeath(private_battle::BattleActor *actor);
+
+    /** \brief Records the hit points an actor just lost in the battle statistics
+    *** \param actor A pointer to the actor who was damaged
+    *** \param hit_points The hit points actually taken from the actor
+    **/
+    void NotifyActorDamage(private_battle::BattleActor *actor, uint32 hit_points);
     //@}
 
+    /** \brief Makes the battle run without any player, to gather its statistics
+    ***
+    *** In a simulated battle, the initial sequence, the dialogues, the music and the
+    *** finish menus are skipped, and the characters choose their actions by
+    *** themselves. Nothing has to be drawn. It must be set before the battle is reset.
+    **/
+    void SetSimulated(bool simulated) {
+        _simulated = simulated;
+    }
+
+    bool IsSimulated() const {
+        return _simulated;
+    }
+
+    const private_battle::BattleStatistics &GetStatistics() const {
+        return _statistics;
+    }
+
     //! \brief Tells the battle type: Wait, semi-wait, active.
     //! \see BATTLE_TYPE enum.
     hoa_battle::private_battle::BATTLE_TYPE GetBattleType() const {
@@ -533,11 +593,22 @@ private:
     //! \brief the battle type time factor, speeding the battle actors depending on the battle type.
     float _battle_type_time_factor;
 
+    //! \brief Whether the battle runs without any player. \see SetSimulated()
+    bool _simulated;
+
+    //! \brief The figures gathered during the battle
+    private_battle::BattleStatistics _statistics;
+
     ////////////////////////////// PRIVATE METHODS ///////////////////////////////
 
     //! \brief Initializes all data necessary for the battle to begin
     void _Initialize();
 
+    /** \brief Loads the particle effects of the characters and enemies skills
+    *** This prevents the first use of each skill from stalling the battle while its effect file is read.
+    **/
+    void _PreloadParticleEffects();
+
     /** \brief Sets the origin location of all character and enemy actors
     *** The location of the actors in both parties is dependent upon the number and physical size of the actor
     *** (the size of its sprite image). This function implements the algorithm that determines those locations.
@@ -183,6 +183,7 @@ bool SkillAction::Update()
     if(!_update_function.is_valid())
         return true;
 
+    ProfileTimer profile(PROFILE_SCRIPT_CALLS);
     try {
         return ScriptCallFunction<bool>(_update_function);
     } catch(const luabind::error &err) {
@@ -41,6 +41,31 @@ namespace hoa_battle
 namespace private_battle
 {
 
+// Battle object class
+float BattleObject::GetDrawXLocation() const
+{
+    return _x_previous_location + (_x_location - _x_previous_location) * _GetDrawInterpolation();
+}
+
+float BattleObject::GetDrawYLocation() const
+{
+    return _y_previous_location + (_y_location - _y_previous_location) * _GetDrawInterpolation();
+}
+
+void BattleObject::SavePreviousLocation()
+{
+    _x_previous_location = _x_location;
+    _y_previous_location = _y_location;
+    _previous_location_update = SystemManager->GetUpdateCount();
+}
+
+float BattleObject::_GetDrawInterpolation() const
+{
+    if(_previous_location_update != SystemManager->GetUpdateCount())
+        return 1.0f;
+    return BattleMode::CurrentInstance()->GetUpdateInterpolation();
+}
+
 // Battle Particle effect class
 BattleParticleEffect::BattleParticleEffect(const std::string &effect_filename):
     BattleObject()
@@ -58,7 +83,7 @@ void BattleParticleEffect::DrawSprite()
     // TODO: Make the battle mode use standard coordinates
     // And remove that workaround
     VideoManager->SetStandardCoordSys();
-    _effect.Move(GetXLocation(), VIDEO_STANDARD_RES_HEIGHT - GetYLocation());
+    _effect.Move(GetDrawXLocation(), VIDEO_STANDARD_RES_HEIGHT - GetDrawYLocation());
     _effect.Draw();
     VideoManager->SetCoordSys(0.0f, VIDEO_STANDARD_RES_WIDTH, 0.0f, VIDEO_STANDARD_RES_HEIGHT);
 }
@@ -68,7 +93,7 @@ void BattleAmmo::DrawSprite()
 {
     // Draw potential sprite ammo
     if(_shown) {
-        VideoManager->Move(GetXLocation(), GetYLocation());
+        VideoManager->Move(GetDrawXLocation(), GetDrawYLocation());
         _ammo_image.Draw();
     }
 }
@@ -218,7 +243,9 @@ void BattleActor::RegisterDamage(uint32 amount, BattleTarget *target)
         return;
     }
 
+    uint32 hit_points = GetHitPoints();
     SubtractHitPoints(amount);
+    BattleMode::CurrentInstance()->NotifyActorDamage(this, hit_points - GetHitPoints());
     _indicator_supervisor->AddDamageIndicator(amount);
 
     if(GetHitPoints() == 0) {
@@ -493,6 +520,129 @@ float BattleActor::GetAverageEvadeRating()
     return evade;
 }
 
+// TODO: No party target will work, this will have to be addressed eventually.
+// The use of a skill on dead enemies is not supported either.
+void BattleActor::_DecideRandomSkillAction(const std::vector<GlobalSkill *> &skills)
+{
+    if(skills.empty()) {
+        IF_PRINT_WARNING(BATTLE_DEBUG) << "actor had no usable skills" << std::endl;
+        ChangeState(ACTOR_STATE_IDLE);
+        return;
+    }
+
+    BattleMode *battle = BattleMode::CurrentInstance();
+
+    // Obtain the living foes
+    std::deque<BattleActor *> alive_foes = IsEnemy() ? battle->GetCharacterParty() : battle->GetEnemyParty();
+    std::deque<BattleActor *>::iterator actor_iterator = alive_foes.begin();
+    while(actor_iterator != alive_foes.end()) {
+        if(!(*actor_iterator)->IsAlive())
+            actor_iterator = alive_foes.erase(actor_iterator);
+        else
+            ++actor_iterator;
+    }
+    if(alive_foes.empty()) {
+        ChangeState(ACTOR_STATE_IDLE);
+        return;
+    }
+
+    // and the living allies
+    std::deque<BattleActor *> alive_allies = IsEnemy() ? battle->GetEnemyParty() : battle->GetCharacterParty();
+    actor_iterator = alive_allies.begin();
+    while(actor_iterator != alive_allies.end()) {
+        if(!(*actor_iterator)->IsAlive())
+            actor_iterator = alive_allies.erase(actor_iterator);
+        else
+            ++actor_iterator;
+    }
+
+    if(alive_allies.empty()) {
+        // it means that the actor actually thinking now is already dead.
+        PRINT_WARNING << "An actor was deciding an action while being dead." << std::endl;
+        ChangeState(ACTOR_STATE_IDLE);
+        return;
+    }
+
+    // Targeting members
+    BattleTarget target;
+    BattleActor *actor_target = NULL;
+
+    // Select a random skill to use
+    uint32 skill_index = 0;
+    if(skills.size() > 1)
+        skill_index = RandomBoundedInteger(0, skills.size() - 1);
+    GlobalSkill *skill = skills[skill_index];
+
+    // Select the target
+    GLOBAL_TARGET target_type = skill->GetTargetType();
+    switch(target_type) {
+    case GLOBAL_TARGET_FOE_POINT:
+    case GLOBAL_TARGET_FOE:
+        // Select a random living foe
+        if(alive_foes.size() == 1)
+            actor_target = alive_foes[0];
+        else
+            actor_target = alive_foes[RandomBoundedInteger(0, alive_foes.size() - 1)];
+        break;
+    case GLOBAL_TARGET_SELF_POINT:
+    case GLOBAL_TARGET_SELF:
+        actor_target = this;
+        break;
+    case GLOBAL_TARGET_ALLY_POINT:
+    case GLOBAL_TARGET_ALLY:
+    case GLOBAL_TARGET_ALLY_EVEN_DEAD:
+        // Select a random living ally, selecting a dead ally is unsupported at the moment.
+        if(alive_allies.size() == 1)
+            actor_target = alive_allies[0];
+        else
+            actor_target = alive_allies[RandomBoundedInteger(0, alive_allies.size() - 1)];
+        break;
+    case GLOBAL_TARGET_ALL_FOES: // TODO: Add support for this
+    case GLOBAL_TARGET_ALL_ALLIES: // TODO: Add support for this
+    default:
+        PRINT_WARNING << "Unsupported skill target type found." << std::endl;
+        ChangeState(ACTOR_STATE_IDLE);
+        return;
+        break;
+    }
+
+    // Potentially select the target point and finsh targeting
+    switch(target_type) {
+    case GLOBAL_TARGET_SELF_POINT:
+    case GLOBAL_TARGET_FOE_POINT:
+    case GLOBAL_TARGET_ALLY_POINT: {
+        // Select a random attack point on the target
+        uint32 num_points = actor_target->GetAttackPoints().size();
+        uint32 point_target = 0;
+        if(num_points == 1)
+            point_target = 0;
+        else
+            point_target = RandomBoundedInteger(0, num_points - 1);
+
+        target.SetPointTarget(target_type, point_target, actor_target);
+        break;
+    }
+
+    case GLOBAL_TARGET_FOE:
+    case GLOBAL_TARGET_SELF:
+    case GLOBAL_TARGET_ALLY:
+    case GLOBAL_TARGET_ALLY_EVEN_DEAD:
+        target.SetActorTarget(target_type, actor_target);
+        break;
+
+    case GLOBAL_TARGET_ALL_FOES: // TODO: Add support for this
+    case GLOBAL_TARGET_ALL_ALLIES: // TODO: Add support for this
+    default:
+        PRINT_WARNING << "Unsupported skill target type found." << std::endl;
+        ChangeState(ACTOR_STATE_IDLE);
+        return;
+        break;
+    }
+
+    SetAction(new SkillAction(this, target, skill));
+    ChangeState(ACTOR_STATE_WARM_UP);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // BattleCharacter class
 ////////////////////////////////////////////////////////////////////////////////
@@ -664,7 +814,7 @@ void BattleCharacter::Update()
 
 void BattleCharacter::DrawSprite()
 {
-    VideoManager->Move(_x_location, _y_location);
+    VideoManager->Move(GetDrawXLocation(), GetDrawYLocation());
     _global_character->RetrieveBattleAnimation(_sprite_animation_alias)->Draw();
 
     if(_is_stunned && (_state == ACTOR_STATE_IDLE || _state == ACTOR_STATE_WARM_UP || _state == ACTOR_STATE_COOL_DOWN)) {
@@ -708,6 +858,27 @@ void BattleCharacter::ChangeActionText()
     }
 }
 
+void BattleCharacter::DecideAutomaticAction()
+{
+    // Only keep the skills which can be used right now on a single target
+    std::vector<GlobalSkill *> usable_skills;
+    const std::map<uint32, GlobalSkill *>& skills = _global_character->GetSkills();
+    for(std::map<uint32, GlobalSkill *>::const_iterator it = skills.begin(); it != skills.end(); ++it) {
+        GlobalSkill *skill = it->second;
+        if(!skill->IsExecutableInBattle() || skill->GetSPRequired() > GetSkillPoints())
+            continue;
+
+        GLOBAL_TARGET target_type = skill->GetTargetType();
+        if(target_type == GLOBAL_TARGET_INVALID || target_type == GLOBAL_TARGET_ALL_FOES
+                || target_type == GLOBAL_TARGET_ALL_ALLIES)
+            continue;
+
+        usable_skills.push_back(skill);
+    }
+
+    _DecideRandomSkillAction(usable_skills);
+}
+
 void BattleCharacter::DrawPortrait()
 {
     VideoManager->SetDrawFlags(VIDEO_X_LEFT, VIDEO_Y_BOTTOM, VIDEO_BLEND, 0);
@@ -966,7 +1137,7 @@ void BattleEnemy::DrawSprite()
     std::vector<StillImage>& sprite_frames = *(_global_enemy->GetBattleSpriteFrames());
     float hp_percent = static_cast<float>(GetHitPoints()) / static_cast<float>(GetMaxHitPoints());
 
-    VideoManager->Move(_x_location, _y_location);
+    VideoManager->Move(GetDrawXLocation(), GetDrawYLocation());
     // Alpha will range from 1.0 to 0.0 in the following calculations
     if(_state == ACTOR_STATE_DYING) {
         sprite_frames[3].Draw(Color(1.0f, 1.0f, 1.0f, _sprite_alpha));
@@ -992,8 +1163,6 @@ void BattleEnemy::DrawSprite()
     }
 } // void BattleEnemy::DrawSprite()
 
-// TODO: No party target will work, this will have to be addressed eventually.
-// The use of a skill on dead enemies is not supported either.
 void BattleEnemy::_DecideAction()
 {
     if(_global_enemy->GetSkills().empty()) {
@@ -1002,115 +1171,7 @@ void BattleEnemy::_DecideAction()
         return;
     }
 
-    // Obtain the living characters
-    std::deque<BattleActor *> alive_characters = BattleMode::CurrentInstance()->GetCharacterParty();
-    std::deque<BattleActor *>::iterator actor_iterator = alive_characters.begin();
-    while(actor_iterator != alive_characters.end()) {
-        if(!(*actor_iterator)->IsAlive())
-            actor_iterator = alive_characters.erase(actor_iterator);
-        else
-            ++actor_iterator;
-    }
-    if(alive_characters.empty()) {
-        ChangeState(ACTOR_STATE_IDLE);
-        return;
-    }
-
-    // and the living enemies
-    std::deque<BattleActor *> alive_enemies = BattleMode::CurrentInstance()->GetEnemyParty();
-    actor_iterator = alive_enemies.begin();
-    while(actor_iterator != alive_enemies.end()) {
-        if(!(*actor_iterator)->IsAlive())
-            actor_iterator = alive_enemies.erase(actor_iterator);
-        else
-            ++actor_iterator;
-    }
-
-    if(alive_enemies.empty()) {
-        // it means that the enemy actually thinking now is already dead.
-        PRINT_WARNING << "An enemy was deciding an action while being dead." << std::endl;
-        ChangeState(ACTOR_STATE_IDLE);
-        return;
-    }
-
-    // Targeting members
-    BattleTarget target;
-    BattleActor *actor_target = NULL;
-
-    // Select a random skill to use
-    uint32 skill_index = 0;
-    if(_enemy_skills.size() > 1)
-        skill_index = RandomBoundedInteger(0, _enemy_skills.size() - 1);
-    GlobalSkill *skill = _enemy_skills[skill_index];
-
-    // Select the target
-    GLOBAL_TARGET target_type = skill->GetTargetType();
-    switch(target_type) {
-    case GLOBAL_TARGET_FOE_POINT:
-    case GLOBAL_TARGET_FOE:
-        // Select a random living character
-        if(alive_characters.size() == 1)
-            actor_target = alive_characters[0];
-        else
-            actor_target = alive_characters[RandomBoundedInteger(0, alive_characters.size() - 1)];
-        break;
-    case GLOBAL_TARGET_SELF_POINT:
-    case GLOBAL_TARGET_SELF:
-        actor_target = this;
-        break;
-    case GLOBAL_TARGET_ALLY_POINT:
-    case GLOBAL_TARGET_ALLY:
-    case GLOBAL_TARGET_ALLY_EVEN_DEAD:
-        // Select a random living enemy, selecting a dead enemy ally is unsupported at the moment.
-        if(alive_enemies.size() == 1)
-            actor_target = alive_enemies[0];
-        else
-            actor_target = alive_enemies[RandomBoundedInteger(0, alive_enemies.size() - 1)];
-        break;
-    case GLOBAL_TARGET_ALL_FOES: // TODO: Add support for this
-    case GLOBAL_TARGET_ALL_ALLIES: // TODO: Add support for this
-    default:
-        PRINT_WARNING << "Unsupported enemy skill type found." << std::endl;
-        ChangeState(ACTOR_STATE_IDLE);
-        return;
-        break;
-    }
-
-    // Potentially select the target point and finsh targeting
-    switch(target_type) {
-    case GLOBAL_TARGET_SELF_POINT:
-    case GLOBAL_TARGET_FOE_POINT:
-    case GLOBAL_TARGET_ALLY_POINT: {
-        // Select a random attack point on the target
-        uint32 num_points = actor_target->GetAttackPoints().size();
-        uint32 point_target = 0;
-        if(num_points == 1)
-            point_target = 0;
-        else
-            point_target = RandomBoundedInteger(0, num_points - 1);
-
-        target.SetPointTarget(target_type, point_target, actor_target);
-        break;
-    }
-
-    case GLOBAL_TARGET_FOE:
-    case GLOBAL_TARGET_SELF:
-    case GLOBAL_TARGET_ALLY:
-    case GLOBAL_TARGET_ALLY_EVEN_DEAD:
-        target.SetActorTarget(target_type, actor_target);
-        break;
-
-    case GLOBAL_TARGET_ALL_FOES: // TODO: Add support for this
-    case GLOBAL_TARGET_ALL_ALLIES: // TODO: Add support for this
-    default:
-        PRINT_WARNING << "Unsupported enemy skill type found." << std::endl;
-        ChangeState(ACTOR_STATE_IDLE);
-        return;
-        break;
-    }
-
-    SetAction(new SkillAction(this, target, skill));
-    ChangeState(ACTOR_STATE_WARM_UP);
+    _DecideRandomSkillAction(_enemy_skills);
 }
 
 } // namespace private_battle
@@ -48,7 +48,10 @@ public:
         _x_origin(0.0f),
         _y_origin(0.0f),
         _x_location(0.0f),
-        _y_location(0.0f)
+        _y_location(0.0f),
+        _x_previous_location(0.0f),
+        _y_previous_location(0.0f),
+        _previous_location_update(0)
     {}
     virtual ~BattleObject()
     {}
@@ -85,6 +88,25 @@ public:
         _y_location = y_location;
     }
 
+    /** \brief Returns the location the object is drawn at
+    *** This is between the locations of the object at the last two battle updates, as far as
+    *** the frame drawn is between them, so that the object moves smoothly at any frame rate.
+    **/
+    //@{
+    float GetDrawXLocation() const;
+
+    float GetDrawYLocation() const;
+    //@}
+
+    //! \brief Saves the current location as the previous one, at the start of each battle update.
+    void SavePreviousLocation();
+
+    //! \brief Makes the object drawn at its current location at once, rather than moving from its previous one
+    void ResetPreviousLocation() {
+        _x_previous_location = _x_location;
+        _y_previous_location = _y_location;
+    }
+
     virtual void DrawSprite()
     {};
 
@@ -94,6 +116,18 @@ protected:
 
     //! \brief The x and y coordinates of the actor's current location on the battle field
     float _x_location, _y_location;
+
+    //! \brief The x and y coordinates of the object location at the previous battle update
+    float _x_previous_location, _y_previous_location;
+
+    //! \brief The game update count when the previous location was saved
+    uint32 _previous_location_update;
+
+    /** \brief Returns how far the frame drawn is between the previous and current locations
+    *** \return 1.0f when the previous location wasn't saved by the last update, e.g. for
+    *** an object which has just been added to the battle.
+    **/
+    float _GetDrawInterpolation() const;
 };
 
 //! \brief A class representing particle effects used as battle objects:
@@ -544,6 +578,14 @@ protected:
 
     //! \brief Updates the Stamina Icon position.
     void _UpdateStaminaIconPosition();
+
+    /** \brief Sets an action using a random skill on a random target, and enters the warm up state
+    *** \param skills The skills to choose from
+    ***
+    *** The foes and the allies of the actor are its opponents and its own party. When no action
+    *** can be set, the actor goes back to the idle state.
+    **/
+    void _DecideRandomSkillAction(const std::vector<hoa_global::GlobalSkill *> &skills);
 }; // class BattleActor
 
 
@@ -597,6 +639,12 @@ public:
         return (_state == ACTOR_STATE_IDLE) || (_state == ACTOR_STATE_COMMAND);
     }
 
+    /** \brief Chooses the character action without the player, in the command state
+    *** A random skill is used among the ones the character can afford, like enemies do.
+    *** This is used by the simulated battles.
+    **/
+    void DecideAutomaticAction();
+
     //! \brief Updates the state of the character. Must be called every frame loop.
     void Update();
 
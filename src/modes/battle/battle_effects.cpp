@@ -239,6 +239,7 @@ void EffectsSupervisor::Update()
 
         // Update the effect according to the script function
         if(!effect_removed) {
+            ProfileTimer profile(PROFILE_SCRIPT_CALLS);
             ScriptCallFunction<void>(*(_status_effects[i]->GetUpdateFunction()), _status_effects[i]);
             _status_effects[i]->ResetIntensityChanged();
         }
@@ -153,6 +153,12 @@ void SequenceSupervisor::_UpdateInitialSequence()
             _battle->_enemy_actors[i]->SetXLocation(_battle->_enemy_actors[i]->GetXOrigin() + MAX_ENEMY_OFFSET);
         }
 
+        // The actors are placed off screen at once
+        for(uint32 i = 0; i < _battle->_character_actors.size(); i++)
+            _battle->_character_actors[i]->ResetPreviousLocation();
+        for(uint32 i = 0; i < _battle->_enemy_actors.size(); i++)
+            _battle->_enemy_actors[i]->ResetPreviousLocation();
+
         _sequence_step = INIT_STEP_BACKGROUND_FADE;
     }
     // Step 1: Fade in the background graphics
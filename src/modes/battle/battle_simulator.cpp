@@ -0,0 +1,224 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012 by Bertram
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    battle_simulator.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fre
+*** \brief   Source file for the battle simulations
+*** ***************************************************************************/
+
+#include "modes/battle/battle_simulator.h"
+
+#include "engine/mode_manager.h"
+#include "engine/script/script_read.h"
+#include "engine/system.h"
+
+#include "common/global/global.h"
+
+#include "modes/battle/battle.h"
+#include "modes/battle/battle_actors.h"
+
+#include <iomanip>
+
+using namespace hoa_utils;
+using namespace hoa_mode_manager;
+using namespace hoa_script;
+using namespace hoa_system;
+using namespace hoa_global;
+using namespace hoa_battle::private_battle;
+
+namespace hoa_battle
+{
+
+std::string BATTLE_SIMULATION_FILENAME;
+uint32 BATTLE_SIMULATION_RUNS = 100;
+uint32 BATTLE_SIMULATION_SEED = 1;
+
+namespace
+{
+
+//! \brief The battle to simulate, as read from a setup file
+struct _SimulationSetup {
+    std::vector<uint32> characters;
+    uint32 experience_points;
+    std::vector<uint32> enemies;
+    BATTLE_TYPE battle_type;
+    std::vector<std::string> battle_scripts;
+    //! \brief The longest battle time, in milliseconds
+    uint32 time_limit;
+};
+
+bool _LoadSetup(const std::string &filename, _SimulationSetup &setup)
+{
+    ReadScriptDescriptor script;
+    if(!script.OpenFile(filename)) {
+        PRINT_ERROR << "Couldn't open the battle simulation file: " << filename << std::endl;
+        return false;
+    }
+
+    if(script.OpenTablespace().empty()) {
+        PRINT_ERROR << "No namespace found in the battle simulation file: " << filename << std::endl;
+        script.CloseFile();
+        return false;
+    }
+
+    script.ReadUIntVector("characters", setup.characters);
+    script.ReadUIntVector("enemies", setup.enemies);
+
+    setup.experience_points = 0;
+    if(script.DoesUIntExist("experience_points"))
+        setup.experience_points = script.ReadUInt("experience_points");
+
+    setup.battle_type = BATTLE_TYPE_WAIT;
+    if(script.DoesIntExist("battle_type"))
+        setup.battle_type = static_cast<BATTLE_TYPE>(script.ReadInt("battle_type"));
+
+    if(script.DoesTableExist("battle_scripts"))
+        script.ReadStringVector("battle_scripts", setup.battle_scripts);
+
+    setup.time_limit = 600000;
+    if(script.DoesUIntExist("time_limit"))
+        setup.time_limit = script.ReadUInt("time_limit") * 1000;
+
+    script.CloseTable(); // The tablespace
+    bool valid = !script.IsErrorDetected();
+    if(!valid)
+        PRINT_ERROR << "Errors in the battle simulation file: " << filename << std::endl
+                    << script.GetErrorMessages() << std::endl;
+    script.CloseFile();
+
+    if(setup.characters.empty() || setup.enemies.empty()) {
+        PRINT_ERROR << "The battle simulation needs both characters and enemies: " << filename << std::endl;
+        return false;
+    }
+    if(setup.battle_type <= BATTLE_TYPE_INVALID || setup.battle_type >= BATTLE_TYPE_TOTAL) {
+        PRINT_ERROR << "Invalid battle type in the battle simulation file: " << filename << std::endl;
+        return false;
+    }
+
+    return valid;
+}
+
+//! \brief Returns the average of a sum over a number of samples, 0 when there are none
+double _Average(double sum, uint32 count)
+{
+    return count > 0 ? sum / count : 0.0;
+}
+
+} // namespace
+
+bool SimulateBattles(const std::string &filename, uint32 runs, uint32 seed)
+{
+    if(runs == 0) {
+        PRINT_ERROR << "No battle to simulate" << std::endl;
+        return false;
+    }
+
+    _SimulationSetup setup;
+    if(!_LoadSetup(filename, setup))
+        return false;
+
+    // The characters are never changed by the simulated battles, so they can be shared by all of them
+    GlobalManager->ClearAllData();
+    for(uint32 i = 0; i < setup.characters.size(); ++i) {
+        GlobalManager->AddCharacter(setup.characters[i]);
+        GlobalCharacter *character = GlobalManager->GetCharacter(setup.characters[i]);
+        if(character == NULL)
+            return false;
+
+        if(setup.experience_points > 0 && character->AddExperiencePoints(setup.experience_points)) {
+            while(character->AcknowledgeGrowth()) {}
+        }
+        character->SetHitPoints(character->GetMaxHitPoints());
+        character->SetSkillPoints(character->GetMaxSkillPoints());
+    }
+
+    const uint32 max_updates = setup.time_limit / 1000 * SYSTEM_UPDATE_RATE;
+
+    uint32 victories = 0;
+    uint32 defeats = 0;
+    double battle_time = 0.0;
+    double character_actions = 0.0;
+    double enemy_actions = 0.0;
+    double damage_to_enemies = 0.0;
+    double damage_to_characters = 0.0;
+    std::vector<std::string> enemy_names;
+    std::vector<double> enemy_death_times(setup.enemies.size(), 0.0);
+    std::vector<uint32> enemy_deaths(setup.enemies.size(), 0);
+
+    for(uint32 run = 0; run < runs; ++run) {
+        // The random numbers of the battle only depend on its seed
+        srand(seed + run);
+
+        BattleMode *battle = new BattleMode();
+        battle->SetSimulated(true);
+        battle->SetBattleType(setup.battle_type);
+        for(uint32 i = 0; i < setup.enemies.size(); ++i)
+            battle->AddEnemy(setup.enemies[i], 0.0f, 0.0f);
+        battle->GetScriptSupervisor().SetScripts(setup.battle_scripts);
+
+        // Replaces the previous battle, which is deleted before the new one starts
+        if(run > 0)
+            ModeManager->Pop();
+        ModeManager->Push(battle);
+        ModeManager->Update();
+
+        for(uint32 update = 0; update < max_updates && !battle->IsBattleFinished(); ++update) {
+            SystemManager->SimulateUpdate();
+            ModeManager->Update();
+        }
+
+        if(battle->GetState() == BATTLE_STATE_VICTORY)
+            ++victories;
+        else if(battle->GetState() == BATTLE_STATE_DEFEAT)
+            ++defeats;
+
+        const BattleStatistics &statistics = battle->GetStatistics();
+        battle_time += statistics.battle_time;
+        character_actions += statistics.character_actions;
+        enemy_actions += statistics.enemy_actions;
+        damage_to_enemies += statistics.damage_to_enemies;
+        damage_to_characters += statistics.damage_to_characters;
+
+        std::deque<BattleEnemy *> &enemies = battle->GetEnemyActors();
+        if(enemy_names.empty()) {
+            for(uint32 i = 0; i < enemies.size() && i < setup.enemies.size(); ++i)
+                enemy_names.push_back(MakeStandardString(enemies[i]->GetName()));
+        }
+        for(uint32 i = 0; i < statistics.enemy_death_times.size() && i < setup.enemies.size(); ++i) {
+            if(statistics.enemy_death_times[i] == 0)
+                continue;
+            enemy_death_times[i] += statistics.enemy_death_times[i];
+            ++enemy_deaths[i];
+        }
+    }
+
+    uint32 unfinished = runs - victories - defeats;
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "Battle simulation: " << filename << std::endl
+              << "Runs: " << runs << ", seeds " << seed << " to " << seed + runs - 1 << std::endl
+              << "Victories: " << victories << " (" << _Average(victories * 100.0, runs) << "%), defeats: "
+              << defeats << ", time limit reached: " << unfinished << std::endl
+              << "Average battle time: " << _Average(battle_time / 1000.0, runs) << " s" << std::endl
+              << "Average actions: " << _Average(character_actions, runs) << " by the characters, "
+              << _Average(enemy_actions, runs) << " by the enemies" << std::endl
+              << "Average damage: " << _Average(damage_to_enemies, runs) << " dealt to the enemies, "
+              << _Average(damage_to_characters, runs) << " dealt to the characters" << std::endl
+              << "Average time to kill:" << std::endl;
+    for(uint32 i = 0; i < enemy_names.size(); ++i) {
+        std::cout << "  " << enemy_names[i] << " #" << i + 1 << ": "
+                  << _Average(enemy_death_times[i] / 1000.0, enemy_deaths[i]) << " s (killed in "
+                  << enemy_deaths[i] << " runs)" << std::endl;
+    }
+
+    return true;
+}
+
+} // namespace hoa_battle
@@ -0,0 +1,55 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012 by Bertram
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    battle_simulator.h
+*** \author  Yohann Ferreira, yohann ferreira orange fre
+*** \brief   Header file for the battle simulations
+***
+*** A battle simulation plays the same battle many times without any player,
+*** as fast as possible and without drawing anything, to gather statistics
+*** used to balance the enemy parties. The battles are described by a setup
+*** file, see dat/battles/simulations/simulation_example.lua.
+***
+*** Each battle is run with its own random seed, the first seed plus the run
+*** index, so that the results can be reproduced. Larger simulations can be
+*** split between several processes, each given a different first seed.
+*** ***************************************************************************/
+
+#ifndef __BATTLE_SIMULATOR_HEADER__
+#define __BATTLE_SIMULATOR_HEADER__
+
+#include "defs.h"
+#include "utils.h"
+
+namespace hoa_battle
+{
+
+//! \brief The battle simulation setup file to run instead of the game, if not empty
+extern std::string BATTLE_SIMULATION_FILENAME;
+
+//! \brief The number of battles to simulate
+extern uint32 BATTLE_SIMULATION_RUNS;
+
+//! \brief The random seed of the first simulated battle
+extern uint32 BATTLE_SIMULATION_SEED;
+
+/** \brief Runs the battle described in a setup file several times and prints the statistics of the results
+*** \param filename The simulation setup file
+*** \param runs The number of battles to run
+*** \param seed The random seed of the first battle, incremented for each of the next ones
+*** \return False if the setup file couldn't be used
+***
+*** The game engines must be initialized, the battles still load their images.
+**/
+bool SimulateBattles(const std::string &filename, uint32 runs, uint32 seed);
+
+} // namespace hoa_battle
+
+#endif // __BATTLE_SIMULATOR_HEADER__
@@ -30,10 +30,14 @@
 #include "engine/input.h"
 
 #include "common/global/global.h"
+#include "common/map_binary.h"
+
+#include <fstream>
 
 using namespace hoa_utils;
 using namespace hoa_audio;
 using namespace hoa_boot;
+using namespace hoa_common;
 using namespace hoa_input;
 using namespace hoa_mode_manager;
 using namespace hoa_script;
@@ -50,6 +54,7 @@ namespace hoa_map
 
 // Initialize static class variables
 MapMode *MapMode::_current_instance = NULL;
+std::list<MapMode *> MapMode::_map_cache;
 
 // ****************************************************************************
 // ********** MapMode Public Class Methods
@@ -57,6 +62,8 @@ MapMode *MapMode::_current_instance = NULL;
 
 MapMode::MapMode(const std::string &filename) :
     GameMode(),
+    _cache_on_leave(false),
+    _texture_memory(0),
     _activated(false),
     _map_filename(filename),
     _map_tablespace(""),
@@ -79,6 +86,10 @@ MapMode::MapMode(const std::string &filename) :
     mode_type = MODE_MANAGER_MAP_MODE;
     _current_instance = this;
 
+    // Tells which images are loaded by this map, see _texture_memory
+    std::map<const private_video::ImageTexture *, int32> previous_image_references;
+    TextureManager->GetImageReferences(previous_image_references);
+
     ResetState();
     PushState(STATE_EXPLORE);
 
@@ -142,6 +153,8 @@ MapMode::MapMode(const std::string &filename) :
 
     // Init the script component.
     GetScriptSupervisor().Initialize(this);
+
+    _texture_memory = TextureManager->GetTextureMemory(previous_image_references);
 }
 
 
@@ -155,6 +168,33 @@ MapMode::~MapMode()
     delete(_treasure_supervisor);
 }
 
+MapMode *MapMode::LoadMap(const std::string &filename)
+{
+    for(std::list<MapMode *>::iterator it = _map_cache.begin(); it != _map_cache.end(); ++it) {
+        MapMode *map = *it;
+        if(map->_map_filename != filename)
+            continue;
+
+        _map_cache.erase(it);
+        if(map->_Enter())
+            return map;
+
+        // The map may be partly set up, so it is loaded again instead
+        delete map;
+        break;
+    }
+
+    return new MapMode(filename);
+}
+
+void MapMode::FlushMapCache()
+{
+    while(!_map_cache.empty()) {
+        delete _map_cache.back();
+        _map_cache.pop_back();
+    }
+}
+
 void MapMode::Deactivate()
 {
     if (!_activated)
@@ -217,6 +257,35 @@ void MapMode::Reset()
         _object_supervisor->ReloadVisiblePartyMember();
 }
 
+bool MapMode::Detach()
+{
+    if(!_cache_on_leave || !_enter_function.is_valid())
+        return false;
+    _cache_on_leave = false;
+
+    // Removes the scene state pushed by the map transition
+    PopState();
+    // Stores the music state to restore it when the map is entered again
+    Deactivate();
+
+    _map_cache.push_front(this);
+    uint32 cache_texture_memory = 0;
+    for(std::list<MapMode *>::const_iterator it = _map_cache.begin(); it != _map_cache.end(); ++it)
+        cache_texture_memory += (*it)->_texture_memory;
+
+    while(_map_cache.size() > MAP_CACHE_SIZE || cache_texture_memory > MAP_CACHE_TEXTURE_MEMORY) {
+        MapMode *map = _map_cache.back();
+        _map_cache.pop_back();
+        cache_texture_memory -= map->_texture_memory;
+
+        // Too large to be kept along with the current map, the mode engine deletes it
+        if(map == this)
+            return false;
+        delete map;
+    }
+    return true;
+}
+
 
 
 void MapMode::Update()
@@ -238,13 +307,19 @@ void MapMode::Update()
     _dialogue_icon.Update();
 
     // Call the map script's update function
-    if(_update_function.is_valid())
+    if(_update_function.is_valid()) {
+        ProfileTimer profile(PROFILE_SCRIPT_CALLS);
         ScriptCallFunction<void>(_update_function);
+    }
 
     // Update all animated tile images
-    _tile_supervisor->Update();
-    _object_supervisor->Update();
-    _object_supervisor->SortObjects();
+    {
+        ProfileTimer profile(PROFILE_MAP_TILES);
+        _tile_supervisor->Update();
+        profile.Switch(PROFILE_MAP_OBJECTS);
+        _object_supervisor->Update();
+        _object_supervisor->SortObjects();
+    }
 
     // Update the active state of the map
     switch(CurrentState()) {
@@ -280,15 +355,21 @@ void MapMode::Update()
 
 void MapMode::Draw()
 {
+    // The map is drawn as seen from the camera between its last two updates
+    VideoManager->SetCoordSys(0.0f, SCREEN_GRID_X_LENGTH, SCREEN_GRID_Y_LENGTH, 0.0f);
+    _UpdateMapFrame(true);
+
     VideoManager->SetStandardCoordSys();
     GetScriptSupervisor().DrawBackground();
 
     VideoManager->SetCoordSys(0.0f, SCREEN_GRID_X_LENGTH, SCREEN_GRID_Y_LENGTH, 0.0f);
     VideoManager->SetDrawFlags(VIDEO_X_CENTER, VIDEO_Y_BOTTOM, 0);
-    if(_draw_function.is_valid())
+    if(_draw_function.is_valid()) {
+        ProfileTimer profile(PROFILE_SCRIPT_CALLS);
         ScriptCallFunction<void>(_draw_function);
-    else
+    } else {
         _DrawMapLayers();
+    }
 
     VideoManager->SetStandardCoordSys();
     GetScriptSupervisor().DrawForeground();
@@ -370,7 +451,7 @@ void MapMode::AddFlatGroundObject(MapObject *obj)
         PRINT_WARNING << "Couldn't add NULL object." << std::endl;
         return;
     }
-    _object_supervisor->_flat_ground_objects.push_back(obj);
+    _object_supervisor->_AddObjectToLayer(obj, _object_supervisor->_flat_ground_objects, _object_supervisor->_flat_ground_unsorted);
     _object_supervisor->_all_objects.insert(std::make_pair(obj->object_id, obj));
 }
 
@@ -380,8 +461,9 @@ void MapMode::AddGroundObject(MapObject *obj)
         PRINT_WARNING << "Couldn't add NULL object." << std::endl;
         return;
     }
-    _object_supervisor->_ground_objects.push_back(obj);
+    _object_supervisor->_AddObjectToLayer(obj, _object_supervisor->_ground_objects, _object_supervisor->_ground_unsorted);
     _object_supervisor->_all_objects.insert(std::make_pair(obj->object_id, obj));
+    _object_supervisor->_IndexObject(obj, false);
 }
 
 
@@ -391,7 +473,7 @@ void MapMode::AddPassObject(MapObject *obj)
         PRINT_WARNING << "Couldn't add NULL object." << std::endl;
         return;
     }
-    _object_supervisor->_pass_objects.push_back(obj);
+    _object_supervisor->_AddObjectToLayer(obj, _object_supervisor->_pass_objects, _object_supervisor->_pass_unsorted);
     _object_supervisor->_all_objects.insert(std::make_pair(obj->object_id, obj));
 }
 
@@ -402,8 +484,9 @@ void MapMode::AddSkyObject(MapObject *obj)
         PRINT_WARNING << "Couldn't add NULL object." << std::endl;
         return;
     }
-    _object_supervisor->_sky_objects.push_back(obj);
+    _object_supervisor->_AddObjectToLayer(obj, _object_supervisor->_sky_objects, _object_supervisor->_sky_unsorted);
     _object_supervisor->_all_objects.insert(std::make_pair(obj->object_id, obj));
+    _object_supervisor->_IndexObject(obj, true);
 }
 
 
@@ -447,6 +530,74 @@ void MapMode::AddLight(const std::string &main_flare_filename,
 
 
 
+namespace
+{
+
+//! \brief Returns the value of a Lua string assignment line, or an empty string.
+std::string _ReadQuotedValue(const std::string &line)
+{
+    size_t start = line.find('"');
+    if(start == std::string::npos)
+        return std::string();
+    size_t end = line.find('"', start + 1);
+    if(end == std::string::npos)
+        return std::string();
+    return line.substr(start + 1, end - start - 1);
+}
+
+/** \brief Reads the images names of a map from the header of its Lua file
+*** The map editor writes the location image and tileset names before the map grid
+*** and tile layers, so only those first lines are read and the script isn't run.
+*** \return False if the file couldn't be opened.
+**/
+bool _ReadMapImageNames(const std::string &map_filename, std::string &map_image_filename,
+                        std::vector<std::string> &tileset_filenames)
+{
+    std::ifstream file(map_filename.c_str());
+    if(!file)
+        return false;
+
+    std::string line;
+    while(std::getline(file, line)) {
+        if(line.compare(0, 8, "map_grid") == 0)
+            break;
+        else if(line.compare(0, 18, "map_image_filename") == 0)
+            map_image_filename = _ReadQuotedValue(line);
+        else if(line.compare(0, 18, "tileset_filenames[") == 0)
+            tileset_filenames.push_back(_ReadQuotedValue(line));
+    }
+    return true;
+}
+
+} // namespace
+
+void MapMode::PrefetchMap(const std::string &map_filename)
+{
+    // The images of a cached map are still loaded
+    for(std::list<MapMode *>::const_iterator it = _map_cache.begin(); it != _map_cache.end(); ++it) {
+        if((*it)->_map_filename == map_filename)
+            return;
+    }
+
+    // Running the whole map script would take longer than loading the images,
+    // so only its header is read.
+    std::string map_image_filename;
+    std::vector<std::string> tileset_filenames;
+    if(!_ReadMapImageNames(map_filename, map_image_filename, tileset_filenames))
+        return;
+
+    // The tilesets are loaded by the tile supervisor as grids of 16 * 16 tiles
+    for(uint32 i = 0; i < tileset_filenames.size(); ++i) {
+        if(!tileset_filenames[i].empty())
+            TextureManager->PrefetchImage("img/tilesets/" + tileset_filenames[i] + ".png", 16, 16);
+    }
+
+    if(!map_image_filename.empty())
+        TextureManager->PrefetchImage(map_image_filename);
+}
+
+
+
 void MapMode::SetCamera(private_map::VirtualSprite *sprite, uint32 duration)
 {
     if(_camera == sprite) {
@@ -540,14 +691,31 @@ bool MapMode::_Load()
         return false;
     }
 
+    // The tile layers, contexts and collision grid are read from the map binary file
+    // when it is up to date, as reading them from the Lua tables is much slower.
+    // Otherwise, they are saved in the user map cache once read for the next times.
+    MapBinaryData map_data;
+    if(!map_data.Load(_map_filename)) {
+        IF_PRINT_DEBUG(MAP_DEBUG) << "No up to date binary data for map: "
+                                  << _map_filename << ", loading it from the Lua file." << std::endl;
+        if(!map_data.Read(_map_script)) {
+            PRINT_ERROR << "Failed to read the tile data." << std::endl;
+            return false;
+        }
+
+        // The map can be loaded anyway
+        if(!map_data.SaveInUserCache(_map_filename))
+            IF_PRINT_WARNING(MAP_DEBUG) << "Couldn't save the binary data of map: " << _map_filename << std::endl;
+    }
+
     // Instruct the supervisor classes to perform their portion of the load operation
-    if(!_tile_supervisor->Load(_map_script)) {
+    if(!_tile_supervisor->Load(_map_script, map_data)) {
         PRINT_ERROR << "Failed to load the tile data." << std::endl;
         return false;
     }
 
     // NOTE: The object supervisor will complain itself about the error.
-    if(!_object_supervisor->Load(_map_script))
+    if(!_object_supervisor->Load(_map_script, map_data))
         return false;
 
     // Loads the map image and translated location names.
@@ -599,6 +767,8 @@ bool MapMode::_Load()
 
     _update_function = _map_script.ReadFunctionPointer("Update");
     _draw_function = _map_script.ReadFunctionPointer("Draw");
+    if(_map_script.DoesFunctionExist("Enter"))
+        _enter_function = _map_script.ReadFunctionPointer("Enter");
 
     // ---------- (6) Prepare all sprites with dialogue
     // This is done at this stage because the map script's load function creates the sprite and dialogue objects. Only after
@@ -618,11 +788,38 @@ bool MapMode::_Load()
     _map_script.CloseAllTables();
     _map_script.CloseFile(); // Free the map file once everyhting is loaded
 
+    // The images prefetched for this map are now referenced by it
+    TextureManager->ReleasePrefetchedImages();
+
+    if(_enter_function.is_valid() && !_Enter()) {
+        PRINT_ERROR << "Invalid map Enter() function." << std::endl;
+        return false;
+    }
+
     return true;
 } // bool MapMode::_Load()
 
 
 
+bool MapMode::_Enter()
+{
+    // As when loading, the map scripts refer to the map being entered
+    _current_instance = this;
+
+    try {
+        ScriptCallFunction<void>(_enter_function, this);
+    } catch(const luabind::error &e) {
+        ScriptManager->HandleLuaError(e);
+        return false;
+    } catch(const luabind::cast_failed &e) {
+        ScriptManager->HandleCastError(e);
+        return false;
+    }
+    return true;
+}
+
+
+
 void MapMode::_UpdateExplore()
 {
     // First go to menu mode if the user requested it
@@ -716,7 +913,7 @@ void MapMode::_UpdateExplore()
 
 
 
-void MapMode::_UpdateMapFrame()
+void MapMode::_UpdateMapFrame(bool interpolate)
 {
     // Reinit map corner check members
     _camera_x_in_map_corner = false;
@@ -735,17 +932,26 @@ void MapMode::_UpdateMapFrame()
     // However, we've discussed the possiblity of adding a zoom feature to maps, in which case we need to continually re-calculate the pixel size
     VideoManager->GetPixelSize(x_pixel_length, y_pixel_length);
 
+    MapPosition camera_position = interpolate ? _camera->GetDrawPosition() : _camera->GetPosition();
     float path_x, path_y = 0.0f;
     if(!_camera_timer.IsRunning()) {
-        path_x = _camera->GetXPosition();
-        path_y = _camera->GetYPosition();
+        path_x = camera_position.x;
+        path_y = camera_position.y;
     } else {
-        path_x = _camera->GetXPosition() + (1 - _camera_timer.PercentComplete()) * _delta_x;
-        path_y = _camera->GetYPosition() + (1 - _camera_timer.PercentComplete()) * _delta_y;
-
-        // Inform the effect supervisor about camera movement.
         float duration = (float)_camera_timer.GetDuration();
         float time_elapsed = (float)SystemManager->GetUpdateTime();
+
+        // The camera movement is drawn as far back from the last update as the camera sprite
+        float percent_complete = _camera_timer.PercentComplete();
+        if(interpolate) {
+            percent_complete -= (1.0f - GetUpdateInterpolation()) * time_elapsed / duration;
+            if(percent_complete < 0.0f)
+                percent_complete = 0.0f;
+        }
+        path_x = camera_position.x + (1 - percent_complete) * _delta_x;
+        path_y = camera_position.y + (1 - percent_complete) * _delta_y;
+
+        // Inform the effect supervisor about camera movement.
         float x_parallax = !IsCameraXAxisInMapCorner() ?
                            _delta_x * time_elapsed / duration
                            / SCREEN_GRID_X_LENGTH * VIDEO_STANDARD_RES_WIDTH :
@@ -755,7 +961,8 @@ void MapMode::_UpdateMapFrame()
                            / SCREEN_GRID_Y_LENGTH * VIDEO_STANDARD_RES_HEIGHT :
                            0.0f;
 
-        GetEffectSupervisor().AddParallax(x_parallax, -y_parallax);
+        if(!interpolate)
+            GetEffectSupervisor().AddParallax(x_parallax, -y_parallax);
     }
 
     current_x = GetFloatInteger(path_x);
@@ -881,8 +1088,10 @@ void MapMode::_DrawMapLayers()
 {
     VideoManager->SetCoordSys(0.0f, SCREEN_GRID_X_LENGTH, SCREEN_GRID_Y_LENGTH, 0.0f);
 
+    ProfileTimer profile(PROFILE_MAP_TILES);
     _tile_supervisor->DrawLayers(&_map_frame, GROUND_LAYER);
     // Save points are engraved on the ground, and thus shouldn't be drawn after walls.
+    profile.Switch(PROFILE_MAP_OBJECTS);
     _object_supervisor->DrawSavePoints();
 
     _object_supervisor->DrawFlatGroundObjects();
@@ -890,8 +1099,10 @@ void MapMode::_DrawMapLayers()
     _object_supervisor->DrawPassObjects();
     _object_supervisor->DrawGroundObjects(true); // Second draw pass of ground objects
 
+    profile.Switch(PROFILE_MAP_TILES);
     _tile_supervisor->DrawLayers(&_map_frame, SKY_LAYER);
 
+    profile.Switch(PROFILE_MAP_OBJECTS);
     _object_supervisor->DrawSkyObjects();
 
     if(VideoManager->DebugInfoOn()) {
@@ -19,9 +19,9 @@
 *** dialogue, and more.
 ***
 *** Each individual map is represented by it's own object of the MapMode class.
-*** It is our intention in the future to retain more than one map in memory at
-*** once to reduce or eliminate loading times when the player transitions
-*** between maps.
+*** The maps recently left through a map transition are kept in memory in the
+*** map cache, so that going back to them doesn't load them again. See
+*** MapMode::LoadMap().
 *** ***************************************************************************/
 
 #ifndef __MAP_HEADER__
@@ -34,6 +34,8 @@
 
 #include "engine/audio/audio_descriptor.h"
 
+#include <list>
+
 //! All calls to map mode are wrapped in this namespace.
 namespace hoa_map
 {
@@ -88,6 +90,22 @@ public:
 
     ~MapMode();
 
+    /** \brief Returns a map, reused from the map cache when possible
+    *** \param filename The name of the Lua file that retains all data about the map
+    *** \return The cached map, entered again by calling its script Enter() function,
+    *** or a new map loaded from the file.
+    ***
+    *** Only the maps whose script has an Enter() function are cached, as the
+    *** function is run again in place of Load() to set the map up for the
+    *** player entering it. The least recently left maps are deleted when there
+    *** are more than MAP_CACHE_SIZE of them, or while the images only used by
+    *** the cached maps exceed MAP_CACHE_TEXTURE_MEMORY.
+    **/
+    static MapMode *LoadMap(const std::string &filename);
+
+    //! \brief Deletes all the maps of the map cache, e.g. when they refer to outdated game data
+    static void FlushMapCache();
+
     //! \brief Resets appropriate class members. Called whenever the MapMode object is made the active game mode.
     void Reset();
 
@@ -95,6 +113,11 @@ public:
     //!  Note that this is called twice when doing a battle transition.
     void Deactivate();
 
+    /** \brief Called when the map is popped off the game stack
+    *** \return True if the map was put in the map cache, see CacheOnLeave().
+    **/
+    bool Detach();
+
     //! \brief Updates the game and calls various sub-update functions depending on the current state of map mode.
     void Update();
 
@@ -117,6 +140,13 @@ public:
     //! \brief Removes the highest item in the state stack
     void PopState();
 
+    /** \brief Requests the map to be put in the map cache once popped off the game stack
+    *** This is done by the map transitions, whose scene state is removed from the cached map.
+    **/
+    void CacheOnLeave() {
+        _cache_on_leave = true;
+    }
+
     /** \brief Retrieves the current map state
     *** \return The top-most item on the map state stack
     **/
@@ -152,6 +182,14 @@ public:
                   const hoa_video::Color &secondary_color,
                   hoa_map::private_map::MAP_CONTEXT map_context);
 
+    /** \brief Starts loading the images of another map in the background
+    *** \param map_filename The map script file
+    ***
+    *** This is done when a transition to the map is started, and may be called by
+    *** the map scripts when the character approaches a transition zone.
+    **/
+    void PrefetchMap(const std::string &map_filename);
+
     //! \brief Vectors containing the save points animations (when the character is in or not).
     std::vector<hoa_video::AnimatedImage> active_save_point_animations;
     std::vector<hoa_video::AnimatedImage> inactive_save_point_animations;
@@ -283,6 +321,18 @@ private:
     **/
     static MapMode *_current_instance;
 
+    //! \brief The maps recently left, the most recently left one first
+    static std::list<MapMode *> _map_cache;
+
+    //! \brief Tells whether the map is put in the map cache once popped off the game stack
+    bool _cache_on_leave;
+
+    /** \brief The memory of the images the map loaded and no other game part was using, in bytes
+    *** This is what deleting the map from the map cache frees, as long as no other map took
+    *** references to the same images meanwhile.
+    **/
+    uint32 _texture_memory;
+
     //! Tells whether the mode is activated. It is true by calling Reset(),
     //! and false when calling Deactivate(). This member exists to prevent
     //! the triggering of deactivate more than once.
@@ -339,6 +389,12 @@ private:
     **/
     ScriptObject _draw_function;
 
+    /** \brief Script function setting the map up for the player entering it
+    *** It is optional, and called after the map script Load() function, and
+    *** again each time the map is entered from the map cache.
+    **/
+    ScriptObject _enter_function;
+
     // ----- Members : Properties and State -----
 
     //! \brief Retains information needed to correctly draw the next map frame
@@ -427,11 +483,18 @@ private:
     //! \brief Loads all map data contained in the Lua file that defines the map
     bool _Load();
 
+    //! \brief Calls the map script Enter() function, returns false if it failed
+    bool _Enter();
+
     //! \brief A helper function to Update() that is called only when the map is in the explore state
     void _UpdateExplore();
 
-    //! \brief Update the map frame coordinates
-    void _UpdateMapFrame();
+    /** \brief Update the map frame coordinates
+    *** \param interpolate Whether the frame is computed for drawing, with the camera between its
+    *** positions of the last two updates. The parallax movement is only reported when false,
+    *** once per update.
+    **/
+    void _UpdateMapFrame(bool interpolate = false);
 
     //! \brief Draws all visible map tiles and sprites to the screen
     void _DrawMapLayers();
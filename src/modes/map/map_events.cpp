@@ -151,6 +151,9 @@ void MapTransitionEvent::_Start()
 
     VideoManager->_StartTransitionFadeOut(Color::black, MAP_FADE_OUT_TIME);
     _done = false;
+
+    // The new map images are decoded during the fade out
+    MapMode::CurrentInstance()->PrefetchMap(_transition_map_filename);
 }
 
 
@@ -164,7 +167,8 @@ bool MapTransitionEvent::_Update()
     // break the fade smoothness and visible duration.
     if(!_done) {
         hoa_global::GlobalManager->SetPreviousLocation(_transition_origin);
-        MapMode *MM = new MapMode(_transition_map_filename);
+        MapMode::CurrentInstance()->CacheOnLeave();
+        MapMode *MM = MapMode::LoadMap(_transition_map_filename);
         ModeManager->Pop();
         ModeManager->Push(MM, false, true);
         _done = true;
@@ -341,10 +345,11 @@ void ScriptedEvent::_Start()
 
 bool ScriptedEvent::_Update()
 {
-    if(_update_function != NULL)
-        return ScriptCallFunction<bool>(*_update_function);
-    else
+    if(_update_function == NULL)
         return true;
+
+    ProfileTimer profile(PROFILE_SCRIPT_CALLS);
+    return ScriptCallFunction<bool>(*_update_function);
 }
 
 // -----------------------------------------------------------------------------
@@ -506,6 +511,7 @@ bool ScriptedSpriteEvent::_Update()
 {
     bool finished = false;
     if(_update_function != NULL) {
+        ProfileTimer profile(PROFILE_SCRIPT_CALLS);
         finished = ScriptCallFunction<bool>(*_update_function, _sprite);
     } else {
         finished = true;
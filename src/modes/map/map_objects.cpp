@@ -22,12 +22,14 @@
 #include "modes/map/map_events.h"
 
 #include "common/global/global.h"
+#include "common/map_binary.h"
 
 #include "engine/video/particle_effect.h"
 #include "engine/audio/audio.h"
 
 using namespace hoa_utils;
 using namespace hoa_audio;
+using namespace hoa_common;
 using namespace hoa_script;
 using namespace hoa_system;
 using namespace hoa_video;
@@ -55,10 +57,21 @@ MapObject::MapObject() :
     collision_mask(ALL_COLLISION),
     sky_object(false),
     draw_on_second_pass(false),
+    always_updated(false),
     _emote_animation(0),
     _emote_offset_x(0.0f),
     _emote_offset_y(0.0f),
-    _emote_time(0)
+    _emote_time(0),
+    _object_supervisor(NULL),
+    _object_cells(NULL),
+    _cell_left(-1),
+    _cell_top(-1),
+    _cell_right(-1),
+    _cell_bottom(-1),
+    _layer_index(0),
+    _query_id(0),
+    _layer_unsorted(NULL),
+    _skipped_update_time(0)
 {}
 
 bool MapObject::ShouldDraw()
@@ -73,7 +86,13 @@ bool MapObject::ShouldDraw()
         return false;
 
     // Determine if the sprite is off-screen and if so, don't draw it.
-    if(!MapRectangle::CheckIntersection(GetImageRectangle(), map->GetMapFrame().screen_edges))
+    MapPosition draw_position = GetDrawPosition();
+    MapRectangle rect = GetImageRectangle();
+    rect.left += draw_position.x - position.x;
+    rect.right += draw_position.x - position.x;
+    rect.top += draw_position.y - position.y;
+    rect.bottom += draw_position.y - position.y;
+    if(!MapRectangle::CheckIntersection(rect, map->GetMapFrame().screen_edges))
         return false;
 
     // Determine the center position coordinates for the camera
@@ -86,10 +105,10 @@ bool MapObject::ShouldDraw()
     // change the coordinate system in map mode, then this should be done only once and the calculated values should be saved for re-use.
     // However, we've discussed the possiblity of adding a zoom feature to maps, in which case we need to continually re-calculate the pixel size
     VideoManager->GetPixelSize(x_pixel_length, y_pixel_length);
-    rounded_x_offset = FloorToFloatMultiple(GetFloatFraction(GetXPosition()), x_pixel_length);
-    rounded_y_offset = FloorToFloatMultiple(GetFloatFraction(GetYPosition()), y_pixel_length);
-    x_pos = static_cast<float>(GetFloatInteger(GetXPosition())) + rounded_x_offset;
-    y_pos = static_cast<float>(GetFloatInteger(GetYPosition())) + rounded_y_offset;
+    rounded_x_offset = FloorToFloatMultiple(GetFloatFraction(draw_position.x), x_pixel_length);
+    rounded_y_offset = FloorToFloatMultiple(GetFloatFraction(draw_position.y), y_pixel_length);
+    x_pos = static_cast<float>(GetFloatInteger(draw_position.x)) + rounded_x_offset;
+    y_pos = static_cast<float>(GetFloatInteger(draw_position.y)) + rounded_y_offset;
 
     // ---------- Move the drawing cursor to the appropriate coordinates for this sprite
     VideoManager->Move(x_pos - map->GetMapFrame().screen_edges.left,
@@ -97,6 +116,55 @@ bool MapObject::ShouldDraw()
     return true;
 } // bool MapObject::ShouldDraw()
 
+MapPosition MapObject::GetDrawPosition() const
+{
+    float interpolation = MapMode::CurrentInstance()->GetUpdateInterpolation();
+    return MapPosition(_previous_position.x + (position.x - _previous_position.x) * interpolation,
+                       _previous_position.y + (position.y - _previous_position.y) * interpolation);
+}
+
+void MapObject::SetPosition(float x, float y)
+{
+    _MovePosition(x, y);
+    _previous_position = position;
+}
+
+void MapObject::SetXPosition(float x)
+{
+    _MovePosition(x, position.y);
+    _previous_position.x = x;
+}
+
+void MapObject::SetYPosition(float y)
+{
+    _MovePosition(position.x, y);
+    _previous_position.y = y;
+}
+
+void MapObject::_MovePosition(float x, float y)
+{
+    if(_layer_unsorted && y != position.y)
+        *_layer_unsorted = true;
+    position.x = x;
+    position.y = y;
+    if(_object_supervisor)
+        _object_supervisor->_UpdateObjectCells(this);
+}
+
+void MapObject::SetCollHalfWidth(float collision)
+{
+    coll_half_width = collision;
+    if(_object_supervisor)
+        _object_supervisor->_UpdateObjectCells(this);
+}
+
+void MapObject::SetCollHeight(float collision)
+{
+    coll_height = collision;
+    if(_object_supervisor)
+        _object_supervisor->_UpdateObjectCells(this);
+}
+
 MapRectangle MapObject::GetCollisionRectangle() const
 {
     MapRectangle rect;
@@ -812,7 +880,20 @@ ObjectSupervisor::ObjectSupervisor() :
     _num_grid_x_axis(0),
     _num_grid_y_axis(0),
     _last_id(1000),
-    _visible_party_member(0)
+    _visible_party_member(0),
+    _path_search_id(0),
+    _num_cell_x_axis(0),
+    _num_cell_y_axis(0),
+    _cell_query_id(0),
+    _flat_ground_unsorted(false),
+    _ground_unsorted(false),
+    _pass_unsorted(false),
+    _sky_unsorted(false),
+    _update_frame(0),
+    _update_time(0),
+    _full_rate_count(0),
+    _reduced_rate_count(0),
+    _sleeping_count(0)
 {
     _virtual_focus = new VirtualSprite();
     _virtual_focus->SetPosition(0.0f, 0.0f);
@@ -905,30 +986,43 @@ VirtualSprite *ObjectSupervisor::GetSprite(uint32 object_id)
 
 void ObjectSupervisor::SortObjects()
 {
-    std::sort(_flat_ground_objects.begin(), _flat_ground_objects.end(), MapObject_Ptr_Less());
-    std::sort(_ground_objects.begin(), _ground_objects.end(), MapObject_Ptr_Less());
-    std::sort(_pass_objects.begin(), _pass_objects.end(), MapObject_Ptr_Less());
-    std::sort(_sky_objects.begin(), _sky_objects.end(), MapObject_Ptr_Less());
+    _SortLayer(_flat_ground_objects, _flat_ground_unsorted);
+    _SortLayer(_pass_objects, _pass_unsorted);
+
+    // Only the collision layers use the layer indices
+    bool ground_changed = _SortLayer(_ground_objects, _ground_unsorted);
+    bool sky_changed = _SortLayer(_sky_objects, _sky_unsorted);
+    if(ground_changed || sky_changed)
+        _UpdateLayerIndices();
 }
 
 
 
-bool ObjectSupervisor::Load(ReadScriptDescriptor &map_file)
+bool ObjectSupervisor::Load(ReadScriptDescriptor &map_file, const MapBinaryData &map_data)
 {
-    if(!map_file.DoesTableExist("map_grid")) {
-        PRINT_ERROR << "No map grid found in map file: " << map_file.GetFilename() << std::endl;
-        return false;
-    }
-
     // Construct the collision grid
-    map_file.OpenTable("map_grid");
-    _num_grid_y_axis = map_file.GetTableSize();
+    _num_grid_y_axis = map_data.num_grid_rows;
     for(uint16 y = 0; y < _num_grid_y_axis; ++y) {
-        _collision_grid.push_back(std::vector<uint32>());
-        map_file.ReadUIntVector(y, _collision_grid.back());
+        std::vector<uint32>::const_iterator row = map_data.collision_grid.begin() + y * map_data.num_grid_cols;
+        _collision_grid.push_back(std::vector<uint32>(row, row + map_data.num_grid_cols));
+    }
+
+    if(_collision_grid.empty()) {
+        PRINT_ERROR << "Empty map grid found in map file: " << map_file.GetFilename() << std::endl;
+        return false;
     }
-    map_file.CloseTable();
     _num_grid_x_axis = _collision_grid[0].size();
+
+    // Create the object spatial index and add the objects which may already exist
+    _num_cell_x_axis = (_num_grid_x_axis + OBJECT_CELL_LENGTH - 1) / OBJECT_CELL_LENGTH;
+    _num_cell_y_axis = (_num_grid_y_axis + OBJECT_CELL_LENGTH - 1) / OBJECT_CELL_LENGTH;
+    _ground_object_cells.assign(_num_cell_x_axis * _num_cell_y_axis, std::vector<MapObject *>());
+    _sky_object_cells.assign(_num_cell_x_axis * _num_cell_y_axis, std::vector<MapObject *>());
+    for(uint32 i = 0; i < _ground_objects.size(); ++i)
+        _AddObjectToCells(_ground_objects[i]);
+    for(uint32 i = 0; i < _sky_objects.size(); ++i)
+        _AddObjectToCells(_sky_objects[i]);
+
     return true;
 }
 
@@ -936,26 +1030,86 @@ bool ObjectSupervisor::Load(ReadScriptDescriptor &map_file)
 
 void ObjectSupervisor::Update()
 {
+    ++_update_frame;
+    _update_time = SystemManager->GetUpdateTime();
+    _full_rate_area = MapMode::CurrentInstance()->GetMapFrame().screen_edges;
+    _full_rate_area.left -= UPDATE_FULL_RATE_MARGIN;
+    _full_rate_area.right += UPDATE_FULL_RATE_MARGIN;
+    _full_rate_area.top -= UPDATE_FULL_RATE_MARGIN;
+    _full_rate_area.bottom += UPDATE_FULL_RATE_MARGIN;
+    _full_rate_count = 0;
+    _reduced_rate_count = 0;
+    _sleeping_count = 0;
+
+    // The objects are drawn moving from where they were before this update
+    for(std::map<uint16, MapObject *>::iterator it = _all_objects.begin(); it != _all_objects.end(); ++it)
+        it->second->_SavePreviousPosition();
+    _virtual_focus->_SavePreviousPosition();
+
     for(uint32 i = 0; i < _flat_ground_objects.size(); ++i)
-        _flat_ground_objects[i]->Update();
+        _UpdateObject(_flat_ground_objects[i], i);
     for(uint32 i = 0; i < _ground_objects.size(); ++i)
-        _ground_objects[i]->Update();
+        _UpdateObject(_ground_objects[i], i);
     // Update save point animation and activeness.
     _UpdateSavePoints();
     for(uint32 i = 0; i < _pass_objects.size(); ++i)
-        _pass_objects[i]->Update();
+        _UpdateObject(_pass_objects[i], i);
     for(uint32 i = 0; i < _sky_objects.size(); ++i)
-        _sky_objects[i]->Update();
+        _UpdateObject(_sky_objects[i], i);
     for(uint32 i = 0; i < _halos.size(); ++i)
-        _halos[i]->Update();
+        _UpdateObject(_halos[i], i);
     for(uint32 i = 0; i < _lights.size(); ++i)
-        _lights[i]->Update();
+        _UpdateObject(_lights[i], i);
     for(uint32 i = 0; i < _zones.size(); ++i)
         _zones[i]->Update();
 
+    SystemManager->AddProfileCount(PROFILE_MAP_OBJECTS_FULL_RATE, _full_rate_count);
+    SystemManager->AddProfileCount(PROFILE_MAP_OBJECTS_REDUCED_RATE, _reduced_rate_count);
+    SystemManager->AddProfileCount(PROFILE_MAP_OBJECTS_SLEEPING, _sleeping_count);
+
     // TODO: examine all sprites for movement and context change, then check all resident zones to see if the sprite has entered
 }
 
+void ObjectSupervisor::_UpdateObject(MapObject *object, uint32 index)
+{
+    // The sprites moved by events must follow them, wherever they are
+    bool full_rate = object->always_updated;
+    MAP_OBJECT_TYPE type = object->GetType();
+    if(type == VIRTUAL_TYPE || type == SPRITE_TYPE || type == ENEMY_TYPE)
+        full_rate = full_rate || static_cast<VirtualSprite *>(object)->control_event != NULL;
+
+    if(!full_rate) {
+        // Objects out of the active context can't be seen or interacted with
+        if(!(object->context & MapMode::CurrentInstance()->GetCurrentContext())) {
+            ++_sleeping_count;
+            return;
+        }
+        full_rate = MapRectangle::CheckIntersection(object->GetImageRectangle(), _full_rate_area);
+    }
+
+    if(full_rate) {
+        ++_full_rate_count;
+    } else {
+        ++_reduced_rate_count;
+        // The updates of the objects are spread on all the frames
+        if((_update_frame + index) % UPDATE_REDUCED_RATE_FRAMES != 0) {
+            object->_skipped_update_time += _update_time;
+            return;
+        }
+    }
+
+    if(object->_skipped_update_time == 0) {
+        object->Update();
+        return;
+    }
+
+    // Catch up with the time skipped by the reduced rate
+    SystemManager->SetUpdateTime(object->_skipped_update_time + _update_time);
+    object->_skipped_update_time = 0;
+    object->Update();
+    SystemManager->SetUpdateTime(_update_time);
+}
+
 void ObjectSupervisor::DrawSavePoints()
 {
     for(uint32 i = 0; i < _save_points.size(); ++i) {
@@ -1083,17 +1237,12 @@ MapObject *ObjectSupervisor::FindNearestInteractionObject(const VirtualSprite *s
 
     // A vector to hold objects which are inside the search area (either partially or fully)
     std::vector<MapObject *> valid_objects;
-    // A pointer to the vector of objects to search
-    std::vector<MapObject *>* search_vector = NULL;
 
-    // Only search the object layer that the sprite resides on.
+    // Only search the object layer that the sprite resides on, and only around the search area.
     // Note that we do not consider searching the pass layer.
-    if(sprite->sky_object)
-        search_vector = &_sky_objects;
-    else
-        search_vector = &_ground_objects;
+    _GetObjectsInArea(search_area, sprite->sky_object, _cell_query_results);
 
-    for(std::vector<MapObject *>::iterator it = (*search_vector).begin(); it != (*search_vector).end(); ++it) {
+    for(std::vector<MapObject *>::iterator it = _cell_query_results.begin(); it != _cell_query_results.end(); ++it) {
         if(*it == sprite)  // Don't allow the sprite itself to be considered in the search
             continue;
 
@@ -1219,17 +1368,45 @@ COLLISION_TYPE ObjectSupervisor::DetectCollision(VirtualSprite *sprite,
     // Get the collision rectangle at the given position
     MapRectangle sprite_rect = sprite->GetCollisionRectangle(x_pos, y_pos);
 
+    // Check the map boundaries and the collision grid.
+    // Note that sprites without collision won't get out of the map either.
+    if(_DetectGridCollision(sprite, sprite_rect) == WALL_COLLISION)
+        return WALL_COLLISION;
+
+    if(sprite->collision_mask == NO_COLLISION)
+        return NO_COLLISION;
+
+    // Only check the objects near the sprite
+    _GetObjectsInArea(sprite_rect, sprite->sky_object, _cell_query_results);
+
+    return _DetectObjectCollision(sprite, sprite_rect, _cell_query_results, collision_object_ptr);
+} // bool ObjectSupervisor::DetectCollision(VirtualSprite* sprite, float x, float y, MapObject** collision_object_ptr)
+
+
+
+COLLISION_TYPE ObjectSupervisor::DetectObjectCollision(VirtualSprite *sprite,
+        float x_pos, float y_pos,
+        MapObject **collision_object_ptr)
+{
+    if(!sprite || sprite->collision_mask == NO_COLLISION)
+        return NO_COLLISION;
+
+    MapRectangle sprite_rect = sprite->GetCollisionRectangle(x_pos, y_pos);
+    _GetObjectsInArea(sprite_rect, sprite->sky_object, _cell_query_results);
+
+    return _DetectObjectCollision(sprite, sprite_rect, _cell_query_results, collision_object_ptr);
+}
+
+
+
+COLLISION_TYPE ObjectSupervisor::_DetectGridCollision(const VirtualSprite *sprite, const MapRectangle &sprite_rect) const
+{
     // Check if any part of the object's collision rectangle is outside of the map boundary
     if(sprite_rect.left < 0.0f || sprite_rect.right >= static_cast<float>(_num_grid_x_axis) ||
             sprite_rect.top < 0.0f || sprite_rect.bottom >= static_cast<float>(_num_grid_y_axis)) {
         return WALL_COLLISION;
     }
 
-    // Check for the absence of collision checking after the map boundaries check,
-    // So that no collision beings won't get out of the map.
-    if(sprite->collision_mask == NO_COLLISION)
-        return NO_COLLISION;
-
     // Check if the object's collision rectangel overlaps with any unwalkable elements on the collision grid
     // Grid based collision is not done for objects in the sky layer
     if(!sprite->sky_object && sprite->collision_mask & WALL_COLLISION) {
@@ -1246,11 +1423,17 @@ COLLISION_TYPE ObjectSupervisor::DetectCollision(VirtualSprite *sprite,
         }
     }
 
-    std::vector<MapObject *>* objects = sprite->sky_object ?
-                                        &_sky_objects : &_ground_objects;
+    return NO_COLLISION;
+}
+
 
+
+COLLISION_TYPE ObjectSupervisor::_DetectObjectCollision(const VirtualSprite *sprite, const MapRectangle &sprite_rect,
+        const std::vector<MapObject *> &objects,
+        MapObject **collision_object_ptr)
+{
     std::vector<hoa_map::private_map::MapObject *>::const_iterator it, it_end;
-    for(it = objects->begin(), it_end = objects->end(); it != it_end; ++it) {
+    for(it = objects.begin(), it_end = objects.end(); it != it_end; ++it) {
         MapObject *collision_object = *it;
         // Check if the object exists and has the no_collision property enabled
         if(!collision_object || collision_object->collision_mask == NO_COLLISION)
@@ -1283,7 +1466,193 @@ COLLISION_TYPE ObjectSupervisor::DetectCollision(VirtualSprite *sprite,
     }
 
     return NO_COLLISION;
-} // bool ObjectSupervisor::DetectCollision(VirtualSprite* sprite, float x, float y, MapObject** collision_object_ptr)
+}
+
+
+void ObjectSupervisor::_AddObjectToLayer(MapObject *object, std::vector<MapObject *> &layer, bool &layer_unsorted)
+{
+    layer.push_back(object);
+    object->_layer_unsorted = &layer_unsorted;
+    layer_unsorted = true;
+}
+
+
+
+bool ObjectSupervisor::_SortLayer(std::vector<MapObject *> &layer, bool &layer_unsorted)
+{
+    if(!layer_unsorted)
+        return false;
+    layer_unsorted = false;
+
+    MapObject_Ptr_Less less;
+    bool changed = false;
+    for(uint32 i = 1; i < layer.size(); ++i) {
+        MapObject *object = layer[i];
+        uint32 j = i;
+        for(; j > 0 && less(object, layer[j - 1]); --j)
+            layer[j] = layer[j - 1];
+
+        if(j != i) {
+            layer[j] = object;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+
+
+void ObjectSupervisor::_IndexObject(MapObject *object, bool sky_layer)
+{
+    std::vector<MapObject *>& layer = sky_layer ? _sky_objects : _ground_objects;
+
+    object->_object_supervisor = this;
+    object->_object_cells = sky_layer ? &_sky_object_cells : &_ground_object_cells;
+    object->_layer_index = layer.size() - 1;
+
+    // The cells don't exist before the map grid is loaded. The object will be added to them then.
+    if(!object->_object_cells->empty())
+        _AddObjectToCells(object);
+}
+
+
+
+void ObjectSupervisor::_GetCellRange(const MapRectangle &rect, int32 &left, int32 &top, int32 &right, int32 &bottom) const
+{
+    // Use the rectangle bounds in any order, so that reversed rectangles still get the cells they may intersect
+    float min_x = rect.left < rect.right ? rect.left : rect.right;
+    float max_x = rect.left < rect.right ? rect.right : rect.left;
+    float min_y = rect.top < rect.bottom ? rect.top : rect.bottom;
+    float max_y = rect.top < rect.bottom ? rect.bottom : rect.top;
+
+    left = static_cast<int32>(min_x) / OBJECT_CELL_LENGTH;
+    right = static_cast<int32>(max_x) / OBJECT_CELL_LENGTH;
+    top = static_cast<int32>(min_y) / OBJECT_CELL_LENGTH;
+    bottom = static_cast<int32>(max_y) / OBJECT_CELL_LENGTH;
+
+    left = left < 0 ? 0 : (left >= _num_cell_x_axis ? _num_cell_x_axis - 1 : left);
+    right = right < 0 ? 0 : (right >= _num_cell_x_axis ? _num_cell_x_axis - 1 : right);
+    top = top < 0 ? 0 : (top >= _num_cell_y_axis ? _num_cell_y_axis - 1 : top);
+    bottom = bottom < 0 ? 0 : (bottom >= _num_cell_y_axis ? _num_cell_y_axis - 1 : bottom);
+}
+
+
+
+void ObjectSupervisor::_AddObjectToCells(MapObject *object)
+{
+    if(!object || !object->_object_cells || object->_object_cells->empty())
+        return;
+
+    _GetCellRange(object->GetCollisionRectangle(), object->_cell_left, object->_cell_top,
+                  object->_cell_right, object->_cell_bottom);
+
+    std::vector<std::vector<MapObject *> > &cells = *object->_object_cells;
+    for(int32 y = object->_cell_top; y <= object->_cell_bottom; ++y) {
+        for(int32 x = object->_cell_left; x <= object->_cell_right; ++x)
+            cells[x + y * _num_cell_x_axis].push_back(object);
+    }
+}
+
+
+
+void ObjectSupervisor::_RemoveObjectFromCells(MapObject *object)
+{
+    if(object->_cell_left < 0)
+        return;
+
+    std::vector<std::vector<MapObject *> > &cells = *object->_object_cells;
+    for(int32 y = object->_cell_top; y <= object->_cell_bottom; ++y) {
+        for(int32 x = object->_cell_left; x <= object->_cell_right; ++x) {
+            std::vector<MapObject *> &cell = cells[x + y * _num_cell_x_axis];
+            std::vector<MapObject *>::iterator it = std::find(cell.begin(), cell.end(), object);
+            if(it != cell.end()) {
+                // The order of the objects in a cell doesn't matter
+                *it = cell.back();
+                cell.pop_back();
+            }
+        }
+    }
+
+    object->_cell_left = -1;
+}
+
+
+
+void ObjectSupervisor::_UpdateObjectCells(MapObject *object)
+{
+    if(object->_cell_left < 0)
+        return;
+
+    int32 left, top, right, bottom;
+    _GetCellRange(object->GetCollisionRectangle(), left, top, right, bottom);
+
+    // Most moves happen within the same cells
+    if(left == object->_cell_left && top == object->_cell_top &&
+            right == object->_cell_right && bottom == object->_cell_bottom)
+        return;
+
+    _RemoveObjectFromCells(object);
+    _AddObjectToCells(object);
+}
+
+
+
+void ObjectSupervisor::_UpdateLayerIndices()
+{
+    for(uint32 i = 0; i < _ground_objects.size(); ++i)
+        _ground_objects[i]->_layer_index = i;
+    for(uint32 i = 0; i < _sky_objects.size(); ++i)
+        _sky_objects[i]->_layer_index = i;
+}
+
+
+
+bool ObjectSupervisor::_CompareLayerIndices(const MapObject *a, const MapObject *b)
+{
+    return a->_layer_index < b->_layer_index;
+}
+
+
+
+void ObjectSupervisor::_GetObjectsInArea(const MapRectangle &rect, bool sky_layer, std::vector<MapObject *> &objects)
+{
+    objects.clear();
+
+    std::vector<std::vector<MapObject *> > &cells = sky_layer ? _sky_object_cells : _ground_object_cells;
+
+    // Before the map grid is loaded, fall back to the whole layer
+    if(cells.empty()) {
+        objects = sky_layer ? _sky_objects : _ground_objects;
+        return;
+    }
+
+    // Objects overlapping several cells must only be returned once
+    if(++_cell_query_id == 0) {
+        for(uint32 i = 0; i < _ground_objects.size(); ++i)
+            _ground_objects[i]->_query_id = 0;
+        for(uint32 i = 0; i < _sky_objects.size(); ++i)
+            _sky_objects[i]->_query_id = 0;
+        _cell_query_id = 1;
+    }
+
+    int32 left, top, right, bottom;
+    _GetCellRange(rect, left, top, right, bottom);
+    for(int32 y = top; y <= bottom; ++y) {
+        for(int32 x = left; x <= right; ++x) {
+            std::vector<MapObject *> &cell = cells[x + y * _num_cell_x_axis];
+            for(uint32 i = 0; i < cell.size(); ++i) {
+                if(cell[i]->_query_id == _cell_query_id)
+                    continue;
+                cell[i]->_query_id = _cell_query_id;
+                objects.push_back(cell[i]);
+            }
+        }
+    }
+
+    // Keep the layer order, so that the results don't depend on the cells
+    std::sort(objects.begin(), objects.end(), _CompareLayerIndices);
+}
+
 
 
 Path ObjectSupervisor::FindPath(VirtualSprite *sprite, const MapPosition &destination)
@@ -1321,8 +1690,17 @@ Path ObjectSupervisor::FindPath(VirtualSprite *sprite, const MapPosition &destin
         return path;
     }
 
-    std::vector<PathNode> open_list;
-    std::vector<PathNode> closed_list;
+    // Prepare the node arrays for this search. They are only cleared when the search id wraps around.
+    const int32 grid_width = static_cast<int32>(_num_grid_x_axis);
+    const uint32 num_nodes = static_cast<uint32>(_num_grid_x_axis) * static_cast<uint32>(_num_grid_y_axis);
+    if(_path_open_ids.size() != num_nodes || ++_path_search_id == 0) {
+        _path_open_ids.assign(num_nodes, 0);
+        _path_closed_ids.assign(num_nodes, 0);
+        _path_g_scores.assign(num_nodes, 0);
+        _path_parents.assign(num_nodes, -1);
+        _path_search_id = 1;
+    }
+    _path_open_heap.clear();
 
     // The current "best node"
     PathNode best_node;
@@ -1334,21 +1712,35 @@ Path ObjectSupervisor::FindPath(VirtualSprite *sprite, const MapPosition &destin
     // The number to add to a node's g_score, depending on whether it is a lateral or diagonal movement
     int16 g_add;
 
-    open_list.push_back(source_node);
+    const int32 source_index = source_node.tile_x + source_node.tile_y * grid_width;
+    const int32 dest_index = dest.tile_x + dest.tile_y * grid_width;
+    _path_open_ids[source_index] = _path_search_id;
+    _path_g_scores[source_index] = 0;
+    _path_parents[source_index] = -1;
+    _path_open_heap.push_back(source_node);
 
     // We will try to keep the original offset all along.
     float offset_x = GetFloatFraction(destination.x);
     float offset_y = GetFloatFraction(destination.y);
 
-    while(open_list.empty() == false) {
-        sort(open_list.begin(), open_list.end());
-        best_node = open_list.back();
-        open_list.pop_back();
-        closed_list.push_back(best_node);
+    bool dest_reached = false;
+    while(_path_open_heap.empty() == false) {
+        // PathNode::operator< is reversed, so the heap top is the node with the lowest f score
+        std::pop_heap(_path_open_heap.begin(), _path_open_heap.end());
+        best_node = _path_open_heap.back();
+        _path_open_heap.pop_back();
+
+        // Nodes are pushed again when a better path to them is found, skip the outdated entries
+        int32 best_index = best_node.tile_x + best_node.tile_y * grid_width;
+        if(_path_closed_ids[best_index] == _path_search_id)
+            continue;
+        _path_closed_ids[best_index] = _path_search_id;
 
         // Check if destination has been reached, and break out of the loop if so
-        if(best_node == dest)
+        if(best_index == dest_index) {
+            dest_reached = true;
             break;
+        }
 
         // Setup the coordinates of the 8 adjacent nodes to the best node
         nodes[0].tile_x = best_node.tile_x - 1;
@@ -1370,19 +1762,31 @@ Path ObjectSupervisor::FindPath(VirtualSprite *sprite, const MapPosition &destin
 
         // Check the eight adjacent nodes
         for(uint8 i = 0; i < 8; ++i) {
-            // ---------- (A): Check if all tiles are walkable
+            if(nodes[i].tile_x < 0 || nodes[i].tile_x >= grid_width ||
+                    nodes[i].tile_y < 0 || nodes[i].tile_y >= static_cast<int32>(_num_grid_y_axis))
+                continue;
+
+            // ---------- (A): Check if the node is already in the closed list
+            int32 index = nodes[i].tile_x + nodes[i].tile_y * grid_width;
+            if(_path_closed_ids[index] == _path_search_id)
+                continue;
+
+            // ---------- (B): Check if all tiles are walkable
             // Don't use 0.0f here for both since errors at the border between
             // two positions may occure, especially when running.
-            COLLISION_TYPE collision_type = DetectCollision(sprite,
-                                            ((float)nodes[i].tile_x) + offset_x,
-                                            ((float)nodes[i].tile_y) + offset_y);
+            MapRectangle sprite_rect = sprite->GetCollisionRectangle(((float)nodes[i].tile_x) + offset_x,
+                                       ((float)nodes[i].tile_y) + offset_y);
 
             // Can't go through walls.
-            if(collision_type == WALL_COLLISION)
+            if(_DetectGridCollision(sprite, sprite_rect) == WALL_COLLISION)
                 continue;
 
-            // ---------- (B): Check if the node is already in the closed list
-            if(find(closed_list.begin(), closed_list.end(), nodes[i]) != closed_list.end())
+            COLLISION_TYPE collision_type = NO_COLLISION;
+            if(sprite->collision_mask != NO_COLLISION) {
+                _GetObjectsInArea(sprite_rect, sprite->sky_object, _cell_query_results);
+                collision_type = _DetectObjectCollision(sprite, sprite_rect, _cell_query_results);
+            }
+            if(collision_type == WALL_COLLISION)
                 continue;
 
             // ---------- (C): If this point has been reached, the node is valid for the sprite to move to
@@ -1399,39 +1803,33 @@ Path ObjectSupervisor::FindPath(VirtualSprite *sprite, const MapPosition &destin
                     || collision_type == ENEMY_COLLISION)
                 g_add += 20;
 
-            // Set the node's parent and calculate its g_score
-            nodes[i].parent_x = best_node.tile_x;
-            nodes[i].parent_y = best_node.tile_y;
-            nodes[i].g_score = best_node.g_score + g_add;
-
-            // ---------- (D): Check to see if the node is already on the open list and update it if necessary
-            std::vector<PathNode>::iterator iter = std::find(open_list.begin(), open_list.end(), nodes[i]);
-            if(iter != open_list.end()) {
-                // If its G is higher, it means that the path we are on is better, so switch the parent
-                if(iter->g_score > nodes[i].g_score) {
-                    iter->g_score = nodes[i].g_score;
-                    iter->f_score = nodes[i].g_score + iter->h_score;
-                    iter->parent_x = nodes[i].parent_x;
-                    iter->parent_y = nodes[i].parent_y;
-                }
-            }
-            // ---------- (E): Add the new node to the open list
-            else {
-                // Calculate the H and F score of the new node (the heuristic used is diagonal)
-                x_delta = abs(dest.tile_x - nodes[i].tile_x);
-                y_delta = abs(dest.tile_y - nodes[i].tile_y);
-                if(x_delta > y_delta)
-                    nodes[i].h_score = 14 * y_delta + 10 * (x_delta - y_delta);
-                else
-                    nodes[i].h_score = 14 * x_delta + 10 * (y_delta - x_delta);
-
-                nodes[i].f_score = nodes[i].g_score + nodes[i].h_score;
-                open_list.push_back(nodes[i]);
-            }
+            int32 g_score = _path_g_scores[best_index] + g_add;
+
+            // ---------- (D): Skip the node if it is already on the open list with a better score
+            if(_path_open_ids[index] == _path_search_id && _path_g_scores[index] <= g_score)
+                continue;
+
+            // ---------- (E): Add the node to the open list, or add it again with its new parent and score
+            _path_open_ids[index] = _path_search_id;
+            _path_g_scores[index] = g_score;
+            _path_parents[index] = best_index;
+
+            // Calculate the H and F score of the node (the heuristic used is diagonal)
+            x_delta = abs(dest.tile_x - nodes[i].tile_x);
+            y_delta = abs(dest.tile_y - nodes[i].tile_y);
+            if(x_delta > y_delta)
+                nodes[i].h_score = 14 * y_delta + 10 * (x_delta - y_delta);
+            else
+                nodes[i].h_score = 14 * x_delta + 10 * (y_delta - x_delta);
+
+            nodes[i].g_score = g_score;
+            nodes[i].f_score = nodes[i].g_score + nodes[i].h_score;
+            _path_open_heap.push_back(nodes[i]);
+            std::push_heap(_path_open_heap.begin(), _path_open_heap.end());
         } // for (uint8 i = 0; i < 8; ++i)
-    } // while (open_list.empty() == false)
+    } // while (_path_open_heap.empty() == false)
 
-    if(open_list.empty() == true) {
+    if(dest_reached == false) {
         IF_PRINT_WARNING(MAP_DEBUG) << "could not find path to destination" << std::endl;
         return path;
     }
@@ -1439,26 +1837,231 @@ Path ObjectSupervisor::FindPath(VirtualSprite *sprite, const MapPosition &destin
     // Add the destination node to the vector.
     path.push_back(destination);
 
-    // Retain the last node parent, and remove it from the closed list
-    int16 parent_x = best_node.parent_x;
-    int16 parent_y = best_node.parent_y;
-    closed_list.pop_back();
-
-    // Go backwards through the closed list following the parent nodes to construct the path
-    for(std::vector<PathNode>::iterator iter = closed_list.end() - 1; iter != closed_list.begin(); --iter) {
-        if(iter->tile_y == parent_y && iter->tile_x == parent_x) {
-            MapPosition next_pos(((float)iter->tile_x) + offset_x, ((float)iter->tile_y) + offset_y);
-            path.push_back(next_pos);
-
-            parent_x = iter->parent_x;
-            parent_y = iter->parent_y;
-        }
+    // Follow the parent nodes back to the source to construct the path
+    for(int32 index = _path_parents[dest_index]; index != source_index && index != -1; index = _path_parents[index]) {
+        MapPosition next_pos(((float)(index % grid_width)) + offset_x, ((float)(index / grid_width)) + offset_y);
+        path.push_back(next_pos);
     }
     std::reverse(path.begin(), path.end());
 
     return path;
 } // Path ObjectSupervisor::FindPath(const VirtualSprite* sprite, const MapPosition& destination)
 
+bool ObjectSupervisor::GetPursuitDirection(VirtualSprite *sprite, uint16 &direction)
+{
+    if(!sprite || !IsWithinMapBounds(sprite))
+        return false;
+
+    PursuitField &field = _UpdatePursuitField(sprite);
+    if(field.target < 0 || !(sprite->context & field.context))
+        return false;
+
+    const int32 grid_width = static_cast<int32>(_num_grid_x_axis);
+    int32 x = static_cast<int32>(sprite->GetXPosition());
+    int32 y = static_cast<int32>(sprite->GetYPosition());
+    int32 index = x + y * grid_width;
+
+    // A sprite standing against a wall may not fit on its own grid element,
+    // it then heads to the nearest neighbour element it fits on
+    bool reached = (field.field_ids[index] == field.field_id);
+    int32 best_distance = reached ? field.distances[index] : 0;
+    int32 best_x = 0;
+    int32 best_y = 0;
+    for(int32 delta_y = -1; delta_y <= 1; ++delta_y) {
+        for(int32 delta_x = -1; delta_x <= 1; ++delta_x) {
+            if(!_IsPursuitStepFree(field, x, y, delta_x, delta_y))
+                continue;
+
+            int32 next_index = index + delta_x + delta_y * grid_width;
+            if(field.field_ids[next_index] != field.field_id)
+                continue;
+
+            if(!reached || field.distances[next_index] < best_distance) {
+                reached = true;
+                best_distance = field.distances[next_index];
+                best_x = delta_x;
+                best_y = delta_y;
+            }
+        }
+    }
+
+    // Out of range, walled off from the camera, or already on its grid element
+    if(best_x == 0 && best_y == 0)
+        return false;
+
+    if(best_x == 0)
+        direction = best_y < 0 ? NORTH : SOUTH;
+    else if(best_y == 0)
+        direction = best_x < 0 ? WEST : EAST;
+    else if(best_x < 0)
+        direction = best_y < 0 ? MOVING_NORTHWEST : MOVING_SOUTHWEST;
+    else
+        direction = best_y < 0 ? MOVING_NORTHEAST : MOVING_SOUTHEAST;
+    return true;
+} // bool ObjectSupervisor::GetPursuitDirection(VirtualSprite *sprite, uint16 &direction)
+
+
+
+PursuitField &ObjectSupervisor::_UpdatePursuitField(const VirtualSprite *sprite)
+{
+    // Find the field of the sprite collision box, or create it
+    PursuitField *field = NULL;
+    for(uint32 i = 0; i < _pursuit_fields.size(); ++i) {
+        PursuitField &existing = _pursuit_fields[i];
+        if(existing.coll_half_width == sprite->coll_half_width && existing.coll_height == sprite->coll_height
+                && existing.collision_mask == sprite->collision_mask && existing.sky_object == sprite->sky_object) {
+            field = &existing;
+            break;
+        }
+    }
+    if(!field) {
+        _pursuit_fields.push_back(PursuitField());
+        field = &_pursuit_fields.back();
+        field->coll_half_width = sprite->coll_half_width;
+        field->coll_height = sprite->coll_height;
+        field->collision_mask = sprite->collision_mask;
+        field->sky_object = sprite->sky_object;
+    }
+
+    VirtualSprite *camera = MapMode::CurrentInstance()->GetCamera();
+    if(!IsWithinMapBounds(camera)) {
+        field->target = -1;
+        return *field;
+    }
+
+    const int32 grid_width = static_cast<int32>(_num_grid_x_axis);
+    const int32 target_x = static_cast<int32>(camera->GetXPosition());
+    const int32 target_y = static_cast<int32>(camera->GetYPosition());
+    const int32 target = target_x + target_y * grid_width;
+    const uint32 num_nodes = static_cast<uint32>(_num_grid_x_axis) * static_cast<uint32>(_num_grid_y_axis);
+
+    // The field stays valid as long as the camera stays on the same grid element
+    if(target == field->target && camera->context == field->context && field->field_ids.size() == num_nodes)
+        return *field;
+
+    // Like the path finding nodes, the elements are only cleared when the field id wraps around
+    if(field->field_ids.size() != num_nodes || ++field->field_id == 0) {
+        field->field_ids.assign(num_nodes, 0);
+        field->distances.assign(num_nodes, 0);
+        field->tested_ids.assign(num_nodes, 0);
+        field->free_elements.assign(num_nodes, 0);
+        field->field_id = 1;
+    }
+    field->target = target;
+    field->context = camera->context;
+
+    // Dijkstra's algorithm, from the camera to all the elements in range
+    std::greater<std::pair<int32, int32> > heap_order;
+    _pursuit_open_heap.clear();
+    field->field_ids[target] = field->field_id;
+    field->distances[target] = 0;
+    _pursuit_open_heap.push_back(std::make_pair(0, target));
+
+    while(!_pursuit_open_heap.empty()) {
+        std::pop_heap(_pursuit_open_heap.begin(), _pursuit_open_heap.end(), heap_order);
+        int32 distance = _pursuit_open_heap.back().first;
+        int32 index = _pursuit_open_heap.back().second;
+        _pursuit_open_heap.pop_back();
+
+        // Elements are pushed again when a shorter way to them is found, skip the outdated entries
+        if(distance > field->distances[index])
+            continue;
+
+        int32 x = index % grid_width;
+        int32 y = index / grid_width;
+        for(int32 delta_y = -1; delta_y <= 1; ++delta_y) {
+            for(int32 delta_x = -1; delta_x <= 1; ++delta_x) {
+                if(abs(x + delta_x - target_x) > PURSUIT_FIELD_RANGE || abs(y + delta_y - target_y) > PURSUIT_FIELD_RANGE)
+                    continue;
+                if(!_IsPursuitStepFree(*field, x, y, delta_x, delta_y))
+                    continue;
+
+                int32 next_index = index + delta_x + delta_y * grid_width;
+                int32 next_distance = distance + (delta_x != 0 && delta_y != 0 ? 14 : 10);
+                if(field->field_ids[next_index] == field->field_id && field->distances[next_index] <= next_distance)
+                    continue;
+
+                field->field_ids[next_index] = field->field_id;
+                field->distances[next_index] = next_distance;
+                _pursuit_open_heap.push_back(std::make_pair(next_distance, next_index));
+                std::push_heap(_pursuit_open_heap.begin(), _pursuit_open_heap.end(), heap_order);
+            }
+        }
+    }
+
+    return *field;
+} // PursuitField &ObjectSupervisor::_UpdatePursuitField(const VirtualSprite *sprite)
+
+
+
+bool ObjectSupervisor::_IsPursuitElementFree(PursuitField &field, int32 x, int32 y)
+{
+    int32 index = x + y * static_cast<int32>(_num_grid_x_axis);
+    if(field.tested_ids[index] == field.field_id)
+        return field.free_elements[index] != 0;
+    field.tested_ids[index] = field.field_id;
+    field.free_elements[index] = 0;
+
+    // Test the chaser collision rectangle like DetectCollision() does, but in the field context
+    MapRectangle rect;
+    rect.left = static_cast<float>(x) + 0.5f - field.coll_half_width;
+    rect.right = static_cast<float>(x) + 0.5f + field.coll_half_width;
+    rect.top = static_cast<float>(y) + 0.5f - field.coll_height;
+    rect.bottom = static_cast<float>(y) + 0.5f;
+
+    if(rect.left < 0.0f || rect.right >= static_cast<float>(_num_grid_x_axis) ||
+            rect.top < 0.0f || rect.bottom >= static_cast<float>(_num_grid_y_axis))
+        return false;
+
+    if(!field.sky_object && field.collision_mask & WALL_COLLISION) {
+        for(uint32 grid_y = static_cast<uint32>(rect.top); grid_y <= static_cast<uint32>(rect.bottom); ++grid_y) {
+            for(uint32 grid_x = static_cast<uint32>(rect.left); grid_x <= static_cast<uint32>(rect.right); ++grid_x) {
+                if(_collision_grid[grid_y][grid_x] & field.context)
+                    return false;
+            }
+        }
+    }
+
+    // Only the objects which don't move are taken in account, the sprites are walked around when met
+    if(field.collision_mask & WALL_COLLISION) {
+        _GetObjectsInArea(rect, field.sky_object, _cell_query_results);
+        for(uint32 i = 0; i < _cell_query_results.size(); ++i) {
+            MapObject *object = _cell_query_results[i];
+            if(object->collision_mask == NO_COLLISION || !(object->context & field.context))
+                continue;
+            if(GetCollisionFromObjectType(object) == WALL_COLLISION && CheckObjectCollision(rect, object))
+                return false;
+        }
+    }
+
+    field.free_elements[index] = 1;
+    return true;
+}
+
+
+
+bool ObjectSupervisor::_IsPursuitStepFree(PursuitField &field, int32 x, int32 y, int32 delta_x, int32 delta_y)
+{
+    if(delta_x == 0 && delta_y == 0)
+        return false;
+
+    int32 next_x = x + delta_x;
+    int32 next_y = y + delta_y;
+    if(next_x < 0 || next_x >= static_cast<int32>(_num_grid_x_axis) ||
+            next_y < 0 || next_y >= static_cast<int32>(_num_grid_y_axis))
+        return false;
+
+    if(!_IsPursuitElementFree(field, next_x, next_y))
+        return false;
+
+    // Don't cut the wall corners
+    if(delta_x != 0 && delta_y != 0)
+        return _IsPursuitElementFree(field, next_x, y) && _IsPursuitElementFree(field, x, next_y);
+    return true;
+}
+
+
+
 void ObjectSupervisor::ReloadVisiblePartyMember()
 {
     // Don't do anything when there is no visible party member.
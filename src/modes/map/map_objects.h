@@ -20,6 +20,11 @@
 
 #include "modes/map/map_treasure.h"
 
+namespace hoa_common
+{
+class MapBinaryData;
+}
+
 namespace hoa_map
 {
 
@@ -58,6 +63,8 @@ namespace private_map
 *** ***************************************************************************/
 class MapObject
 {
+    friend class ObjectSupervisor;
+
 public:
     MapObject();
 
@@ -142,6 +149,11 @@ public:
     *** in the pass layer can be both walked over and walked under by sprites in the ground layer.
     **/
     bool draw_on_second_pass;
+
+    /** \brief When true, the object is updated every frame, even far from the screen or out of
+    *** the active context (default == false). See ObjectSupervisor::Update().
+    **/
+    bool always_updated;
     //@}
 
     // ---------- Methods
@@ -173,6 +185,12 @@ public:
     bool ShouldDraw();
     //@}
 
+    /** \brief Returns the position the object is drawn at
+    *** This is between the positions of the object at the last two map updates, as far as the
+    *** frame drawn is between them, so that the object moves smoothly at any frame rate.
+    **/
+    MapPosition GetDrawPosition() const;
+
     //! \brief Retrieves the object type identifier
     MAP_OBJECT_TYPE GetObjectType() const {
         return _object_type;
@@ -215,18 +233,14 @@ public:
         context = ctxt;
     }
 
-    void SetPosition(float x, float y) {
-        position.x = x;
-        position.y = y;
-    }
+    /** \note The position and collision setters keep the object spatial index and layer order up to date.
+    *** The position setters place the object: it isn't drawn moving from its former position.
+    **/
+    void SetPosition(float x, float y);
 
-    void SetXPosition(float x) {
-        position.x = x;
-    }
+    void SetXPosition(float x);
 
-    void SetYPosition(float y) {
-        position.y = y;
-    }
+    void SetYPosition(float y);
 
     void SetImgHalfWidth(float width) {
         img_half_width = width;
@@ -236,13 +250,9 @@ public:
         img_height = height;
     }
 
-    void SetCollHalfWidth(float collision) {
-        coll_half_width = collision;
-    }
+    void SetCollHalfWidth(float collision);
 
-    void SetCollHeight(float collision) {
-        coll_height = collision;
-    }
+    void SetCollHeight(float collision);
 
     void SetUpdatable(bool update) {
         updatable = update;
@@ -261,6 +271,10 @@ public:
         draw_on_second_pass = pass;
     }
 
+    void SetAlwaysUpdated(bool always) {
+        always_updated = always;
+    }
+
     int16 GetObjectID() const {
         return object_id;
     }
@@ -313,6 +327,10 @@ public:
         return draw_on_second_pass;
     }
 
+    bool IsAlwaysUpdated() const {
+        return always_updated;
+    }
+
     MAP_OBJECT_TYPE GetType() const {
         return _object_type;
     }
@@ -347,6 +365,50 @@ protected:
 
     //! \brief Takes care of drawing the emote animation.
     void _DrawEmote();
+
+    /** \brief Moves the object to a new position, drawing it between its former and new positions
+    *** Unlike SetPosition(), which places the object, this keeps the position of the last update
+    *** for the drawing code to interpolate from.
+    **/
+    void _MovePosition(float x, float y);
+
+private:
+    /** \brief The position of the object at the previous map update.
+    *** \note The position setters also set it, so that the object is drawn at its new place at once.
+    **/
+    MapPosition _previous_position;
+
+    //! \brief Saves the current position as the previous one, at the start of each map update.
+    void _SavePreviousPosition() {
+        _previous_position = position;
+    }
+
+    /** \name Spatial Index Members
+    *** Used by the object supervisor to find the objects near a map area
+    *** without going through a whole object layer.
+    **/
+    //@{
+    //! \brief The object supervisor indexing this object, or NULL if the object isn't indexed.
+    ObjectSupervisor *_object_supervisor;
+
+    //! \brief The spatial index cells of the object layer, or NULL if the object isn't indexed.
+    std::vector<std::vector<MapObject *> > *_object_cells;
+
+    //! \brief The range of cells the object is registered in. _cell_left is -1 when it is in no cell.
+    int32 _cell_left, _cell_top, _cell_right, _cell_bottom;
+
+    //! \brief The index of the object in its layer container, used to return objects in layer order.
+    uint32 _layer_index;
+
+    //! \brief The id of the last spatial index query which returned this object.
+    uint32 _query_id;
+    //@}
+
+    //! \brief The flag telling the object layer must be sorted again, or NULL if the object isn't in a layer.
+    bool *_layer_unsorted;
+
+    //! \brief The time elapsed since the last update of the object, when it is updated at a reduced rate.
+    uint32 _skipped_update_time;
 }; // class MapObject
 
 
@@ -762,6 +824,7 @@ class ObjectSupervisor
     friend class hoa_map::MapMode;
     // TEMP: for allowing context zones to access all objects
     friend class hoa_map::private_map::ContextZone;
+    friend class MapObject;
     friend void hoa_defs::BindModeCode();
 
 public:
@@ -800,20 +863,30 @@ public:
     **/
     VirtualSprite *GetSprite(uint32 object_id);
 
-    //! \brief Sorts objects on all three layers according to their draw order
+    /** \brief Sorts objects on all the layers according to their draw order
+    *** Only the layers where objects were added or moved vertically since the last call
+    *** are sorted, with an insertion sort which is about linear as they are almost sorted.
+    **/
     void SortObjects();
 
     /** \brief Loads the collision grid data and saved state of all map objects
     *** \param map_file A reference to the open map script file
+    *** \param map_data The map binary data, read instead of the Lua collision grid when not NULL
     *** \return Whether the collision data loading was successful.
     ***
     *** The file must be open prior to making this call and additionally must
     *** be at the highest level scope (i.e., there are no actively open tables
     *** in the script descriptor object).
     **/
-    bool Load(hoa_script::ReadScriptDescriptor &map_file);
-
-    //! \brief Updates the state of all map zones and objects
+    bool Load(hoa_script::ReadScriptDescriptor &map_file, const hoa_common::MapBinaryData &map_data);
+
+    /** \brief Updates the state of all map zones and objects
+    *** To save the time spent on the objects which can't be seen, each object is updated:
+    *** - every frame, when near the screen or always_updated, or controlled by an event,
+    *** - every UPDATE_REDUCED_RATE_FRAMES frames, with the time elapsed since its last update, when farther away,
+    *** - not at all, while out of the active context.
+    *** The number of objects at each rate is given to the frame profiler.
+    **/
     void Update();
 
     /** \brief Draws the various object layers to the screen
@@ -887,19 +960,46 @@ public:
     COLLISION_TYPE DetectCollision(VirtualSprite *sprite, float x, float y,
                                    MapObject **collision_object_ptr = NULL);
 
+    /** \brief Tells the collision type of a sprite with the other objects when it is at the given position
+    *** \param sprite A pointer to the map sprite to check
+    *** \param x The collision point on the x axis
+    *** \param y The collision point on the y axis
+    *** \param coll_obj A pointer to the MapObject that the sprite has collided with, if any
+    *** \return The type of collision detected, which may include NO_COLLISION
+    ***
+    *** Unlike DetectCollision(), the map bounds and collision grid are not checked. This is meant
+    *** for positions already known to be free of walls.
+    **/
+    COLLISION_TYPE DetectObjectCollision(VirtualSprite *sprite, float x, float y,
+                                         MapObject **collision_object_ptr = NULL);
+
     /** \brief Finds a path from a sprite's current position to a destination
     *** \param sprite A pointer of the sprite to find the path for
     *** \param dest The destination coordinates
     *** \param path A vector of PathNode objects storing the path
     ***
     *** This algorithm uses the A* algorithm to find a path from a source to a destination.
-    *** This function ignores the position of all other objects and only concerns itself with
-    *** which map grid elements are walkable.
+    *** Walls and physical objects block the path, while other sprites only make it more costly.
+    *** The open list is a binary heap and the node data is stored in flat arrays indexed by
+    *** collision grid element, which are kept between calls.
     ***
     *** \note If an error is detected or a path could not be found, the function will empty the path vector before returning
     **/
     Path FindPath(private_map::VirtualSprite *sprite, const MapPosition &destination);
 
+    /** \brief Gives the direction a sprite should take to reach the camera, using the pursuit flow field
+    *** \param sprite A pointer to the sprite chasing the camera
+    *** \param direction Set to the direction toward the next grid element on the way, when one was found
+    *** \return False if the sprite isn't linked to the camera by the flow field, or is already on its grid element
+    ***
+    *** The flow field holds the walking distance to the camera of every grid element around it, in the
+    *** camera context. It is shared by all the sprites chasing the camera with the same collision box,
+    *** so that each of them only looks at the distances of its neighbour elements. The field is computed
+    *** again only when the camera enters another grid element or context, and only up to
+    *** PURSUIT_FIELD_RANGE grid elements away. The other sprites are ignored, as they keep moving.
+    **/
+    bool GetPursuitDirection(private_map::VirtualSprite *sprite, uint16 &direction);
+
     /** \brief Returns the pointer to the virtual focus.
     **/
     private_map::VirtualSprite *VirtualFocus() {
@@ -927,6 +1027,16 @@ public:
     **/
     void SetAllEnemyStatesToDead();
 
+    //! \brief Returns the number of collision grid elements along the x axis.
+    uint16 GetGridXAxis() const {
+        return _num_grid_x_axis;
+    }
+
+    //! \brief Returns the number of collision grid elements along the y axis.
+    uint16 GetGridYAxis() const {
+        return _num_grid_y_axis;
+    }
+
     //! \brief Tells whether the collision coords are valid.
     bool IsWithinMapBounds(float x, float y) const;
 
@@ -946,6 +1056,103 @@ private:
     //! \brief Debug: Draws the map zones in orange
     void _DrawMapZones();
 
+    /** \brief Tells whether a sprite collision rectangle is outside of the map or overlaps unwalkable grid elements
+    *** \param sprite A pointer to the map sprite to check
+    *** \param sprite_rect The collision rectangle of the sprite at the position to check
+    *** \return WALL_COLLISION if so, NO_COLLISION otherwise
+    **/
+    COLLISION_TYPE _DetectGridCollision(const VirtualSprite *sprite, const MapRectangle &sprite_rect) const;
+
+    /** \brief Adds an object to the spatial index of a collision layer
+    *** \param object A pointer to the object, which must be the last one added to its layer container
+    *** \param sky_layer Whether the object was added to the sky layer rather than to the ground layer
+    **/
+    void _IndexObject(MapObject *object, bool sky_layer);
+
+    /** \brief Computes the range of spatial index cells covered by a rectangle
+    *** The cell coordinates are clamped to the map, so that out of bounds objects and areas still
+    *** share cells with the objects they may intersect.
+    **/
+    void _GetCellRange(const MapRectangle &rect, int32 &left, int32 &top, int32 &right, int32 &bottom) const;
+
+    //! \brief Registers the object in the cells covered by its collision rectangle.
+    void _AddObjectToCells(MapObject *object);
+
+    //! \brief Removes the object from the cells it is registered in.
+    void _RemoveObjectFromCells(MapObject *object);
+
+    //! \brief Moves the object to the cells covered by its collision rectangle, if they changed.
+    void _UpdateObjectCells(MapObject *object);
+
+    //! \brief Updates the layer index of the ground and sky objects, after sorting them.
+    void _UpdateLayerIndices();
+
+    /** \brief Computes the pursuit flow field fitting a sprite again if the camera changed its grid element or context
+    *** \param sprite The sprite chasing the camera
+    *** \return The field of the sprite collision box, created on first use
+    **/
+    private_map::PursuitField &_UpdatePursuitField(const VirtualSprite *sprite);
+
+    /** \brief Updates an object at the rate fitting its position, see Update()
+    *** \param object The object to update
+    *** \param index The index of the object in its container, which spreads the reduced rate updates on several frames
+    **/
+    void _UpdateObject(MapObject *object, uint32 index);
+
+    /** \brief Tells whether a chaser collision rectangle centered on a grid element overlaps no wall or physical object
+    *** \param field The pursuit field giving the chaser properties and context
+    *** \param x, y The grid element to test, which must be within the map bounds
+    *** The result is kept in the field until its next computation.
+    **/
+    bool _IsPursuitElementFree(private_map::PursuitField &field, int32 x, int32 y);
+
+    /** \brief Tells whether a chaser can step from a grid element to a neighbour one in a pursuit field
+    *** \param field The pursuit field giving the chaser properties and context
+    *** \param x, y The grid element to step from
+    *** \param delta_x, delta_y The step, from -1 to 1 on each axis
+    *** Diagonal steps are only allowed when both the lateral steps are, so that they don't cut wall corners.
+    **/
+    bool _IsPursuitStepFree(private_map::PursuitField &field, int32 x, int32 y, int32 delta_x, int32 delta_y);
+
+    /** \brief Adds an object at the end of a layer container, which will be sorted on the next SortObjects() call
+    *** \param object The object to add
+    *** \param layer The layer container to add it to
+    *** \param layer_unsorted The flag telling this layer must be sorted again
+    **/
+    void _AddObjectToLayer(MapObject *object, std::vector<MapObject *> &layer, bool &layer_unsorted);
+
+    /** \brief Sorts a layer container in draw order if its flag tells it is needed, and clears the flag
+    *** \return True if any object of the layer changed place
+    ***
+    *** The layers are almost sorted, as only a few objects move between two calls, which makes
+    *** an insertion sort much faster than std::sort(). It is also stable, so objects on the same
+    *** line don't swap places.
+    **/
+    static bool _SortLayer(std::vector<MapObject *> &layer, bool &layer_unsorted);
+
+    //! \brief Sorts map objects on their position in their layer container.
+    static bool _CompareLayerIndices(const MapObject *a, const MapObject *b);
+
+    /** \brief Finds the objects of a collision layer which may intersect a given area
+    *** \param rect The area to look for objects in
+    *** \param sky_layer Whether to look in the sky layer rather than in the ground layer
+    *** \param objects Filled with the objects registered in the cells covered by the area, in layer order
+    *** Only the objects whose collision rectangle may intersect the area are returned, so that looping
+    *** through them gives the same results as looping through the whole layer container.
+    **/
+    void _GetObjectsInArea(const MapRectangle &rect, bool sky_layer, std::vector<MapObject *> &objects);
+
+    /** \brief Tells the collision type of a sprite collision rectangle against the given objects
+    *** \param sprite A pointer to the map sprite to check
+    *** \param sprite_rect The collision rectangle of the sprite at the position to check
+    *** \param objects The objects the sprite may collide with
+    *** \param collision_object_ptr A pointer to the MapObject that the sprite has collided with, if any
+    *** \return The type of collision detected, which may include NO_COLLISION
+    **/
+    COLLISION_TYPE _DetectObjectCollision(const VirtualSprite *sprite, const MapRectangle &sprite_rect,
+                                          const std::vector<MapObject *> &objects,
+                                          MapObject **collision_object_ptr = NULL);
+
     /** \brief The number of rows and columns in the collision gride
     *** The number of collision grid rows and columns is always equal to twice
     *** that of the number of rows and columns of tiles (stored in the TileManager).
@@ -978,6 +1185,79 @@ private:
     **/
     std::vector<std::vector<uint32> > _collision_grid;
 
+    /** \name Path Finding Members
+    *** The node data used by FindPath(), stored in flat arrays indexed by collision grid element
+    *** (x + y * _num_grid_x_axis). An element only holds valid data when its search id is the one of the
+    *** current search, so that the arrays never need to be cleared between two calls.
+    **/
+    //@{
+    //! \brief The id of the last path search, incremented by each FindPath() call.
+    uint32 _path_search_id;
+
+    //! \brief The id of the search which last reached each node.
+    std::vector<uint32> _path_open_ids;
+
+    //! \brief The id of the search which last closed each node.
+    std::vector<uint32> _path_closed_ids;
+
+    //! \brief The best known g score of each node.
+    std::vector<int32> _path_g_scores;
+
+    //! \brief The index of the parent of each node.
+    std::vector<int32> _path_parents;
+
+    //! \brief The open list, used as a binary heap sorted on the node f scores.
+    std::vector<PathNode> _path_open_heap;
+
+    //@}
+
+    /** \name Pursuit Flow Field Members
+    *** The walking distances to the camera used by GetPursuitDirection().
+    **/
+    //@{
+    //! \brief The fields of each chaser collision box met on the map.
+    std::vector<private_map::PursuitField> _pursuit_fields;
+
+    //! \brief The open list of the computation, as a binary heap of (distance, grid element) pairs.
+    std::vector<std::pair<int32, int32> > _pursuit_open_heap;
+    //@}
+
+    /** \name Update Rate Members
+    *** Used by Update() to choose the update rate of each object.
+    **/
+    //@{
+    //! \brief The number of calls to Update(), which tells the objects at reduced rate when to update.
+    uint32 _update_frame;
+
+    //! \brief The time elapsed since the last Update() call, in milliseconds.
+    uint32 _update_time;
+
+    //! \brief The map area where the objects are updated every frame: the screen with a margin around it.
+    MapRectangle _full_rate_area;
+
+    //! \brief The number of objects updated at full rate, at reduced rate, and sleeping during the current Update() call.
+    uint32 _full_rate_count, _reduced_rate_count, _sleeping_count;
+    //@}
+
+    /** \name Object Spatial Index Members
+    *** The map is divided into cells of OBJECT_CELL_LENGTH grid elements. Each cell holds the objects of
+    *** the ground or sky layer whose collision rectangle overlaps it, and is updated when objects move.
+    **/
+    //@{
+    //! \brief The number of cells on each axis.
+    int32 _num_cell_x_axis, _num_cell_y_axis;
+
+    //! \brief The ground and sky object cells, stored like this: _object_cells[x + y * _num_cell_x_axis]
+    std::vector<std::vector<MapObject *> > _ground_object_cells;
+    std::vector<std::vector<MapObject *> > _sky_object_cells;
+
+    //! \brief The id of the last spatial index query, used to return each object only once.
+    uint32 _cell_query_id;
+
+    //! \brief The objects found by the last spatial index query made by the supervisor itself.
+    std::vector<MapObject *> _cell_query_results;
+    //@}
+
     /** \brief A map containing pointers to all of the sprites on a map.
     *** This map does not include a pointer to the _virtual_focus object. The
     *** sprite's unique identifier integer is used as the map key.
@@ -1013,6 +1293,16 @@ private:
     **/
     std::vector<MapObject *> _sky_objects;
 
+    /** \name Layer Sort Flags
+    *** Set when an object was added to the layer or moved vertically, so that only these layers are sorted.
+    **/
+    //@{
+    bool _flat_ground_unsorted;
+    bool _ground_unsorted;
+    bool _pass_unsorted;
+    bool _sky_unsorted;
+    //@}
+
     //! \brief Containers for all of the map source of light, quite similar as the ground objects container.
     //! \note Halos and lights are not registered in _all_objects.
     std::vector<Halo *> _halos;
@@ -300,7 +300,7 @@ void VirtualSprite::_SetNextPosition()
     }
 
     // Make the sprite advance at the end
-    SetPosition(next_pos_x, next_pos_y);
+    _MovePosition(next_pos_x, next_pos_y);
     moved_position = true;
 }
 
@@ -1226,7 +1226,12 @@ void EnemySprite::Update()
             // the NULL check MUST come before the rest or a null pointer exception could happen if no zone is registered
             if(MapMode::CurrentInstance()->AttackAllowed()
                     && (_zone == NULL || (can_get_out_of_zone || _zone->IsInsideZone(camera_x, camera_y)))) {
-                if(xdelta > -0.5 && xdelta < 0.5 && ydelta < 0)
+                // Follow the shared pursuit field around the walls, and head straight to the camera
+                // when it's out of the field range or on the same grid element
+                uint16 pursuit_direction = 0;
+                if(MapMode::CurrentInstance()->GetObjectSupervisor()->GetPursuitDirection(this, pursuit_direction))
+                    SetDirection(pursuit_direction);
+                else if(xdelta > -0.5 && xdelta < 0.5 && ydelta < 0)
                     SetDirection(SOUTH);
                 else if(xdelta > -0.5 && xdelta < 0.5 && ydelta > 0)
                     SetDirection(NORTH);
@@ -19,7 +19,12 @@
 
 #include "engine/video/video.h"
 
+#include "common/map_binary.h"
+
+#include <algorithm>
+
 using namespace hoa_utils;
+using namespace hoa_common;
 using namespace hoa_script;
 using namespace hoa_video;
 
@@ -108,7 +113,9 @@ TileSupervisor::TileSupervisor() :
     _num_tile_on_x_axis(0),
     _num_tile_on_y_axis(0),
     _ctxt_layers(0),
-    _current_context(MAP_CONTEXT_NONE)
+    _current_context(MAP_CONTEXT_NONE),
+    _num_chunks_on_x_axis(0),
+    _num_chunks_on_y_axis(0)
 {}
 
 TileSupervisor::~TileSupervisor()
@@ -121,6 +128,9 @@ TileSupervisor::~TileSupervisor()
     _tile_grid.clear();
     _tile_images.clear();
     _animated_tile_images.clear();
+    _tile_animation_ids.clear();
+    _animated_tile_frames.clear();
+    _layer_chunks.clear();
 }
 
 static LAYER_TYPE getLayerType(const std::string &type)
@@ -133,19 +143,16 @@ static LAYER_TYPE getLayerType(const std::string &type)
 }
 
 
-bool TileSupervisor::Load(ReadScriptDescriptor &map_file)
+bool TileSupervisor::Load(ReadScriptDescriptor &map_file, const MapBinaryData &map_data)
 {
-    // Load the map dimensions and do some basic sanity checks
-    _num_tile_on_y_axis = map_file.ReadInt("num_tile_rows");
-    _num_tile_on_x_axis = map_file.ReadInt("num_tile_cols");
+    // Load the map dimensions
+    _num_tile_on_y_axis = map_data.num_tile_rows;
+    _num_tile_on_x_axis = map_data.num_tile_cols;
 
     std::vector<int32> context_inherits;
-    //map_file.ReadUIntVector("context_inherits", context_inherits);
-    map_file.OpenTable("contexts");
-    uint32 num_contexts = map_file.GetTableSize();
+    uint32 num_contexts = map_data.context_inherits.size();
     for(uint32 context_id = 0;  context_id < num_contexts; ++context_id) {
-        map_file.OpenTable(context_id);
-        int32 inheritance = map_file.ReadInt("inherit_from");
+        int32 inheritance = map_data.context_inherits[context_id];
 
         // The base context can't inherit from another one
         if(context_id == 0)
@@ -156,10 +163,7 @@ bool TileSupervisor::Load(ReadScriptDescriptor &map_file)
             inheritance = -1;
 
         context_inherits.push_back(inheritance);
-
-        map_file.CloseTable();
     }
-    map_file.CloseTable(); // contexts
 
     // Load all of the tileset images that are used by this map
 
@@ -188,11 +192,6 @@ bool TileSupervisor::Load(ReadScriptDescriptor &map_file)
         }
     }
 
-    if(!map_file.DoesTableExist("layers")) {
-        PRINT_ERROR << "No 'layers' table in the map file." << std::endl;
-        return false;
-    }
-
     // Read in the map tile indeces from all tile layers for the base context
     // The indeces stored for the map layers in this file directly correspond to a location within a tileset. Tilesets contain a total of 256 tiles
     // each, so 0-255 correspond to the first tileset, 256-511 the second, etc. The tile location within the tileset is also determined by the index,
@@ -202,78 +201,32 @@ bool TileSupervisor::Load(ReadScriptDescriptor &map_file)
     _tile_grid.clear();
     _tile_grid.insert(std::make_pair(MAP_CONTEXT_01, Context()));
 
-    std::vector<int32> table_x_indeces; // Used to temporarily store a row of table indeces
-
-    map_file.OpenTable("layers");
-
-    uint32 layers_number = map_file.GetTableSize();
-
-    // layers[0]-[n]
+    // The map data already has the right size, so the tiles can be copied row by row
+    uint32 layers_number = map_data.layer_tiles.size();
     for(uint32 layer_id = 0; layer_id < layers_number; ++layer_id) {
-        // Opens the sub-table: layers[layer_id]
-        if(!map_file.DoesTableExist(layer_id))
-            continue;
-
-        map_file.OpenTable(layer_id);
-
-        // Add a layer for the base context
         _tile_grid[MAP_CONTEXT_01].resize(layer_id + 1);
 
-        LAYER_TYPE layer_type = getLayerType(map_file.ReadString("type"));
+        LAYER_TYPE layer_type = getLayerType(map_data.layer_types[layer_id]);
 
         if(layer_type == INVALID_LAYER) {
             PRINT_WARNING << "Ignoring unexisting layer type: " << layer_type
                           << " in file: " << map_file.GetFilename() << std::endl;
-            map_file.CloseTable(); // layers[i]
             continue;
         }
 
         _tile_grid[MAP_CONTEXT_01][layer_id].layer_type = layer_type;
-
-        // Add the new tile rows (y axis)
         _tile_grid[MAP_CONTEXT_01][layer_id].tiles.resize(_num_tile_on_y_axis);
 
-        // Read the tile data
-        for(uint32 y = 0; y < _num_tile_on_y_axis; ++y) {
-            table_x_indeces.clear();
-
-            // Check to make sure tables are of the proper size
-            if(!map_file.DoesTableExist(y)) {
-                PRINT_ERROR << "the layers[" << layer_id << "] table size was not equal to the number of tile rows specified by the map, "
-                            " first missing row: " << y << std::endl;
-                return false;
-            }
-
-            map_file.ReadIntVector(y, table_x_indeces);
-
-            // Check the number of columns
-            if(table_x_indeces.size() != _num_tile_on_x_axis) {
-                PRINT_ERROR << "the layers[" << layer_id << "][" << y << "] table size was not equal to the number of tile columns specified by the map, "
-                            "should have " << _num_tile_on_x_axis << " values." << std::endl;
-                return false;
-            }
-
-            // Prepare the columns (x axis)
-            _tile_grid[MAP_CONTEXT_01][layer_id].tiles[y].resize(_num_tile_on_x_axis);
-
-            for(uint32 x = 0; x < _num_tile_on_x_axis; ++x) {
-                _tile_grid[MAP_CONTEXT_01][layer_id].tiles[y][x] = table_x_indeces[x];
-            }
-        }
-        map_file.CloseTable(); // layers[layer_id]
+        std::vector<int32>::const_iterator row = map_data.layer_tiles[layer_id].begin();
+        for(uint32 y = 0; y < _num_tile_on_y_axis; ++y, row += _num_tile_on_x_axis)
+            _tile_grid[MAP_CONTEXT_01][layer_id].tiles[y].assign(row, row + _num_tile_on_x_axis);
     }
 
-    map_file.CloseTable(); // layers
-
     // Create each additional context for the map by loading its table data
 
     // Load the tile data for each additional map context
     for(uint32 ctxt = 1; ctxt < num_contexts; ++ctxt) {
         MAP_CONTEXT this_context = static_cast<MAP_CONTEXT>(1 << ctxt);
-        std::string context_name = "context_";
-        if(ctxt < 10)  // precede single digit context names with a zero
-            context_name += "0";
-        context_name += NumberToString(ctxt);
 
         // Check wether the context inhjeritance id is lower than the current one.
         if(context_inherits[ctxt] >= (int32)ctxt) {
@@ -312,8 +265,7 @@ bool TileSupervisor::Load(ReadScriptDescriptor &map_file)
         // and third represent the row and column of the tile respectively, and the fourth value indicates which tile image should be used for this context.
         // So if the first four entries in the context table were {0, 12, 26, 180}, this would set the lower layer tile at position (12, 26) to the tile
         // index 180.
-        std::vector<int32> context_data;
-        map_file.ReadIntVector(context_name, context_data);
+        const std::vector<int32> &context_data = map_data.context_data[ctxt];
         if(context_data.size() % 4 != 0) {
             PRINT_WARNING <<  ", context data was not evenly divisible by four (incomplete context data)"
                           << " in context: " << this_context << std::endl;
@@ -452,12 +404,15 @@ bool TileSupervisor::Load(ReadScriptDescriptor &map_file)
                 // Add the tile as a StillImage
                 if(tile_animations.find(reference) == tile_animations.end()) {
                     _tile_images.push_back(new StillImage(tileset_images[i][j]));
+                    _tile_animation_ids.push_back(-1);
                 }
 
                 // Add the tile as an AnimatedImage
                 else {
                     _tile_images.push_back(tile_animations[reference]);
+                    _tile_animation_ids.push_back(static_cast<int32>(_animated_tile_images.size()));
                     _animated_tile_images.push_back(tile_animations[reference]);
+                    _animated_tile_frames.push_back(tile_animations[reference]->GetCurrentFrameIndex());
                     tile_animations.erase(reference);
                 }
             }
@@ -471,6 +426,10 @@ bool TileSupervisor::Load(ReadScriptDescriptor &map_file)
     // Remove all tileset images. Any tiles which were not added to _tile_images will no longer exist in memory
     tileset_images.clear();
 
+    // The layers are drawn by chunks of TILE_CHUNK_SIZE * TILE_CHUNK_SIZE tiles
+    _num_chunks_on_x_axis = (_num_tile_on_x_axis + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE;
+    _num_chunks_on_y_axis = (_num_tile_on_y_axis + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE;
+
     return true;
 } // bool TileSupervisor::Load(ReadScriptDescriptor& map_file)
 
@@ -478,8 +437,12 @@ bool TileSupervisor::Load(ReadScriptDescriptor &map_file)
 
 void TileSupervisor::Update()
 {
+    // Tells whether at least one animated tile changed its frame
+    bool frame_changed = false;
     for(uint32 i = 0; i < _animated_tile_images.size(); i++) {
         _animated_tile_images[i]->Update();
+        if(_animated_tile_images[i]->GetCurrentFrameIndex() != _animated_tile_frames[i])
+            frame_changed = true;
     }
 
     // When the context changes, reset the layers pointer
@@ -492,7 +455,35 @@ void TileSupervisor::Update()
         else
             _ctxt_layers = 0;
         _current_context = context;
+
+        // Every chunk will be rebuilt anyway
+        _ResetChunks();
+        frame_changed = false;
     }
+
+    if(!frame_changed)
+        return;
+
+    // Only the chunks using an animation that changed its frame need to be rebuilt
+    for(uint32 layer_id = 0; layer_id < _layer_chunks.size(); ++layer_id) {
+        std::vector<LayerChunk> &chunks = _layer_chunks[layer_id];
+        for(uint32 i = 0; i < chunks.size(); ++i) {
+            LayerChunk &chunk = chunks[i];
+            if(chunk.dirty)
+                continue;
+
+            for(uint32 j = 0; j < chunk.animated_tiles.size(); ++j) {
+                uint32 anim_id = chunk.animated_tiles[j];
+                if(_animated_tile_images[anim_id]->GetCurrentFrameIndex() != _animated_tile_frames[anim_id]) {
+                    chunk.dirty = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    for(uint32 i = 0; i < _animated_tile_images.size(); i++)
+        _animated_tile_frames[i] = _animated_tile_images[i]->GetCurrentFrameIndex();
 }
 
 
@@ -505,8 +496,51 @@ void TileSupervisor::DrawLayers(const MapFrame *frame, const LAYER_TYPE &layer_t
     VideoManager->SetDrawFlags(VIDEO_BLEND, VIDEO_X_LEFT, VIDEO_Y_TOP, 0);
 
     // Map frame ends
-    uint32 y_end = static_cast<uint32>(frame->tile_y_start + frame->num_draw_y_axis);
     uint32 x_end = static_cast<uint32>(frame->tile_x_start + frame->num_draw_x_axis);
+    uint32 y_end = static_cast<uint32>(frame->tile_y_start + frame->num_draw_y_axis);
+    if(x_end > _num_tile_on_x_axis)
+        x_end = _num_tile_on_x_axis;
+    if(y_end > _num_tile_on_y_axis)
+        y_end = _num_tile_on_y_axis;
+    if(frame->tile_x_start < 0 || frame->tile_y_start < 0
+            || static_cast<uint32>(frame->tile_x_start) >= x_end
+            || static_cast<uint32>(frame->tile_y_start) >= y_end) {
+        VideoManager->SetDrawFlags(VIDEO_X_CENTER, VIDEO_Y_BOTTOM, 0);
+        return;
+    }
+
+    uint16 chunk_x_start = static_cast<uint16>(frame->tile_x_start) / TILE_CHUNK_SIZE;
+    uint16 chunk_y_start = static_cast<uint16>(frame->tile_y_start) / TILE_CHUNK_SIZE;
+    uint16 chunk_x_end = (x_end - 1) / TILE_CHUNK_SIZE;
+    uint16 chunk_y_end = (y_end - 1) / TILE_CHUNK_SIZE;
+
+    // The chunk vertices are expressed in map tile units, where the tile (x, y) top-left corner
+    // is at (x * 2, y * 2). So we move the cursor at the position of the tile (0, 0).
+    // We substract 1.0 horizontally and 2.0 vertically here because the tiles positions
+    // are given from their top left coordinates, while the frame offsets are given
+    // from the bottom center point, as the engine does for everything else.
+    const CoordSys &coord_sys = VideoManager->GetCoordSys();
+    float x_shake, y_shake;
+    VideoManager->GetShakeOffsets(x_shake, y_shake);
+    VideoManager->Move(frame->tile_x_offset - 1.0f - static_cast<float>(frame->tile_x_start * 2)
+                       + x_shake * coord_sys.GetHorizontalDirection(),
+                       frame->tile_y_offset - 2.0f - static_cast<float>(frame->tile_y_start * 2)
+                       + y_shake * coord_sys.GetVerticalDirection());
+
+    // The chunks are drawn directly through OpenGL
+    VideoManager->FlushSprites();
+
+    // Set up the GL state once for all the layer chunks
+    VideoManager->EnableBlending();
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // Normal blending
+    VideoManager->EnableTexture2D();
+    VideoManager->EnableVertexArray();
+    VideoManager->EnableTextureCoordArray();
+    VideoManager->DisableColorArray();
+
+    // Apply the screen fading modulation as the still images would
+    float modulation = VideoManager->GetFadeModulation();
+    glColor4f(modulation, modulation, modulation, 1.0f);
 
     for(uint32 layer_id = 0; layer_id < _ctxt_layers->size(); ++layer_id) {
 
@@ -514,27 +548,127 @@ void TileSupervisor::DrawLayers(const MapFrame *frame, const LAYER_TYPE &layer_t
         if(layer.layer_type != layer_type)
             continue;
 
-        // We substract 0.5 horizontally and 1.0 vertically here
-        // because the video engine will display the map tiles using their
-        // top left coordinates to avoid a position computation flaw when specifying the tile
-        // coordinates from the bottom center point, as the engine does for everything else.
-        VideoManager->Move(frame->tile_x_offset - 1.0f, frame->tile_y_offset - 2.0f);
-
-        for(uint32 y = static_cast<uint32>(frame->tile_y_start); y < y_end; ++y) {
-            for(uint32 x = static_cast<uint32>(frame->tile_x_start); x < x_end; ++x) {
-                // Draw a tile image if it exists at this location
-                if(layer.tiles[y][x] >= 0)
-                    _tile_images[ layer.tiles[y][x] ]->Draw();
-
-                VideoManager->MoveRelative(2.0f, 0.0f);
-            } // x
-            VideoManager->MoveRelative(-static_cast<float>(frame->num_draw_x_axis * 2), 2.0f);
-        } // y
+        if(_layer_chunks.size() <= layer_id)
+            continue;
+
+        std::vector<LayerChunk> &chunks = _layer_chunks[layer_id];
+
+        for(uint16 chunk_y = chunk_y_start; chunk_y <= chunk_y_end; ++chunk_y) {
+            for(uint16 chunk_x = chunk_x_start; chunk_x <= chunk_x_end; ++chunk_x) {
+                LayerChunk &chunk = chunks[chunk_y * _num_chunks_on_x_axis + chunk_x];
+                if(chunk.dirty)
+                    _BuildChunk(layer, chunk_x, chunk_y, chunk);
+
+                for(uint32 i = 0; i < chunk.batches.size(); ++i) {
+                    LayerChunk::SheetBatch &batch = chunk.batches[i];
+
+                    TextureManager->_BindTexture(batch.sheet->tex_id);
+                    batch.sheet->Smooth(batch.smooth);
+
+                    glVertexPointer(2, GL_FLOAT, 0, &batch.vertices[0]);
+                    glTexCoordPointer(2, GL_FLOAT, 0, &batch.tex_coords[0]);
+                    glDrawArrays(GL_QUADS, 0, batch.vertices.size() / 2);
+                }
+            } // chunk_x
+        } // chunk_y
     } // layer_id
+
     // Restore the previous draw flags
     VideoManager->SetDrawFlags(VIDEO_X_CENTER, VIDEO_Y_BOTTOM, 0);
 }
 
+
+void TileSupervisor::_ResetChunks()
+{
+    _layer_chunks.clear();
+    if(!_ctxt_layers)
+        return;
+
+    _layer_chunks.resize(_ctxt_layers->size());
+    for(uint32 layer_id = 0; layer_id < _layer_chunks.size(); ++layer_id)
+        _layer_chunks[layer_id].resize(_num_chunks_on_x_axis * _num_chunks_on_y_axis);
+}
+
+
+void TileSupervisor::_BuildChunk(const Layer &layer, uint16 chunk_x, uint16 chunk_y, LayerChunk &chunk)
+{
+    chunk.batches.clear();
+    chunk.animated_tiles.clear();
+    chunk.dirty = false;
+
+    uint32 x_start = chunk_x * TILE_CHUNK_SIZE;
+    uint32 y_start = chunk_y * TILE_CHUNK_SIZE;
+    uint32 x_end = std::min<uint32>(x_start + TILE_CHUNK_SIZE, _num_tile_on_x_axis);
+    uint32 y_end = std::min<uint32>(y_start + TILE_CHUNK_SIZE, _num_tile_on_y_axis);
+
+    for(uint32 y = y_start; y < y_end; ++y) {
+        for(uint32 x = x_start; x < x_end; ++x) {
+            int16 tile_id = layer.tiles[y][x];
+            if(tile_id < 0)
+                continue;
+
+            // Get the still image currently representing the tile
+            const StillImage *image = 0;
+            int32 anim_id = _tile_animation_ids[tile_id];
+            if(anim_id < 0) {
+                image = static_cast<const StillImage *>(_tile_images[tile_id]);
+            } else {
+                image = _animated_tile_images[anim_id]->GetCurrentFrame();
+                if(std::find(chunk.animated_tiles.begin(), chunk.animated_tiles.end(),
+                             static_cast<uint32>(anim_id)) == chunk.animated_tiles.end())
+                    chunk.animated_tiles.push_back(static_cast<uint32>(anim_id));
+            }
+
+            if(!image || !image->_image_texture)
+                continue;
+
+            const private_video::ImageTexture *texture = image->_image_texture;
+
+            // Find the batch corresponding to the tile texture sheet
+            LayerChunk::SheetBatch *batch = 0;
+            for(uint32 i = 0; i < chunk.batches.size(); ++i) {
+                if(chunk.batches[i].sheet == texture->texture_sheet && chunk.batches[i].smooth == image->_smooth) {
+                    batch = &chunk.batches[i];
+                    break;
+                }
+            }
+            if(!batch) {
+                chunk.batches.push_back(LayerChunk::SheetBatch());
+                batch = &chunk.batches.back();
+                batch->sheet = texture->texture_sheet;
+                batch->smooth = image->_smooth;
+            }
+
+            // Compute the texture coordinates the same way ImageDescriptor::_DrawTexture() does
+            float s0 = texture->u1 + (image->_u1 * (texture->u2 - texture->u1));
+            float s1 = texture->u1 + (image->_u2 * (texture->u2 - texture->u1));
+            float t0 = texture->v1 + (image->_v1 * (texture->v2 - texture->v1));
+            float t1 = texture->v1 + (image->_v2 * (texture->v2 - texture->v1));
+
+            // The tile top-left corner, in map tile units
+            float left = static_cast<float>(x * 2);
+            float top = static_cast<float>(y * 2);
+            float right = left + image->_width;
+            float bottom = top + image->_height;
+
+            const float vertices[] = {
+                left, bottom,
+                right, bottom,
+                right, top,
+                left, top
+            };
+            const float tex_coords[] = {
+                s0, t1,
+                s1, t1,
+                s1, t0,
+                s0, t0
+            };
+            batch->vertices.insert(batch->vertices.end(), vertices, vertices + 8);
+            batch->tex_coords.insert(batch->tex_coords.end(), tex_coords, tex_coords + 8);
+        } // x
+    } // y
+}
+
 } // namespace private_map
 
 } // namespace hoa_map
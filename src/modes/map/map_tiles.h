@@ -23,6 +23,11 @@
 
 #include "engine/script/script_read.h"
 
+namespace hoa_common
+{
+class MapBinaryData;
+}
+
 namespace hoa_map
 {
 
@@ -53,6 +58,56 @@ public:
 // A map context - A map file can have several, but at least one.
 typedef std::vector<Layer> Context;
 
+//! \brief The number of tiles on each side of a layer chunk.
+const uint16 TILE_CHUNK_SIZE = 16;
+
+/** ****************************************************************************
+*** \brief Cached draw data for a square block of tiles of a single layer.
+***
+*** The tiles of a chunk are grouped by the texture sheet they are stored in,
+*** so that drawing a chunk only costs one draw call per texture sheet used.
+*** The data is only rebuilt when the chunk is marked dirty, i.e. when one of its
+*** animated tiles changes its frame, or when the map context changes.
+*** ***************************************************************************/
+class LayerChunk
+{
+public:
+    //! \brief The vertex and texture coordinates of all the tiles stored in one texture sheet.
+    class SheetBatch
+    {
+    public:
+        SheetBatch():
+            sheet(NULL),
+            smooth(true)
+        {}
+
+        //! \brief The texture sheet containing the tiles of this batch.
+        hoa_video::private_video::TexSheet *sheet;
+
+        //! \brief Whether the texture sheet should be smoothed when drawing this batch.
+        bool smooth;
+
+        //! \brief Four (x, y) vertices per tile, in map tile units.
+        std::vector<float> vertices;
+
+        //! \brief Four (u, v) texture coordinates per tile.
+        std::vector<float> tex_coords;
+    };
+
+    LayerChunk():
+        dirty(true)
+    {}
+
+    //! \brief One batch per texture sheet used by the chunk tiles.
+    std::vector<SheetBatch> batches;
+
+    //! \brief The indeces (in the animated tile images vector) of the animations used in the chunk.
+    std::vector<uint32> animated_tiles;
+
+    //! \brief Tells whether the cached data must be rebuilt before the next draw.
+    bool dirty;
+};
+
 /** ****************************************************************************
 *** \brief A helper class to MapMode responsible for all tile data and operations
 ***
@@ -74,9 +129,10 @@ public:
 
     /** \brief Handles all operations on loading tilesets and tile images from the map data file
     *** \param map_file A reference to the Lua file containing the map data
+    *** \param map_data The map binary data, read instead of the Lua layers and contexts when not NULL
     *** \note The map file should already be opened with no Lua tables open
     **/
-    bool Load(hoa_script::ReadScriptDescriptor &map_file);
+    bool Load(hoa_script::ReadScriptDescriptor &map_file, const hoa_common::MapBinaryData &map_data);
 
     //! \brief Updates all animated tile images
     void Update();
@@ -124,6 +180,31 @@ private:
     *** _tile_images vector, which contains both still and animated images.
     **/
     std::vector<hoa_video::AnimatedImage *> _animated_tile_images;
+
+    //! \brief The index of each tile image in _animated_tile_images, or -1 for still tile images.
+    std::vector<int32> _tile_animation_ids;
+
+    //! \brief The frame index of each animated tile image, as used when the chunks were last built.
+    std::vector<uint32> _animated_tile_frames;
+
+    //! \brief The number of chunks on the x and y axis of each layer.
+    uint16 _num_chunks_on_x_axis, _num_chunks_on_y_axis;
+
+    /** \brief The cached draw data of the current context layers.
+    *** _layer_chunks[layer_id][chunk_y * _num_chunks_on_x_axis + chunk_x] is the chunk at (chunk_x, chunk_y).
+    **/
+    std::vector<std::vector<LayerChunk> > _layer_chunks;
+
+    //! \brief Marks all the chunks of the current context layers for rebuilding.
+    void _ResetChunks();
+
+    /** \brief Rebuilds the cached draw data of a single chunk.
+    *** \param layer The layer the chunk belongs to
+    *** \param chunk_x The chunk column
+    *** \param chunk_y The chunk row
+    *** \param chunk The chunk to rebuild
+    **/
+    void _BuildChunk(const Layer &layer, uint16 chunk_x, uint16 chunk_y, LayerChunk &chunk);
 }; // class TileSupervisor
 
 } // namespace private_map
@@ -52,6 +52,21 @@ const uint16 HALF_TILES_ON_Y_AXIS = TILES_ON_Y_AXIS / 2;
 
 const uint16 GRID_LENGTH = 32; // Length of a grid element in pixels
 const uint16 TILE_LENGTH = GRID_LENGTH * 2; // Length of a tile in pixels
+
+const uint16 OBJECT_CELL_LENGTH = 4; // Length of an object spatial index cell, in grid elements
+const int32 PURSUIT_FIELD_RANGE = 48; // Distance from the camera the enemies pursuit field reaches, in grid elements
+
+const float UPDATE_FULL_RATE_MARGIN = 8.0f; // Distance from the screen within which objects are updated every frame, in grid elements
+const uint32 UPDATE_REDUCED_RATE_FRAMES = 4; // Number of frames between two updates of the objects farther from the screen
+//@}
+
+
+/** \name Map Cache Limits
+*** \brief The limits of the recently left maps kept loaded, see MapMode::LoadMap()
+**/
+//@{
+const uint32 MAP_CACHE_SIZE = 3; // Largest number of maps in the map cache
+const uint32 MAP_CACHE_TEXTURE_MEMORY = 64 * 1024 * 1024; // Memory of the images only used by the cached maps above which they are deleted, in bytes
 //@}
 
 
@@ -397,6 +412,55 @@ public:
     }
 }; // class PathNode
 
+/** \brief The walking distances to the camera of the grid elements around it, for one chaser collision box
+*** The distances are 10 per lateral step and 14 per diagonal step, as in the path finding. A grid element
+*** is only reached when the chaser collision rectangle, centered on it, overlaps neither the walls nor the
+*** physical objects. The data is stored like the path finding node data, and only cleared when the
+*** field id wraps around.
+**/
+class PursuitField
+{
+public:
+    PursuitField() :
+        coll_half_width(0.0f),
+        coll_height(0.0f),
+        collision_mask(0),
+        sky_object(false),
+        target(-1),
+        context(MAP_CONTEXT_NONE),
+        field_id(0)
+    {}
+
+    //! \name Chaser Properties
+    //@{
+    //! \brief The collision box and collision properties of the sprites using the field.
+    float coll_half_width, coll_height;
+    uint32 collision_mask;
+    bool sky_object;
+    //@}
+
+    //! \brief The grid element of the camera when the field was computed, or -1 if it wasn't.
+    int32 target;
+
+    //! \brief The context the field was computed in.
+    MAP_CONTEXT context;
+
+    //! \brief The id of the last field computation, incremented each time the field is computed.
+    uint32 field_id;
+
+    //! \brief The id of the computation which last reached each grid element.
+    std::vector<uint32> field_ids;
+
+    //! \brief The walking distance to the camera of each grid element.
+    std::vector<int32> distances;
+
+    //! \brief The id of the computation which last tested whether the chaser fits on each grid element.
+    std::vector<uint32> tested_ids;
+
+    //! \brief Whether the chaser fits on each grid element, valid when tested during the last computation.
+    std::vector<uint8> free_elements;
+}; // class PursuitField
+
 struct MapVector {
     MapVector() :
         x(0.0f),
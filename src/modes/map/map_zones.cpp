@@ -84,16 +84,6 @@ void MapZone::Draw()
     }
 }
 
-void MapZone::_RandomPosition(float &x, float &y)
-{
-    // Select a random ZoneSection
-    uint16 i = RandomBoundedInteger(0, _sections.size() - 1);
-
-    // Select a random x and y position inside that section
-    x = (float)RandomBoundedInteger(_sections[i].left_col, _sections[i].right_col);
-    y = (float)RandomBoundedInteger(_sections[i].top_row, _sections[i].bottom_row);
-}
-
 bool MapZone::_ShouldDraw(const ZoneSection &section)
 {
     MapMode *map = MapMode::CurrentInstance();
@@ -306,6 +296,7 @@ EnemyZone::EnemyZone(const EnemyZone &copy) :
     _active_enemies = copy._active_enemies;
     _spawn_timer = copy._spawn_timer;
     _dead_timer = copy._dead_timer;
+    _spawn_positions = copy._spawn_positions;
     if(copy._spawn_zone == NULL)
         _spawn_zone = NULL;
     else
@@ -330,6 +321,7 @@ EnemyZone &EnemyZone::operator=(const EnemyZone &copy)
     _active_enemies = copy._active_enemies;
     _spawn_timer = copy._spawn_timer;
     _dead_timer = copy._dead_timer;
+    _spawn_positions = copy._spawn_positions;
     if(copy._spawn_zone == NULL)
         _spawn_zone = NULL;
     else
@@ -423,13 +415,51 @@ void EnemyZone::EnemyDead()
 
 
 
+const std::vector<MapPosition> &EnemyZone::_GetSpawnPositions(EnemySprite *enemy)
+{
+    for(uint32 i = 0; i < _spawn_positions.size(); ++i) {
+        if(_spawn_positions[i].contexts == enemy->GetContext()
+                && _spawn_positions[i].coll_half_width == enemy->GetCollHalfWidth()
+                && _spawn_positions[i].coll_height == enemy->GetCollHeight())
+            return _spawn_positions[i].positions;
+    }
+
+    _spawn_positions.push_back(SpawnPositions());
+    SpawnPositions &spawn_positions = _spawn_positions.back();
+    spawn_positions.contexts = enemy->GetContext();
+    spawn_positions.coll_half_width = enemy->GetCollHalfWidth();
+    spawn_positions.coll_height = enemy->GetCollHeight();
+
+    // Only the walls, which never move, are looked for: the map grid, and the physical objects
+    ObjectSupervisor *object_supervisor = MapMode::CurrentInstance()->GetObjectSupervisor();
+    uint32 collision_mask = enemy->collision_mask;
+    enemy->collision_mask = WALL_COLLISION;
+
+    const std::vector<ZoneSection> &sections = HasSeparateSpawnZone() ? _spawn_zone->_sections : _sections;
+    for(uint32 i = 0; i < sections.size(); ++i) {
+        for(uint16 y = sections[i].top_row; y <= sections[i].bottom_row; ++y) {
+            for(uint16 x = sections[i].left_col; x <= sections[i].right_col; ++x) {
+                if(object_supervisor->DetectCollision(enemy, x, y) == NO_COLLISION)
+                    spawn_positions.positions.push_back(MapPosition(x, y));
+            }
+        }
+    }
+    enemy->collision_mask = collision_mask;
+
+    if(spawn_positions.positions.empty()) {
+        PRINT_WARNING << "No free spawning position for an enemy in an enemy zone of map: "
+                      << MapMode::CurrentInstance()->GetMapFilename() << std::endl;
+    }
+    return spawn_positions.positions;
+}
+
+
+
 void EnemyZone::Update()
 {
-    // When spawning an enemy in a random zone location, sometimes it is occupied by another
-    // object or that section is unwalkable. We try only a few different spawn locations before
-    // giving up and waiting for the next call to Update(). Otherwise this function could
-    // potentially take a noticable amount of time to complete
-    const int8 SPAWN_RETRIES = 50;
+    // When spawning an enemy at a random free position, sometimes it is occupied by another
+    // sprite. We try only a few different spawn positions before waiting for the next call to Update().
+    const int8 SPAWN_RETRIES = 10;
 
     // Test whether a respawn is still permitted
     if (_spawns_left == 0)
@@ -472,30 +502,23 @@ void EnemyZone::Update()
         }
     }
 
-    // Used to retain random position coordinates in the zone
-    float x = 0.0f;
-    float y = 0.0f;
     // Number of times to try finding a valid spawning location
     int8 retries = SPAWN_RETRIES;
     // Holds the result of a collision detection check
     uint32 collision = NO_COLLISION;
 
-    // Select a random position inside the zone to place the spawning enemy
+    // Select a random free position inside the zone to place the spawning enemy
     _enemies[index]->collision_mask = WALL_COLLISION | CHARACTER_COLLISION;
-    MapZone *spawning_zone = NULL;
-    if (!HasSeparateSpawnZone()) {
-        spawning_zone = this;
-    } else {
-        spawning_zone = _spawn_zone;
-    }
-    // If there is a collision, retry a different location
+    const std::vector<MapPosition> &spawn_positions = _GetSpawnPositions(_enemies[index]);
+    if(spawn_positions.empty())
+        return;
+
+    // If another object is there, retry a different position
+    ObjectSupervisor *object_supervisor = MapMode::CurrentInstance()->GetObjectSupervisor();
     do {
-        spawning_zone->_RandomPosition(x, y);
-        _enemies[index]->SetPosition(x, y);
-        collision = MapMode::CurrentInstance()->GetObjectSupervisor()->DetectCollision(_enemies[index],
-                    _enemies[index]->GetXPosition(),
-                    _enemies[index]->GetYPosition(),
-                    NULL);
+        const MapPosition &position = spawn_positions[RandomBoundedInteger(0, spawn_positions.size() - 1)];
+        _enemies[index]->SetPosition(position.x, position.y);
+        collision = object_supervisor->DetectObjectCollision(_enemies[index], position.x, position.y);
     } while (collision != NO_COLLISION && --retries > 0);
 
     // Otherwise, spawn the enemy and reset the spawn timer
@@ -508,10 +531,6 @@ void EnemyZone::Update()
         _spawn_timer.Run();
         _enemies[index]->ChangeStateSpawning();
         ++_active_enemies;
-    } else {
-        PRINT_WARNING << "Couldn't spawn a monster within " << SPAWN_RETRIES
-                      << " tries. Check the enemy zones of map:"
-                      << MapMode::CurrentInstance()->GetMapFilename() << std::endl;
     }
 } // void EnemyZone::Update()
 
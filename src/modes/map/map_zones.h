@@ -142,12 +142,6 @@ protected:
     //! \brief The rectangular sections which compose the map zone
     std::vector<ZoneSection> _sections;
 
-    /** \brief Returns random x, y position coordinates within the zone
-    *** \param x A reference where to store the value of the x position
-    *** \param y A reference where to store the value of the x position
-    **/
-    void _RandomPosition(float &x, float &y);
-
     //! \brief Tells whether a section is on screen and place the drawing cursor in that case.
     bool _ShouldDraw(const ZoneSection &section);
 }; // class MapZone
@@ -500,7 +494,10 @@ public:
     //! \brief Decrements the number of active enemies by one
     void EnemyDead();
 
-    //! \brief Gradually spawns enemy sprites in the zone
+    /** \brief Gradually spawns enemy sprites in the zone
+    *** The enemies spawn at random positions where they don't collide with anything. Those which may
+    *** only be blocked by walls are found once, so that each spawn only needs a few collision checks.
+    **/
     void Update();
 
     //! \brief Draw the zone on screen for debugging purpose
@@ -586,6 +583,27 @@ private:
     *** \note These sprites will be deleted by the map object manager, not the destructor of this class.
     **/
     std::vector<EnemySprite *> _enemies;
+
+    //! \brief The positions of the spawning sections where an enemy collision box is on free ground
+    struct SpawnPositions {
+        //! \brief The collision box and contexts of the enemies using these positions
+        MAP_CONTEXT contexts;
+        float coll_half_width;
+        float coll_height;
+
+        std::vector<MapPosition> positions;
+    };
+
+    /** \brief The spawning positions of each kind of enemy of the zone
+    *** The positions are searched on the first spawn, once the map grid and zone sections are all loaded.
+    *** Only the objects which may have moved on them since then have to be checked when spawning.
+    **/
+    std::vector<SpawnPositions> _spawn_positions;
+
+    /** \brief Returns the positions of the spawning sections where an enemy doesn't collide with
+    *** the map grid or physical objects, searching them if not already done for its collision box
+    **/
+    const std::vector<MapPosition> &_GetSpawnPositions(EnemySprite *enemy);
 }; // class EnemyZone : public MapZone
 
 
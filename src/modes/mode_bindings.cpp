@@ -99,6 +99,7 @@ void BindModeCode()
             .def("AddSavePoint", &MapMode::AddSavePoint)
             .def("AddHalo", &MapMode::AddHalo)
             .def("AddLight", &MapMode::AddLight)
+            .def("PrefetchMap", &MapMode::PrefetchMap)
             .def("SetCamera", (void(MapMode:: *)(private_map::VirtualSprite *))&MapMode::SetCamera)
             .def("SetCamera", (void(MapMode:: *)(private_map::VirtualSprite *, uint32))&MapMode::SetCamera)
             .def("MoveVirtualFocus", (void(MapMode:: *)(float, float))&MapMode::MoveVirtualFocus)
@@ -190,7 +191,9 @@ void BindModeCode()
                 luabind::value("ENEMY_SPEED", static_cast<uint32>(ENEMY_SPEED)),
                 luabind::value("FAST_SPEED", static_cast<uint32>(FAST_SPEED)),
                 luabind::value("VERY_FAST_SPEED", static_cast<uint32>(VERY_FAST_SPEED))
-            ]
+            ],
+
+            luabind::def("FlushMapCache", &MapMode::FlushMapCache)
         ];
 
         luabind::module(hoa_script::ScriptManager->GetGlobalState(), "hoa_map")
@@ -221,6 +224,7 @@ void BindModeCode()
             .def("SetVisible", &MapObject::SetVisible)
             .def("SetCollisionMask", &MapObject::SetCollisionMask)
             .def("SetDrawOnSecondPass", &MapObject::SetDrawOnSecondPass)
+            .def("SetAlwaysUpdated", &MapObject::SetAlwaysUpdated)
             .def("GetObjectID", &MapObject::GetObjectID)
             .def("GetContext", &MapObject::GetContext)
             .def("GetXPosition", &MapObject::GetXPosition)
@@ -233,6 +237,7 @@ void BindModeCode()
             .def("IsVisible", &MapObject::IsVisible)
             .def("GetCollisionMask", &MapObject::GetCollisionMask)
             .def("IsDrawOnSecondPass", &MapObject::IsDrawOnSecondPass)
+            .def("IsAlwaysUpdated", &MapObject::IsAlwaysUpdated)
             .def("Emote", &MapObject::Emote)
         ];
 
@@ -845,6 +845,18 @@ bool DeleteFile(const std::string &filename)
 
 
 
+uint64_t ComputeChecksum(const std::vector<char> &data)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for(uint32 i = 0; i < data.size(); ++i) {
+        hash ^= static_cast<uint8>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+
+
 
 #if defined __MACH__
 const std::string GetUserDataPath(bool user_files)
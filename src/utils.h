@@ -671,6 +671,14 @@ std::vector<std::string> ListDirectory(const std::string &dir_name, const std::s
 **/
 bool DeleteFile(const std::string &filename);
 
+/** \brief Computes the 64-bit FNV-1a hash of some data
+*** This is used to know whether the files built from another file, like the
+*** compiled scripts, are up to date whatever their modification times. Unlike
+*** a 32-bit checksum such as Adler-32, it still tells apart same size files
+*** differing by a few characters, e.g. one number changed in a map table.
+**/
+uint64_t ComputeChecksum(const std::vector<char> &data);
+
 //! \name User directory and settings paths
 //@{
 /** \brief Finds the OS specific directory path to save and retrieve user data